@@ -1,6 +1,9 @@
 #pragma once
 
+#include <vector>
 #include "StringBase.h"
+#include "ListBase.h"
+#include "DictionaryBase.h"
 
 enum class ApexAssetType
 {
@@ -32,7 +35,8 @@ enum class ApexAssetStatus
 	Error,
 };
 
-struct ApexAsset
+// Scratch record filled in by the asset info builders, committed to an ApexAssetList
+struct ApexAssetInfo
 {
 	uint64_t Hash;
 
@@ -45,5 +49,67 @@ struct ApexAsset
 
 	uint64_t FileCreatedTime = 0;
 
+	ApexAssetInfo();
+};
+
+// Append-only arena that owns all of the text for an asset list
+class ApexAssetStringPool
+{
+public:
+	ApexAssetStringPool();
+	~ApexAssetStringPool() = default;
+
+	// Copies the string into the arena
+	const char* Store(const char* Value, uint32_t Length);
+	// Copies the string into the arena, returning the existing copy if it was already interned
+	const char* Intern(const char* Value, uint32_t Length);
+	// Returns a lowercase copy of the string, or the string itself when it is already lowercase
+	const char* Lower(const char* Value, uint32_t Length);
+
+private:
+	char* Allocate(uint32_t Length);
+
+	std::vector<std::unique_ptr<char[]>> Blocks;
+	char* BlockCursor;
+	uint32_t BlockRemaining;
+
+	// Hash of the contents -> interned copy
+	Dictionary<uint64_t, const char*> Interned;
+
+	constexpr static uint32_t BlockSize = 0x10000;
+};
+
+// A single row of the asset list, text is owned by the list's string pool
+struct ApexAsset
+{
+	uint64_t Hash;
+	uint64_t FileCreatedTime;
+
+	const char* Name;
+	const char* NameLower;
+	const char* Info;
+	const char* DebugInfo;
+
+	uint32_t NameLength;
+	uint32_t Version;
+	ApexAssetType Type;
+	ApexAssetStatus Status;
+
 	ApexAsset();
-};
\ No newline at end of file
+};
+
+// The loaded asset list, rows reference text stored in the list's arena
+class ApexAssetList : public List<ApexAsset>
+{
+public:
+	ApexAssetList() = default;
+	ApexAssetList(const ApexAssetList&) = delete;
+
+	// Commits a built asset, moving its text into the arena
+	ApexAsset& AddAsset(const ApexAssetInfo& Asset);
+	// Sorts the rows by their name
+	void SortByName();
+
+	// The arena that owns the text for every row
+	ApexAssetStringPool Strings;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <regex>
+#include "StringBase.h"
+#include "ListBase.h"
+#include "ApexAsset.h"
+
+// A single parsed search term
+struct AssetSearchTerm
+{
+	enum class TermKind
+	{
+		Substring,	// "term"
+		Prefix,		// "^term"
+		Regex,		// "re:pattern"
+	};
+
+	TermKind Kind;
+	string Text;
+	std::shared_ptr<std::regex> Pattern;
+};
+
+// A parsed search query
+//
+// Terms are comma separated and matched against the lowercase asset name, a leading '!' turns the
+// query into a blacklist. "type:<name>" and "v:<version>" terms filter the results instead of matching names.
+struct AssetSearchQuery
+{
+	bool IsBlacklist = false;
+
+	List<AssetSearchTerm> Terms;
+
+	// Bitmask of ApexAssetType values, 0 = any
+	uint32_t TypeMask = 0;
+	// Required asset version, -1 = any
+	int32_t Version = -1;
+
+	// Parses the raw text of a search box
+	static AssetSearchQuery Parse(const string& Text);
+};
+
+// UI independent search over the loaded asset list, backed by a trigram index of the lowercase names
+class AssetSearchIndex
+{
+public:
+	AssetSearchIndex();
+	~AssetSearchIndex() = default;
+
+	// Builds the index for the given list, the list must outlive the index and not be reordered
+	void Build(const ApexAssetList* Assets);
+	// Releases the index
+	void Reset();
+	// Whether or not the index has been built
+	bool IsBuilt() const;
+
+	// Runs a search query, returning matching row indices in list order
+	List<uint32_t> Search(const string& Text);
+	// Runs a parsed search query, returning matching row indices in list order
+	List<uint32_t> Search(const AssetSearchQuery& Query);
+
+private:
+	const ApexAssetList* Assets;
+
+	// Sorted trigram keys, with the rows for Keys[i] in Postings[Offsets[i]..Offsets[i + 1]]
+	std::vector<uint32_t> Keys;
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Postings;
+
+	// The last single term query, used to refine results when the term is extended
+	string LastTerm;
+	uint32_t LastTypeMask;
+	int32_t LastVersion;
+	List<uint32_t> LastResults;
+	bool HasLastResults;
+
+	// Gets the candidate rows for a substring of at least 3 characters, false if it can't match anything
+	bool GetCandidates(const string& Text, List<uint32_t>& Result) const;
+	// Finds the posting list for a trigram
+	bool FindPostings(uint32_t Trigram, const uint32_t*& Begin, const uint32_t*& End) const;
+
+	// Whether or not the asset passes the query filters
+	static bool MatchesFilters(const ApexAsset& Asset, const AssetSearchQuery& Query);
+	// Whether or not the asset name matches the term
+	static bool MatchesTerm(const ApexAsset& Asset, const AssetSearchTerm& Term);
+
+	// Packs three characters into a trigram key
+	static uint32_t MakeTrigram(const char* Value);
+};
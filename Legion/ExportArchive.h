@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "StringBase.h"
+#include "DictionaryBase.h"
+#include "ZipArchive.h"
+
+// Packs exported files into zip archives instead of leaving them loose in the export directory
+//
+// Files handed to the export writer go into the archive straight from memory, everything else is exported into the
+// asset's own staging directory and compressed by the worker once the asset is done.
+// Every name is claimed before its contents are read, so files shared by several assets are only exported once.
+// Appending to the archive is serialized, once a shard passes the configured size the next entry starts a new one.
+class ExportArchive
+{
+public:
+	ExportArchive(const string& ExportDirectory);
+	~ExportArchive();
+
+	// Moves every file below the staging directory into the archive, named by their path below it
+	void AddDirectory(const string& StagingPath);
+	// Adds a file that is still in memory under the name its staging path maps to, returns false if the path isn't staged
+	bool AddBuffer(const string& Path, const uint8_t* Header, uint32_t HeaderSize, const uint8_t* Buffer, uint64_t Size);
+	// Whether or not the file a staging path maps to is already in the archive
+	bool Contains(const string& Path);
+	// Writes the central directory of the open shard and removes the staging directories
+	void Close();
+
+	// Whether or not exports are packed into archives
+	static bool IsEnabled();
+	// Gets the archive exports are currently packed into, if any
+	static ExportArchive* GetActive();
+	// Gets the staging directory of an asset
+	string GetStagingPath(uint32_t AssetIndex) const;
+	// Gets a directory below the staging root that is removed with it when the archive closes
+	string GetScratchPath(const string& Name) const;
+
+private:
+	std::mutex WriteMutex;
+	std::unique_ptr<Compression::ZipArchive> Archive;
+	Dictionary<uint64_t, bool> Entries;
+
+	string ExportDirectory;
+	uint64_t ShardSize;
+	uint32_t ShardIndex;
+	bool StoreTextures;
+
+	// Closes the open shard and starts the next one
+	void OpenShard();
+	// Compresses and appends a single staged file
+	void AddFile(const string& FilePath, const string& FileNameInZip);
+	// Compresses and appends the contents of a file whose name was claimed, returns the bytes written
+	uint64_t AddEntry(const string& FileNameInZip, const uint8_t* Buffer, uint64_t FileSize);
+	// Claims a name in the archive, returns false if another file already has it
+	bool Claim(const string& FileNameInZip);
+	// Gets the name in the archive of a file below an asset staging directory, empty for any other path
+	string GetNameInArchive(const string& Path) const;
+};
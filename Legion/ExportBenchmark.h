@@ -0,0 +1,21 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "StringBase.h"
+
+// Repeatedly mounts, lists and exports a pak file, then reports the time and throughput of each phase
+//
+// Every run starts from a fresh file system with overwriting enabled so the runs do the same work.
+// The profiler is enabled for the runs, so the report also holds the time spent on each asset type.
+class ExportBenchmark
+{
+public:
+	// Runs the benchmark and writes export_benchmark.json to the export folder
+	static bool Run(const string& Path, const std::array<bool, 11>& Assets, uint32_t Runs);
+
+private:
+	// Don't initialize this class
+	ExportBenchmark() = delete;
+	~ExportBenchmark() = delete;
+};
@@ -38,5 +38,5 @@ public:
 	// Handles exporting vpk assets in parallel
 	static void ExportMdlAssets(const std::unique_ptr<MdlLib>& MdlFS, List<string>& ExportAssets);
 	// Write a list of loaded assets to disk
-	static void ExportAssetList(std::unique_ptr<List<ApexAsset>>& AssetList, string RpakName, const string& FilePath);
+	static void ExportAssetList(std::unique_ptr<ApexAssetList>& AssetList, string RpakName, const string& FilePath);
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "ListBase.h"
+
+// Limits the memory held by export workers at once
+//
+// Workers reserve their asset's estimated size before decoding it, assets that don't fit are set aside
+// while the worker moves on to the next one. Small assets aren't counted, a reservation larger than the limit
+// waits for an empty budget.
+class ExportMemoryBudget
+{
+public:
+	ExportMemoryBudget(uint64_t Limit);
+	~ExportMemoryBudget() = default;
+
+	// Waits until the bytes fit within the budget, returns the bytes reserved
+	uint64_t Acquire(uint64_t Bytes);
+	// Reserves the bytes only if they fit right now, Reserved is set to the bytes reserved
+	bool TryAcquire(uint64_t Bytes, uint64_t& Reserved);
+	// Returns reserved bytes to the budget
+	void Release(uint64_t Bytes);
+
+	// Gets the configured limit, or half of the physical memory when unset
+	static uint64_t GetConfiguredLimit();
+
+private:
+	std::mutex Mutex;
+	std::condition_variable Available;
+
+	uint64_t Limit;
+	uint64_t InUse;
+
+	// Gets the bytes counted against the budget for a reservation
+	uint64_t GetCountedBytes(uint64_t Bytes) const;
+};
+
+// Holds a reservation until the end of the scope
+class ExportMemoryReservation
+{
+public:
+	ExportMemoryReservation(ExportMemoryBudget& Budget);
+	~ExportMemoryReservation();
+
+	// Waits until the bytes fit
+	void Acquire(uint64_t Bytes);
+	// Reserves the bytes only if they fit right now
+	bool TryAcquire(uint64_t Bytes);
+
+private:
+	ExportMemoryBudget& Budget;
+	uint64_t Bytes;
+};
+
+// Hands out export slots in order, a slot whose memory doesn't fit yet is set aside and taken
+// by the first worker that finds room for it, so workers keep exporting instead of waiting
+class ExportMemoryQueue
+{
+public:
+	// Takes the estimated memory of each slot
+	ExportMemoryQueue(List<uint64_t> SlotBytes);
+	~ExportMemoryQueue() = default;
+
+	// Takes the next slot and reserves its memory, false once every slot was handed out
+	bool Next(uint32_t& Slot, ExportMemoryReservation& Reservation);
+
+private:
+	List<uint64_t> SlotBytes;
+
+	std::atomic<uint32_t> NextSlot;
+
+	std::mutex DeferredMutex;
+	std::deque<uint32_t> Deferred;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "StringBase.h"
+
+// The stages of loading and exporting that are timed
+//
+// Different stages may nest so their times are inclusive, nested scopes of the same stage are only timed once.
+enum class ExportStage : uint32_t
+{
+	Mount,
+	Decompress,
+	Extract,
+	ExportModel,
+	ExportAnimation,
+	TextureSave,
+	FileWrite,
+
+	Count
+};
+
+// Assets of one type finished so far and the time spent on them, summed over every thread
+struct ExportTypeTotals
+{
+	uint32_t AssetType;
+	uint64_t Assets;
+	uint64_t Ticks;
+};
+
+// Collects per thread timings of export stages and assets, then writes them to a json report
+//
+// Recording is a no-op until the profiler is enabled, each thread only touches its own counters.
+// Threads borrowed through ThreadBudget::Run record under the asset and open stages of the thread that borrowed them.
+class ExportProfiler
+{
+public:
+	// Starts recording and hooks ThreadBudget loops, call before any work is done
+	static void Enable();
+	// Whether or not the profiler is recording
+	static bool IsEnabled();
+
+	// Marks the start of a stage on the current thread
+	static void EnterStage(ExportStage Stage);
+	// Adds a timed stage to the current thread
+	static void LeaveStage(ExportStage Stage, uint64_t Ticks, uint64_t Bytes);
+	// Marks the start of an asset on the current thread, stages are grouped by the asset's type
+	static void BeginAsset(uint64_t Hash, uint32_t AssetType, uint64_t PredictedTicks);
+	// Marks the end of the current asset on the current thread
+	static void EndAsset();
+
+	// Gets the totals of every asset type recorded so far, every recording thread must be done
+	static std::vector<ExportTypeTotals> GetTypeTotals();
+	// Writes the collected timings, every recording thread must be done
+	static bool WriteReport(const string& Path);
+
+	// Gets the current time in profiler ticks
+	static uint64_t GetTicks();
+
+private:
+	static std::atomic<bool> Enabled;
+
+	// Don't initialize this class
+	ExportProfiler() = delete;
+	~ExportProfiler() = delete;
+};
+
+// Times a stage for the lifetime of the scope
+class ExportProfileScope
+{
+public:
+	ExportProfileScope(ExportStage Stage, uint64_t Bytes = 0);
+	~ExportProfileScope();
+
+	// Adds to the bytes processed by this stage
+	void AddBytes(uint64_t Bytes);
+
+private:
+	ExportStage Stage;
+	uint64_t Start;
+	uint64_t Bytes;
+};
+
+// Times an asset for the lifetime of the scope
+class ExportAssetProfileScope
+{
+public:
+	ExportAssetProfileScope(uint64_t Hash, uint32_t AssetType, uint64_t PredictedTicks = 0);
+	~ExportAssetProfileScope();
+
+private:
+	bool IsRecording;
+};
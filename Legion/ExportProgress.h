@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "ExportManager.h"
+#include "Thread.h"
+
+// Set while a bulk export is being canceled, long extractors check it between their parts and stop early
+class ExportCancellation
+{
+public:
+	// Asks the running export to stop
+	static void Request();
+	// Clears a previous request
+	static void Reset();
+	// Whether or not the running export should stop
+	static bool IsRequested();
+
+private:
+	static std::atomic<bool> Requested;
+
+	// Don't initialize this class
+	ExportCancellation() = delete;
+	~ExportCancellation() = delete;
+};
+
+// Tracks a bulk export with atomic counters while a separate thread reports progress and asset statuses
+//
+// Workers only store the result of each asset, so the overhead stays the same no matter how small the assets are.
+// The reporter polls the status callback for cancellation even while no asset finishes and forwards it to ExportCancellation.
+class ExportProgress
+{
+public:
+	// Starts the reporter for an export of the given number of assets
+	ExportProgress(uint32_t AssetCount, ExportProgressCallback ProgressCallback, CheckStatusCallback StatusCallback, Forms::Form* MainForm);
+	~ExportProgress();
+
+	// Marks the asset at a position in the export order as exported
+	void AssetExported(uint32_t Slot, int32_t AssetIndex);
+	// Marks the asset at a position in the export order as failed
+	void AssetFailed(uint32_t Slot, int32_t AssetIndex);
+
+	// Stops the reporter and reports every remaining status, call before reporting the export as finished
+	void Finish();
+
+private:
+	uint32_t AssetCount;
+
+	ExportProgressCallback* ProgressCallback;
+	CheckStatusCallback* StatusCallback;
+	Forms::Form* MainForm;
+
+	// The asset index and result of each slot, 0 until the asset is done
+	std::unique_ptr<std::atomic<uint64_t>[]> Results;
+	std::atomic<uint32_t> Completed;
+
+	// Only touched by the reporter, or after it stopped
+	uint32_t ReportedSlots;
+	uint32_t ReportedProgress;
+
+	std::mutex ReporterMutex;
+	std::condition_variable ReporterWake;
+	bool ReporterStopping;
+	std::unique_ptr<Threading::Thread> Reporter;
+
+	// Stores the result of a slot
+	void SetResult(uint32_t Slot, int32_t AssetIndex, uint64_t Result);
+	// Hands finished statuses and the progress to the callbacks, Flush skips assets that never finished
+	void Report(bool Flush);
+};
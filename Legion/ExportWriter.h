@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include "StringBase.h"
+#include "MemoryStream.h"
+
+// Counters of the output queue, ticks are in profiler ticks
+struct ExportWriterStats
+{
+	uint64_t FilesWritten;
+	uint64_t FilesFailed;
+	uint64_t BytesWritten;
+	uint64_t WriteTicks;
+
+	uint64_t PeakQueuedFiles;
+	uint64_t PeakQueuedBytes;
+
+	uint64_t Stalls;
+	uint64_t StallTicks;
+};
+
+// Writes finished export files on dedicated threads so decode workers don't wait on the disk
+//
+// Workers hand over whole files, each written with one large write. The queue is bounded by bytes,
+// a worker that would overflow it waits for room and the wait is counted as a stall.
+// While the writer isn't running files are written on the calling thread.
+// Files staged for an open archive are packed into it on the calling thread instead of being written.
+class ExportWriter
+{
+public:
+	// Starts the writer threads, a zero thread count leaves writes on the calling thread
+	static void Start(uint32_t ThreadCount, uint64_t QueueLimit);
+	// Waits for the queue to drain, stops the threads and logs the queue counters
+	static void Stop();
+	// Whether or not files are being queued
+	static bool IsRunning();
+
+	// Writes a file from the buffer, the header is copied and written in front of it
+	static void WriteFile(const string& Path, std::unique_ptr<uint8_t[]> Buffer, uint64_t Size, const uint8_t* Header = nullptr, uint32_t HeaderSize = 0, std::function<void()> OnWritten = nullptr);
+	// Writes a file from the contents of the stream
+	static void WriteFile(const string& Path, std::unique_ptr<IO::MemoryStream> Stream, std::function<void()> OnWritten = nullptr);
+
+	// Gets the counters of the current or last run
+	static ExportWriterStats GetStats();
+
+	// Gets the configured writer thread count
+	static uint32_t GetConfiguredThreadCount();
+	// Gets the configured queue limit in bytes
+	static uint64_t GetConfiguredQueueLimit();
+
+private:
+	// Don't initialize this class
+	ExportWriter() = delete;
+	~ExportWriter() = delete;
+};
@@ -11,6 +11,7 @@
 #include "bsplib.h"
 #include "MilesLib.h"
 #include "ApexAsset.h"
+#include "AssetSearchIndex.h"
 #include "ExportAsset.h"
 #include "ExportManager.h"
 #include "LegionPreview.h"
@@ -96,7 +97,9 @@ private:
 	std::unique_ptr<MilesLib> MilesFileSystem;
 
 	// Converted assets for the list...
-	std::unique_ptr<List<ApexAsset>> LoadedAssets;
+	std::unique_ptr<ApexAssetList> LoadedAssets;
+	// Search index over the loaded assets
+	AssetSearchIndex SearchIndex;
 	
 	// List of display indices for the list...
 	List<uint32_t> DisplayIndices;
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <mutex>
+#include <vector>
 //#include "MemoryModule.h"
 #include "StringBase.h"
 #include "DictionaryBase.h"
 #include "ListBase.h"
 #include "ApexAsset.h"
+#include "ExportAsset.h"
+#include "FileStream.h"
 
 struct FORMATCHUNK
 {
@@ -36,7 +40,8 @@ struct WAVEHEADER
 
 struct MilesAudioAsset
 {
-	string Name;
+	// Points into the bank's name table, owned by the MilesLib
+	const char* Name;
 	uint32_t SampleRate;
 	uint32_t ChannelCount;
 
@@ -56,7 +61,14 @@ struct MilesStreamBank
 	string Path;
 	uint32_t StreamDataOffset;
 
+	// A single handle shared by every extraction from this bank
+	std::shared_ptr<IO::FileStream> Stream;
+	std::shared_ptr<std::mutex> StreamLock;
+
 	MilesStreamBank() = default;
+
+	// Reads a block of the bank at the given offset, safe to call from multiple threads
+	uint64_t Read(uint64_t Offset, uint8_t* Buffer, uint64_t Count) const;
 };
 
 enum class MilesLanguageID : int16_t
@@ -91,9 +103,11 @@ public:
 	void MountBank(const string& Path);
 	// Extracts a Miles audio file
 	bool ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath);
+	// Sorts a list of assets into the order their data is laid out in the stream banks
+	void SortByStreamOffset(List<ExportAsset>& ExportAssets);
 
 	// Builds the viewer list of assets
-	std::unique_ptr<List<ApexAsset>> BuildAssetList();
+	std::unique_ptr<ApexAssetList> BuildAssetList();
 
 	// A list of loaded assets
 	Dictionary<uint64_t, MilesAudioAsset> Assets;
@@ -102,6 +116,18 @@ private:
 
 	// A list of streaming audio bank files
 	Dictionary<uint32_t, MilesStreamBank> StreamBanks;
+	// Folders that have already been scanned for streaming audio banks
+	List<string> StreamBankDirectories;
+	// The loaded name tables of every mounted bank
+	std::vector<std::unique_ptr<char[]>> NameTables;
 
 	uint32_t MbnkVersion;
+
+	// Loads the part of a bank's name table that is referenced by its sources
+	const char* LoadNameTable(IO::Stream* Stream, uint64_t NameTableOffset, const List<uint32_t>& NameOffsets, uint32_t& NameTableSize);
+	// Opens the streaming audio banks next to a bank for the selected language
+	void MountStreamBanks(const string& BasePath, MilesLanguageID SelectedLanguage);
+
+	// Gets the stream bank key for an asset
+	static uint32_t GetStreamBankKey(const MilesAudioAsset& Asset);
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include "StringBase.h"
+
+// Mounts the rpaks of two game builds and compares their assets without exporting anything
+//
+// Assets are matched by guid, an asset changed when its type, version or content hash differs.
+// The builds are mounted one after another so only the hashes of the old build stay in memory.
+class PakDiff
+{
+public:
+	// Compares every rpak in the two folders and writes pak_diff.json to the export folder
+	static bool Run(const string& OldPath, const string& NewPath);
+
+private:
+	// Don't initialize this class
+	PakDiff() = delete;
+	~PakDiff() = delete;
+};
@@ -6,9 +6,12 @@
 #include "MemoryStream.h"
 #include "FileStream.h"
 #include "BinaryReader.h"
+#include "BufferedTextWriter.h"
 
 #include "RpakAssets.h"
 #include "ApexAsset.h"
+#include "ExportProfiler.h"
+#include "RpakMemoCache.h"
 
 // For when using the previewer
 #include "Model.h"
@@ -234,6 +237,28 @@ enum class RpakGameVersion : uint32_t
 	Apex      = 0x8, // Apex Legends
 };
 
+// The footer table of a starpak, sorted by offset
+class StarpakEntryTable
+{
+public:
+	StarpakEntryTable() = default;
+	~StarpakEntryTable() = default;
+
+	// Gets the size of the entry that starts at the given offset
+	bool TryGetSize(uint64_t Offset, uint64_t& Size) const;
+
+	std::vector<StarpakStreamEntry> Entries;
+};
+
+// A loaded file that contains an asset, appended while mounting
+struct RpakAssetFileEntry
+{
+	uint64_t NameHash;
+	uint32_t FileIndex;
+	// Position in the sequence assets were mounted in
+	uint32_t Order;
+};
+
 class RpakFile
 {
 public:
@@ -249,10 +274,10 @@ public:
 	List<RpakSegmentBlock> SegmentBlocks;
 
 	List<string> StarpakReferences;
-	Dictionary<uint64_t, uint64_t> StarpakMap;
+	std::vector<std::shared_ptr<const StarpakEntryTable>> StarpakTables;
 
 	List<string> OptimalStarpakReferences;
-	Dictionary<uint64_t, uint64_t> OptimalStarpakMap;
+	std::vector<std::shared_ptr<const StarpakEntryTable>> OptimalStarpakTables;
 
 	uint64_t EmbeddedStarpakOffset;
 	uint64_t EmbeddedStarpakSize;
@@ -264,6 +289,12 @@ public:
 
 	std::unique_ptr<uint8_t[]> PatchData;
 	uint64_t PatchDataSize;
+
+	// Locations of every pointer in the pages, the loader fixes these up when the pak is mounted
+	List<RpakDescriptor> PointerDescriptors;
+
+	// Gets the size of a streamed entry, the low byte of the offset is the starpak index
+	bool TryGetStarpakEntrySize(uint64_t StarpakOffset, uint64_t& Size, bool Optimal) const;
 };
 
 struct RpakLoadAsset
@@ -417,6 +448,29 @@ static std::map<SubtitleLanguageHash, string> SubtitleLanguageMap{
 	{SubtitleLanguageHash::Spanish, "spanish"},
 };
 
+// What exporting an asset is expected to take, estimated from its header
+struct RpakExportEstimate
+{
+	// Memory held while the asset exports
+	uint64_t Memory;
+	// Time in profiler ticks, used to schedule the longest exports first
+	uint64_t Ticks;
+};
+
+// Raw pixel data of a texture in its final DXGI layout, mips are stored largest first
+struct RpakTextureData
+{
+	uint16_t Width;
+	uint16_t Height;
+	DXGI_FORMAT Format;
+	uint32_t MipLevels;
+	// PS4 textures are stored morton ordered
+	bool IsSwizzled;
+
+	std::unique_ptr<uint8_t[]> Pixels;
+	uint64_t PixelsSize;
+};
+
 class RpakLib
 {
 public:
@@ -434,7 +488,7 @@ public:
 	bool m_bImageExporterInitialized = false;
 
 	// Builds the viewer list of assets
-	std::unique_ptr<List<ApexAsset>> BuildAssetList(const std::array<bool, 11>& arrAssets);
+	std::unique_ptr<ApexAssetList> BuildAssetList(const std::array<bool, 11>& arrAssets);
 	// Builds the preview model mesh
 	std::unique_ptr<Assets::Model> BuildPreviewModel(uint64_t Hash);
 	// Builds the preview texture
@@ -449,6 +503,15 @@ public:
 	// Initializes a image exporter
 	void InitializeImageExporter(ImageExportFormat_t Format = ImageExportFormat_t::Dds);
 
+	// Estimates the memory and time needed to export an asset, reading its header once
+	RpakExportEstimate EstimateExport(const RpakLoadAsset& Asset);
+	// Hashes the subheader, raw data and streamed sizes of every mounted asset in parallel, pointers are left out so moved data alone doesn't change a hash
+	void HashAssetContents(Dictionary<uint64_t, uint64_t>& Hashes);
+	// Logs the hits and misses of the parsed asset caches
+	void LogMemoCacheStats();
+	// Sets the directory holding one copy of every exported texture payload, empty writes each texture on its own
+	void SetTextureStorePath(const string& Path);
+
 	void ExportModel(const RpakLoadAsset& Asset, const string& Path, const string& AnimPath);
 	void ExportMaterial(const RpakLoadAsset& Asset, const string& Path);
 	void ExportMaterialCPU(const RpakLoadAsset& Asset, const string& Path);
@@ -476,14 +539,33 @@ public:
 
 	// Used by the BSP system.
 	RMdlMaterial ExtractMaterial(const RpakLoadAsset& Asset, const string& Path, bool IncludeImages, bool IncludeImageNames, bool silent = false);
-	void QCWriteAseqData(IO::StreamWriter& qc, const string& Path, uint64_t AnimHash, const RpakLoadAsset& RigAsset, List<string> PoseParameters, List<string>& AnimationNames, bool WriteAnimations);
+	void QCWriteAseqData(IO::BufferedTextWriter& qc, const string& Path, uint64_t AnimHash, const RpakLoadAsset& RigAsset, List<string> PoseParameters, List<string>& AnimationNames, bool WriteAnimations);
 private:
 	std::array<RpakFile, MAX_LOADED_FILES> LoadedFiles;
 	uint32_t LoadedFileIndex;
 
+	// Every file each asset was mounted from, grouped by PatchAssets to resolve assets with one lookup
+	std::vector<RpakAssetFileEntry> AssetFileIndex;
+
 	List<string> LoadFileQueue;
 	List<string> LoadedFilePaths;
 
+	// Starpak footer tables by path hash, shared between every file that references them
+	Dictionary<uint64_t, std::shared_ptr<const StarpakEntryTable>> StarpakTableCache;
+
+	// Parsed data shared by many exports, cleared whenever assets are patched
+	RpakMemoCache<List<ShaderVar>> ShaderVarCache;
+	RpakMemoCache<List<ShaderResBinding>> ShaderResBindingCache;
+	RpakMemoCache<SettingsLayout> SettingsLayoutCache;
+	RpakMemoCache<List<Assets::Bone>> SkeletonCache;
+
+	// Serializes moves into the content stores shared by shaders and textures
+	std::mutex ContentStoreMutex;
+	std::atomic<uint32_t> ContentStoreTempIndex = 0;
+
+	// Exported textures are linked to a single copy of their payload here, when set
+	string TextureStorePath;
+
 	// The exporter formats for models and anims
 	std::unique_ptr<Assets::Exporters::Exporter> ModelExporter;
 	std::unique_ptr<Assets::Exporters::Exporter> AnimExporter;
@@ -503,23 +585,23 @@ private:
 
 private:
 	// purpose: set up asset list entries
-	void BuildModelInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildAnimInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildRawAnimInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildMaterialInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildTextureInfo(const RpakLoadAsset& asset, ApexAsset& assetInfo);
-	void BuildUIIAInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildDataTableInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildSubtitleInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildShaderSetInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildUIImageAtlasInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildSettingsInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildMapInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildEffectInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildSettingsLayoutInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildRSONInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildRUIInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
-	void BuildWrapInfo(const RpakLoadAsset& Asset, ApexAsset& Info);
+	void BuildModelInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildAnimInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildRawAnimInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildMaterialInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildTextureInfo(const RpakLoadAsset& asset, ApexAssetInfo& assetInfo);
+	void BuildUIIAInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildDataTableInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildSubtitleInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildShaderSetInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildUIImageAtlasInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildSettingsInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildMapInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildEffectInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildSettingsLayoutInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildRSONInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildRUIInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
+	void BuildWrapInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info);
 
 	std::unique_ptr<Assets::Model> ExtractModel(const RpakLoadAsset& Asset, const string& Path, const string& AnimPath, bool IncludeMaterials, bool IncludeAnimations);
 	std::unique_ptr<Assets::Model> ExtractModel_V16(const RpakLoadAsset& Asset, const string& Path, const string& AnimPath, bool IncludeMaterials, bool IncludeAnimations);
@@ -528,6 +610,20 @@ private:
 	void ExtractModelLod_V16(IO::BinaryReader& Reader, const std::unique_ptr<IO::MemoryStream>& RpakStream, string Name, uint64_t Offset, const std::unique_ptr<Assets::Model>& Model, RMdlFixupPatches& Fixup, uint32_t Version, bool IncludeMaterials);
 	void ExtractModelLodOld(IO::BinaryReader& Reader, const std::unique_ptr<IO::MemoryStream>& RpakStream, string Name, uint64_t Offset, const std::unique_ptr<Assets::Model>& Model, RMdlFixupPatches& Fixup, uint32_t Version, bool IncludeMaterials);
 	void ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets::Texture>& texture, string& name);
+	// Reads the raw pixel data of a texture, includeMips appends every lower mip that can be read without decoding
+	bool ExtractTextureData(const RpakLoadAsset& asset, RpakTextureData& data, string& name, bool includeMips);
+	// Builds a texture from the highest mip of the raw data, unswizzling it when needed
+	void BuildTexture(const RpakTextureData& data, std::unique_ptr<Assets::Texture>& texture);
+	// Gets a temp path beside a stored blob that no other writer uses
+	string GetStoreTempPath(const string& BlobPath);
+	// Links the path to a stored blob, false when the blob hasn't been stored yet
+	bool LinkStoredBlob(const string& BlobPath, const string& DestPath);
+	// Moves a freshly written blob into its store and links the path to it
+	void StoreBlob(const string& TempPath, const string& BlobPath, const string& DestPath);
+	// Estimates the time needed to export a list of sequences referenced by an asset
+	uint64_t EstimateSequencesCost(const RpakLoadAsset& Asset, const RPakPtr& Sequences, uint32_t Count);
+	// Gets the size of the data a sequence stores outside of itself, 0 when the header doesn't say
+	uint64_t GetSequenceDataSize(const RpakLoadAsset& Asset);
 	void ExtractUIIA(const RpakLoadAsset& Asset, std::unique_ptr<Assets::Texture>& Texture);
 	void ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets::Bone>& Skeleton, const string& Path);
 	void ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bone>& Skeleton, const string& Path);
@@ -535,11 +631,17 @@ private:
 	List<Assets::Bone> ExtractSkeleton_V16(IO::BinaryReader& Reader, uint64_t SkeletonOffset, uint32_t Version, int mdlHeaderSize=0);
 	//List<List<DataTableColumnData>> ExtractDataTable(const RpakLoadAsset& Asset);
 	List<SubtitleEntry> ExtractSubtitles(const RpakLoadAsset& Asset);
-	void ExtractShader(const RpakLoadAsset& Asset, const string& OutputDirPath, const string& Path);
+	// Writes shader bytecode to the content addressed store and links it to the path
+	void ExtractShader(const RpakLoadAsset& Asset, const string& StorePath, const string& OutputDirPath, const string& Path);
 	ShaderSetHeader ExtractShaderSet(const RpakLoadAsset& Asset);
 	void ExtractUIImageAtlas(const RpakLoadAsset& Asset, const string& Path);
+	// Decodes the blocks of a block compressed atlas under the region, the result is aligned to the first block
+	std::unique_ptr<Assets::Texture> DecodeAtlasRegion(const RpakTextureData& Atlas, size_t RowPitch, uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height);
 	void ExtractSettings(const RpakLoadAsset& Asset, const string& Path, const string& Name, const SettingsHeader& Header);
 	SettingsLayout ExtractSettingsLayout(const RpakLoadAsset& Asset);
+	SettingsLayout ParseSettingsLayout(const RpakLoadAsset& Asset);
+	List<ShaderVar> ParseShaderVars(const RpakLoadAsset& Asset, const std::string& CBufName, D3D_SHADER_VARIABLE_TYPE Type);
+	List<ShaderResBinding> ParseShaderResourceBindings(const RpakLoadAsset& Asset, D3D_SHADER_INPUT_TYPE InputType);
 
 	string ExtractAnimationRig(const RpakLoadAsset& Asset);
 	string ExtractAnimationSeq(const RpakLoadAsset& Asset);
@@ -549,7 +651,7 @@ private:
 
 	void ExtractTextureName(const RpakLoadAsset& asset, string& name);
 
-	void R_WriteRSONFile(const RpakLoadAsset& Asset, std::ofstream& out, IO::BinaryReader & Reader, RSONNode node, int level);
+	void R_WriteRSONFile(const RpakLoadAsset& Asset, IO::BufferedTextWriter& out, IO::BinaryReader & Reader, RSONNode node, int level);
 
 	string GetSubtitlesNameFromHash(uint64_t Hash);
 	void CalcBonePosition(const mstudio_rle_anim_t& BoneFlags, uint16_t** BoneTrackData, const std::unique_ptr<Assets::Animation>& Anim, uint32_t BoneIndex, uint32_t Frame, uint32_t FrameIndex);
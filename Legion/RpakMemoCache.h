@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include "DictionaryBase.h"
+
+// A thread safe cache of data parsed from assets, keyed by guid
+//
+// Values are immutable once stored. Threads that miss the same key at once may both parse it, the first stored value wins.
+template<typename T>
+class RpakMemoCache
+{
+public:
+	RpakMemoCache() = default;
+	~RpakMemoCache() = default;
+
+	// Gets the cached value for the key, or stores the result of the parser
+	template<typename TParser>
+	std::shared_ptr<const T> Get(uint64_t Key, TParser Parser)
+	{
+		std::shared_ptr<const T> Value;
+
+		{
+			std::shared_lock<std::shared_mutex> Lock(this->Mutex);
+
+			if (this->Values.TryGetValue(Key, Value))
+			{
+				this->Hits++;
+				return Value;
+			}
+		}
+
+		this->Misses++;
+
+		std::shared_ptr<const T> Parsed = std::make_shared<const T>(Parser());
+		std::unique_lock<std::shared_mutex> Lock(this->Mutex);
+
+		if (this->Values.TryGetValue(Key, Value))
+			return Value;
+
+		this->Values.Add(Key, Parsed);
+		return Parsed;
+	}
+
+	// Drops every cached value, call when the assets they were parsed from change
+	void Clear()
+	{
+		std::unique_lock<std::shared_mutex> Lock(this->Mutex);
+		this->Values.Clear();
+	}
+
+	// Combines a guid with another value that changes the parsed result
+	static uint64_t CombineKey(uint64_t Guid, uint64_t Value)
+	{
+		return Guid ^ (Value * 0x9E3779B97F4A7C15ull);
+	}
+
+	uint64_t GetHits() const
+	{
+		return this->Hits.load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetMisses() const
+	{
+		return this->Misses.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::shared_mutex Mutex;
+	Dictionary<uint64_t, std::shared_ptr<const T>> Values;
+
+	std::atomic<uint64_t> Hits = 0;
+	std::atomic<uint64_t> Misses = 0;
+};
@@ -5,6 +5,7 @@ namespace Utils
 	string GetTimestamp();
 	string GetDate();
 	string Vector3ToHexColor(Math::Vector3 vec);
+	string GetAssetTypeName(uint32_t AssetType);
 	static std::string GetIndentation(int level)
 	{
 		std::string ret = "";
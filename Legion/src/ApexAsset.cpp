@@ -1,10 +1,132 @@
 #include "pch.h"
 #include "ApexAsset.h"
+#include "XXHash.h"
 
-ApexAsset::ApexAsset()
+ApexAssetInfo::ApexAssetInfo()
 {
 	Name = "<Error>";
 	Status = ApexAssetStatus::Loaded;
 	Type = ApexAssetType::Model;
 	Info = "N/A";
 }
+
+ApexAsset::ApexAsset()
+	: Hash(0), FileCreatedTime(0), Name(""), NameLower(""), Info(""), DebugInfo(""), NameLength(0), Version(0), Type(ApexAssetType::Model), Status(ApexAssetStatus::Loaded)
+{
+}
+
+ApexAssetStringPool::ApexAssetStringPool()
+	: BlockCursor(nullptr), BlockRemaining(0)
+{
+}
+
+char* ApexAssetStringPool::Allocate(uint32_t Length)
+{
+	// Reserve room for the null terminator
+	Length += 1;
+
+	if (Length > BlockRemaining)
+	{
+		// Oversized strings get a dedicated block so we don't waste the current one
+		if (Length > BlockSize / 4)
+		{
+			this->Blocks.emplace_back(std::make_unique<char[]>(Length));
+			return this->Blocks.back().get();
+		}
+
+		this->Blocks.emplace_back(std::make_unique<char[]>(BlockSize));
+		this->BlockCursor = this->Blocks.back().get();
+		this->BlockRemaining = BlockSize;
+	}
+
+	char* Result = this->BlockCursor;
+
+	this->BlockCursor += Length;
+	this->BlockRemaining -= Length;
+
+	return Result;
+}
+
+const char* ApexAssetStringPool::Store(const char* Value, uint32_t Length)
+{
+	if (Length == 0)
+		return "";
+
+	char* Result = this->Allocate(Length);
+
+	std::memcpy(Result, Value, Length);
+	Result[Length] = '\0';
+
+	return Result;
+}
+
+const char* ApexAssetStringPool::Intern(const char* Value, uint32_t Length)
+{
+	if (Length == 0)
+		return "";
+
+	uint64_t Hash = Hashing::XXHash::ComputeHash((uint8_t*)Value, 0, Length);
+	const char* Existing = nullptr;
+
+	if (this->Interned.TryGetValue(Hash, Existing))
+	{
+		// Guard against hash collisions, just store a copy if the contents differ
+		if (std::strncmp(Existing, Value, Length) == 0 && Existing[Length] == '\0')
+			return Existing;
+
+		return this->Store(Value, Length);
+	}
+
+	const char* Result = this->Store(Value, Length);
+	this->Interned.Add(Hash, Result);
+
+	return Result;
+}
+
+const char* ApexAssetStringPool::Lower(const char* Value, uint32_t Length)
+{
+	uint32_t FirstUpper = 0;
+
+	while (FirstUpper < Length && !(Value[FirstUpper] >= 'A' && Value[FirstUpper] <= 'Z'))
+		FirstUpper++;
+
+	// Most names are already lowercase, share the storage in that case
+	if (FirstUpper == Length)
+		return Value;
+
+	char* Result = this->Allocate(Length);
+
+	std::memcpy(Result, Value, FirstUpper);
+
+	for (uint32_t i = FirstUpper; i < Length; i++)
+		Result[i] = (char)::tolower((uint8_t)Value[i]);
+
+	Result[Length] = '\0';
+
+	return Result;
+}
+
+ApexAsset& ApexAssetList::AddAsset(const ApexAssetInfo& Asset)
+{
+	ApexAsset& Result = this->Emplace();
+
+	Result.Hash = Asset.Hash;
+	Result.FileCreatedTime = Asset.FileCreatedTime;
+	Result.Type = Asset.Type;
+	Result.Status = Asset.Status;
+	Result.Version = Asset.Version;
+
+	// Names are almost always unique, info text is heavily shared between rows
+	Result.NameLength = Asset.Name.Length();
+	Result.Name = this->Strings.Store(Asset.Name.ToCString(), Asset.Name.Length());
+	Result.NameLower = this->Strings.Lower(Result.Name, Result.NameLength);
+	Result.Info = this->Strings.Intern(Asset.Info.ToCString(), Asset.Info.Length());
+	Result.DebugInfo = this->Strings.Intern(Asset.DebugInfo.ToCString(), Asset.DebugInfo.Length());
+
+	return Result;
+}
+
+void ApexAssetList::SortByName()
+{
+	this->Sort([](const ApexAsset& lhs, const ApexAsset& rhs) { return std::strcmp(lhs.Name, rhs.Name) < 0; });
+}
@@ -0,0 +1,351 @@
+#include "pch.h"
+#include "AssetSearchIndex.h"
+
+// Names used by "type:" filters, in ApexAssetType order
+static const char* AssetSearchTypeNames[] = { "model", "animationset", "animationseq", "image", "material", "datatable", "sound", "subtitles", "shaderset", "uiimage", "uiimageatlas", "settings", "settingslayout", "rson", "rui", "map", "effect", "wrap" };
+
+AssetSearchQuery AssetSearchQuery::Parse(const string& Text)
+{
+	AssetSearchQuery Result;
+	// Only the names are lowercase, regex patterns keep their case so escapes like \D keep their meaning
+	string SearchText = Text.Trim();
+
+	Result.IsBlacklist = SearchText.StartsWith("!");
+	if (Result.IsBlacklist)
+		SearchText = SearchText.Substring(1);
+
+	List<string> SearchMap = SearchText.Split(",");
+
+	for (auto& Search : SearchMap)
+	{
+		string Pattern = Search.Trim();
+		string Term = Pattern.ToLower();
+
+		if (Term.Length() == 0)
+			continue;
+
+		if (Term.StartsWith("type:"))
+		{
+			string TypeName = Term.Substring(5).Replace(" ", "");
+			uint32_t TypeMask = (1u << 31); // Unknown types match nothing
+
+			for (uint32_t i = 0; i < _countof(AssetSearchTypeNames); i++)
+			{
+				if (TypeName == AssetSearchTypeNames[i])
+				{
+					TypeMask = (1u << i);
+					break;
+				}
+			}
+
+			Result.TypeMask |= TypeMask;
+		}
+		else if (Term.StartsWith("v:") || Term.StartsWith("version:"))
+		{
+			Result.Version = (int32_t)std::strtol(Term.Substring(Term.IndexOf(":") + 1).ToCString(), nullptr, 10);
+		}
+		else if (Term.StartsWith("re:"))
+		{
+			AssetSearchTerm& NewTerm = Result.Terms.Emplace();
+			NewTerm.Kind = AssetSearchTerm::TermKind::Regex;
+			NewTerm.Text = Pattern.Substring(3);
+
+			try
+			{
+				NewTerm.Pattern = std::make_shared<std::regex>(NewTerm.Text.ToCString(), std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+			}
+			catch (const std::regex_error&)
+			{
+				// Not a valid pattern, treat it as plain text
+				NewTerm.Kind = AssetSearchTerm::TermKind::Substring;
+				NewTerm.Text = Term.Substring(3);
+			}
+		}
+		else if (Term.StartsWith("^") && Term.Length() > 1)
+		{
+			AssetSearchTerm& NewTerm = Result.Terms.Emplace();
+			NewTerm.Kind = AssetSearchTerm::TermKind::Prefix;
+			NewTerm.Text = Term.Substring(1);
+		}
+		else
+		{
+			AssetSearchTerm& NewTerm = Result.Terms.Emplace();
+			NewTerm.Kind = AssetSearchTerm::TermKind::Substring;
+			NewTerm.Text = Term;
+		}
+	}
+
+	return Result;
+}
+
+AssetSearchIndex::AssetSearchIndex()
+	: Assets(nullptr), LastTypeMask(0), LastVersion(-1), HasLastResults(false)
+{
+}
+
+void AssetSearchIndex::Build(const ApexAssetList* Assets)
+{
+	this->Reset();
+	this->Assets = Assets;
+
+	if (Assets == nullptr)
+		return;
+
+	const ApexAsset* Rows = Assets->begin();
+	uint32_t RowCount = Assets->Count();
+
+	// (trigram << 32 | row) pairs, sorting them groups the rows of each trigram in list order
+	std::vector<uint64_t> Pairs;
+	std::vector<uint32_t> RowTrigrams;
+
+	Pairs.reserve((size_t)RowCount * 24);
+
+	for (uint32_t i = 0; i < RowCount; i++)
+	{
+		const ApexAsset& Asset = Rows[i];
+
+		RowTrigrams.clear();
+
+		for (uint32_t c = 0; c + 3 <= Asset.NameLength; c++)
+			RowTrigrams.push_back(MakeTrigram(Asset.NameLower + c));
+
+		std::sort(RowTrigrams.begin(), RowTrigrams.end());
+		auto UniqueEnd = std::unique(RowTrigrams.begin(), RowTrigrams.end());
+
+		for (auto It = RowTrigrams.begin(); It != UniqueEnd; ++It)
+			Pairs.push_back(((uint64_t)*It << 32) | i);
+	}
+
+	std::sort(Pairs.begin(), Pairs.end());
+
+	this->Postings.resize(Pairs.size());
+
+	for (size_t i = 0; i < Pairs.size(); i++)
+	{
+		uint32_t Trigram = (uint32_t)(Pairs[i] >> 32);
+
+		if (this->Keys.empty() || this->Keys.back() != Trigram)
+		{
+			this->Keys.push_back(Trigram);
+			this->Offsets.push_back((uint32_t)i);
+		}
+
+		this->Postings[i] = (uint32_t)Pairs[i];
+	}
+
+	this->Offsets.push_back((uint32_t)Pairs.size());
+}
+
+void AssetSearchIndex::Reset()
+{
+	this->Assets = nullptr;
+
+	this->Keys.clear();
+	this->Keys.shrink_to_fit();
+	this->Offsets.clear();
+	this->Offsets.shrink_to_fit();
+	this->Postings.clear();
+	this->Postings.shrink_to_fit();
+
+	this->LastResults.Clear();
+	this->HasLastResults = false;
+}
+
+bool AssetSearchIndex::IsBuilt() const
+{
+	return this->Assets != nullptr;
+}
+
+List<uint32_t> AssetSearchIndex::Search(const string& Text)
+{
+	return this->Search(AssetSearchQuery::Parse(Text));
+}
+
+List<uint32_t> AssetSearchIndex::Search(const AssetSearchQuery& Query)
+{
+	List<uint32_t> Result;
+
+	if (this->Assets == nullptr)
+		return Result;
+
+	const ApexAsset* Rows = this->Assets->begin();
+	uint32_t RowCount = this->Assets->Count();
+
+	bool IsSingleSubstring = !Query.IsBlacklist && Query.Terms.Count() == 1 && Query.Terms[0].Kind == AssetSearchTerm::TermKind::Substring;
+
+	// Extending the previous term can only narrow its results, so refine those instead
+	if (IsSingleSubstring && this->HasLastResults && Query.TypeMask == this->LastTypeMask && Query.Version == this->LastVersion && Query.Terms[0].Text.Contains(this->LastTerm))
+	{
+		const AssetSearchTerm& Term = Query.Terms[0];
+
+		for (auto& Row : this->LastResults)
+		{
+			if (MatchesTerm(Rows[Row], Term))
+				Result.EmplaceBack(Row);
+		}
+	}
+	else if (!Query.IsBlacklist && Query.Terms.Count() > 0)
+	{
+		// Union the indexed candidates of every term, any term that can't use the index forces a full scan
+		std::vector<uint8_t> Marked(RowCount, 0);
+		bool FullScan = false;
+
+		for (auto& Term : Query.Terms)
+		{
+			if (Term.Kind == AssetSearchTerm::TermKind::Regex || Term.Text.Length() < 3)
+			{
+				FullScan = true;
+				break;
+			}
+
+			List<uint32_t> Candidates;
+
+			if (!this->GetCandidates(Term.Text, Candidates))
+				continue;
+
+			for (auto& Row : Candidates)
+				Marked[Row] = 1;
+		}
+
+		for (uint32_t i = 0; i < RowCount; i++)
+		{
+			if (!FullScan && !Marked[i])
+				continue;
+
+			const ApexAsset& Asset = Rows[i];
+
+			if (!MatchesFilters(Asset, Query))
+				continue;
+
+			for (auto& Term : Query.Terms)
+			{
+				if (MatchesTerm(Asset, Term))
+				{
+					Result.EmplaceBack(i);
+					break;
+				}
+			}
+		}
+	}
+	else
+	{
+		// Blacklists and filter only queries have to visit every row
+		for (uint32_t i = 0; i < RowCount; i++)
+		{
+			const ApexAsset& Asset = Rows[i];
+
+			if (!MatchesFilters(Asset, Query))
+				continue;
+
+			bool IsMatch = true;
+
+			for (auto& Term : Query.Terms)
+			{
+				if (MatchesTerm(Asset, Term))
+				{
+					IsMatch = false;
+					break;
+				}
+			}
+
+			if (IsMatch)
+				Result.EmplaceBack(i);
+		}
+	}
+
+	if (IsSingleSubstring)
+	{
+		this->LastTerm = Query.Terms[0].Text;
+		this->LastTypeMask = Query.TypeMask;
+		this->LastVersion = Query.Version;
+		this->LastResults = Result;
+		this->HasLastResults = true;
+	}
+	else
+	{
+		this->LastResults.Clear();
+		this->HasLastResults = false;
+	}
+
+	return Result;
+}
+
+bool AssetSearchIndex::GetCandidates(const string& Text, List<uint32_t>& Result) const
+{
+	// Collect the posting lists of every trigram in the term
+	List<std::pair<const uint32_t*, const uint32_t*>> Lists;
+
+	for (uint32_t c = 0; c + 3 <= Text.Length(); c++)
+	{
+		const uint32_t* Begin = nullptr;
+		const uint32_t* End = nullptr;
+
+		if (!this->FindPostings(MakeTrigram((const char*)Text + c), Begin, End))
+			return false;
+
+		Lists.EmplaceBack(Begin, End);
+	}
+
+	// Start from the smallest list, then intersect the rest into it
+	Lists.Sort([](const std::pair<const uint32_t*, const uint32_t*>& lhs, const std::pair<const uint32_t*, const uint32_t*>& rhs) { return (lhs.second - lhs.first) < (rhs.second - rhs.first); });
+
+	Result = List<uint32_t>(Lists[0].first, (uint32_t)(Lists[0].second - Lists[0].first));
+
+	for (uint32_t i = 1; i < Lists.Count() && Result.Count() > 0; i++)
+	{
+		List<uint32_t> Intersection;
+
+		for (auto& Row : Result)
+		{
+			if (std::binary_search(Lists[i].first, Lists[i].second, Row))
+				Intersection.EmplaceBack(Row);
+		}
+
+		Result = std::move(Intersection);
+	}
+
+	return Result.Count() > 0;
+}
+
+bool AssetSearchIndex::FindPostings(uint32_t Trigram, const uint32_t*& Begin, const uint32_t*& End) const
+{
+	auto It = std::lower_bound(this->Keys.begin(), this->Keys.end(), Trigram);
+
+	if (It == this->Keys.end() || *It != Trigram)
+		return false;
+
+	size_t KeyIndex = It - this->Keys.begin();
+
+	Begin = this->Postings.data() + this->Offsets[KeyIndex];
+	End = this->Postings.data() + this->Offsets[KeyIndex + 1];
+
+	return true;
+}
+
+bool AssetSearchIndex::MatchesFilters(const ApexAsset& Asset, const AssetSearchQuery& Query)
+{
+	if (Query.TypeMask != 0 && (Query.TypeMask & (1u << (uint32_t)Asset.Type)) == 0)
+		return false;
+	if (Query.Version >= 0 && Asset.Version != (uint32_t)Query.Version)
+		return false;
+
+	return true;
+}
+
+bool AssetSearchIndex::MatchesTerm(const ApexAsset& Asset, const AssetSearchTerm& Term)
+{
+	switch (Term.Kind)
+	{
+	case AssetSearchTerm::TermKind::Prefix:
+		return std::strncmp(Asset.NameLower, Term.Text.ToCString(), Term.Text.Length()) == 0;
+	case AssetSearchTerm::TermKind::Regex:
+		return std::regex_search(Asset.NameLower, *Term.Pattern);
+	default:
+		return std::strstr(Asset.NameLower, Term.Text.ToCString()) != nullptr;
+	}
+}
+
+uint32_t AssetSearchIndex::MakeTrigram(const char* Value)
+{
+	return ((uint32_t)(uint8_t)Value[0] << 16) | ((uint32_t)(uint8_t)Value[1] << 8) | (uint32_t)(uint8_t)Value[2];
+}
@@ -2,10 +2,71 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "ThreadBudget.h"
+#include "ExportWriter.h"
+#include "ExportProgress.h"
 #include <rtech.h>
 #include <animtypes.h>
 
-void RpakLib::BuildAnimInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+// A single section of animation data, read once and then decoded for every frame that lives in it
+struct RpakAnimSection
+{
+	struct BoneTrack
+	{
+		uint32_t BoneIndex;
+		uint8_t Flags;
+		mstudio_rle_anim_t Anim;
+		uint64_t DataOffset;
+	};
+
+	std::vector<uint8_t> BoneFlags;
+	std::vector<uint8_t> TrackData;
+	std::vector<BoneTrack> Tracks;
+
+	// Reads the bone flags and every animated bone track of the section at the given offset
+	void Load(IO::BinaryReader& Reader, uint64_t Offset, uint32_t BoneCount, bool IsAdditive)
+	{
+		IO::Stream* Stream = Reader.GetBaseStream();
+
+		this->BoneFlags.assign(((4 * (uint64_t)BoneCount + 7) / 8 + 1) & 0xFFFFFFFFFFFFFFFE, 0);
+		this->TrackData.clear();
+		this->Tracks.clear();
+
+		Stream->SetPosition(Offset);
+		Stream->Read(this->BoneFlags.data(), 0, this->BoneFlags.size());
+
+		for (uint32_t b = 0; b < BoneCount; b++)
+		{
+			uint8_t Flags = (this->BoneFlags[b / 2] >> (4 * (b % 2))) & 0xF;
+
+			if (!(Flags & (STUDIO_ANIM_BONEPOS | STUDIO_ANIM_BONEROT | STUDIO_ANIM_BONESCALE)))
+				continue;
+
+			BoneTrack Track{ b, Flags, Reader.Read<mstudio_rle_anim_t>(), this->TrackData.size() };
+
+			short sizeToRead = Track.Anim.size > 0 ? Track.Anim.size - sizeof(mstudio_rle_anim_t) : 0;
+
+			if (sizeToRead > 0)
+			{
+				this->TrackData.resize(Track.DataOffset + sizeToRead);
+				Stream->Read(this->TrackData.data(), Track.DataOffset, sizeToRead);
+			}
+
+			// Set this so when we do translations we will know whether or not to add the rest position onto it...
+			Track.Anim.bAdditiveCustom = IsAdditive;
+
+			this->Tracks.push_back(Track);
+		}
+	}
+
+	// Gets the start of a bone's track data
+	uint16_t* GetTrackData(const BoneTrack& Track)
+	{
+		return (uint16_t*)(this->TrackData.data() + Track.DataOffset);
+	}
+};
+
+void RpakLib::BuildAnimInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -42,7 +103,7 @@ void RpakLib::BuildAnimInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
 	}
 }
 
-void RpakLib::BuildRawAnimInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildRawAnimInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -118,12 +179,11 @@ void RpakLib::ExportAnimationRig_V5(const RpakLoadAsset& Asset, const string& Pa
 
 		RpakStream->SetPosition(SkeletonOffset);
 
-		char* skelBuf = new char[studiohdr.bonedataindex + (sizeof(mstudiobonedata_t_v16) * studiohdr.numbones)];
-		Reader.Read(skelBuf, 0, studiohdr.bonedataindex + (sizeof(mstudiobonedata_t_v16) * studiohdr.numbones));
+		uint64_t skelSize = studiohdr.bonedataindex + (sizeof(mstudiobonedata_t_v16) * studiohdr.numbones);
+		auto skelBuf = std::make_unique<uint8_t[]>(skelSize);
+		Reader.Read(skelBuf.get(), 0, skelSize);
 
-		std::ofstream skelOut(IO::Path::Combine(AnimSetPath, AnimSetName + ".rrig"), std::ios::out | std::ios::binary);
-		skelOut.write(skelBuf, studiohdr.bonedataindex + (sizeof(mstudiobonedata_t_v16) * studiohdr.numbones));
-		skelOut.close();
+		ExportWriter::WriteFile(IO::Path::Combine(AnimSetPath, AnimSetName + ".rrig"), std::move(skelBuf), skelSize);
 
 		// ignore for now
 		const uint64_t ReferenceOffset = this->GetFileOffset(Asset, RigHeader.animSeqs);
@@ -166,7 +226,7 @@ void RpakLib::ExportAnimationRig_V5(const RpakLoadAsset& Asset, const string& Pa
 	}
 
 	// version is 99 because it's supposed to only check model version, not arig version
-	const List<Assets::Bone> Skeleton = this->ExtractSkeleton_V16(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99);
+	const List<Assets::Bone> Skeleton = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton_V16(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99); });
 
 	const uint64_t ReferenceOffset = this->GetFileOffset(Asset, RigHeader.animSeqs);
 
@@ -205,7 +265,7 @@ void RpakLib::ExportAnimationRig_V5(const RpakLoadAsset& Asset, const string& Pa
 
 		auto Model = std::make_unique<Assets::Model>(0, 0);
 		Model->Name = AnimSetName;
-		Model->Bones = std::move(this->ExtractSkeleton_V16(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99));
+		Model->Bones = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton_V16(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99); });
 
 		this->ExportQC(Asset, IO::Path::Combine(AnimSetPath, AnimSetName + ".qc"), FullAnimSetName, Model, studioBuf.get(), nullptr);
 	}
@@ -247,12 +307,10 @@ void RpakLib::ExportAnimationRig(const RpakLoadAsset& Asset, const string& Path)
 
 		RpakStream->SetPosition(SkeletonOffset);
 
-		char* skelBuf = new char[studiohdr.length];
-		Reader.Read(skelBuf, 0, studiohdr.length);
+		auto skelBuf = std::make_unique<uint8_t[]>(studiohdr.length);
+		Reader.Read(skelBuf.get(), 0, studiohdr.length);
 
-		std::ofstream skelOut(IO::Path::Combine(AnimSetPath, AnimSetName + ".rrig"), std::ios::out | std::ios::binary);
-		skelOut.write(skelBuf, studiohdr.length);
-		skelOut.close();
+		ExportWriter::WriteFile(IO::Path::Combine(AnimSetPath, AnimSetName + ".rrig"), std::move(skelBuf), studiohdr.length);
 
 		const uint64_t ReferenceOffset = this->GetFileOffset(Asset, RigHeader.animSeqs);
 
@@ -295,7 +353,7 @@ void RpakLib::ExportAnimationRig(const RpakLoadAsset& Asset, const string& Path)
 	}
 
 	// version is 99 because it's supposed to only check model version, not arig version
-	const List<Assets::Bone> Skeleton = this->ExtractSkeleton(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99);
+	const List<Assets::Bone> Skeleton = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99); });
 
 	const uint64_t ReferenceOffset = this->GetFileOffset(Asset, RigHeader.animSeqs);
 
@@ -334,7 +392,7 @@ void RpakLib::ExportAnimationRig(const RpakLoadAsset& Asset, const string& Path)
 
 		auto Model = std::make_unique<Assets::Model>(0, 0);
 		Model->Name = AnimSetName;
-		Model->Bones = std::move(this->ExtractSkeleton(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99));
+		Model->Bones = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton(Reader, this->GetFileOffset(Asset, RigHeader.studioData), 99); });
 
 		this->ExportQC(Asset, IO::Path::Combine(AnimSetPath, AnimSetName + ".qc"), FullAnimSetName, Model, studioBuf.get(), nullptr);
 	}
@@ -370,6 +428,8 @@ string RpakLib::ExtractAnimationRig(const RpakLoadAsset& Asset)
 
 void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bone>& Skeleton, const string& Path)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 
@@ -391,25 +451,33 @@ void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bo
 	uint64_t ActualOptStarpakOffset = Asset.OptimalStarpakOffset & 0xFFFFFFFFFFFFFF00;
 
 	uint64_t starpakDataOffset = 0;
-	std::unique_ptr<IO::FileStream> StarpakStream = nullptr;
 
 	if (Asset.OptimalStarpakOffset != -1)
-	{
 		starpakDataOffset = ActualOptStarpakOffset;
-		StarpakStream = this->GetStarpakStream(Asset, true);
-	}
 	else if (Asset.StarpakOffset != -1)
-	{
 		starpakDataOffset = ActualStarpakOffset;
-		StarpakStream = this->GetStarpakStream(Asset, false);
-	}
-
-	IO::BinaryReader StarpakReader = IO::BinaryReader(StarpakStream.get(), true);
 
 	AnimExportFormat_t AnimFormat = (AnimExportFormat_t)ExportManager::Config.Get<System::SettingType::Integer>("AnimFormat");
 
-	for (uint32_t i = 0; i < seqdesc.numblends; i++)
+	// Blends only share the skeleton, so each one is decoded and exported on its own streams
+	Threading::ThreadBudget::Run(seqdesc.numblends, [&](uint32_t i)
 	{
+		// A canceled export skips the blends that haven't started
+		if (ExportCancellation::IsRequested())
+			return;
+
+		auto RpakStream = this->GetFileStream(Asset);
+		IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
+
+		std::unique_ptr<IO::FileStream> StarpakStream = nullptr;
+
+		if (Asset.OptimalStarpakOffset != -1)
+			StarpakStream = this->GetStarpakStream(Asset, true);
+		else if (Asset.StarpakOffset != -1)
+			StarpakStream = this->GetStarpakStream(Asset, false);
+
+		IO::BinaryReader StarpakReader = IO::BinaryReader(StarpakStream.get(), true);
+
 		RpakStream->SetPosition(seqOffset + seqdesc.animindexindex + ((uint64_t)i * sizeof(uint32_t)));
 
 		int animindex = Reader.Read<int>();
@@ -422,7 +490,7 @@ void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bo
 
 		// unsure what this flag is
 		if (!(animdesc.flags & 0x20000))
-			continue;
+			return;
 
 		Assets::AnimationCurveMode AnimCurveType = Assets::AnimationCurveMode::Absolute;
 
@@ -450,22 +518,16 @@ void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bo
 
 		const uint64_t AnimHeaderPointer = seqOffset + animindex;
 
+		// Frames are stored in sections, each one is read once and then decoded for all of its frames
+		RpakAnimSection Section;
+		int64_t LoadedChunkTableIndex = -1;
+
 		for (uint32_t Frame = 0; Frame < animdesc.numframes; Frame++)
 		{
 			uint32_t ChunkTableIndex = 0;
 			uint32_t ChunkFrame = Frame;
-			uint32_t FrameCountOneLess = 0;
-			uint32_t FirstChunk = animdesc.animindex;
-			uint64_t ChunkDataOffset = 0;
-			uint32_t IsExternal = 0;
-			uint64_t ResultDataPtr = 0;
 
-			if (!animdesc.mediancount)
-			{
-				// Nothing here
-				goto nomedian;
-			}
-			else if (ChunkFrame >= animdesc.sectionframes)
+			if (animdesc.mediancount && ChunkFrame >= animdesc.sectionframes)
 			{
 				uint32_t FrameCount = animdesc.numframes;
 				uint32_t ChunkFrameMinusSplitCount = ChunkFrame - animdesc.sectionframes;
@@ -481,70 +543,52 @@ void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bo
 				}
 			}
 
-			ChunkDataOffset = animdesc.sectionindex + 8 * (uint64_t)ChunkTableIndex;
-
-			RpakStream->SetPosition(AnimHeaderPointer + ChunkDataOffset);
-			FirstChunk = Reader.Read<uint32_t>();
-			IsExternal = Reader.Read<uint32_t>();
-
-			if (IsExternal)
-			{
-				uint64_t v13 = animdesc.somedataoffset;
-				if (v13)
-				{
-					ResultDataPtr = v13 + FirstChunk;
-				}
-				else
-				{
-					ResultDataPtr = starpakDataOffset + FirstChunk;
-				}
-			}
-			else
-			{
-			nomedian:
-				ResultDataPtr = AnimHeaderPointer + FirstChunk;
-			}
-
-			char boneFlagData[256]{};
-
-			if (IsExternal)
-			{
-				StarpakStream->SetPosition(ResultDataPtr);
-				StarpakStream->Read((uint8_t*)boneFlagData, 0, ((4 * (uint64_t)Skeleton.Count() + 7) / 8 + 1) & 0xFFFFFFFFFFFFFFFE);
-			}
-			else
-			{
-				RpakStream->SetPosition(ResultDataPtr);
-				RpakStream->Read((uint8_t*)boneFlagData, 0, ((4 * (uint64_t)Skeleton.Count() + 7) / 8 + 1) & 0xFFFFFFFFFFFFFFFE);
-			}
-
-			IO::BinaryReader* currentReader = IsExternal ? &StarpakReader : &Reader;
-
-			for (uint32_t b = 0; b < Skeleton.Count(); b++)
+			if (ChunkTableIndex != LoadedChunkTableIndex)
 			{
-				uint32_t Shift = 4 * (b % 2);
-				char boneFlags = boneFlagData[b / 2] >> Shift;
+				uint32_t FirstChunk = animdesc.animindex;
+				uint32_t IsExternal = 0;
+				uint64_t ResultDataPtr = AnimHeaderPointer + FirstChunk;
 
-				if (boneFlags & 0x7)
+				if (animdesc.mediancount)
 				{
-					mstudio_rle_anim_t anim = currentReader->Read<mstudio_rle_anim_t>();
-
-					short sizeToRead = anim.size > 0 ? anim.size - sizeof(mstudio_rle_anim_t) : 0;
+					uint64_t ChunkDataOffset = animdesc.sectionindex + 8 * (uint64_t)ChunkTableIndex;
 
-					std::unique_ptr<uint8_t[]> boneTrackData = currentReader->Read(sizeToRead);
+					RpakStream->SetPosition(AnimHeaderPointer + ChunkDataOffset);
+					FirstChunk = Reader.Read<uint32_t>();
+					IsExternal = Reader.Read<uint32_t>();
 
-					uint16_t* BoneTrackDataPtr = (uint16_t*)boneTrackData.get();
+					if (IsExternal)
+					{
+						uint64_t v13 = animdesc.somedataoffset;
+						if (v13)
+						{
+							ResultDataPtr = v13 + FirstChunk;
+						}
+						else
+						{
+							ResultDataPtr = starpakDataOffset + FirstChunk;
+						}
+					}
+					else
+					{
+						ResultDataPtr = AnimHeaderPointer + FirstChunk;
+					}
+				}
 
-					// this flag does not exist
-					anim.bAdditiveCustom = (AnimCurveType == Assets::AnimationCurveMode::Additive);
+				Section.Load(IsExternal ? StarpakReader : Reader, ResultDataPtr, Skeleton.Count(), AnimCurveType == Assets::AnimationCurveMode::Additive);
+				LoadedChunkTableIndex = ChunkTableIndex;
+			}
 
-					if (boneFlags & STUDIO_ANIM_BONEPOS)
-						CalcBonePosition(anim, &BoneTrackDataPtr, Anim, b, ChunkFrame, Frame);
-					if (boneFlags & STUDIO_ANIM_BONEROT)
-						CalcBoneQuaternion(anim, &BoneTrackDataPtr, Anim, b, ChunkFrame, Frame);
-					if (boneFlags & STUDIO_ANIM_BONESCALE)
-						CalcBoneScale(anim, &BoneTrackDataPtr, Anim, b, ChunkFrame, Frame);
-				}
+			for (auto& Track : Section.Tracks)
+			{
+				uint16_t* BoneTrackDataPtr = Section.GetTrackData(Track);
+
+				if (Track.Flags & STUDIO_ANIM_BONEPOS)
+					CalcBonePosition(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, ChunkFrame, Frame);
+				if (Track.Flags & STUDIO_ANIM_BONEROT)
+					CalcBoneQuaternion(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, ChunkFrame, Frame);
+				if (Track.Flags & STUDIO_ANIM_BONESCALE)
+					CalcBoneScale(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, ChunkFrame, Frame);
 			}
 		}
 
@@ -562,16 +606,21 @@ void RpakLib::ExtractAnimation(const RpakLoadAsset& Asset, const List<Assets::Bo
 		try
 		{
 			if (Utils::ShouldWriteFile(DestinationPath))
+			{
+				ExportProfileScope Profile(ExportStage::ExportAnimation);
 				this->AnimExporter->ExportAnimation(*Anim.get(), DestinationPath);
+			}
 		}
 		catch (...)
 		{
 		}
-	}
+	});
 }
 
 void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets::Bone>& Skeleton, const string& Path)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 
@@ -593,27 +642,34 @@ void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets
 	uint64_t ActualOptStarpakOffset = Asset.OptimalStarpakOffset & 0xFFFFFFFFFFFFFF00;
 
 	uint64_t starpakDataOffset = 0;
-	std::unique_ptr<IO::FileStream> StarpakStream = nullptr;
 
 	if (Asset.OptimalStarpakOffset != -1)
-	{
 		starpakDataOffset = ActualOptStarpakOffset;
-		StarpakStream = this->GetStarpakStream(Asset, true);
-	}
 	else if (Asset.StarpakOffset != -1)
-	{
 		starpakDataOffset = ActualStarpakOffset;
-		StarpakStream = this->GetStarpakStream(Asset, false);
-	}
-
-	IO::BinaryReader StarpakReader = IO::BinaryReader(StarpakStream.get(), true);
 
 	AnimExportFormat_t AnimFormat = (AnimExportFormat_t)ExportManager::Config.Get<System::SettingType::Integer>("AnimFormat");
 
-	for (uint32_t i = 0; i < seqdesc.numblends; i++)
+	// Blends only share the skeleton, so each one is decoded and exported on its own streams
+	Threading::ThreadBudget::Run(seqdesc.numblends, [&](uint32_t i)
 	{
+		if (ExportCancellation::IsRequested())
+			return;
+
 		if (AnimFormat == AnimExportFormat_t::SMD && i > 1)
-			continue;
+			return;
+
+		auto RpakStream = this->GetFileStream(Asset);
+		IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
+
+		std::unique_ptr<IO::FileStream> StarpakStream = nullptr;
+
+		if (Asset.OptimalStarpakOffset != -1)
+			StarpakStream = this->GetStarpakStream(Asset, true);
+		else if (Asset.StarpakOffset != -1)
+			StarpakStream = this->GetStarpakStream(Asset, false);
+
+		IO::BinaryReader StarpakReader = IO::BinaryReader(StarpakStream.get(), true);
 
 		// sizeof(VAR) needs to match animindex!!!!!!
 		RpakStream->SetPosition(seqOffset + seqdesc.animindexindex + ((uint64_t)i * sizeof(short)));
@@ -629,7 +685,7 @@ void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets
 
 		// unsure what this flag is
 		if (!(animdesc.flags & 0x20000))
-			continue;
+			return;
 
 		std::unique_ptr<Assets::Animation> Anim = std::make_unique<Assets::Animation>(Skeleton.Count());
 
@@ -657,21 +713,16 @@ void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets
 
 		const uint64_t animDescPtr = seqOffset + animindex;
 
+		// Frames are stored in sections, each one is read once and then decoded for all of its frames
+		RpakAnimSection Section;
+		int loadedSectionIdx = -1;
+
 		for (uint32_t frameIdx = 0; frameIdx < animdesc.numframes; frameIdx++)
 		{
 			int sectionIdx = 0; // the index of the section we are in
 			short sectionFrameIdx = frameIdx; // frame index for sections
-			int sectionOffset = 0; // offset into current section
-			uint64_t ResultDataPtr = 0; // ptr to the data
-			int AnimIndex = animdesc.animindex; // offset to animation or first section if section animation
-			bool IsExternal = false; // if this is a section, is the section outside of the actual sequence
 
-			if (!animdesc.sectionframes)
-			{
-				// Nothing here
-				goto nomedian;
-			}
-			else if (sectionFrameIdx >= animdesc.sectionstaticframes)
+			if (animdesc.sectionframes && sectionFrameIdx >= animdesc.sectionstaticframes)
 			{
 				uint32_t sectionFrameMinusSplitCount = sectionFrameIdx - animdesc.sectionstaticframes; // I don't really know what unk2 is for but porter uses it so *shrug*
 				if (animdesc.numframes <= animdesc.sectionstaticframes || sectionFrameIdx != animdesc.numframes - 1)
@@ -686,67 +737,47 @@ void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets
 				}
 			}
 
-			// Make sure sizeof(VAR) is right datatype!!!
-			sectionOffset = animdesc.sectionindex + sizeof(int) * sectionIdx;
-
-			RpakStream->SetPosition(animDescPtr + sectionOffset);
-			AnimIndex = Reader.Read<int>();
-
-			if (AnimIndex < 0 && StarpakStream)
-			{
-				AnimIndex = abs(AnimIndex) - 1;
-
-				ResultDataPtr = starpakDataOffset + AnimIndex;
-				IsExternal = true;
-			}
-			else
-			{
-			nomedian:
-				IsExternal = false;
-				ResultDataPtr = animDescPtr + AnimIndex;
-			}
-
-			// I have a really bad feeling we will see > 256 bones sooner than later
-			char boneFlagData[256]{};
-
-			if (IsExternal)
-			{
-				StarpakStream->SetPosition(ResultDataPtr);
-				StarpakStream->Read((uint8_t*)boneFlagData, 0, ((4 * (uint64_t)Skeleton.Count() + 7) / 8 + 1) & 0xFFFFFFFFFFFFFFFE);
-			}
-			else
-			{
-				RpakStream->SetPosition(ResultDataPtr);
-				RpakStream->Read((uint8_t*)boneFlagData, 0, ((4 * (uint64_t)Skeleton.Count() + 7) / 8 + 1) & 0xFFFFFFFFFFFFFFFE);
-			}
-
-			IO::BinaryReader* currentReader = IsExternal ? &StarpakReader : &Reader;
-
-			for (uint32_t b = 0; b < Skeleton.Count(); b++)
+			if (sectionIdx != loadedSectionIdx)
 			{
-				uint32_t Shift = 4 * (b % 2);
-				char BoneTrackFlags = boneFlagData[b / 2] >> Shift;
+				int AnimIndex = animdesc.animindex; // offset to animation or first section if section animation
+				bool IsExternal = false; // if this is a section, is the section outside of the actual sequence
+				uint64_t ResultDataPtr = 0; // ptr to the data
 
-				if (BoneTrackFlags & (STUDIO_ANIM_BONEPOS | STUDIO_ANIM_BONEROT | STUDIO_ANIM_BONESCALE))
+				if (animdesc.sectionframes)
 				{
-					mstudio_rle_anim_t anim = currentReader->Read<mstudio_rle_anim_t>();
+					// Make sure sizeof(VAR) is right datatype!!!
+					int sectionOffset = animdesc.sectionindex + sizeof(int) * sectionIdx;
 
-					short sizeToRead = anim.size > 0 ? anim.size - sizeof(mstudio_rle_anim_t) : 0;
+					RpakStream->SetPosition(animDescPtr + sectionOffset);
+					AnimIndex = Reader.Read<int>();
+				}
 
-					std::unique_ptr<uint8_t[]> boneTrackData = currentReader->Read(sizeToRead);
+				if (animdesc.sectionframes && AnimIndex < 0 && StarpakStream)
+				{
+					AnimIndex = abs(AnimIndex) - 1;
 
-					uint16_t* BoneTrackDataPtr = (uint16_t*)boneTrackData.get();
+					ResultDataPtr = starpakDataOffset + AnimIndex;
+					IsExternal = true;
+				}
+				else
+				{
+					ResultDataPtr = animDescPtr + AnimIndex;
+				}
 
-					// Set this so when we do translations we will know whether or not to add the rest position onto it...
-					anim.bAdditiveCustom = (AnimCurveType == Assets::AnimationCurveMode::Additive);
+				Section.Load(IsExternal ? StarpakReader : Reader, ResultDataPtr, Skeleton.Count(), AnimCurveType == Assets::AnimationCurveMode::Additive);
+				loadedSectionIdx = sectionIdx;
+			}
 
-					if (BoneTrackFlags & STUDIO_ANIM_BONEPOS)
-						CalcBonePosition(anim, &BoneTrackDataPtr, Anim, b, sectionFrameIdx, frameIdx);
-					if (BoneTrackFlags & STUDIO_ANIM_BONEROT)
-						CalcBoneQuaternion(anim, &BoneTrackDataPtr, Anim, b, sectionFrameIdx, frameIdx);
-					if (BoneTrackFlags & STUDIO_ANIM_BONESCALE)
-						CalcBoneScale(anim, &BoneTrackDataPtr, Anim, b, sectionFrameIdx, frameIdx);
-				}
+			for (auto& Track : Section.Tracks)
+			{
+				uint16_t* BoneTrackDataPtr = Section.GetTrackData(Track);
+
+				if (Track.Flags & STUDIO_ANIM_BONEPOS)
+					CalcBonePosition(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, sectionFrameIdx, frameIdx);
+				if (Track.Flags & STUDIO_ANIM_BONEROT)
+					CalcBoneQuaternion(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, sectionFrameIdx, frameIdx);
+				if (Track.Flags & STUDIO_ANIM_BONESCALE)
+					CalcBoneScale(Track.Anim, &BoneTrackDataPtr, Anim, Track.BoneIndex, sectionFrameIdx, frameIdx);
 			}
 		}
 
@@ -765,12 +796,15 @@ void RpakLib::ExtractAnimation_V11(const RpakLoadAsset& Asset, const List<Assets
 		try
 		{
 			if (Utils::ShouldWriteFile(DestinationPath))
+			{
+				ExportProfileScope Profile(ExportStage::ExportAnimation);
 				this->AnimExporter->ExportAnimation(*Anim.get(), DestinationPath);
+			}
 		}
 		catch (...)
 		{
 		}
-	}
+	});
 }
 
 void RpakLib::ExportAnimationSeq(const RpakLoadAsset& Asset, const string& Path)
@@ -990,33 +1024,27 @@ void RpakLib::ExportAnimationSeq(const RpakLoadAsset& Asset, const string& Path)
 	uint64_t RSeqSize = RpakStream->GetPosition() - AnimationOffset;
 
 	RpakStream->SetPosition(AnimationOffset);
-	char* rseqBuf = new char[RSeqSize];
-	Reader.Read(rseqBuf, 0, RSeqSize);
+	auto rseqBuf = std::make_unique<uint8_t[]>(RSeqSize);
+	Reader.Read(rseqBuf.get(), 0, RSeqSize);
 
-	std::ofstream rseqOut(AnimSetPath, std::ios::out | std::ios::binary);
-	rseqOut.write(rseqBuf, RSeqSize);
-	rseqOut.close();
+	ExportWriter::WriteFile(AnimSetPath, std::move(rseqBuf), RSeqSize);
 
 	// WIP EXTERNAL DATA
 	if (AnHeader.pExternalData.Index || AnHeader.externalDataSize)
 	{
-		char* externalBuf = new char[AnHeader.externalDataSize];
+		auto externalBuf = std::make_unique<uint8_t[]>(AnHeader.externalDataSize);
 
 		if (StarpakStream != nullptr)
 		{
 			StarpakStream->SetPosition(starpakDataOffset);
-			StarpakStream->Read((uint8_t*)externalBuf, 0, AnHeader.externalDataSize);
+			StarpakStream->Read(externalBuf.get(), 0, AnHeader.externalDataSize);
 		}
 		else
 		{
 			RpakStream->SetPosition(this->GetFileOffset(Asset, AnHeader.pExternalData));
-			RpakStream->Read((uint8_t*)externalBuf, 0, AnHeader.externalDataSize);
+			RpakStream->Read(externalBuf.get(), 0, AnHeader.externalDataSize);
 		}
 
-		std::ofstream externalOut(IO::Path::ChangeExtension(AnimSetPath, ".rseq_ext"), std::ios::out | std::ios::binary);
-		externalOut.write(externalBuf, AnHeader.externalDataSize);
-		externalOut.close();
-
-		delete[] externalBuf;
+		ExportWriter::WriteFile(IO::Path::ChangeExtension(AnimSetPath, ".rseq_ext"), std::move(externalBuf), AnHeader.externalDataSize);
 	}
 }
\ No newline at end of file
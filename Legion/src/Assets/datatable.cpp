@@ -2,8 +2,9 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "File.h"
 
-void RpakLib::BuildDataTableInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildDataTableInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -41,22 +42,20 @@ void RpakLib::ExportDataTable(const RpakLoadAsset& Asset, const string& Path)
 
 	List<List<DataTableColumnData>> DataTable = this->ExtractDataTable(Asset);
 
-	std::ofstream dtbl_out(DestinationPath.ToCString(), std::ios::out);
+	IO::BufferedTextWriter dtbl_out(IO::File::Create(DestinationPath), true);
 
 	for (uint32_t i = 0; i < DataTable.Count(); ++i)
 	{
-		List<DataTableColumnData> Row = DataTable[i];
+		auto& Row = DataTable[i];
 
 		for (uint32_t c = 0; c < Row.Count(); ++c)
 		{
-			DataTableColumnData cd = Row[c];
+			auto& cd = Row[c];
 
 			switch (cd.Type)
 			{
 			case DataTableColumnDataType::Bool:
-				if (cd.bValue)
-					dtbl_out << "true";
-				else dtbl_out << "false";
+				dtbl_out << cd.bValue;
 				break;
 			case DataTableColumnDataType::Int:
 				dtbl_out << cd.iValue;
@@ -66,40 +65,40 @@ void RpakLib::ExportDataTable(const RpakLoadAsset& Asset, const string& Path)
 				break;
 			case DataTableColumnDataType::Vector:
 			{
-				dtbl_out << "\"<" << cd.vValue.X << "," << cd.vValue.Y << "," << cd.vValue.Z << ">\"";
+				dtbl_out << "\"<" << cd.vValue.X << ',' << cd.vValue.Y << ',' << cd.vValue.Z << ">\"";
 				break;
 			}
 			case DataTableColumnDataType::Asset:
 			{
-				dtbl_out << "\"" + cd.assetValue + "\"";
+				dtbl_out << '"' << cd.assetValue << '"';
 				break;
 			}
 			case DataTableColumnDataType::AssetNoPrecache:
 			{
-				dtbl_out << "\"" + cd.assetNPValue + "\"";
+				dtbl_out << '"' << cd.assetNPValue << '"';
 				break;
 			}
 			case DataTableColumnDataType::StringT:
 			{
-				dtbl_out << "\"" + cd.stringValue + "\"";
+				dtbl_out << '"' << cd.stringValue << '"';
 				break;
 			}
 			}
 			if (c != Row.Count() - 1)
 			{
-				dtbl_out << ",";
+				dtbl_out << ',';
 			}
 			else {
-				dtbl_out << "\n";
+				dtbl_out << '\n';
 			}
 		}
 	}
 
-	auto LastExport = DataTable[DataTable.Count() - 1];
+	auto& LastExport = DataTable[DataTable.Count() - 1];
 
 	for (uint32_t c = 0; c < LastExport.Count(); ++c)
 	{
-		DataTableColumnData cd = LastExport[c];
+		auto& cd = LastExport[c];
 
 		switch (cd.Type)
 		{
@@ -136,12 +135,12 @@ void RpakLib::ExportDataTable(const RpakLoadAsset& Asset, const string& Path)
 		}
 
 		if (c != LastExport.Count() - 1)
-			dtbl_out << ",";
+			dtbl_out << ',';
 		else
-			dtbl_out << "\n";
+			dtbl_out << '\n';
 	}
 
-	dtbl_out.close();
+	dtbl_out.Close();
 }
 
 List<List<DataTableColumnData>> RpakLib::ExtractDataTable(const RpakLoadAsset& Asset)
@@ -5,7 +5,7 @@
 #include <rtech.h>
 
 // N1094_CL456479 (Season 3 Launch) won't work with this because the base rpak (effects.rpak) is patched itself.
-void RpakLib::BuildEffectInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildEffectInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -20,7 +20,7 @@ const char* s_MaterialTypes[] = {
 	"RGBS",
 };
 
-void RpakLib::BuildMaterialInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildMaterialInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -255,6 +255,8 @@ void RpakLib::ExportMaterial(const RpakLoadAsset& Asset, const string& Path)
 
 RMdlMaterial RpakLib::ExtractMaterial(const RpakLoadAsset& Asset, const string& Path, bool IncludeImages, bool IncludeImageNames, bool silent)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	RMdlMaterial Result;
 
 	auto RpakStream = this->GetFileStream(Asset);
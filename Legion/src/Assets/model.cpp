@@ -2,9 +2,12 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "ThreadBudget.h"
+#include "ExportWriter.h"
+#include "ExportProgress.h"
 #include <rtech.h>
 
-void RpakLib::BuildModelInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildModelInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -96,17 +99,23 @@ void RpakLib::ExportModel(const RpakLoadAsset& Asset, const string& Path, const
 	IO::Directory::CreateDirectory(Path);
 	auto Model = this->ExtractModel(Asset, Path, AnimPath, true, true);
 
-	if (Model && this->ModelExporter)
+	// A model extracted while the export was canceled may be missing meshes
+	if (Model && this->ModelExporter && !ExportCancellation::IsRequested())
 	{
 		string DestinationPath = IO::Path::Combine(IO::Path::Combine(Path, Model->Name), Model->Name + "_LOD0" + (const char*)ModelExporter->ModelExtension());
 
 		if (Utils::ShouldWriteFile(DestinationPath))
+		{
+			ExportProfileScope Profile(ExportStage::ExportModel);
 			this->ModelExporter->ExportModel(*Model.get(), DestinationPath);
+		}
 	}
 }
 
 std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& Asset, const string& Path, const string& AnimPath, bool IncludeMaterials, bool IncludeAnimations)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 	auto Model = std::make_unique<Assets::Model>(0, 0);
@@ -208,22 +217,21 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 
 			RpakStream->SetPosition(PhyOffset);
 
-			char* phyBuf = new char[PhySize];
+			auto phyBuf = std::make_unique<uint8_t[]>(PhySize);
 
-			Reader.Read(phyBuf, 0, PhySize);
+			Reader.Read(phyBuf.get(), 0, PhySize);
 
-			std::ofstream phyOut(BaseFileName + ".phy", std::ios::out | std::ios::binary);
-			phyOut.write(phyBuf, PhySize);
-			phyOut.close();
+			ExportWriter::WriteFile(BaseFileName + ".phy", std::move(phyBuf), PhySize);
 		}
 
-		std::ofstream rmdlOut(BaseFileName + ".rmdl", std::ios::out | std::ios::binary);
+		// The studio data is still needed for the qc, the writer gets its own copy
+		auto rmdlBuf = std::make_unique<uint8_t[]>(cpuData.modelLength);
+		std::memcpy(rmdlBuf.get(), studioBuf.get(), cpuData.modelLength);
 
-		rmdlOut.write(studioBuf.get(), cpuData.modelLength);
-		rmdlOut.close();
+		ExportWriter::WriteFile(BaseFileName + ".rmdl", std::move(rmdlBuf), cpuData.modelLength);
 	}
 
-	Model->Bones = std::move(ExtractSkeleton_V16(Reader, StudioOffset, Asset.AssetVersion, Asset.SubHeaderSize));
+	Model->Bones = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton_V16(Reader, StudioOffset, Asset.AssetVersion, Asset.SubHeaderSize); });
 
 	if (!bExportingRawRMdl)
 		Model->GenerateGlobalTransforms(true, true); // We need global transforms
@@ -234,6 +242,8 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 
 		RpakStream->SetPosition(this->GetFileOffset(Asset, mdlHdr.animSeqs.Index, mdlHdr.animSeqs.Offset));
 
+		List<uint64_t> AnimHashes;
+
 		for (uint32_t i = 0; i < mdlHdr.animSeqCount; i++)
 		{
 			uint64_t AnimHash = Reader.Read<uint64_t>();
@@ -241,12 +251,17 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 			if (!Assets.ContainsKey(AnimHash))
 				continue;	// Should never happen
 
-			// We need to make sure the skeleton is kept alive (copied) here...
+			AnimHashes.EmplaceBack(AnimHash);
+		}
+
+		// The skeleton is finished and only read from here on, so sequences can export side by side
+		Threading::ThreadBudget::Run(AnimHashes.Count(), [&](uint32_t i)
+		{
 			if (!bExportingRawRMdl)
-				this->ExtractAnimation_V11(Assets[AnimHash], Model->Bones, AnimationPath);
+				this->ExtractAnimation_V11(Assets[AnimHashes[i]], Model->Bones, AnimationPath);
 			else
-				this->ExportAnimationSeq(Assets[AnimHash], AnimationPath);
-		}
+				this->ExportAnimationSeq(Assets[AnimHashes[i]], AnimationPath);
+		});
 	}
 
 	RpakStream->SetPosition(StudioOffset);
@@ -329,9 +344,9 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 	size_t lodSize = 0;
 	size_t cmpSize = 0;
 
-	size_t streamedDataSize = this->LoadedFiles[Asset.FileIndex].StarpakMap[Asset.StarpakOffset];
+	uint64_t streamedDataSize = 0;
 
-	if (this->LoadedFiles[Asset.FileIndex].StarpakMap.ContainsKey(Asset.StarpakOffset))
+	if (this->LoadedFiles[Asset.FileIndex].TryGetStarpakEntrySize(Asset.StarpakOffset, streamedDataSize, false))
 	{
 		IO::Stream* StarpakStream = StarpakReader.GetBaseStream();
 
@@ -360,6 +375,9 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 				// this is purely for getting the full vg, has nothing to do with actual model export
 				for (const auto& lod : lods)
 				{
+					if (ExportCancellation::IsRequested())
+						return nullptr;
+
 					cmpSize = lod.vgsizedecompressed;
 
 					// DecompressStreamedBuffer deletes the buffer, no need to free it.
@@ -398,9 +416,7 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 			return nullptr;
 		}
 
-		std::ofstream vgOut(BaseFileName + ".vg", std::ios::out | std::ios::binary);
-		vgOut.write((char*)dcmpBuf.get(), lodSize);
-		vgOut.close();
+		ExportWriter::WriteFile(BaseFileName + ".vg", std::move(dcmpBuf), lodSize);
 		return nullptr;
 	}
 
@@ -505,6 +521,8 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel_V16(const RpakLoadAsset& As
 
 std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset, const string& Path, const string& AnimPath, bool IncludeMaterials, bool IncludeAnimations)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	if (Asset.AssetVersion >= 16)
 		return this->ExtractModel_V16(Asset, Path, AnimPath, IncludeMaterials, IncludeAnimations);
 
@@ -626,22 +644,21 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset,
 
 			RpakStream->SetPosition(PhyOffset);
 
-			char* phyBuf = new char[PhySize];
+			auto phyBuf = std::make_unique<uint8_t[]>(PhySize);
 
-			Reader.Read(phyBuf, 0, PhySize);
+			Reader.Read(phyBuf.get(), 0, PhySize);
 
-			std::ofstream phyOut(BaseFileName + ".phy", std::ios::out | std::ios::binary);
-			phyOut.write(phyBuf, PhySize);
-			phyOut.close();
+			ExportWriter::WriteFile(BaseFileName + ".phy", std::move(phyBuf), PhySize);
 		}
 
-		std::ofstream rmdlOut(BaseFileName + ".rmdl", std::ios::out | std::ios::binary);
+		// The studio data is still needed for the qc, the writer gets its own copy
+		auto rmdlBuf = std::make_unique<uint8_t[]>(studiohdr.length);
+		std::memcpy(rmdlBuf.get(), studioBuf.get(), studiohdr.length);
 
-		rmdlOut.write(studioBuf.get(), studiohdr.length);
-		rmdlOut.close();
+		ExportWriter::WriteFile(BaseFileName + ".rmdl", std::move(rmdlBuf), studiohdr.length);
 	}
 
-	Model->Bones = std::move(ExtractSkeleton(Reader, StudioOffset, Asset.AssetVersion, Asset.SubHeaderSize));
+	Model->Bones = *this->SkeletonCache.Get(Asset.NameHash, [&] { return this->ExtractSkeleton(Reader, StudioOffset, Asset.AssetVersion, Asset.SubHeaderSize); });
 
 	if (!bExportingRawRMdl)
 		Model->GenerateGlobalTransforms(true, true); // We need global transforms
@@ -652,6 +669,8 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset,
 
 		RpakStream->SetPosition(this->GetFileOffset(Asset, mdlHdr.animSeqs.Index, mdlHdr.animSeqs.Offset));
 
+		List<uint64_t> AnimHashes;
+
 		for (uint32_t i = 0; i < mdlHdr.animSeqCount; i++)
 		{
 			uint64_t AnimHash = Reader.Read<uint64_t>();
@@ -659,12 +678,17 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset,
 			if (!Assets.ContainsKey(AnimHash))
 				continue;	// Should never happen
 
-			// We need to make sure the skeleton is kept alive (copied) here...
+			AnimHashes.EmplaceBack(AnimHash);
+		}
+
+		// The skeleton is finished and only read from here on, so sequences can export side by side
+		Threading::ThreadBudget::Run(AnimHashes.Count(), [&](uint32_t i)
+		{
 			if (!bExportingRawRMdl)
-				this->ExtractAnimation(Assets[AnimHash], Model->Bones, AnimationPath);
+				this->ExtractAnimation(Assets[AnimHashes[i]], Model->Bones, AnimationPath);
 			else
-				this->ExportAnimationSeq(Assets[AnimHash], AnimationPath);
-		}
+				this->ExportAnimationSeq(Assets[AnimHashes[i]], AnimationPath);
+		});
 	}
 
 	RpakStream->SetPosition(StudioOffset);
@@ -815,14 +839,11 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset,
 			auto VGHeader = StarpakReader.Read<RMdlVGHeaderOld>();
 
 			StarpakStream->SetPosition(Offset);
-			char* vgBuf = new char[VGHeader.DataSize];
-
-			StarpakReader.Read(vgBuf, 0, VGHeader.DataSize);
+			auto vgBuf = std::make_unique<uint8_t[]>(VGHeader.DataSize);
 
-			std::ofstream vgOut(BaseFileName + ".vg", std::ios::out | std::ios::binary);
+			StarpakReader.Read(vgBuf.get(), 0, VGHeader.DataSize);
 
-			vgOut.write(vgBuf, VGHeader.DataSize);
-			vgOut.close();
+			ExportWriter::WriteFile(BaseFileName + ".vg", std::move(vgBuf), VGHeader.DataSize);
 
 			//RpakStream->SetPosition(StudioOffset);
 			//
@@ -877,14 +898,11 @@ std::unique_ptr<Assets::Model> RpakLib::ExtractModel(const RpakLoadAsset& Asset,
 			if (dataSize)
 			{
 				StarpakStream->SetPosition(Offset);
-				char* vgBuf = new char[dataSize];
+				auto vgBuf = std::make_unique<uint8_t[]>(dataSize);
 
-				StarpakReader.Read(vgBuf, 0, dataSize);
+				StarpakReader.Read(vgBuf.get(), 0, dataSize);
 
-				std::ofstream vgOut(BaseFileName + ".vg", std::ios::out | std::ios::binary);
-
-				vgOut.write(vgBuf, dataSize);
-				vgOut.close();
+				ExportWriter::WriteFile(BaseFileName + ".vg", std::move(vgBuf), dataSize);
 			}
 		}
 
@@ -938,6 +956,10 @@ void RpakLib::ExtractModelLod_V16(IO::BinaryReader& Reader, const std::unique_pt
 	// Loop and read meshes
 	for (uint32_t s = 0; s < vg.nummeshes; s++)
 	{
+		// Canceled exports drop the model, so the remaining meshes can be skipped
+		if (ExportCancellation::IsRequested())
+			return;
+
 		VGMesh_t_v16& mesh = MeshBuffer[s];
 
 		// We have buffers per mesh now thank god
@@ -1129,6 +1151,9 @@ void RpakLib::ExtractModelLod_V14(IO::BinaryReader& Reader, const std::unique_pt
 	// Loop and read meshes
 	for (uint32_t s = 0; s < lod.meshCount; s++)
 	{
+		if (ExportCancellation::IsRequested())
+			return;
+
 		RMdlVGMesh_V14& mesh = MeshBuffer[s];
 
 		// We have buffers per mesh now thank god
@@ -1397,6 +1422,9 @@ void RpakLib::ExtractModelLod(IO::BinaryReader& Reader, const std::unique_ptr<IO
 	// Loop and read meshes
 	for (uint32_t s = 0; s < lod.meshCount; s++)
 	{
+		if (ExportCancellation::IsRequested())
+			return;
+
 		RMdlVGMesh& mesh = MeshBuffer[s];
 
 		// We have buffers per mesh now thank god
@@ -1680,6 +1708,9 @@ void RpakLib::ExtractModelLodOld(IO::BinaryReader& Reader, const std::unique_ptr
 	// Loop and read submeshes
 	for (uint32_t s = LodSubmeshStart; s < LodSubmeshCount; s++)
 	{
+		if (ExportCancellation::IsRequested())
+			return;
+
 		auto& Submesh = SubmeshBuffer[s];
 
 		// Ignore a submesh that has no strips, otherwise there is no mesh.
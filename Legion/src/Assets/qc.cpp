@@ -7,7 +7,7 @@ const std::vector<std::string> MaterialTypes = { "_rgdu", "_rgdp", "_rgdc", "_sk
 
 #define RadiansToDegrees(r) ((r / Math::MathHelper::PI) * 180.0f)
 
-void WriteCommonJiggle(IO::StreamWriter& qc, mstudiojigglebonev54_t*& JiggleBone)
+void WriteCommonJiggle(IO::BufferedTextWriter& qc, mstudiojigglebonev54_t*& JiggleBone)
 {
 	if (JiggleBone->length)
 		qc.WriteFmt("\t\tlength %.4f\n", JiggleBone->length);
@@ -37,7 +37,7 @@ void WriteCommonJiggle(IO::StreamWriter& qc, mstudiojigglebonev54_t*& JiggleBone
 		qc.WriteFmt("\t\tpitch_bounce %.4f\n", JiggleBone->pitchBounce);
 }
 
-void WriteJiggleBoneData(IO::StreamWriter& qc, mstudiojigglebonev54_t*& JiggleBone)
+void WriteJiggleBoneData(IO::BufferedTextWriter& qc, mstudiojigglebonev54_t*& JiggleBone)
 {
 	if (JiggleBone->flags & JIGGLE_IS_FLEXIBLE)
 	{
@@ -110,7 +110,7 @@ void SMDWriteRefAnim(const string& Path, const List<Assets::Bone>& Bones, string
 {
 	string RefPath = IO::Path::Combine(IO::Path::GetDirectoryName(Path), (Name + "_ref.smd"));
 
-	IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(RefPath));
+	IO::BufferedTextWriter Writer = IO::BufferedTextWriter(IO::File::Create(RefPath));
 
 	Writer.WriteLine(
 		"version 1\n"
@@ -136,7 +136,9 @@ void SMDWriteRefAnim(const string& Path, const List<Assets::Bone>& Bones, string
 	for (Assets::Bone& Bone : Bones)
 	{
 		auto Euler = Bone.LocalRotation().ToEulerAngles();
-		Writer.WriteLineFmt("\t%d %f %f %f %f %f %f", BoneIndex, Bone.LocalPosition().X, Bone.LocalPosition().Y, Bone.LocalPosition().Z, Math::MathHelper::DegreesToRadians(Euler.X), Math::MathHelper::DegreesToRadians(Euler.Y), Math::MathHelper::DegreesToRadians(Euler.Z));
+		Writer << '\t' << BoneIndex << ' ' << Bone.LocalPosition().X << ' ' << Bone.LocalPosition().Y << ' ' << Bone.LocalPosition().Z;
+		Writer << ' ' << Math::MathHelper::DegreesToRadians(Euler.X) << ' ' << Math::MathHelper::DegreesToRadians(Euler.Y) << ' ' << Math::MathHelper::DegreesToRadians(Euler.Z);
+		Writer.WriteLine();
 		BoneIndex++;
 	}
 
@@ -167,7 +169,7 @@ void RpakLib::ExportQC(const RpakLoadAsset& Asset, const string& Path, const str
 	}
 	else extention = this->ModelExporter->ModelExtension();
 
-	IO::StreamWriter qc(IO::File::Create(Path));
+	IO::BufferedTextWriter qc(IO::File::Create(Path));
 
 	s3studiohdr_t hdr{};
 
@@ -716,7 +718,7 @@ void RpakLib::ExportQC(const RpakLoadAsset& Asset, const string& Path, const str
 	qc.Close();
 }
 
-void RpakLib::QCWriteAseqData(IO::StreamWriter& qc, const string& Path, uint64_t AnimHash, const RpakLoadAsset& RigAsset, List<string> PoseParameters, List<string>& AnimationNames, bool WriteAnimations)
+void RpakLib::QCWriteAseqData(IO::BufferedTextWriter& qc, const string& Path, uint64_t AnimHash, const RpakLoadAsset& RigAsset, List<string> PoseParameters, List<string>& AnimationNames, bool WriteAnimations)
 {
 	if (this->Assets.ContainsKey(AnimHash))
 	{
@@ -4,7 +4,7 @@
 #include "Directory.h"
 #include <rtech.h>
 
-void RpakLib::BuildMapInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildMapInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
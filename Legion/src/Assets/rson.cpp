@@ -2,8 +2,9 @@
 #include "RpakLib.h"
 #include <Path.h>
 #include <Directory.h>
+#include <File.h>
 
-void RpakLib::BuildRSONInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildRSONInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	Info.Name = string::Format("rson_0x%llx", Asset.NameHash);
 	Info.Type = ApexAssetType::RSON;
@@ -26,7 +27,7 @@ void RpakLib::ExportRSON(const RpakLoadAsset& Asset, const string& Path)
 	this->ExtractRSON(Asset, DestinationPath);
 }
 
-void RpakLib::R_WriteRSONFile(const RpakLoadAsset& Asset, std::ofstream& out, IO::BinaryReader& Reader, RSONNode node, int level)
+void RpakLib::R_WriteRSONFile(const RpakLoadAsset& Asset, IO::BufferedTextWriter& out, IO::BinaryReader& Reader, RSONNode node, int level)
 {
 	auto RpakStream = Reader.GetBaseStream();
 	string name = this->ReadStringFromPointer(Asset, node.pName);
@@ -37,7 +38,7 @@ void RpakLib::R_WriteRSONFile(const RpakLoadAsset& Asset, std::ofstream& out, IO
 	case RSON_STRING: // single string value
 	{
 		string value = this->ReadStringFromPointer(Asset, node.pValues);
-		out << " \"" + value.ToString() + "\"\n";
+		out << " \"" << value << "\"\n";
 		break;
 	}
 	case RSON_OBJECT: // object
@@ -87,7 +88,7 @@ void RpakLib::R_WriteRSONFile(const RpakLoadAsset& Asset, std::ofstream& out, IO
 		break;
 	}
 	case RSON_BOOLEAN:
-		out << std::boolalpha << (node.pValues.Value > 0) << "\n";
+		out << (node.pValues.Value > 0) << "\n";
 		break;
 	case RSON_INTEGER:
 		out << " " << node.pValues.Value << "\n";
@@ -108,7 +109,7 @@ void RpakLib::ExtractRSON(const RpakLoadAsset& Asset, const string& Path)
 
 	RSONHeader header = Reader.Read<RSONHeader>();
 
-	std::ofstream out_stream(Path.ToString(), std::ios::out);
+	IO::BufferedTextWriter out_stream(IO::File::Create(Path), true);
 
 
 
@@ -149,5 +150,5 @@ void RpakLib::ExtractRSON(const RpakLoadAsset& Asset, const string& Path)
 	}
 
 
-	out_stream.close();
+	out_stream.Close();
 }
\ No newline at end of file
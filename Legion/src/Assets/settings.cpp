@@ -2,13 +2,14 @@
 #include "RpakLib.h"
 #include <Path.h>
 #include <Directory.h>
+#include <File.h>
 
 bool operator<(const SettingsLayoutItem& lhs, const SettingsLayoutItem& rhs)
 {
 	return lhs.valueOffset < rhs.valueOffset;
 }
 
-void RpakLib::BuildSettingsInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildSettingsInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -35,7 +36,7 @@ void RpakLib::BuildSettingsInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
 	Info.Info = "N/A";
 }
 
-void RpakLib::BuildSettingsLayoutInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildSettingsLayoutInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -66,7 +67,7 @@ void RpakLib::ExportSettingsLayout(const RpakLoadAsset& Asset, const string& Pat
 	if (!Utils::ShouldWriteFile(DestinationPath))
 		return;
 
-	std::ofstream out(DestinationPath, std::ios::out);
+	IO::BufferedTextWriter out(IO::File::Create(DestinationPath), true);
 
 	out << "\"" << Layout.name << "\"\n{";
 
@@ -136,7 +137,7 @@ void RpakLib::ExtractSettings(const RpakLoadAsset& Asset, const string& Path, co
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 
-	std::ofstream out(Path.ToCString(), std::ios::out);
+	IO::BufferedTextWriter out(IO::File::Create(Path), true);
 
 	out << "\"" << Name << "\" -> \"" << Layout.name << "\"" << "\n{";
 
@@ -153,7 +154,7 @@ void RpakLib::ExtractSettings(const RpakLoadAsset& Asset, const string& Path, co
 		case SettingsFieldType::ST_Bool:
 		{
 			bool bValue = Reader.Read<bool>();
-			out << std::boolalpha << bValue;
+			out << bValue;
 			break;
 		}
 		case SettingsFieldType::ST_Int:
@@ -249,10 +250,16 @@ void RpakLib::ExtractSettings(const RpakLoadAsset& Asset, const string& Path, co
 	}
 
 	out << "\n}";
-	out.close();
+	out.Close();
 }
 
 SettingsLayout RpakLib::ExtractSettingsLayout(const RpakLoadAsset& Asset)
+{
+	// Many settings assets share one layout
+	return *this->SettingsLayoutCache.Get(Asset.NameHash, [this, &Asset] { return this->ParseSettingsLayout(Asset); });
+}
+
+SettingsLayout RpakLib::ParseSettingsLayout(const RpakLoadAsset& Asset)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
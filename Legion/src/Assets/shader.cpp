@@ -2,8 +2,10 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "File.h"
+#include "XXHash.h"
 
-void RpakLib::BuildShaderSetInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildShaderSetInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -64,24 +66,24 @@ void RpakLib::ExportShaderSet(const RpakLoadAsset& Asset, const string& Path)
 	if (!IO::Directory::Exists(ShaderSetPath))
 		IO::Directory::CreateDirectory(ShaderSetPath);
 
+	// Unique bytecode is stored once, shaderset directories link to it
+	string StorePath = IO::Path::Combine(Path, "_bytecode");
+
 	if (Assets.ContainsKey(PixelShaderGuid))
 	{
 		string PixelShaderPath = IO::Path::Combine(ShaderSetPath, string::Format("0x%llx_ps.fxc", PixelShaderGuid));
-		this->ExtractShader(Assets[PixelShaderGuid], ShaderSetPath, PixelShaderPath);
+		this->ExtractShader(Assets[PixelShaderGuid], StorePath, ShaderSetPath, PixelShaderPath);
 	}
 
 	if (Assets.ContainsKey(VertexShaderGuid))
 	{
 		string VertexShaderPath = IO::Path::Combine(ShaderSetPath, string::Format("0x%llx_vs.fxc", VertexShaderGuid));
-		this->ExtractShader(Assets[VertexShaderGuid], ShaderSetPath, VertexShaderPath);
+		this->ExtractShader(Assets[VertexShaderGuid], StorePath, ShaderSetPath, VertexShaderPath);
 	}
 }
 
-void RpakLib::ExtractShader(const RpakLoadAsset& Asset, const string& OutputDirPath, const string& Path)
+void RpakLib::ExtractShader(const RpakLoadAsset& Asset, const string& StorePath, const string& OutputDirPath, const string& Path)
 {
-	if (!Utils::ShouldWriteFile(Path))
-		return;
-
 	if (Asset.RawDataIndex == -1 || Asset.RawDataOffset == -1)
 		return;
 
@@ -100,19 +102,35 @@ void RpakLib::ExtractShader(const RpakLoadAsset& Asset, const string& OutputDirP
 		Name = IO::Path::Combine(OutputDirPath, Reader.ReadCString() + ".fxc");
 	}
 
+	if (!Utils::ShouldWriteFile(Name))
+		return;
+
 	RpakStream->SetPosition(this->GetFileOffset(Asset, Asset.RawDataIndex, Asset.RawDataOffset));
 
 	ShaderDataHeader DataHeader = Reader.Read<ShaderDataHeader>();
 
-	RpakStream->SetPosition(this->GetFileOffset(Asset, DataHeader.ByteCodeIndex, DataHeader.ByteCodeOffset));
+	uint64_t ByteCodeOffset = this->GetFileOffset(Asset, DataHeader.ByteCodeIndex, DataHeader.ByteCodeOffset);
+
+	if (ByteCodeOffset + DataHeader.DataSize > RpakStream->GetLength())
+		return;
+
+	// Hash the bytecode where it sits in the segment, only unseen blobs are ever copied out
+	uint8_t* ByteCode = RpakStream->GetBuffer() + ByteCodeOffset;
+	uint64_t ContentHash = Hashing::XXHash::ComputeHash(ByteCode, 0, DataHeader.DataSize);
+
+	string BlobPath = IO::Path::Combine(StorePath, string::Format("%016llx.fxc", ContentHash));
 
-	char* bcBuf = new char[DataHeader.DataSize];
+	// Blobs are named by their content, so one left by an earlier export is already correct
+	if (this->LinkStoredBlob(BlobPath, Name))
+		return;
+
+	// Each writer gets its own temp file, only the move into the store is serialized
+	string TempPath = this->GetStoreTempPath(BlobPath);
 
-	Reader.Read(bcBuf, 0, DataHeader.DataSize);
+	IO::Directory::CreateDirectory(StorePath);
+	IO::File::WriteAllBytes(TempPath, ByteCode, DataHeader.DataSize);
 
-	std::ofstream shaderOut(Name.ToCString(), std::ios::binary | std::ios::out);
-	shaderOut.write(bcBuf, DataHeader.DataSize);
-	shaderOut.close();
+	this->StoreBlob(TempPath, BlobPath, Name);
 }
 
 ShaderSetHeader RpakLib::ExtractShaderSet(const RpakLoadAsset& Asset)
@@ -128,6 +146,14 @@ ShaderSetHeader RpakLib::ExtractShaderSet(const RpakLoadAsset& Asset)
 }
 
 List<ShaderVar> RpakLib::ExtractShaderVars(const RpakLoadAsset& Asset, const std::string& CBufName, D3D_SHADER_VARIABLE_TYPE VarsType)
+{
+	// Every material using a shader reads the same buffer, so the reflection is only walked once
+	uint64_t Key = RpakMemoCache<List<ShaderVar>>::CombineKey(Asset.NameHash, Hashing::XXHash::HashString(CBufName.c_str(), Hashing::XXHashVersion::XX64, (uint64_t)VarsType));
+
+	return *this->ShaderVarCache.Get(Key, [this, &Asset, &CBufName, VarsType] { return this->ParseShaderVars(Asset, CBufName, VarsType); });
+}
+
+List<ShaderVar> RpakLib::ParseShaderVars(const RpakLoadAsset& Asset, const std::string& CBufName, D3D_SHADER_VARIABLE_TYPE VarsType)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -215,6 +241,13 @@ List<ShaderVar> RpakLib::ExtractShaderVars(const RpakLoadAsset& Asset, const std
 }
 
 List<ShaderResBinding> RpakLib::ExtractShaderResourceBindings(const RpakLoadAsset& Asset, D3D_SHADER_INPUT_TYPE InputType)
+{
+	uint64_t Key = RpakMemoCache<List<ShaderResBinding>>::CombineKey(Asset.NameHash, (uint64_t)InputType + 1);
+
+	return *this->ShaderResBindingCache.Get(Key, [this, &Asset, InputType] { return this->ParseShaderResourceBindings(Asset, InputType); });
+}
+
+List<ShaderResBinding> RpakLib::ParseShaderResourceBindings(const RpakLoadAsset& Asset, D3D_SHADER_INPUT_TYPE InputType)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -11,7 +11,7 @@ string RpakLib::GetSubtitlesNameFromHash(uint64_t Hash)
 	return string::Format("subt_0x%llx", Hash);
 }
 
-void RpakLib::BuildSubtitleInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildSubtitleInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -2,6 +2,10 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "File.h"
+#include "XXHash.h"
+#include "ExportWriter.h"
+#include "ExportProgress.h"
 #include <DDS.h>
 #include <rtech.h>
 
@@ -26,7 +30,7 @@ void RpakLib::ExtractTextureName(const RpakLoadAsset& asset, string& name)
 	}
 }
 
-void RpakLib::BuildTextureInfo(const RpakLoadAsset& asset, ApexAsset& assetInfo)
+void RpakLib::BuildTextureInfo(const RpakLoadAsset& asset, ApexAssetInfo& assetInfo)
 {
 	auto rpakStream = this->GetFileStream(asset);
 	IO::BinaryReader reader = IO::BinaryReader(rpakStream.get(), true);
@@ -73,10 +77,23 @@ void RpakLib::ExportTexture(const RpakLoadAsset& asset, const string& path, bool
 	string destName = nameOverride == "" ? string::Format("0x%llx%s", asset.NameHash, (const char*)ImageExtension) : nameOverride;
 	string destPath = IO::Path::Combine(path, destName);
 
-	std::unique_ptr<Assets::Texture> texture = nullptr;
+	NormalRecalcType_t NormalRecalcType = normalRecalculate ? (NormalRecalcType_t)ExportManager::Config.Get<System::SettingType::Integer>("NormalRecalcType") : NormalRecalcType_t::None;
+
+	// The raw data is already in its final layout, so dds output can skip the texture entirely unless it needs transcoding
+	bool writeRawData = ImageSaveType == Assets::SaveFileType::Dds && NormalRecalcType == NormalRecalcType_t::None;
+
+	// Materials export their textures one after another, each one checks for a cancel before reading and encoding
+	if (ExportCancellation::IsRequested())
+		return;
+
+	RpakTextureData data{};
 	string name;
 
-	this->ExtractTexture(asset, texture, name);
+	if (!this->ExtractTextureData(asset, data, name, writeRawData && ExportManager::Config.GetBool("ExportImageMips")))
+		return;
+
+	if (ExportCancellation::IsRequested())
+		return;
 
 	if (includeImageNames && name.Length() > 0)
 		destPath = IO::Path::Combine(path, string::Format("%s%s", IO::Path::GetFileNameWithoutExtension(name).ToCString(), (const char*)ImageExtension));
@@ -84,29 +101,74 @@ void RpakLib::ExportTexture(const RpakLoadAsset& asset, const string& path, bool
 	if (!Utils::ShouldWriteFile(destPath))
 		return;
 
+	// The payload is hashed once while it is still in memory, an identical one stored earlier is linked without encoding it again
+	string blobPath = "";
+
+	if (this->TextureStorePath.Length() > 0)
+	{
+		// Output settings change the encoded file, so they seed the payload hash
+		uint64_t outputKey = ((uint64_t)data.Width << 48) | ((uint64_t)data.Height << 32) | ((uint64_t)data.Format << 16) | ((uint64_t)data.MipLevels << 8)
+			| ((uint64_t)ImageSaveType << 4) | ((uint64_t)NormalRecalcType << 1) | (uint64_t)data.IsSwizzled;
+		uint64_t contentHash = Hashing::XXHash::ComputeHash(data.Pixels.get(), 0, data.PixelsSize, Hashing::XXHashVersion::XX64, outputKey);
+
+		blobPath = IO::Path::Combine(this->TextureStorePath, string::Format("%016llx%s", contentHash, (const char*)ImageExtension));
+
+		if (this->LinkStoredBlob(blobPath, destPath))
+			return;
+	}
+
+	// Stored payloads are written beside the store first, another export may be writing the same one
+	string outPath = (blobPath.Length() > 0) ? this->GetStoreTempPath(blobPath) : destPath;
+	std::function<void()> onWritten = nullptr;
+
+	// The move into the store waits until the writer has the file on disk
+	if (blobPath.Length() > 0)
+		onWritten = [this, outPath, blobPath, destPath] { this->StoreBlob(outPath, blobPath, destPath); };
+
 	try
 	{
-		if (texture)
+		if (writeRawData && !data.IsSwizzled)
 		{
-			if (normalRecalculate)
+			Assets::DDSFormat ddsFormat;
+
+			ddsFormat.Format = data.Format;
+			ddsFormat.MipLevels = data.MipLevels;
+
+			uint8_t header[0x100]{};
+			uint32_t headerSize = 0;
+
+			Assets::DDS::WriteDDSHeader(header, data.Width, data.Height, ddsFormat, headerSize);
+
+			// The payload is handed to the writer as is, the header goes in front of it
+			ExportProfileScope profile(ExportStage::FileWrite, data.PixelsSize);
+			ExportWriter::WriteFile(outPath, std::move(data.Pixels), data.PixelsSize, header, headerSize, onWritten);
+		}
+		else
+		{
+			std::unique_ptr<Assets::Texture> texture = nullptr;
+
+			this->BuildTexture(data, texture);
+
+			switch (NormalRecalcType)
 			{
-				NormalRecalcType_t NormalRecalcType = (NormalRecalcType_t)ExportManager::Config.Get<System::SettingType::Integer>("NormalRecalcType");
+			case NormalRecalcType_t::None:
+				break;
+			case NormalRecalcType_t::DirectX:
+				texture->Transcode(Assets::TranscodeType::NormalMapBC5);
+				break;
+			case NormalRecalcType_t::OpenGl:
+				texture->Transcode(Assets::TranscodeType::NormalMapBC5OpenGl);
+				break;
+			}
 
-				Assets::TranscodeType Type = Assets::TranscodeType::NormalMapBC5OpenGl;
+			auto encoded = std::make_unique<IO::MemoryStream>();
 
-				switch (NormalRecalcType)
-				{
-				case NormalRecalcType_t::None:
-					break;
-				case NormalRecalcType_t::DirectX:
-					texture->Transcode(Assets::TranscodeType::NormalMapBC5);
-					break;
-				case NormalRecalcType_t::OpenGl:
-					texture->Transcode(Assets::TranscodeType::NormalMapBC5OpenGl);
-					break;
-				}
+			{
+				ExportProfileScope profile(ExportStage::TextureSave);
+				texture->Save(*encoded, ImageSaveType);
 			}
-			texture->Save(destPath, ImageSaveType);
+
+			ExportWriter::WriteFile(outPath, std::move(encoded), onWritten);
 		}
 	}
 	catch (...)
@@ -115,44 +177,125 @@ void RpakLib::ExportTexture(const RpakLoadAsset& asset, const string& path, bool
 	}
 }
 
+void RpakLib::SetTextureStorePath(const string& Path)
+{
+	this->TextureStorePath = Path;
+
+	if (Path.Length() > 0)
+		IO::Directory::CreateDirectory(Path);
+}
+
 #undef max
 constexpr uint32_t ALIGNMENT_SIZE = 15;
-uint64_t CalculateHighestMipOffset(const TextureHeader& txtrHdr, const uint8_t& mipCount)
+uint64_t CalculateMipSlicePitch(const TextureHeader& txtrHdr, uint32_t mipLevel)
+{
+	int mipWidth = std::max(0, (txtrHdr.width >> mipLevel) - 1);
+	int mipHeight = std::max(0, (txtrHdr.height >> mipLevel) - 1);
+
+	const uint8_t x = s_pBytesPerPixel[txtrHdr.imageFormat].first;
+	const uint8_t y = s_pBytesPerPixel[txtrHdr.imageFormat].second;
+
+	uint32_t bppWidth = (y + mipWidth) >> (y >> 1);
+	uint32_t bppHeight = (y + mipHeight) >> (y >> 1);
+
+	return (uint64_t)x * bppWidth * bppHeight;
+}
+
+// Permanent mips are stored smallest first, with every array slice 16 byte aligned
+uint64_t CalculateMipOffset(const TextureHeader& txtrHdr, uint32_t mipLevel, uint32_t mipCount)
 {
 	uint64_t retOffset = 0;
 
-	for (int mipLevel = mipCount - 1; mipLevel >= 1; mipLevel--)
+	for (int level = mipCount - 1; level > (int)mipLevel; level--)
+	{
+		retOffset += ((CalculateMipSlicePitch(txtrHdr, level) + ALIGNMENT_SIZE) & ~(uint64_t)ALIGNMENT_SIZE) * txtrHdr.arraySize;
+	}
+
+	return retOffset;
+}
+
+uint64_t CalculateHighestMipOffset(const TextureHeader& txtrHdr, const uint8_t& mipCount)
+{
+	return CalculateMipOffset(txtrHdr, 0, mipCount);
+}
+
+void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets::Texture>& texture, string& name)
+{
+	RpakTextureData data{};
+
+	if (this->ExtractTextureData(asset, data, name, false))
+		this->BuildTexture(data, texture);
+	else
+		texture = std::make_unique<Assets::Texture>(data.Width, data.Height, data.Format);
+}
+
+void RpakLib::BuildTexture(const RpakTextureData& data, std::unique_ptr<Assets::Texture>& texture)
+{
+	texture = std::make_unique<Assets::Texture>(data.Width, data.Height, data.Format);
+
+	// Only the highest mip is kept
+	std::memcpy(texture->GetPixels(), data.Pixels.get(), min((uint64_t)texture->BlockSize(), data.PixelsSize));
+
+	// unswizzle ps4 textures
+	if (data.IsSwizzled)
 	{
-		int mipWidth = std::max(0, (txtrHdr.width >> mipLevel) - 1);
-		int mipHeight = std::max(0, (txtrHdr.height >> mipLevel) - 1);
+		auto uTexture = std::make_unique<Assets::Texture>(data.Width, data.Height, data.Format);
 
-		const uint8_t x = s_pBytesPerPixel[txtrHdr.imageFormat].first;
-		const uint8_t y = s_pBytesPerPixel[txtrHdr.imageFormat].second;
+		uint8_t bpp = texture->GetBpp();
+		int vp = (bpp * 2);
 
-		uint32_t bppWidth = (y + mipWidth) >> (y >> 1);
-		uint32_t bppHeight = (y + mipHeight) >> (y >> 1);
-		uint32_t sliceWidth = x * (y >> (y >> 1));
+		int pixbl = texture->Pixbl();
+		if (pixbl == 1)
+			vp = bpp / 8;
 
-		uint32_t rowPitch = sliceWidth * bppWidth;
-		uint32_t slicePitch = x * bppWidth * bppHeight;
+		int blocksY = data.Height / pixbl;
+		int blocksX = data.Width / pixbl;
 
-		for (int a = 0; a < txtrHdr.arraySize; a++)
+		uint8_t tempArray[16]{};
+		int tmp = 0;
+
+		for (int i = 0; i < (blocksY + 7) / 8; i++)
 		{
-			retOffset += ((uint64_t)(slicePitch + ALIGNMENT_SIZE) & ~ALIGNMENT_SIZE);
+			for (int j = 0; j < (blocksX + 7) / 8; j++)
+			{
+				for (int k = 0; k < 64; k++)
+				{
+					int mr = Assets::Texture::Morton(k, 8, 8);
+					int v0 = mr / 8;
+					int v1 = mr % 8;
+
+					std::memcpy(tempArray, texture->GetPixels() + tmp, vp);
+					tmp += vp;
+
+					if (j * 8 + v1 < blocksX && i * 8 + v0 < blocksY)
+					{
+						int dstIdx = (vp) * ((i * 8 + v0) * blocksX + j * 8 + v1);
+						std::memcpy(uTexture->GetPixels() + dstIdx, tempArray, vp);
+					}
+				}
+			}
 		}
+
+		texture = std::move(uTexture);
 	}
 
-	return retOffset;
+	// unswizzle switch textures
+	/*else if (TexHeader.compressionType == 9)
+	{
+		// stub for now because there's other issues
+	}*/
 }
 
-void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets::Texture>& texture, string& name)
+bool RpakLib::ExtractTextureData(const RpakLoadAsset& asset, RpakTextureData& data, string& name, bool includeMips)
 {
+	ExportProfileScope profile(ExportStage::Extract);
+
 	auto rpakStream = this->GetFileStream(asset);
 	IO::BinaryReader reader = IO::BinaryReader(rpakStream.get(), true);
 
 	rpakStream->SetPosition(this->GetFileOffset(asset, asset.SubHeaderIndex, asset.SubHeaderOffset));
 
-	TextureHeader txtrHdr;
+	TextureHeader txtrHdr{};
 
 	if (asset.AssetVersion >= 9)
 	{
@@ -197,11 +340,15 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 		name = "";
 	}
 
-	Assets::DDSFormat ddsFormat;
+	data.Width = txtrHdr.width;
+	data.Height = txtrHdr.height;
+	data.Format = TxtrFormatToDXGI[txtrHdr.imageFormat];
+	data.MipLevels = 1;
+	data.IsSwizzled = txtrHdr.unk == 8;
 
-	ddsFormat.Format = TxtrFormatToDXGI[txtrHdr.imageFormat];
+	Assets::DDSFormat ddsFormat;
 
-	texture = std::make_unique<Assets::Texture>(txtrHdr.width, txtrHdr.height, ddsFormat.Format);
+	ddsFormat.Format = data.Format;
 
 	std::unique_ptr<IO::FileStream> starpakStream = nullptr;
 	uint64_t starpakOffset = asset.StarpakOffset & 0xFFFFFFFFFFFFFF00;
@@ -209,9 +356,14 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 
 	std::unique_ptr<IO::MemoryStream> decompStarpakStream = nullptr;
 	uint64_t highestMipOffset = 0;
-	uint64_t blockSize = texture->BlockSize();
+	uint64_t blockSize = Assets::DDS::CalculateMipSize(txtrHdr.width, txtrHdr.height, 0, ddsFormat);
 
 	bool isVersionWithCompression = asset.AssetVersion >= 9;
+	bool hasRawData = asset.RawDataIndex != -1 && asset.RawDataIndex >= this->LoadedFiles[asset.FileIndex].StartSegmentIndex;
+
+	// Mips above the permanent ones, the permanent mips can only follow the highest one when it is the only streamed mip
+	uint32_t streamedMipCount = txtrHdr.streamedMipCount + txtrHdr.optStreamedMipCount;
+	bool canAppendMips = false;
 
 	if (isVersionWithCompression)
 	{
@@ -232,9 +384,12 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 			starpakStream = this->GetStarpakStream(asset, true);
 			highestMipOffset = optStarpakOffset;
 
-			if (this->LoadedFiles[asset.FileIndex].OptimalStarpakMap.ContainsKey(asset.OptimalStarpakOffset))
+			uint64_t starpakEntrySize = 0;
+
+			if (this->LoadedFiles[asset.FileIndex].TryGetStarpakEntrySize(asset.OptimalStarpakOffset, starpakEntrySize, true))
 			{
-				decompStarpakStream = std::move(decompressBuffer(starpakStream, this->LoadedFiles[asset.FileIndex].OptimalStarpakMap[asset.OptimalStarpakOffset], optStarpakOffset, blockSize));
+				decompStarpakStream = std::move(decompressBuffer(starpakStream, starpakEntrySize, optStarpakOffset, blockSize));
+				canAppendMips = streamedMipCount == 1;
 			}
 			else
 			{
@@ -262,9 +417,12 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 			starpakStream = this->GetStarpakStream(asset, false);
 			highestMipOffset = starpakOffset;
 
-			if (this->LoadedFiles[asset.FileIndex].StarpakMap.ContainsKey(asset.StarpakOffset))
+			uint64_t starpakEntrySize = 0;
+
+			if (this->LoadedFiles[asset.FileIndex].TryGetStarpakEntrySize(asset.StarpakOffset, starpakEntrySize, false))
 			{
-				decompStarpakStream = std::move(decompressBuffer(starpakStream, this->LoadedFiles[asset.FileIndex].StarpakMap[asset.StarpakOffset], starpakOffset, blockSize));
+				decompStarpakStream = std::move(decompressBuffer(starpakStream, starpakEntrySize, starpakOffset, blockSize));
+				canAppendMips = streamedMipCount == 1;
 			}
 			else
 			{
@@ -275,14 +433,15 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 				highestMipOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset);
 			}
 		}
-		else if (asset.RawDataIndex != -1 && asset.RawDataIndex >= this->LoadedFiles[asset.FileIndex].StartSegmentIndex) // Is txtr data in RPak?
+		else if (hasRawData) // Is txtr data in RPak?
 		{
 			highestMipOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset) + CalculateHighestMipOffset(txtrHdr, txtrHdr.permanentMipCount);
+			canAppendMips = streamedMipCount == 0;
 		}
 		else
 		{
 			g_Logger.Warning("Asset 0x%llx has no valid data.\n", asset.NameHash);
-			return;
+			return false;
 		}
 	}
 	else
@@ -292,9 +451,11 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 			starpakStream = this->GetStarpakStream(asset, true);
 			highestMipOffset = optStarpakOffset;
 
-			if (this->LoadedFiles[asset.FileIndex].OptimalStarpakMap.ContainsKey(asset.OptimalStarpakOffset))
+			uint64_t starpakEntrySize = 0;
+
+			if (this->LoadedFiles[asset.FileIndex].TryGetStarpakEntrySize(asset.OptimalStarpakOffset, starpakEntrySize, true))
 			{
-				highestMipOffset += (this->LoadedFiles[asset.FileIndex].OptimalStarpakMap[asset.OptimalStarpakOffset] - blockSize);
+				highestMipOffset += (starpakEntrySize - blockSize);
 			}
 			else
 			{
@@ -308,9 +469,11 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 			starpakStream = this->GetStarpakStream(asset, false);
 			highestMipOffset = starpakOffset;
 
-			if (this->LoadedFiles[asset.FileIndex].StarpakMap.ContainsKey(asset.StarpakOffset))
+			uint64_t starpakEntrySize = 0;
+
+			if (this->LoadedFiles[asset.FileIndex].TryGetStarpakEntrySize(asset.StarpakOffset, starpakEntrySize, false))
 			{
-				highestMipOffset += (this->LoadedFiles[asset.FileIndex].StarpakMap[asset.StarpakOffset] - blockSize);
+				highestMipOffset += (starpakEntrySize - blockSize);
 			}
 			else
 			{
@@ -319,82 +482,68 @@ void RpakLib::ExtractTexture(const RpakLoadAsset& asset, std::unique_ptr<Assets:
 				highestMipOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset) + (txtrHdr.dataSize - blockSize);
 			}
 		}
-		else if (asset.RawDataIndex != -1 && asset.RawDataIndex >= this->LoadedFiles[asset.FileIndex].StartSegmentIndex) // Is txtr data in RPak?
+		else if (hasRawData) // Is txtr data in RPak?
 		{
 			if (!txtrHdr.unkMip)
 				highestMipOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset) + (txtrHdr.dataSize - blockSize);
 			else
 				highestMipOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset) + CalculateHighestMipOffset(txtrHdr, txtrHdr.permanentMipCount);
+
+			// Only trust the permanent layout when it agrees with where the highest mip was found
+			canAppendMips = streamedMipCount == 0 && highestMipOffset == this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset) + CalculateHighestMipOffset(txtrHdr, txtrHdr.permanentMipCount);
 		}
 		else
 		{
 			g_Logger.Warning("Asset 0x%llx has no valid data.\n", asset.NameHash);
-			return;
+			return false;
 		}
 	}
 
+	// The lower mips are read straight from the permanent data, stopping at the first level the DDS layout disagrees with
+	uint32_t totalMipCount = streamedMipCount + txtrHdr.permanentMipCount;
+
+	if (includeMips && canAppendMips && hasRawData && !data.IsSwizzled)
+	{
+		while (data.MipLevels < totalMipCount && CalculateMipSlicePitch(txtrHdr, data.MipLevels) == Assets::DDS::CalculateMipSize(txtrHdr.width, txtrHdr.height, data.MipLevels, ddsFormat))
+			data.MipLevels++;
+	}
+
+	ddsFormat.MipLevels = data.MipLevels;
+
+	data.PixelsSize = Assets::DDS::CalculatePayloadSize(txtrHdr.width, txtrHdr.height, ddsFormat);
+	data.Pixels = std::make_unique<uint8_t[]>(data.PixelsSize);
+
 	if (decompStarpakStream)
 	{
-		decompStarpakStream->Read(texture->GetPixels(), 0, blockSize);
+		decompStarpakStream->Read(data.Pixels.get(), 0, blockSize);
 		decompStarpakStream->Close();
 	}
 	else if (starpakStream)
 	{
 		starpakStream->SetPosition(highestMipOffset);
-		starpakStream->Read(texture->GetPixels(), 0, blockSize);
+		starpakStream->Read(data.Pixels.get(), 0, blockSize);
 	}
-	else 
+	else
 	{
 		rpakStream->SetPosition(highestMipOffset);
-		rpakStream->Read(texture->GetPixels(), 0, blockSize);
+		rpakStream->Read(data.Pixels.get(), 0, blockSize);
 	}
 
-	// unswizzle ps4 textures
-	if (txtrHdr.unk == 8)
+	if (data.MipLevels > 1)
 	{
-		auto uTexture = std::make_unique<Assets::Texture>(txtrHdr.width, txtrHdr.height, ddsFormat.Format);
-
-		uint8_t bpp = texture->GetBpp();
-		int vp = (bpp * 2);
-
-		int pixbl = texture->Pixbl();
-		if (pixbl == 1)
-			vp = bpp / 8;
-
-		int blocksY = txtrHdr.height / pixbl;
-		int blocksX = txtrHdr.width / pixbl;
+		uint64_t rawDataOffset = this->GetFileOffset(asset, asset.RawDataIndex, asset.RawDataOffset);
+		uint64_t pixelsOffset = blockSize;
 
-		uint8_t tempArray[16]{};
-		int tmp = 0;
-
-		for (int i = 0; i < (blocksY + 7) / 8; i++)
+		for (uint32_t mipLevel = 1; mipLevel < data.MipLevels; mipLevel++)
 		{
-			for (int j = 0; j < (blocksX + 7) / 8; j++)
-			{
-				for (int k = 0; k < 64; k++)
-				{
-					int mr = Assets::Texture::Morton(k, 8, 8);
-					int v0 = mr / 8;
-					int v1 = mr % 8;
+			uint64_t mipSize = Assets::DDS::CalculateMipSize(txtrHdr.width, txtrHdr.height, mipLevel, ddsFormat);
 
-					std::memcpy(tempArray, texture->GetPixels() + tmp, vp);
-					tmp += vp;
+			rpakStream->SetPosition(rawDataOffset + CalculateMipOffset(txtrHdr, mipLevel, totalMipCount));
+			rpakStream->Read(data.Pixels.get(), pixelsOffset, mipSize);
 
-					if (j * 8 + v1 < blocksX && i * 8 + v0 < blocksY)
-					{
-						int dstIdx = (vp) * ((i * 8 + v0) * blocksX + j * 8 + v1);
-						std::memcpy(uTexture->GetPixels() + dstIdx, tempArray, vp);
-					}
-				}
-			}
+			pixelsOffset += mipSize;
 		}
-
-		texture = std::move(uTexture);
 	}
 
-	// unswizzle switch textures
-	/*else if (TexHeader.compressionType == 9)
-	{
-		// stub for now because there's other issues
-	}*/
-}
\ No newline at end of file
+	return true;
+}
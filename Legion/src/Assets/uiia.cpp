@@ -2,12 +2,14 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "ThreadBudget.h"
 #include "RpakImageTiles.h"
 #include <DDS.h>
+#include <TextureCPUDecoder.h>
 #include <rtech.h>
 // this file could probably be renamed to be more generic ui stuff in the future
 
-void RpakLib::BuildUIIAInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildUIIAInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -69,7 +71,10 @@ void RpakLib::ExportUIIA(const RpakLoadAsset& Asset, const string& Path)
 	try
 	{
 		if (Texture != nullptr)
+		{
+			ExportProfileScope Profile(ExportStage::TextureSave);
 			Texture->Save(DestinationPath, ImageSaveType);
+		}
 	}
 	catch (...)
 	{
@@ -79,6 +84,8 @@ void RpakLib::ExportUIIA(const RpakLoadAsset& Asset, const string& Path)
 
 void RpakLib::ExtractUIIA(const RpakLoadAsset& Asset, std::unique_ptr<Assets::Texture>& Texture)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 
@@ -97,9 +104,10 @@ void RpakLib::ExtractUIIA(const RpakLoadAsset& Asset, std::unique_ptr<Assets::Te
 	{
 		auto TempStream = this->GetStarpakStream(Asset, true);
 
-		if (this->LoadedFiles[Asset.FileIndex].OptimalStarpakMap.ContainsKey(Asset.OptimalStarpakOffset))
+		uint64_t BufferSize = 0;
+
+		if (this->LoadedFiles[Asset.FileIndex].TryGetStarpakEntrySize(Asset.OptimalStarpakOffset, BufferSize, true))
 		{
-			auto BufferSize = this->LoadedFiles[Asset.FileIndex].OptimalStarpakMap[Asset.OptimalStarpakOffset];
 			auto CompressedBuffer = std::make_unique<uint8_t[]>(BufferSize);
 
 			TempStream->SetPosition(ActualOptStarpakOffset);
@@ -116,9 +124,10 @@ void RpakLib::ExtractUIIA(const RpakLoadAsset& Asset, std::unique_ptr<Assets::Te
 	{
 		auto TempStream = this->GetStarpakStream(Asset, false);
 
-		if (this->LoadedFiles[Asset.FileIndex].StarpakMap.ContainsKey(Asset.StarpakOffset))
+		uint64_t BufferSize = 0;
+
+		if (this->LoadedFiles[Asset.FileIndex].TryGetStarpakEntrySize(Asset.StarpakOffset, BufferSize, false))
 		{
-			uint64_t BufferSize = this->LoadedFiles[Asset.FileIndex].StarpakMap[Asset.StarpakOffset];
 			auto CompressedBuffer = std::make_unique<uint8_t[]>(BufferSize);
 
 			TempStream->SetPosition(ActualStarpakOffset);
@@ -226,220 +235,91 @@ void RpakLib::ExtractUIIA(const RpakLoadAsset& Asset, std::unique_ptr<Assets::Te
 			}
 		}
 
-		if (NumBc1Blocks)
-		{
-			//
-			// We are now at the Bc1 blocks.
-			//
-
-			auto Bc1Destination = std::make_unique<uint8_t[]>(TotalBlocks * 512);
-			auto Bc1Texture = std::make_unique<Assets::Texture>(Width, Height, DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM);
-
-			//
-			// Copy over the blocks
-			//
-
-			for (uint32_t y = 0; y < HeightBlocks; y++)
-			{
-				for (uint32_t x = 0; x < WidthBlocks; x++)
-				{
-					RUIImageTile& Point = CodePoints[x + (y * WidthBlocks)];
-					uint32_t BlockOffset = (x * 512) + ((y * WidthBlocks) * 512);
-
-					if (Point.Opcode != 0x40)
-					{
-						std::memcpy(Bc1Destination.get() + BlockOffset, RUIImageTileBc1, sizeof(RUIImageTileBc1));
-						continue;
-					}
-
-					RpakStream->SetPosition(Point.Offset + Offset);
-
-					// Bc1Destination contains 32x32 BC1 512 bytes swizzled, copy to texture location.
-					RpakStream->Read(Bc1Destination.get() + BlockOffset, 0, 512);
-				}
-			}
-
-			//
-			// Unswizzle Bc1 blocks.
-			//
-
-			uint32_t Num5 = Height / 4;
-			uint32_t Num6 = Width / 4;
-			constexpr uint32_t Bc1Bpp2x = 4 * 2;
-
-			uint64_t Bc1Offset = 0;
-
-			for (uint32_t y = 0; y < Num5; y++)
-			{
-				for (uint32_t x = 0; x < Num6; x++)
-				{
-					uint32_t mx = x;
-					uint32_t my = y;
-
-					//g_pRtech->UnswizzleBlock(x, y, Num6, 2, mx, my);
-					//g_pRtech->UnswizzleBlock(mx, my, Num6, 4, mx, my);
-					//g_pRtech->UnswizzleBlock(mx, my, Num6, 8, mx, my);
-
-					// please don't mess with this code. it only just works and idk why it's being such a pain
-
-					// --- 2 ---
-					int power = 2;
-					int b_2 = (mx / 2 + my * (Num6 / power)) % (2 * (Num6 / power)) /
-						2 + (Num6 / power) * ((mx / 2 + my * (Num6 / power)) % (2 * (Num6 / power)) % 2) +
-						2 * (Num6 / power) * ((mx / 2 + my * (Num6 / power)) / (2 * (Num6 / power)));
-
-					int c_2 = mx % 2 + 2 * (b_2 % (Num6 / power));
-					mx = b_2 / (Num6 / power);
-					my = c_2 / 4;
-					c_2 %= 4;
-
-					// --- 4 ---
-					power = 4;
-					int b_4 = (my + mx / 2 * (Num6 / power)) % (2 * (Num6 / power)) /
-						2 + (Num6 / power) * ((my + mx / 2 * (Num6 / power)) % (2 * (Num6 / power)) % 2) +
-						2 * (Num6 / power) * ((my + mx / 2 * (Num6 / power)) / (2 * (Num6 / power)));
+		//
+		// Tiles without data use the constant tile of the image's base format, which repeats a single block of one color
+		//
 
-					int c_4 = mx % 2 + 2 * (b_4 / (Num6 / power));
-					mx = b_4 / (Num6 / power);
-					my = c_4 / 4;
-					c_4 %= 4;
+		uint32_t FillPixel = 0;
 
-					// --- 8 ---
-					power = 8;
-					int b_8 = ((c_2 + 4 * (b_4 % (Num6 / 4))) / 8 + my * (Num6 / power)) % (2 * (Num6 / power)) /
-						2 + (Num6 / power) * (((c_2 + 4 * (b_4 % (Num6 / 4))) / 8 + my * (Num6 / power)) % (2 * (Num6 / power)) % 2) +
-						2 * (Num6 / power) * (((c_2 + 4 * (b_4 % (Num6 / 4))) / 8 + my * (Num6 / power)) / (2 * (Num6 / power)));
+		if (NumBc1Blocks || NumBc7Blocks)
+		{
+			alignas(16) uint8_t FillBlock[4 * 4 * 4];
 
-					int v85 = b_8 / (Num6 / 8);
+			if (NumBc1Blocks)
+				Assets::TextureCPUDecoder::DecompressBlock(DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM, RUIImageTileBc1, FillBlock, 16);
+			else
+				Assets::TextureCPUDecoder::DecompressBlock(DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM, RUIImageTileBc7, FillBlock, 16);
 
-					my = (c_4 + 4 * ((int)b_8 / (Num6 / power)));
-					mx = (c_2 + 4 * (b_4 % (Num6 / 4))) % 8 + 8 * (unsigned int)(b_8 % (Num6 / power));
+			std::memcpy(&FillPixel, FillBlock, sizeof(uint32_t));
+		}
 
-					uint64_t destination = Bc1Bpp2x * (my * Num6 + mx);
+		Texture = std::make_unique<Assets::Texture>(Width, Height, DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM);
 
-					std::memcpy(Bc1Texture->GetPixels() + destination, Bc1Destination.get() + Bc1Offset, Bc1Bpp2x);
-					Bc1Offset += Bc1Bpp2x;
-				}
-			}
+		uint8_t* Pixels = Texture->GetPixels();
+		const uint8_t* TileData = RpakStream->GetBuffer();
+		uint64_t TileDataSize = RpakStream->GetLength();
+		size_t RowPitch = (size_t)Width * 4;
 
-			Bc1Texture->ConvertToFormat(DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM);
-			Texture = std::move(Bc1Texture);
-		}
-		else
-		{
-			// We didn't have an initial texture to use, to initialize the resulting texture
-			Texture = std::make_unique<Assets::Texture>(Width, Height, DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM);
-		}
+		//
+		// Every row of tiles is independent, decode the blocks straight into the final image
+		//
 
-		if (NumBc7Blocks)
+		Threading::ThreadBudget::Run(HeightBlocks, [&](uint32_t y)
 		{
-			//
-			// We are now at the Bc7 blocks.
-			//
-
-			auto Bc7Destination = std::make_unique<uint8_t[]>(TotalBlocks * 1024);
-			auto Bc7Texture = std::make_unique<Assets::Texture>(Width, Height, DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM);
+			uint8_t* TileRow = Pixels + (size_t)y * 32 * RowPitch;
+			uint32_t FillStart = 0;
 
-			//
-			// Copy over the blocks
-			//
-
-			for (uint32_t y = 0; y < HeightBlocks; y++)
+			for (uint32_t x = 0; x <= WidthBlocks; x++)
 			{
-				for (uint32_t x = 0; x < WidthBlocks; x++)
+				const uint8_t* Tile = nullptr;
+				DXGI_FORMAT TileFormat = DXGI_FORMAT::DXGI_FORMAT_UNKNOWN;
+				uint32_t TileSize = 0;
+
+				if (x < WidthBlocks)
 				{
-					RUIImageTile& Point = CodePoints[x + (y * WidthBlocks)];
-					uint32_t BlockOffset = (x * 1024) + ((y * WidthBlocks) * 1024);
+					const RUIImageTile& Point = CodePoints[x + (y * WidthBlocks)];
 
-					if (Point.Opcode != 0x41)
+					if (Point.Opcode == 0x40)
 					{
-						std::memcpy(Bc7Destination.get() + BlockOffset, RUIImageTileBc7, sizeof(RUIImageTileBc7));
-						continue;
+						TileFormat = DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM;
+						TileSize = sizeof(RUIImageTileBc1);
+					}
+					else if (Point.Opcode == 0x41)
+					{
+						TileFormat = DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM;
+						TileSize = sizeof(RUIImageTileBc7);
 					}
 
-					RpakStream->SetPosition(Point.Offset + Offset);
+					if (TileSize && Offset + Point.Offset + TileSize <= TileDataSize)
+						Tile = TileData + Offset + Point.Offset;
 
-					// Bc1Destination contains 32x32 BC7 1024 bytes swizzled, copy to texture location.
-					RpakStream->Read(Bc7Destination.get() + BlockOffset, 0, 1024);
+					if (Tile == nullptr)
+						continue;
 				}
-			}
-
-			//
-			// Unswizzle Bc7 blocks.
-			//
-
-			uint32_t blocksH = Height / 4;
-			uint32_t blocksW = Width / 4;
-			constexpr uint32_t Bc7Bpp2x = 8 * 2;
-
-			uint64_t Bc7Offset = 0;
 
-			for (uint32_t blockI = 0; blockI < blocksH; blockI++)
-			{
-				int v77 = blocksW / 2;
-				int v147 = blocksW / 2;
-				int v78 = blockI * (blocksW / 2);
-				int v79 = blocksW / 4;
-				int v80 = blocksW / 8;
-				for (uint32_t blockJ = 0; blockJ < blocksW; blockJ++)
+				// Fill the run of constant tiles before this one in bulk
+				if (FillStart < x)
 				{
-					uint32_t mx = blockJ;
-					uint32_t my = blockI;
-
-					/*g_pRtech->UnswizzleBlock(blockJ, blockI, blocksW, 2, mx, my);
-					g_pRtech->UnswizzleBlock(mx, my, blocksW, 4, mx, my);
-					g_pRtech->UnswizzleBlock(mx, my, blocksW, 8, mx, my);*/
-
-					// this is ugly and bad, should get put back into the function calls eventually
-					int v81 = (blockJ / 2 + v78) % (2 * (blocksW / 2)) / 2
-						+ v77 * ((blockJ / 2 + v78) % (2 * (blocksW / 2)) % 2)
-						+ 2 * (blocksW / 2) * ((blockJ / 2 + v78) / (2 * (blocksW / 2)));
-					int v82 = blockJ % 2 + 2 * (v81 % v77);
-					int v83 = v81 / v77;
-					int v84 = v82 / 4;
-					v82 %= 4;
-					int v85 = (v84 + v83 / 2 * v79) % (2 * (blocksW / 4)) / 2
-						+ v79 * ((v84 + v83 / 2 * v79) % (2 * (blocksW / 4)) % 2)
-						+ 2 * (blocksW / 4) * ((v84 + v83 / 2 * v79) / (2 * (blocksW / 4)));
-					int v86 = v83 % 2 + 2 * (v85 / v79);
-					int v87 = ((v82 + 4 * (v85 % v79)) / 8 + v86 / 4 * v80) % (2 * v80) / 2
-						+ v80 * (((v82 + 4 * (v85 % v79)) / 8 + v86 / 4 * v80) % (2 * v80) % 2)
-						+ 2 * v80 * (((v82 + 4 * (v85 % v79)) / 8 + v86 / 4 * v80) / (2 * v80));
-					int v88 = Bc7Bpp2x
-						* ((v82 + 4 * (v85 % v79)) % 8
-							+ 8 * (unsigned int)(v87 % v80)
-							+ blocksW * (v86 % 4 + 4 * ((int)v87 / v80)));
-
-					//uint64_t destination = Bc7Bpp2x * (my * blocksW + mx);
-
-					std::memcpy(Bc7Texture->GetPixels() + v88, Bc7Destination.get() + Bc7Offset, Bc7Bpp2x);
-					Bc7Offset += Bc7Bpp2x;
+					for (uint32_t Line = 0; Line < 32; Line++)
+						std::fill_n((uint32_t*)(TileRow + Line * RowPitch) + FillStart * 32, (x - FillStart) * 32, FillPixel);
 				}
-			}
 
-			Bc7Texture->ConvertToFormat(DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM);
+				FillStart = x + 1;
 
-			if (NumBc1Blocks)
-			{
-				// Stitch the 32x32 uncompressed tiles to the final image.
-				for (uint32_t y = 0; y < HeightBlocks; y++)
+				if (Tile == nullptr)
+					continue;
+
+				// The 8x8 blocks of a tile are stored in morton order
+				uint32_t BlockSize = TileSize / 64;
+
+				for (uint32_t i = 0; i < 64; i++)
 				{
-					for (uint32_t x = 0; x < WidthBlocks; x++)
-					{
-						RUIImageTile& Point = CodePoints[x + (y * WidthBlocks)];
+					uint32_t BlockX = (i & 1) | ((i >> 1) & 2) | ((i >> 2) & 4);
+					uint32_t BlockY = ((i >> 1) & 1) | ((i >> 2) & 2) | ((i >> 3) & 4);
 
-						if (Point.Opcode == 0x41)
-						{
-							Texture->CopyTextureSlice(Bc7Texture, { (x * 32), (y * 32), 32, 32 }, (x * 32), (y * 32));
-						}
-					}
+					Assets::TextureCPUDecoder::DecompressBlock(TileFormat, Tile + i * BlockSize, TileRow + (BlockY * 4) * RowPitch + (x * 32 + BlockX * 4) * 4, RowPitch);
 				}
 			}
-			else
-			{
-				// We are the final image
-				Texture = std::move(Bc7Texture);
-			}
-		}
+		});
 	}
 }
\ No newline at end of file
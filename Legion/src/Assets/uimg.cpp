@@ -2,9 +2,12 @@
 #include "RpakLib.h"
 #include "Path.h"
 #include "Directory.h"
+#include "ThreadBudget.h"
+#include <DDS.h>
+#include <TextureCPUDecoder.h>
 #include <rtech.h>
 
-void RpakLib::BuildUIImageAtlasInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildUIImageAtlasInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -63,6 +66,8 @@ void RpakLib::ExportUIImageAtlas(const RpakLoadAsset& Asset, const string& Path)
 
 void RpakLib::ExtractUIImageAtlas(const RpakLoadAsset& Asset, const string& Path)
 {
+	ExportProfileScope Profile(ExportStage::Extract);
+
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
 
@@ -127,26 +132,137 @@ void RpakLib::ExtractUIImageAtlas(const RpakLoadAsset& Asset, const string& Path
 		}
 	}
 
-	std::unique_ptr<Assets::Texture> Texture = nullptr;
+	RpakTextureData Atlas{};
 	string Name;
 
-	this->ExtractTexture(Assets[Header.TextureGuid], Texture, Name);
-	Texture->ConvertToFormat(DXGI_FORMAT_R8G8B8A8_UNORM);
+	if (!this->ExtractTextureData(Assets[Header.TextureGuid], Atlas, Name, false))
+		return;
+
+	// Block compressed atlases are sliced from the raw blocks, anything else is converted once up front
+	bool IsBlockCompressed = DirectX::IsCompressed(Atlas.Format) && !Atlas.IsSwizzled;
+	std::unique_ptr<Assets::Texture> Texture = nullptr;
+
+	if (!IsBlockCompressed)
+	{
+		this->BuildTexture(Atlas, Texture);
+		Texture->ConvertToFormat(DXGI_FORMAT_R8G8B8A8_UNORM);
+	}
+
+	size_t AtlasRowPitch = 0, AtlasSlicePitch = 0;
+	DirectX::ComputePitch(Atlas.Format, Atlas.Width, Atlas.Height, AtlasRowPitch, AtlasSlicePitch);
 
-	for (auto& img : UIAtlasImages)
+	uint32_t BlockSize = IsBlockCompressed ? (uint32_t)DirectX::BitsPerPixel(Atlas.Format) * 2 : 0;
+
+	Threading::ThreadBudget::Run(UIAtlasImages.Count(), [&](uint32_t i)
 	{
-		std::unique_ptr<Assets::Texture> tmp = std::make_unique<Assets::Texture>(img.Width, img.Height, Texture.get()->Format());
-		uint32_t BytesPerPixel = tmp->GetBpp() / 8;
+		// Saving through WIC requires COM on helper threads, every successful init is paired with an uninit
+		struct ComScope
+		{
+			HRESULT Result = CoInitializeEx(0, COINIT_MULTITHREADED);
 
-		DirectX::Rect srcRect{ img.PosX, img.PosY, img.Width, img.Height };
+			~ComScope()
+			{
+				if (SUCCEEDED(Result))
+					CoUninitialize();
+			}
+		} Com;
 
-		tmp->CopyTextureSlice(Texture, srcRect, 0, 0);
+		const UIAtlasImage& img = UIAtlasImages[i];
 
 		string ImageName = string::Format("0x%x%s", img.Hash, (const char*)ImageExtension);
 
 		if (img.Path.Length() > 0)
 			ImageName = string::Format("%s%s", IO::Path::GetFileNameWithoutExtension(img.Path).ToCString(), (const char*)ImageExtension);
 
-		tmp->Save(IO::Path::Combine(Path, ImageName), ImageSaveType);
-	}
-}
\ No newline at end of file
+		string ImagePath = IO::Path::Combine(Path, ImageName);
+
+		if (img.Width == 0 || img.Height == 0)
+			return;
+
+		std::unique_ptr<Assets::Texture> tmp = std::make_unique<Assets::Texture>(img.Width, img.Height, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+		if (!IsBlockCompressed)
+		{
+			tmp->CopyTextureSlice(Texture, DirectX::Rect{ img.PosX, img.PosY, img.Width, img.Height }, 0, 0);
+			ExportProfileScope Profile(ExportStage::TextureSave);
+			tmp->Save(ImagePath, ImageSaveType);
+			return;
+		}
+
+		bool IsInsideAtlas = (uint32_t)img.PosX + img.Width <= Atlas.Width && (uint32_t)img.PosY + img.Height <= Atlas.Height;
+
+		// Block aligned images can be written as dds without decoding anything
+		if (ImageSaveType == Assets::SaveFileType::Dds && IsInsideAtlas && (img.PosX % 4) == 0 && (img.PosY % 4) == 0)
+		{
+			uint32_t BlocksWide = (img.Width + 3) / 4;
+			uint32_t BlocksHigh = (img.Height + 3) / 4;
+			size_t RowSize = (size_t)BlocksWide * BlockSize;
+
+			auto Blocks = std::make_unique<uint8_t[]>(RowSize * BlocksHigh);
+
+			for (uint32_t y = 0; y < BlocksHigh; y++)
+				std::memcpy(Blocks.get() + RowSize * y, Atlas.Pixels.get() + AtlasRowPitch * ((img.PosY / 4) + y) + (size_t)(img.PosX / 4) * BlockSize, RowSize);
+
+			Assets::DDSFormat Format;
+			Format.Format = Atlas.Format;
+
+			ExportProfileScope Profile(ExportStage::FileWrite, RowSize * BlocksHigh);
+			Assets::DDS::WriteDDSFile(ImagePath, img.Width, img.Height, Format, Blocks.get(), RowSize * BlocksHigh);
+			return;
+		}
+
+		if (img.PosX < Atlas.Width && img.PosY < Atlas.Height)
+		{
+			uint32_t CopyWidth = min((uint32_t)img.Width, Atlas.Width - (uint32_t)img.PosX);
+			uint32_t CopyHeight = min((uint32_t)img.Height, Atlas.Height - (uint32_t)img.PosY);
+
+			auto Region = this->DecodeAtlasRegion(Atlas, AtlasRowPitch, img.PosX, img.PosY, CopyWidth, CopyHeight);
+
+			if (Region != nullptr)
+				tmp->CopyTextureSlice(Region, DirectX::Rect{ img.PosX % 4, img.PosY % 4, CopyWidth, CopyHeight }, 0, 0);
+		}
+
+		ExportProfileScope Profile(ExportStage::TextureSave);
+		tmp->Save(ImagePath, ImageSaveType);
+	});
+}
+
+std::unique_ptr<Assets::Texture> RpakLib::DecodeAtlasRegion(const RpakTextureData& Atlas, size_t RowPitch, uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height)
+{
+	// Only the blocks under the region are decoded, the result starts at the block containing (X, Y)
+	uint32_t FirstBlockX = X / 4;
+	uint32_t FirstBlockY = Y / 4;
+	uint32_t BlocksWide = ((X + Width + 3) / 4) - FirstBlockX;
+	uint32_t BlocksHigh = ((Y + Height + 3) / 4) - FirstBlockY;
+	uint32_t BlockSize = (uint32_t)DirectX::BitsPerPixel(Atlas.Format) * 2;
+
+	DirectX::Image Blocks{};
+	Blocks.width = (size_t)BlocksWide * 4;
+	Blocks.height = (size_t)BlocksHigh * 4;
+	Blocks.format = Atlas.Format;
+	Blocks.rowPitch = RowPitch;
+	Blocks.slicePitch = RowPitch * BlocksHigh;
+	Blocks.pixels = Atlas.Pixels.get() + RowPitch * FirstBlockY + (size_t)FirstBlockX * BlockSize;
+
+	DirectX::TexMetadata Metadata{};
+	Metadata.width = Blocks.width;
+	Metadata.height = Blocks.height;
+	Metadata.depth = 1;
+	Metadata.arraySize = 1;
+	Metadata.mipLevels = 1;
+	Metadata.format = Atlas.Format;
+	Metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+	auto Result = std::make_unique<DirectX::ScratchImage>();
+	HRESULT hr;
+
+	if (Assets::TextureCPUDecoder::IsSupported(Atlas.Format, DXGI_FORMAT_R8G8B8A8_UNORM))
+		hr = Assets::TextureCPUDecoder::Decompress(&Blocks, 1, Metadata, DXGI_FORMAT_R8G8B8A8_UNORM, *Result);
+	else
+		hr = DirectX::Decompress(Blocks, DXGI_FORMAT_R8G8B8A8_UNORM, *Result);
+
+	if (FAILED(hr))
+		return nullptr;
+
+	return std::make_unique<Assets::Texture>(Result.release());
+}
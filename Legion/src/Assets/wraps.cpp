@@ -3,6 +3,7 @@
 #include "Path.h"
 #include "Directory.h"
 #include "rtech.h"
+#include "ExportWriter.h"
 
 static string GetSizeinString(uint64_t size) {
 	const uint32_t KB = 1024;
@@ -17,7 +18,7 @@ static string GetSizeinString(uint64_t size) {
 	return string::Format("%d B", size);
 }
 
-void RpakLib::BuildWrapInfo(const RpakLoadAsset& Asset, ApexAsset& Info)
+void RpakLib::BuildWrapInfo(const RpakLoadAsset& Asset, ApexAssetInfo& Info)
 {
 	auto RpakStream = this->GetFileStream(Asset);
 	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
@@ -84,8 +85,6 @@ void RpakLib::ExportWrap(const RpakLoadAsset& Asset, const string& Path)
 	if (!name.Contains("bsp"))
 		Size = ContainsNullByte ? Size : Size - 1;
 
-	std::ofstream out(DestinationPath, std::ios::out | std::ios::binary);
-
 	uint8_t* tmpBuf = new uint8_t[Size];
 
 	if (!IsStreamed)
@@ -123,21 +122,15 @@ void RpakLib::ExportWrap(const RpakLoadAsset& Asset, const string& Path)
 	{
 		std::unique_ptr<IO::MemoryStream> DecompStream = RTech::DecompressStreamedBuffer(tmpBuf, Size, (uint8_t)CompressionType::OODLE);
 
-		uint8_t* outtmpBuf = new uint8_t[Size];
-
-		DecompStream->Read(outtmpBuf, 0, Size);
-
-		out.write((char*)outtmpBuf, Size);
+		auto outtmpBuf = std::make_unique<uint8_t[]>(Size);
 
+		DecompStream->Read(outtmpBuf.get(), 0, Size);
 		DecompStream.release();
 
-		delete[] outtmpBuf;
+		ExportWriter::WriteFile(DestinationPath, std::move(outtmpBuf), Size);
 	}
 	else
 	{
-		out.write((char*)tmpBuf, Size);
-		delete[] tmpBuf;
+		ExportWriter::WriteFile(DestinationPath, std::unique_ptr<uint8_t[]>(tmpBuf), Size);
 	}
-
-	out.close();
 };
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "ExportArchive.h"
+#include "ExportManager.h"
+#include "ExportProfiler.h"
+#include "File.h"
+#include "Path.h"
+#include "Directory.h"
+#include "CRC32.h"
+#include "XXHash.h"
+#include "DeflateCodec.h"
+
+static const char* StagingDirectoryName = "_staging";
+
+static ExportArchive* ActiveArchive = nullptr;
+
+ExportArchive::ExportArchive(const string& ExportDirectory)
+	: ExportDirectory(ExportDirectory), ShardIndex(0)
+{
+	this->ShardSize = (uint64_t)ExportManager::Config.Get<System::SettingType::Integer>("ExportArchiveShardSize") * 1024 * 1024;
+	this->StoreTextures = ExportManager::Config.GetBool("ExportArchiveStoreTextures");
+
+	IO::Directory::CreateDirectory(ExportDirectory);
+
+	this->OpenShard();
+
+	ActiveArchive = this;
+}
+
+ExportArchive::~ExportArchive()
+{
+	this->Close();
+}
+
+void ExportArchive::AddDirectory(const string& StagingPath)
+{
+	if (!IO::Directory::Exists(StagingPath))
+		return;
+
+	List<string> Directories;
+	Directories.EmplaceBack(StagingPath);
+
+	for (uint32_t i = 0; i < Directories.Count(); i++)
+	{
+		for (auto& SubDirectory : IO::Directory::GetDirectories(Directories[i]))
+			Directories.EmplaceBack(SubDirectory);
+
+		for (auto& FilePath : IO::Directory::GetFiles(Directories[i]))
+			this->AddFile(FilePath, FilePath.Substring(StagingPath.Length() + 1));
+	}
+
+	IO::Directory::Delete(StagingPath);
+}
+
+bool ExportArchive::AddBuffer(const string& Path, const uint8_t* Header, uint32_t HeaderSize, const uint8_t* Buffer, uint64_t Size)
+{
+	string FileNameInZip = this->GetNameInArchive(Path);
+
+	if (FileNameInZip.Length() == 0)
+		return false;
+
+	// Assets that share a file each export it, the first copy wins
+	if (!this->Claim(FileNameInZip))
+		return true;
+
+	ExportProfileScope Profile(ExportStage::FileWrite);
+
+	if (HeaderSize == 0)
+	{
+		Profile.AddBytes(this->AddEntry(FileNameInZip, Buffer, Size));
+		return true;
+	}
+
+	// Entries are written from one buffer, the header is small next to the payload
+	auto Contents = std::make_unique<uint8_t[]>(HeaderSize + Size);
+
+	std::memcpy(Contents.get(), Header, HeaderSize);
+	std::memcpy(Contents.get() + HeaderSize, Buffer, Size);
+
+	Profile.AddBytes(this->AddEntry(FileNameInZip, Contents.get(), HeaderSize + Size));
+
+	return true;
+}
+
+bool ExportArchive::Contains(const string& Path)
+{
+	string FileNameInZip = this->GetNameInArchive(Path);
+
+	if (FileNameInZip.Length() == 0)
+		return false;
+
+	auto NameHash = Hashing::XXHash::HashString(FileNameInZip.ToLower());
+
+	std::lock_guard<std::mutex> Lock(this->WriteMutex);
+
+	return this->Entries.ContainsKey(NameHash);
+}
+
+void ExportArchive::Close()
+{
+	std::lock_guard<std::mutex> Lock(this->WriteMutex);
+
+	if (!this->Archive)
+		return;
+
+	this->Archive->Close();
+	this->Archive.reset();
+
+	if (ActiveArchive == this)
+		ActiveArchive = nullptr;
+
+	IO::Directory::Delete(IO::Path::Combine(this->ExportDirectory, StagingDirectoryName));
+}
+
+bool ExportArchive::IsEnabled()
+{
+	return ExportManager::Config.GetBool("ExportArchive");
+}
+
+ExportArchive* ExportArchive::GetActive()
+{
+	return ActiveArchive;
+}
+
+string ExportArchive::GetStagingPath(uint32_t AssetIndex) const
+{
+	return IO::Path::Combine(IO::Path::Combine(this->ExportDirectory, StagingDirectoryName), string::Format("%u", AssetIndex));
+}
+
+string ExportArchive::GetScratchPath(const string& Name) const
+{
+	return IO::Path::Combine(IO::Path::Combine(this->ExportDirectory, StagingDirectoryName), Name);
+}
+
+void ExportArchive::OpenShard()
+{
+	if (this->Archive)
+		this->Archive->Close();
+
+	string ArchivePath = IO::Path::Combine(this->ExportDirectory, "exported_files.zip");
+
+	if (this->ShardSize > 0)
+		ArchivePath = IO::Path::Combine(this->ExportDirectory, string::Format("exported_files_%03u.zip", this->ShardIndex));
+
+	this->Archive = std::make_unique<Compression::ZipArchive>(IO::File::Create(ArchivePath));
+	this->ShardIndex++;
+}
+
+void ExportArchive::AddFile(const string& FilePath, const string& FileNameInZip)
+{
+	// A copy another asset already packed is dropped without reading it
+	if (!this->Claim(FileNameInZip))
+	{
+		IO::File::Delete(FilePath);
+		return;
+	}
+
+	ExportProfileScope Profile(ExportStage::FileWrite);
+
+	std::unique_ptr<uint8_t[]> Buffer;
+	uint64_t FileSize = 0;
+
+	{
+		auto Stream = IO::File::OpenRead(FilePath);
+
+		FileSize = Stream->GetLength();
+		Buffer = std::make_unique<uint8_t[]>(FileSize);
+
+		Stream->Read(Buffer.get(), 0, FileSize);
+	}
+
+	IO::File::Delete(FilePath);
+
+	Profile.AddBytes(this->AddEntry(FileNameInZip, Buffer.get(), FileSize));
+}
+
+uint64_t ExportArchive::AddEntry(const string& FileNameInZip, const uint8_t* Buffer, uint64_t FileSize)
+{
+	auto Crc32 = Hashing::CRC32::ComputeHash((uint8_t*)Buffer, 0, FileSize);
+
+	// Block compressed textures barely shrink, storing them skips the work
+	bool Store = this->StoreTextures && IO::Path::GetExtension(FileNameInZip).ToLower() == ".dds";
+
+	std::unique_ptr<uint8_t[]> Compressed;
+	uint64_t CompressedSize = 0;
+
+	if (!Store)
+	{
+		Compressed = std::make_unique<uint8_t[]>(FileSize);
+		CompressedSize = Compression::DeflateCodec::CompressFinal((uint8_t*)Buffer, 0, FileSize, Compressed.get(), 0, FileSize);
+	}
+
+	std::lock_guard<std::mutex> Lock(this->WriteMutex);
+
+	if (this->ShardSize > 0 && this->Archive->GetBaseStream()->GetPosition() >= this->ShardSize)
+		this->OpenShard();
+
+	if (CompressedSize > 0)
+		this->Archive->AddCompressed(Compression::ZipCompressionMethod::Deflate, FileNameInZip, Compressed.get(), CompressedSize, FileSize, Crc32);
+	else
+		this->Archive->AddCompressed(Compression::ZipCompressionMethod::Store, FileNameInZip, Buffer, FileSize, FileSize, Crc32);
+
+	return (CompressedSize > 0) ? CompressedSize : FileSize;
+}
+
+bool ExportArchive::Claim(const string& FileNameInZip)
+{
+	auto NameHash = Hashing::XXHash::HashString(FileNameInZip.ToLower());
+
+	std::lock_guard<std::mutex> Lock(this->WriteMutex);
+
+	return this->Entries.Add(NameHash, true);
+}
+
+string ExportArchive::GetNameInArchive(const string& Path) const
+{
+	string StagingRoot = IO::Path::Combine(this->ExportDirectory, StagingDirectoryName);
+
+	if (Path.Length() <= StagingRoot.Length() + 1 || !Path.StartsWith(StagingRoot))
+		return "";
+
+	// Asset directories are named by index, anything else below the root is scratch space
+	string StagedPath = Path.Substring(StagingRoot.Length() + 1);
+	uint32_t Separator = StagedPath.IndexOf('\\');
+
+	if (Separator == 0 || Separator == string::InvalidPosition)
+		return "";
+
+	for (uint32_t i = 0; i < Separator; i++)
+	{
+		if (StagedPath[i] < '0' || StagedPath[i] > '9')
+			return "";
+	}
+
+	return StagedPath.Substring(Separator + 1);
+}
@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "ExportBenchmark.h"
+#include "ExportManager.h"
+#include "ExportProfiler.h"
+#include "RpakLib.h"
+#include "File.h"
+#include "Path.h"
+#include "Directory.h"
+#include "StreamWriter.h"
+
+#include <vector>
+
+enum class BenchmarkPhase : uint32_t
+{
+	Mount,
+	List,
+	Export,
+
+	Count
+};
+
+static const char* BenchmarkPhaseNames[] = { "mount", "list", "export" };
+
+struct BenchmarkRun
+{
+	uint64_t Ticks[(uint32_t)BenchmarkPhase::Count];
+	uint64_t Assets;
+
+	// Time the workers spent on each asset type during the export phase
+	std::vector<ExportTypeTotals> Types;
+};
+
+static double BenchmarkMilliseconds(uint64_t Ticks)
+{
+	return (double)Ticks / 1000000.0;
+}
+
+static uint64_t BenchmarkMedian(std::vector<uint64_t> Values)
+{
+	std::sort(Values.begin(), Values.end());
+
+	size_t Middle = Values.size() / 2;
+
+	if (Values.size() % 2 == 0)
+		return (Values[Middle - 1] + Values[Middle]) / 2;
+
+	return Values[Middle];
+}
+
+// Gets what the profiler recorded between two snapshots, types without finished assets are left out
+static std::vector<ExportTypeTotals> BenchmarkTypeDelta(const std::vector<ExportTypeTotals>& Before, const std::vector<ExportTypeTotals>& After)
+{
+	std::vector<ExportTypeTotals> Result;
+
+	for (auto& Type : After)
+	{
+		ExportTypeTotals Delta = Type;
+
+		for (auto& Previous : Before)
+		{
+			if (Previous.AssetType == Type.AssetType)
+			{
+				Delta.Assets -= Previous.Assets;
+				Delta.Ticks -= Previous.Ticks;
+				break;
+			}
+		}
+
+		if (Delta.Assets > 0)
+			Result.push_back(Delta);
+	}
+
+	return Result;
+}
+
+bool ExportBenchmark::Run(const string& Path, const std::array<bool, 11>& Assets, uint32_t Runs)
+{
+	if (Runs == 0)
+		return false;
+
+	uint64_t PakSize = 0;
+
+	try
+	{
+		PakSize = IO::File::OpenRead(Path)->GetLength();
+	}
+	catch (...)
+	{
+		g_Logger.Info("Benchmark failed to open %s\n", Path.ToCString());
+		return false;
+	}
+
+	// Later runs would skip every file the first run wrote
+	bool Overwrite = ExportManager::Config.GetBool("OverwriteExistingFiles");
+	ExportManager::Config.SetBool("OverwriteExistingFiles", true);
+
+	// Per type times come from the profiler, its scopes add a little to every run
+	if (!ExportProfiler::IsEnabled())
+		ExportProfiler::Enable();
+
+	std::vector<BenchmarkRun> Results;
+
+	for (uint32_t i = 0; i < Runs; i++)
+	{
+		BenchmarkRun Result{};
+
+		uint64_t Start = ExportProfiler::GetTicks();
+
+		auto Rpak = std::make_unique<RpakLib>();
+		Rpak->LoadRpak(Path);
+		Rpak->PatchAssets();
+
+		uint64_t Mounted = ExportProfiler::GetTicks();
+
+		auto AssetList = Rpak->BuildAssetList(Assets);
+
+		uint64_t Listed = ExportProfiler::GetTicks();
+
+		List<ExportAsset> ExportAssets;
+
+		for (auto& Asset : *AssetList.get())
+		{
+			ExportAsset EAsset;
+			EAsset.AssetHash = Asset.Hash;
+			EAsset.AssetIndex = 0;
+			ExportAssets.EmplaceBack(EAsset);
+		}
+
+		auto TypesBefore = ExportProfiler::GetTypeTotals();
+
+		ExportManager::ExportRpakAssets(Rpak, ExportAssets, [](uint32_t i, Forms::Form*, bool) {}, [](int32_t i, Forms::Form*) -> bool { return false; }, nullptr);
+
+		uint64_t Exported = ExportProfiler::GetTicks();
+
+		Result.Ticks[(uint32_t)BenchmarkPhase::Mount] = Mounted - Start;
+		Result.Ticks[(uint32_t)BenchmarkPhase::List] = Listed - Mounted;
+		Result.Ticks[(uint32_t)BenchmarkPhase::Export] = Exported - Listed;
+		Result.Assets = ExportAssets.Count();
+		Result.Types = BenchmarkTypeDelta(TypesBefore, ExportProfiler::GetTypeTotals());
+
+		g_Logger.Info("Benchmark run %u/%u: mount %.3f ms, list %.3f ms, export %.3f ms, %llu assets\n", i + 1, Runs,
+			BenchmarkMilliseconds(Result.Ticks[(uint32_t)BenchmarkPhase::Mount]),
+			BenchmarkMilliseconds(Result.Ticks[(uint32_t)BenchmarkPhase::List]),
+			BenchmarkMilliseconds(Result.Ticks[(uint32_t)BenchmarkPhase::Export]),
+			Result.Assets);
+
+		Results.push_back(Result);
+	}
+
+	ExportManager::Config.SetBool("OverwriteExistingFiles", Overwrite);
+
+	string ReportPath = IO::Path::Combine(ExportManager::ExportPath, "export_benchmark.json");
+
+	try
+	{
+		IO::Directory::CreateDirectory(ExportManager::ExportPath);
+		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(ReportPath));
+
+		uint64_t AssetCount = Results[0].Assets;
+
+		Writer.WriteLine("{");
+		Writer.WriteLineFmt("\t\"pak\": \"%s\",", IO::Path::GetFileName(Path).ToCString());
+		Writer.WriteLineFmt("\t\"pak_bytes\": %llu,", PakSize);
+		Writer.WriteLineFmt("\t\"assets\": %llu,", AssetCount);
+		Writer.WriteLineFmt("\t\"runs\": %u,", Runs);
+		Writer.WriteLine("\t\"phases\": [");
+
+		for (uint32_t p = 0; p < (uint32_t)BenchmarkPhase::Count; p++)
+		{
+			std::vector<uint64_t> Ticks;
+
+			for (auto& Result : Results)
+				Ticks.push_back(Result.Ticks[p]);
+
+			double BestMs = BenchmarkMilliseconds(*std::min_element(Ticks.begin(), Ticks.end()));
+			double MedianMs = BenchmarkMilliseconds(BenchmarkMedian(Ticks));
+
+			// Mounting is measured against the size of the pak, the other phases against the assets they handle
+			double Throughput = 0.0;
+
+			if (MedianMs > 0.0)
+			{
+				if (p == (uint32_t)BenchmarkPhase::Mount)
+					Throughput = ((double)PakSize / (1024.0 * 1024.0)) / (MedianMs / 1000.0);
+				else
+					Throughput = (double)AssetCount / (MedianMs / 1000.0);
+			}
+
+			Writer.WriteFmt("\t\t{ \"phase\": \"%s\", \"best_ms\": %.3f, \"median_ms\": %.3f, \"%s\": %.2f, \"runs_ms\": [", BenchmarkPhaseNames[p], BestMs, MedianMs, (p == (uint32_t)BenchmarkPhase::Mount) ? "mb_per_s" : "assets_per_s", Throughput);
+
+			for (size_t i = 0; i < Ticks.size(); i++)
+				Writer.WriteFmt("%s%.3f", (i > 0) ? ", " : "", BenchmarkMilliseconds(Ticks[i]));
+
+			Writer.WriteLine((p + 1 < (uint32_t)BenchmarkPhase::Count) ? "] }," : "] }");
+		}
+
+		Writer.WriteLine("\t],");
+
+		// Summed over every worker, so a type can take longer than the export phase itself
+		Writer.WriteLine("\t\"asset_types\": [");
+
+		auto& Types = Results[0].Types;
+
+		for (size_t t = 0; t < Types.size(); t++)
+		{
+			std::vector<uint64_t> Ticks;
+
+			for (auto& Result : Results)
+			{
+				auto It = std::find_if(Result.Types.begin(), Result.Types.end(), [&Types, t](const ExportTypeTotals& Value) { return Value.AssetType == Types[t].AssetType; });
+				Ticks.push_back((It != Result.Types.end()) ? It->Ticks : 0);
+			}
+
+			Writer.WriteFmt("\t\t{ \"type\": \"%s\", \"assets\": %llu, \"best_ms\": %.3f, \"median_ms\": %.3f, \"runs_ms\": [", Utils::GetAssetTypeName(Types[t].AssetType).ToCString(), Types[t].Assets,
+				BenchmarkMilliseconds(*std::min_element(Ticks.begin(), Ticks.end())),
+				BenchmarkMilliseconds(BenchmarkMedian(Ticks)));
+
+			for (size_t i = 0; i < Ticks.size(); i++)
+				Writer.WriteFmt("%s%.3f", (i > 0) ? ", " : "", BenchmarkMilliseconds(Ticks[i]));
+
+			Writer.WriteLine((t + 1 < Types.size()) ? "] }," : "] }");
+		}
+
+		Writer.WriteLine("\t]");
+		Writer.WriteLine("}");
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	g_Logger.Info("Exported benchmark: %s\n", ReportPath.ToCString());
+
+	return true;
+}
@@ -1,11 +1,16 @@
 #include "pch.h"
 #include "ExportManager.h"
 #include "ParallelTask.h"
+#include "ThreadBudget.h"
 #include "Path.h"
 #include "Directory.h"
 #include "File.h"
 #include "Environment.h"
 #include "LegionMain.h"
+#include "ExportMemoryBudget.h"
+#include "ExportArchive.h"
+#include "ExportWriter.h"
+#include "ExportProgress.h"
 
 #define CONFIG_PATH "LegionPlus.cfg"
 
@@ -64,6 +69,15 @@ void ExportManager::InitializeExporter()
 	INIT_SETTING(Boolean, "LoadEffects", true);
 	INIT_SETTING(Boolean, "LoadRSONs", true);
 	INIT_SETTING(Boolean, "OverwriteExistingFiles", false);
+	INIT_SETTING(Boolean, "ExportImageMips", false);
+	INIT_SETTING(Integer, "ExportMemoryBudget", (uint32_t)0); // MB, 0 uses half of the physical memory
+	INIT_SETTING(Boolean, "ExportArchive", false);
+	INIT_SETTING(Integer, "ExportArchiveShardSize", (uint32_t)0); // MB, 0 writes a single archive
+	INIT_SETTING(Boolean, "ExportArchiveStoreTextures", true);
+	INIT_SETTING(Boolean, "DeduplicateImages", false);
+	INIT_SETTING(Integer, "ExportWriterThreads", (uint32_t)2); // 0 writes on the export workers
+	INIT_SETTING(Integer, "ExportWriterQueueSize", (uint32_t)256); // MB
+	INIT_SETTING(Boolean, "ExportLongestFirst", true);
 
 	Config.Save(ConfigPath);
 }
@@ -96,17 +110,18 @@ void ExportManager::ExportMilesAssets(const std::unique_ptr<MilesLib>& MilesFile
 {
 	std::atomic<uint32_t> AssetIndex = 0;
 
-	std::mutex UpdateMutex;
-	uint32_t CurrentProgress = 0;
 	string ExportDirectory = ExportPath;
 
 	IO::Directory::CreateDirectory(IO::Path::Combine(ExportDirectory, "sounds"));
 
-	Threading::ParallelTask([&MilesFileSystem, &ExportAssets, &ProgressCallback, &StatusCallback, &MainForm, &AssetIndex, &CurrentProgress, &UpdateMutex, ExportDirectory]
-	{
-		bool IsCancel = false;
+	// Export in the order the data is stored so each stream bank is read sequentially
+	MilesFileSystem->SortByStreamOffset(ExportAssets);
 
-		while (AssetIndex < ExportAssets.Count() && !IsCancel)
+	ExportProgress Progress(ExportAssets.Count(), ProgressCallback, StatusCallback, MainForm);
+
+	Threading::ParallelTask([&MilesFileSystem, &ExportAssets, &AssetIndex, &Progress, ExportDirectory]
+	{
+		while (AssetIndex < ExportAssets.Count() && !ExportCancellation::IsRequested())
 		{
 			unsigned int AssetToConvert = AssetIndex++;
 
@@ -122,40 +137,23 @@ void ExportManager::ExportMilesAssets(const std::unique_ptr<MilesLib>& MilesFile
 				IO::Directory::CreateDirectory(IO::Path::Combine(Path, Name));
 				Path = IO::Path::Combine(Path, Name);
 			}
-			Path = IO::Path::Combine(Path, AudioAsset.Name + ".wav");
+			Path = IO::Path::Combine(Path, string(AudioAsset.Name) + ".wav");
 
-			bool bSuccess = MilesFileSystem->ExtractAsset(AudioAsset, Path);
-
-			if (!bSuccess)
-			{
-				((LegionMain*)MainForm)->SetAssetError(Asset.AssetIndex);
-				continue;
-			}
-
-			IsCancel = StatusCallback(Asset.AssetIndex, MainForm);
-
-			{
-				std::lock_guard<std::mutex> UpdateLock(UpdateMutex);
-				uint32_t NewProgress = (uint32_t)(((float)(AssetToConvert + 1) / (float)ExportAssets.Count()) * 100.f);
-
-				if (NewProgress > CurrentProgress)
-				{
-					CurrentProgress = NewProgress;
-					ProgressCallback(NewProgress, MainForm, false);
-				}
-			}
+			if (MilesFileSystem->ExtractAsset(AudioAsset, Path))
+				Progress.AssetExported(AssetToConvert, Asset.AssetIndex);
+			else
+				Progress.AssetFailed(AssetToConvert, Asset.AssetIndex);
 		}
-		ProgressCallback(100, MainForm, true);
 	});
 
+	Progress.Finish();
+
+	ProgressCallback(100, MainForm, true);
+
 }
 
 void ExportManager::ExportRpakAssets(const std::unique_ptr<RpakLib>& RpakFileSystem, List<ExportAsset> ExportAssets, ExportProgressCallback ProgressCallback, CheckStatusCallback StatusCallback, Forms::Form* MainForm)
 {
-	std::atomic<uint32_t> AssetIndex = 0;
-
-	std::mutex UpdateMutex;
-	uint32_t CurrentProgress = 0;
 	string ExportDirectory = ExportPath;
 
 	//IO::Directory::CreateDirectory(IO::Path::Combine(ExportDirectory, "images"));
@@ -174,88 +172,147 @@ void ExportManager::ExportRpakAssets(const std::unique_ptr<RpakLib>& RpakFileSys
 	RpakFileSystem->InitializeAnimExporter((AnimExportFormat_t)Config.Get<System::SettingType::Integer>("AnimFormat"));
 	RpakFileSystem->InitializeImageExporter((ImageExportFormat_t)Config.Get<System::SettingType::Integer>("ImageFormat"));
 
-	Threading::ParallelTask([&RpakFileSystem, &ExportAssets, &ProgressCallback, &StatusCallback, &MainForm, &AssetIndex, &CurrentProgress, &UpdateMutex, ExportDirectory]
+	ExportMemoryBudget MemoryBudget(ExportMemoryBudget::GetConfiguredLimit());
+
+	std::unique_ptr<ExportArchive> Archive;
+
+	if (ExportArchive::IsEnabled())
+		Archive = std::make_unique<ExportArchive>(ExportDirectory);
+
+	// Textures sharing a payload are written once and linked under every other name
+	if (Config.GetBool("DeduplicateImages"))
+		RpakFileSystem->SetTextureStorePath((Archive) ? Archive->GetScratchPath("_textures") : IO::Path::Combine(ExportDirectory, "_textures"));
+
+	// Staged files are packed as soon as their asset is done, so archives keep writing on the workers
+	if (!Archive)
+		ExportWriter::Start(ExportWriter::GetConfiguredThreadCount(), ExportWriter::GetConfiguredQueueLimit());
+
+	List<uint64_t> PredictedTicks(ExportAssets.Count(), true);
+	List<uint64_t> PredictedMemory(ExportAssets.Count(), true);
+	List<uint32_t> ExportOrder(ExportAssets.Count(), true);
+
+	for (uint32_t i = 0; i < ExportAssets.Count(); i++)
+	{
+		RpakExportEstimate Estimate = RpakFileSystem->EstimateExport(RpakFileSystem->Assets[ExportAssets[i].AssetHash]);
+
+		PredictedTicks[i] = Estimate.Ticks;
+		PredictedMemory[i] = Estimate.Memory;
+		ExportOrder[i] = i;
+	}
+
+	// The longest exports go first so a large asset picked up late can't keep one worker busy after the rest are done,
+	// the small ones fill in behind them while large ones that don't fit the memory budget are set aside
+	if (Config.GetBool("ExportLongestFirst"))
+		std::stable_sort(ExportOrder.begin(), ExportOrder.end(), [&PredictedTicks](uint32_t lhs, uint32_t rhs) { return PredictedTicks[lhs] > PredictedTicks[rhs]; });
+
+	List<uint64_t> SlotMemory(ExportAssets.Count(), true);
+
+	for (uint32_t i = 0; i < ExportAssets.Count(); i++)
+		SlotMemory[i] = PredictedMemory[ExportOrder[i]];
+
+	// Assets that don't fit the memory budget yet are set aside while the worker takes the next one
+	ExportMemoryQueue MemoryQueue(std::move(SlotMemory));
+
+	ExportProgress Progress(ExportAssets.Count(), ProgressCallback, StatusCallback, MainForm);
+
+	Threading::ParallelTask([&RpakFileSystem, &ExportAssets, &Progress, &MemoryBudget, &MemoryQueue, &Archive, &PredictedTicks, &ExportOrder, ExportDirectory]
 	{
 		(void)CoInitializeEx(0, COINIT_MULTITHREADED);
 
-		bool IsCancel = false;
+		// Workers hold a core each, nested tasks only borrow the cores of workers that already ran out of assets
+		uint32_t HeldThreads = Threading::ThreadBudget::TryTake(1);
 
-		while (AssetIndex < ExportAssets.Count() && !IsCancel)
+		while (!ExportCancellation::IsRequested())
 		{
-			auto AssetToConvert = AssetIndex++;
+			ExportMemoryReservation Reservation(MemoryBudget);
+			uint32_t AssetToConvert = 0;
 
-			if (AssetToConvert >= ExportAssets.Count())
-				continue;
+			if (!MemoryQueue.Next(AssetToConvert, Reservation))
+				break;
 
-			auto& Asset = ExportAssets[AssetToConvert];
+			auto ListIndex = ExportOrder[AssetToConvert];
+			auto& Asset = ExportAssets[ListIndex];
 			auto& AssetToExport = RpakFileSystem->Assets[Asset.AssetHash];
 
+			ExportAssetProfileScope Profile(Asset.AssetHash, AssetToExport.AssetType, PredictedTicks[ListIndex]);
+
+			// Packed exports go to the asset's own directory first
+			string AssetDirectory = (Archive) ? Archive->GetStagingPath(AssetToConvert) : ExportDirectory;
+
 			switch (AssetToExport.AssetType)
 			{
 			case (uint32_t)AssetType_t::Texture:
-				RpakFileSystem->ExportTexture(AssetToExport, IO::Path::Combine(ExportDirectory, "images"), true);
+				RpakFileSystem->ExportTexture(AssetToExport, IO::Path::Combine(AssetDirectory, "images"), true);
 				break;
 			case (uint32_t)AssetType_t::UIIA:
-				RpakFileSystem->ExportUIIA(AssetToExport, IO::Path::Combine(ExportDirectory, "images"));
+				RpakFileSystem->ExportUIIA(AssetToExport, IO::Path::Combine(AssetDirectory, "images"));
 				break;
 			case (uint32_t)AssetType_t::Material:
-				RpakFileSystem->ExportMaterial(AssetToExport, IO::Path::Combine(ExportDirectory, "materials"));
+				RpakFileSystem->ExportMaterial(AssetToExport, IO::Path::Combine(AssetDirectory, "materials"));
 				break;
 			case (uint32_t)AssetType_t::Model:
-				RpakFileSystem->ExportModel(AssetToExport, IO::Path::Combine(ExportDirectory, "models"), IO::Path::Combine(ExportDirectory, "animations"));
+				RpakFileSystem->ExportModel(AssetToExport, IO::Path::Combine(AssetDirectory, "models"), IO::Path::Combine(AssetDirectory, "animations"));
 				break;
 			case (uint32_t)AssetType_t::AnimationRig:
-				RpakFileSystem->ExportAnimationRig(AssetToExport, IO::Path::Combine(ExportDirectory, "animations"));
+				RpakFileSystem->ExportAnimationRig(AssetToExport, IO::Path::Combine(AssetDirectory, "animations"));
 				break;
 			case (uint32_t)AssetType_t::Animation:
-				RpakFileSystem->ExportAnimationSeq(AssetToExport, IO::Path::Combine(ExportDirectory, "anim_sequences"));
+				RpakFileSystem->ExportAnimationSeq(AssetToExport, IO::Path::Combine(AssetDirectory, "anim_sequences"));
 				break;
 			case (uint32_t)AssetType_t::DataTable:
-				RpakFileSystem->ExportDataTable(AssetToExport, IO::Path::Combine(ExportDirectory, "datatables"));
+				RpakFileSystem->ExportDataTable(AssetToExport, IO::Path::Combine(AssetDirectory, "datatables"));
 				break;
 			case (uint32_t)AssetType_t::Subtitles:
-				RpakFileSystem->ExportSubtitles(AssetToExport, IO::Path::Combine(ExportDirectory, "subtitles"));
+				RpakFileSystem->ExportSubtitles(AssetToExport, IO::Path::Combine(AssetDirectory, "subtitles"));
 				break;
 			case (uint32_t)AssetType_t::ShaderSet:
-				RpakFileSystem->ExportShaderSet(AssetToExport, IO::Path::Combine(ExportDirectory, "shadersets"));
+				RpakFileSystem->ExportShaderSet(AssetToExport, IO::Path::Combine(AssetDirectory, "shadersets"));
 				break;
 			case (uint32_t)AssetType_t::UIImageAtlas:
-				RpakFileSystem->ExportUIImageAtlas(AssetToExport, IO::Path::Combine(ExportDirectory, "atlases"));
+				RpakFileSystem->ExportUIImageAtlas(AssetToExport, IO::Path::Combine(AssetDirectory, "atlases"));
 				break;
 			case (uint32_t)AssetType_t::Settings:
-				RpakFileSystem->ExportSettings(AssetToExport, IO::Path::Combine(ExportDirectory, "settings"));
+				RpakFileSystem->ExportSettings(AssetToExport, IO::Path::Combine(AssetDirectory, "settings"));
 				break;
 			case (uint32_t)AssetType_t::SettingsLayout:
-				RpakFileSystem->ExportSettingsLayout(AssetToExport, IO::Path::Combine(ExportDirectory, "settings_layouts"));
+				RpakFileSystem->ExportSettingsLayout(AssetToExport, IO::Path::Combine(AssetDirectory, "settings_layouts"));
 				break;
 			case (uint32_t)AssetType_t::RSON:
-				RpakFileSystem->ExportRSON(AssetToExport, IO::Path::Combine(ExportDirectory, "rson"));
+				RpakFileSystem->ExportRSON(AssetToExport, IO::Path::Combine(AssetDirectory, "rson"));
 				break;
 			case (uint32_t)AssetType_t::RUI:
-				RpakFileSystem->ExportRUI(AssetToExport, IO::Path::Combine(ExportDirectory, "rui"));
+				RpakFileSystem->ExportRUI(AssetToExport, IO::Path::Combine(AssetDirectory, "rui"));
 				break;
 			case (uint32_t)AssetType_t::Wrap:
-				RpakFileSystem->ExportWrap(AssetToExport, IO::Path::Combine(ExportDirectory, "wraps"));
+				RpakFileSystem->ExportWrap(AssetToExport, IO::Path::Combine(AssetDirectory, "wraps"));
 				break;
 			}
 
-			IsCancel = StatusCallback(Asset.AssetIndex, MainForm);
+			// Extractors return early once a cancel is requested, a partial asset is neither packed nor reported
+			if (ExportCancellation::IsRequested())
+				break;
 
-			{
-				std::lock_guard<std::mutex> UpdateLock(UpdateMutex);
-				auto NewProgress = (uint32_t)(((float)AssetToConvert / (float)ExportAssets.Count()) * 100.f);
-
-				if (NewProgress > CurrentProgress)
-				{
-					CurrentProgress = NewProgress;
-					ProgressCallback(NewProgress, MainForm, false);
-				}
-			}
+			if (Archive)
+				Archive->AddDirectory(AssetDirectory);
+
+			Progress.AssetExported(AssetToConvert, Asset.AssetIndex);
 		}
 
+		Threading::ThreadBudget::Return(HeldThreads);
+
 		CoUninitialize();
 	});
 
+	Progress.Finish();
+
+	ExportWriter::Stop();
+	RpakFileSystem->SetTextureStorePath("");
+
+	if (Archive)
+		Archive->Close();
+
+	RpakFileSystem->LogMemoCacheStats();
+
 	ProgressCallback(100, MainForm, true);
 }
 
@@ -294,7 +351,7 @@ void ExportManager::ExportMdlAssets(const std::unique_ptr<MdlLib>& MdlFS, List<s
 	});
 }
 
-void ExportManager::ExportAssetList(std::unique_ptr<List<ApexAsset>>& AssetList, string RpakName, const string& FilePath)
+void ExportManager::ExportAssetList(std::unique_ptr<ApexAssetList>& AssetList, string RpakName, const string& FilePath)
 {
 	string ExportDirectory = IO::Path::Combine(ExportPath, "lists");
 	IO::Directory::CreateDirectory(ExportDirectory);
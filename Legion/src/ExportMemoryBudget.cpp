@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "ExportMemoryBudget.h"
+#include "ExportManager.h"
+
+// Reservations below this aren't counted, small assets keep flowing no matter how full the budget is
+constexpr uint64_t ExportMemorySmallAsset = 4ull * 1024 * 1024;
+
+ExportMemoryBudget::ExportMemoryBudget(uint64_t Limit)
+	: Limit(max(Limit, 1ull)), InUse(0)
+{
+}
+
+uint64_t ExportMemoryBudget::Acquire(uint64_t Bytes)
+{
+	Bytes = this->GetCountedBytes(Bytes);
+
+	if (Bytes == 0)
+		return 0;
+
+	std::unique_lock<std::mutex> Lock(this->Mutex);
+
+	this->Available.wait(Lock, [this, Bytes] { return this->InUse + Bytes <= this->Limit; });
+	this->InUse += Bytes;
+
+	return Bytes;
+}
+
+bool ExportMemoryBudget::TryAcquire(uint64_t Bytes, uint64_t& Reserved)
+{
+	Bytes = this->GetCountedBytes(Bytes);
+	Reserved = 0;
+
+	if (Bytes == 0)
+		return true;
+
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	if (this->InUse + Bytes > this->Limit)
+		return false;
+
+	this->InUse += Bytes;
+	Reserved = Bytes;
+
+	return true;
+}
+
+void ExportMemoryBudget::Release(uint64_t Bytes)
+{
+	if (Bytes == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(this->Mutex);
+		this->InUse -= Bytes;
+	}
+
+	this->Available.notify_all();
+}
+
+uint64_t ExportMemoryBudget::GetConfiguredLimit()
+{
+	uint64_t LimitMB = (uint64_t)ExportManager::Config.Get<System::SettingType::Integer>("ExportMemoryBudget");
+
+	if (LimitMB > 0)
+		return LimitMB * 1024 * 1024;
+
+	MEMORYSTATUSEX Status{};
+	Status.dwLength = sizeof(Status);
+
+	if (GlobalMemoryStatusEx(&Status))
+		return Status.ullTotalPhys / 2;
+
+	return 4ull * 1024 * 1024 * 1024;
+}
+
+uint64_t ExportMemoryBudget::GetCountedBytes(uint64_t Bytes) const
+{
+	if (Bytes < ExportMemorySmallAsset)
+		return 0;
+
+	// Anything larger than the whole budget runs on its own
+	return min(Bytes, this->Limit);
+}
+
+ExportMemoryReservation::ExportMemoryReservation(ExportMemoryBudget& Budget)
+	: Budget(Budget), Bytes(0)
+{
+}
+
+ExportMemoryReservation::~ExportMemoryReservation()
+{
+	this->Budget.Release(this->Bytes);
+}
+
+void ExportMemoryReservation::Acquire(uint64_t Bytes)
+{
+	this->Bytes += this->Budget.Acquire(Bytes);
+}
+
+bool ExportMemoryReservation::TryAcquire(uint64_t Bytes)
+{
+	uint64_t Reserved = 0;
+
+	if (!this->Budget.TryAcquire(Bytes, Reserved))
+		return false;
+
+	this->Bytes += Reserved;
+	return true;
+}
+
+ExportMemoryQueue::ExportMemoryQueue(List<uint64_t> SlotBytes)
+	: SlotBytes(std::move(SlotBytes)), NextSlot(0)
+{
+}
+
+bool ExportMemoryQueue::Next(uint32_t& Slot, ExportMemoryReservation& Reservation)
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(this->DeferredMutex);
+
+			// Set aside slots go first once there's room for them
+			for (auto It = this->Deferred.begin(); It != this->Deferred.end(); It++)
+			{
+				if (Reservation.TryAcquire(this->SlotBytes[*It]))
+				{
+					Slot = *It;
+					this->Deferred.erase(It);
+					return true;
+				}
+			}
+		}
+
+		uint32_t Candidate = this->NextSlot++;
+
+		if (Candidate < this->SlotBytes.Count())
+		{
+			if (Reservation.TryAcquire(this->SlotBytes[Candidate]))
+			{
+				Slot = Candidate;
+				return true;
+			}
+
+			std::lock_guard<std::mutex> Lock(this->DeferredMutex);
+			this->Deferred.push_back(Candidate);
+
+			continue;
+		}
+
+		// Only slots that don't fit are left, wait for room for the oldest one
+		{
+			std::lock_guard<std::mutex> Lock(this->DeferredMutex);
+
+			if (this->Deferred.empty())
+				return false;
+
+			Slot = this->Deferred.front();
+			this->Deferred.pop_front();
+		}
+
+		Reservation.Acquire(this->SlotBytes[Slot]);
+		return true;
+	}
+}
@@ -0,0 +1,480 @@
+#include "pch.h"
+#include "ExportProfiler.h"
+#include "ExportWriter.h"
+#include "File.h"
+#include "StreamWriter.h"
+#include "ThreadBudget.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Names used in the report, in ExportStage order
+static const char* ExportStageNames[] = { "mount", "decompress", "extract", "export_model", "export_animation", "texture_save", "file_write" };
+
+// Slowest assets reported for each asset type
+constexpr uint32_t ExportOutliersPerType = 10;
+
+struct ExportStageCounters
+{
+	uint64_t Calls;
+	uint64_t Ticks;
+	uint64_t Bytes;
+};
+
+struct ExportTypeProfile
+{
+	uint32_t AssetType;
+	uint64_t Assets;
+	uint64_t Ticks;
+	uint64_t MaxTicks;
+	uint64_t PredictedTicks;
+
+	ExportStageCounters Stages[(uint32_t)ExportStage::Count];
+};
+
+struct ExportAssetSample
+{
+	uint64_t Hash;
+	uint32_t AssetType;
+	uint64_t Ticks;
+	uint64_t PredictedTicks;
+};
+
+struct ExportThreadProfile
+{
+	uint32_t ThreadId;
+
+	// The asset being exported right now, type 0 when stages run outside of an asset
+	uint64_t AssetHash;
+	uint32_t AssetType;
+	uint64_t AssetStart;
+	uint64_t AssetPredictedTicks;
+
+	// Open scopes of each stage
+	uint32_t StageDepth[(uint32_t)ExportStage::Count];
+
+	std::vector<ExportTypeProfile> Types;
+	std::vector<ExportAssetSample> Assets;
+
+	// Threads borrowed by loops of this thread record here, they are reused by later loops once they detach
+	std::vector<std::unique_ptr<ExportThreadProfile>> Helpers;
+	bool IsAttached;
+
+	ExportTypeProfile& GetType(uint32_t Type)
+	{
+		for (auto& Profile : this->Types)
+		{
+			if (Profile.AssetType == Type)
+				return Profile;
+		}
+
+		ExportTypeProfile Profile{};
+		Profile.AssetType = Type;
+
+		this->Types.push_back(Profile);
+		return this->Types.back();
+	}
+};
+
+static std::mutex ProfileThreadsMutex;
+static std::vector<std::unique_ptr<ExportThreadProfile>> ProfileThreads;
+static thread_local ExportThreadProfile* CurrentThreadProfile = nullptr;
+static uint64_t ProfileStartTicks = 0;
+
+std::atomic<bool> ExportProfiler::Enabled = false;
+
+static std::unique_ptr<ExportThreadProfile> CreateThreadProfile(uint32_t ThreadId)
+{
+	auto Profile = std::make_unique<ExportThreadProfile>();
+	std::memset(Profile->StageDepth, 0, sizeof(Profile->StageDepth));
+	Profile->ThreadId = ThreadId;
+	Profile->AssetHash = 0;
+	Profile->AssetType = 0;
+	Profile->AssetStart = 0;
+	Profile->AssetPredictedTicks = 0;
+	Profile->IsAttached = false;
+
+	return Profile;
+}
+
+static ExportThreadProfile* GetThreadProfile()
+{
+	if (CurrentThreadProfile == nullptr)
+	{
+		auto Profile = CreateThreadProfile(GetCurrentThreadId());
+
+		std::lock_guard<std::mutex> Lock(ProfileThreadsMutex);
+
+		CurrentThreadProfile = Profile.get();
+		ProfileThreads.push_back(std::move(Profile));
+	}
+
+	return CurrentThreadProfile;
+}
+
+// Books the stages of borrowed threads to the asset and the open stages of the thread that borrowed them
+class ExportProfileContext : public Threading::ThreadBudgetContext
+{
+public:
+	ExportProfileContext(ExportThreadProfile* Parent)
+		: Parent(Parent), AssetHash(Parent->AssetHash), AssetType(Parent->AssetType)
+	{
+		std::memcpy(this->StageDepth, Parent->StageDepth, sizeof(this->StageDepth));
+	}
+
+	virtual void Attach()
+	{
+		ExportThreadProfile* Profile = nullptr;
+
+		{
+			std::lock_guard<std::mutex> Lock(ProfileThreadsMutex);
+
+			for (auto& Helper : this->Parent->Helpers)
+			{
+				if (!Helper->IsAttached)
+				{
+					Profile = Helper.get();
+					break;
+				}
+			}
+
+			if (Profile == nullptr)
+			{
+				this->Parent->Helpers.push_back(CreateThreadProfile(this->Parent->ThreadId));
+				Profile = this->Parent->Helpers.back().get();
+			}
+
+			Profile->IsAttached = true;
+		}
+
+		// Stages the parent has open are already timed by it, nested scopes on the helper only add calls and bytes
+		Profile->AssetHash = this->AssetHash;
+		Profile->AssetType = this->AssetType;
+		std::memcpy(Profile->StageDepth, this->StageDepth, sizeof(Profile->StageDepth));
+
+		CurrentThreadProfile = Profile;
+	}
+
+	virtual void Detach()
+	{
+		std::lock_guard<std::mutex> Lock(ProfileThreadsMutex);
+
+		CurrentThreadProfile->IsAttached = false;
+		CurrentThreadProfile = nullptr;
+	}
+
+private:
+	ExportThreadProfile* Parent;
+	uint64_t AssetHash;
+	uint32_t AssetType;
+	uint32_t StageDepth[(uint32_t)ExportStage::Count];
+};
+
+static std::unique_ptr<Threading::ThreadBudgetContext> CaptureProfileContext()
+{
+	if (!ExportProfiler::IsEnabled())
+		return nullptr;
+
+	return std::make_unique<ExportProfileContext>(GetThreadProfile());
+}
+
+// Calls the callback for a thread profile and the profiles of every thread it borrowed
+template<typename F>
+static void ForEachThreadProfile(const ExportThreadProfile& Profile, const F& Callback)
+{
+	Callback(Profile);
+
+	for (auto& Helper : Profile.Helpers)
+		ForEachThreadProfile(*Helper, Callback);
+}
+
+static double TicksToMilliseconds(uint64_t Ticks)
+{
+	return (double)Ticks / 1000000.0;
+}
+
+static void WriteStages(IO::StreamWriter& Writer, const ExportStageCounters* Stages)
+{
+	Writer.Write("[");
+
+	bool IsFirst = true;
+
+	for (uint32_t i = 0; i < (uint32_t)ExportStage::Count; i++)
+	{
+		if (Stages[i].Calls == 0)
+			continue;
+
+		Writer.WriteFmt("%s{ \"stage\": \"%s\", \"calls\": %llu, \"ms\": %.3f, \"bytes\": %llu }", IsFirst ? "" : ", ", ExportStageNames[i], Stages[i].Calls, TicksToMilliseconds(Stages[i].Ticks), Stages[i].Bytes);
+		IsFirst = false;
+	}
+
+	Writer.Write("]");
+}
+
+static void AddStages(ExportStageCounters* Result, const ExportStageCounters* Stages)
+{
+	for (uint32_t i = 0; i < (uint32_t)ExportStage::Count; i++)
+	{
+		Result[i].Calls += Stages[i].Calls;
+		Result[i].Ticks += Stages[i].Ticks;
+		Result[i].Bytes += Stages[i].Bytes;
+	}
+}
+
+void ExportProfiler::Enable()
+{
+	ProfileStartTicks = GetTicks();
+	Enabled = true;
+
+	Threading::ThreadBudget::SetCapture(CaptureProfileContext);
+}
+
+bool ExportProfiler::IsEnabled()
+{
+	return Enabled.load(std::memory_order_relaxed);
+}
+
+void ExportProfiler::EnterStage(ExportStage Stage)
+{
+	GetThreadProfile()->StageDepth[(uint32_t)Stage]++;
+}
+
+void ExportProfiler::LeaveStage(ExportStage Stage, uint64_t Ticks, uint64_t Bytes)
+{
+	ExportThreadProfile* Profile = GetThreadProfile();
+	ExportStageCounters& Counters = Profile->GetType(Profile->AssetType).Stages[(uint32_t)Stage];
+
+	Counters.Calls++;
+	Counters.Bytes += Bytes;
+
+	// Only the outermost scope counts towards the time, otherwise nested extracts would be counted twice
+	if (--Profile->StageDepth[(uint32_t)Stage] == 0)
+		Counters.Ticks += Ticks;
+}
+
+void ExportProfiler::BeginAsset(uint64_t Hash, uint32_t AssetType, uint64_t PredictedTicks)
+{
+	ExportThreadProfile* Profile = GetThreadProfile();
+
+	Profile->AssetHash = Hash;
+	Profile->AssetType = AssetType;
+	Profile->AssetStart = GetTicks();
+	Profile->AssetPredictedTicks = PredictedTicks;
+}
+
+void ExportProfiler::EndAsset()
+{
+	ExportThreadProfile* Profile = GetThreadProfile();
+	uint64_t Ticks = GetTicks() - Profile->AssetStart;
+
+	ExportTypeProfile& Type = Profile->GetType(Profile->AssetType);
+
+	Type.Assets++;
+	Type.Ticks += Ticks;
+	Type.MaxTicks = max(Type.MaxTicks, Ticks);
+	Type.PredictedTicks += Profile->AssetPredictedTicks;
+
+	Profile->Assets.push_back({ Profile->AssetHash, Profile->AssetType, Ticks, Profile->AssetPredictedTicks });
+
+	Profile->AssetHash = 0;
+	Profile->AssetType = 0;
+}
+
+std::vector<ExportTypeTotals> ExportProfiler::GetTypeTotals()
+{
+	std::vector<ExportTypeTotals> Result;
+
+	std::lock_guard<std::mutex> Lock(ProfileThreadsMutex);
+
+	for (auto& Thread : ProfileThreads)
+	{
+		ForEachThreadProfile(*Thread, [&Result](const ExportThreadProfile& Profile)
+		{
+			for (auto& Type : Profile.Types)
+			{
+				auto It = std::find_if(Result.begin(), Result.end(), [&Type](const ExportTypeTotals& Value) { return Value.AssetType == Type.AssetType; });
+
+				if (It == Result.end())
+				{
+					Result.push_back({ Type.AssetType, Type.Assets, Type.Ticks });
+					continue;
+				}
+
+				It->Assets += Type.Assets;
+				It->Ticks += Type.Ticks;
+			}
+		});
+	}
+
+	return Result;
+}
+
+bool ExportProfiler::WriteReport(const string& Path)
+{
+	if (!IsEnabled())
+		return false;
+
+	std::lock_guard<std::mutex> Lock(ProfileThreadsMutex);
+
+	// Merge every thread into totals per stage and per asset type
+	ExportStageCounters Totals[(uint32_t)ExportStage::Count]{};
+	std::vector<ExportTypeProfile> Types;
+	std::vector<ExportAssetSample> Assets;
+
+	for (auto& Thread : ProfileThreads)
+	{
+		ForEachThreadProfile(*Thread, [&Totals, &Types, &Assets](const ExportThreadProfile& Profile)
+		{
+			for (auto& Type : Profile.Types)
+			{
+				AddStages(Totals, Type.Stages);
+
+				auto It = std::find_if(Types.begin(), Types.end(), [&Type](const ExportTypeProfile& Value) { return Value.AssetType == Type.AssetType; });
+
+				if (It == Types.end())
+				{
+					Types.push_back(Type);
+					continue;
+				}
+
+				It->Assets += Type.Assets;
+				It->Ticks += Type.Ticks;
+				It->MaxTicks = max(It->MaxTicks, Type.MaxTicks);
+				It->PredictedTicks += Type.PredictedTicks;
+
+				AddStages(It->Stages, Type.Stages);
+			}
+
+			Assets.insert(Assets.end(), Profile.Assets.begin(), Profile.Assets.end());
+		});
+	}
+
+	std::sort(Types.begin(), Types.end(), [](const ExportTypeProfile& lhs, const ExportTypeProfile& rhs) { return lhs.Ticks > rhs.Ticks; });
+	std::sort(Assets.begin(), Assets.end(), [](const ExportAssetSample& lhs, const ExportAssetSample& rhs) { return lhs.Ticks > rhs.Ticks; });
+
+	try
+	{
+		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(Path));
+
+		Writer.WriteLine("{");
+		Writer.WriteLineFmt("\t\"duration_ms\": %.3f,", TicksToMilliseconds(GetTicks() - ProfileStartTicks));
+		Writer.WriteLineFmt("\t\"assets\": %llu,", (uint64_t)Assets.size());
+
+		Writer.Write("\t\"stages\": ");
+		WriteStages(Writer, Totals);
+		Writer.WriteLine(",");
+
+		auto WriterStats = ExportWriter::GetStats();
+
+		Writer.WriteLineFmt("\t\"writer\": { \"files\": %llu, \"failed\": %llu, \"bytes\": %llu, \"write_ms\": %.3f, \"peak_queued_files\": %llu, \"peak_queued_bytes\": %llu, \"stalls\": %llu, \"stall_ms\": %.3f },",
+			WriterStats.FilesWritten, WriterStats.FilesFailed, WriterStats.BytesWritten, TicksToMilliseconds(WriterStats.WriteTicks), WriterStats.PeakQueuedFiles, WriterStats.PeakQueuedBytes, WriterStats.Stalls, TicksToMilliseconds(WriterStats.StallTicks));
+
+		Writer.WriteLine("\t\"threads\": [");
+
+		for (size_t i = 0; i < ProfileThreads.size(); i++)
+		{
+			auto& Thread = ProfileThreads[i];
+			ExportStageCounters Stages[(uint32_t)ExportStage::Count]{};
+
+			// Borrowed threads come and go with each loop, their stages count towards the thread that borrowed them
+			ForEachThreadProfile(*Thread, [&Stages](const ExportThreadProfile& Profile)
+			{
+				for (auto& Type : Profile.Types)
+					AddStages(Stages, Type.Stages);
+			});
+
+			Writer.WriteFmt("\t\t{ \"thread\": %u, \"assets\": %llu, \"stages\": ", Thread->ThreadId, (uint64_t)Thread->Assets.size());
+			WriteStages(Writer, Stages);
+			Writer.WriteLine((i + 1 < ProfileThreads.size()) ? " }," : " }");
+		}
+
+		Writer.WriteLine("\t],");
+		Writer.WriteLine("\t\"asset_types\": [");
+
+		for (size_t i = 0; i < Types.size(); i++)
+		{
+			auto& Type = Types[i];
+			double AverageMs = (Type.Assets > 0) ? TicksToMilliseconds(Type.Ticks) / (double)Type.Assets : 0.0;
+
+			Writer.WriteLine("\t\t{");
+			Writer.WriteLineFmt("\t\t\t\"type\": \"%s\", \"assets\": %llu, \"ms\": %.3f, \"average_ms\": %.3f, \"max_ms\": %.3f,", Utils::GetAssetTypeName(Type.AssetType).ToCString(), Type.Assets, TicksToMilliseconds(Type.Ticks), AverageMs, TicksToMilliseconds(Type.MaxTicks));
+
+			// The scheduler's estimate for the type, x_predicted above 1 means the estimates run short
+			Writer.WriteLineFmt("\t\t\t\"predicted_ms\": %.3f, \"x_predicted\": %.2f,", TicksToMilliseconds(Type.PredictedTicks), (Type.PredictedTicks > 0) ? (double)Type.Ticks / (double)Type.PredictedTicks : 0.0);
+
+			Writer.Write("\t\t\t\"stages\": ");
+			WriteStages(Writer, Type.Stages);
+			Writer.WriteLine(",");
+
+			// The slowest assets of this type, relative to the average so pathological ones stand out
+			Writer.Write("\t\t\t\"outliers\": [");
+
+			uint32_t Outliers = 0;
+
+			for (auto& Asset : Assets)
+			{
+				if (Asset.AssetType != Type.AssetType)
+					continue;
+				if (Outliers == ExportOutliersPerType)
+					break;
+
+				double AssetMs = TicksToMilliseconds(Asset.Ticks);
+
+				Writer.WriteFmt("%s{ \"guid\": \"0x%llx\", \"ms\": %.3f, \"x_average\": %.2f, \"predicted_ms\": %.3f }", (Outliers > 0) ? ", " : "", Asset.Hash, AssetMs, (AverageMs > 0.0) ? AssetMs / AverageMs : 0.0, TicksToMilliseconds(Asset.PredictedTicks));
+				Outliers++;
+			}
+
+			Writer.WriteLine("]");
+			Writer.WriteLine((i + 1 < Types.size()) ? "\t\t}," : "\t\t}");
+		}
+
+		Writer.WriteLine("\t]");
+		Writer.WriteLine("}");
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t ExportProfiler::GetTicks()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ExportProfileScope::ExportProfileScope(ExportStage Stage, uint64_t Bytes)
+	: Stage(Stage), Start(0), Bytes(Bytes)
+{
+	if (ExportProfiler::IsEnabled())
+	{
+		ExportProfiler::EnterStage(Stage);
+		this->Start = ExportProfiler::GetTicks();
+	}
+}
+
+ExportProfileScope::~ExportProfileScope()
+{
+	if (this->Start != 0)
+		ExportProfiler::LeaveStage(this->Stage, ExportProfiler::GetTicks() - this->Start, this->Bytes);
+}
+
+void ExportProfileScope::AddBytes(uint64_t Bytes)
+{
+	this->Bytes += Bytes;
+}
+
+ExportAssetProfileScope::ExportAssetProfileScope(uint64_t Hash, uint32_t AssetType, uint64_t PredictedTicks)
+	: IsRecording(ExportProfiler::IsEnabled())
+{
+	if (this->IsRecording)
+		ExportProfiler::BeginAsset(Hash, AssetType, PredictedTicks);
+}
+
+ExportAssetProfileScope::~ExportAssetProfileScope()
+{
+	if (this->IsRecording)
+		ExportProfiler::EndAsset();
+}
@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "ExportProgress.h"
+#include "LegionMain.h"
+
+// How often the reporter wakes up
+constexpr uint32_t ExportProgressIntervalMs = 50;
+
+// Results stored in the low bits of a slot, the asset index sits above them
+constexpr uint64_t ExportResultExported = 1;
+constexpr uint64_t ExportResultFailed = 2;
+constexpr uint32_t ExportResultBits = 2;
+
+std::atomic<bool> ExportCancellation::Requested = false;
+
+void ExportCancellation::Request()
+{
+	Requested.store(true, std::memory_order_relaxed);
+}
+
+void ExportCancellation::Reset()
+{
+	Requested.store(false, std::memory_order_relaxed);
+}
+
+bool ExportCancellation::IsRequested()
+{
+	return Requested.load(std::memory_order_relaxed);
+}
+
+ExportProgress::ExportProgress(uint32_t AssetCount, ExportProgressCallback ProgressCallback, CheckStatusCallback StatusCallback, Forms::Form* MainForm)
+	: AssetCount(AssetCount), ProgressCallback(ProgressCallback), StatusCallback(StatusCallback), MainForm(MainForm), Completed(0), ReportedSlots(0), ReportedProgress(0), ReporterStopping(false)
+{
+	this->Results = std::make_unique<std::atomic<uint64_t>[]>(AssetCount);
+
+	for (uint32_t i = 0; i < AssetCount; i++)
+		this->Results[i].store(0, std::memory_order_relaxed);
+
+	ExportCancellation::Reset();
+
+	this->Reporter = std::make_unique<Threading::Thread>([this]
+	{
+		std::unique_lock<std::mutex> Lock(this->ReporterMutex);
+
+		while (!this->ReporterWake.wait_for(Lock, std::chrono::milliseconds(ExportProgressIntervalMs), [this] { return this->ReporterStopping; }))
+		{
+			// The callbacks may wait on the ui, Finish shouldn't wait on them
+			Lock.unlock();
+			this->Report(false);
+			Lock.lock();
+		}
+	});
+
+	this->Reporter->Start();
+}
+
+ExportProgress::~ExportProgress()
+{
+	this->Finish();
+}
+
+void ExportProgress::AssetExported(uint32_t Slot, int32_t AssetIndex)
+{
+	this->SetResult(Slot, AssetIndex, ExportResultExported);
+}
+
+void ExportProgress::AssetFailed(uint32_t Slot, int32_t AssetIndex)
+{
+	this->SetResult(Slot, AssetIndex, ExportResultFailed);
+}
+
+void ExportProgress::Finish()
+{
+	if (!this->Reporter)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(this->ReporterMutex);
+		this->ReporterStopping = true;
+	}
+
+	this->ReporterWake.notify_all();
+	this->Reporter->Join();
+	this->Reporter.reset();
+
+	this->Report(true);
+
+	ExportCancellation::Reset();
+}
+
+void ExportProgress::SetResult(uint32_t Slot, int32_t AssetIndex, uint64_t Result)
+{
+	this->Results[Slot].store(((uint64_t)(uint32_t)AssetIndex << ExportResultBits) | Result, std::memory_order_release);
+	this->Completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ExportProgress::Report(bool Flush)
+{
+	// Statuses go out in export order, an asset that is still running holds back the ones after it
+	while (this->ReportedSlots < this->AssetCount)
+	{
+		uint64_t Result = this->Results[this->ReportedSlots].load(std::memory_order_acquire);
+
+		if (Result == 0 && !Flush)
+			break;
+
+		this->ReportedSlots++;
+
+		if (Result == 0)
+			continue;
+
+		int32_t AssetIndex = (int32_t)(Result >> ExportResultBits);
+
+		if ((Result & ExportResultFailed) != 0)
+		{
+			if (this->MainForm != nullptr)
+				((LegionMain*)this->MainForm)->SetAssetError(AssetIndex);
+		}
+		else if (this->StatusCallback(AssetIndex, this->MainForm))
+		{
+			ExportCancellation::Request();
+		}
+	}
+
+	if (Flush)
+		return;
+
+	// Polled even when nothing finished, so one long asset doesn't hold back a cancel
+	if (this->StatusCallback(-1, this->MainForm))
+		ExportCancellation::Request();
+
+	if (this->AssetCount == 0)
+		return;
+
+	uint32_t Progress = (uint32_t)(((uint64_t)this->Completed.load(std::memory_order_relaxed) * 100) / this->AssetCount);
+
+	if (Progress > this->ReportedProgress)
+	{
+		this->ReportedProgress = Progress;
+		this->ProgressCallback(Progress, this->MainForm, false);
+	}
+}
@@ -0,0 +1,279 @@
+#include "pch.h"
+#include "ExportWriter.h"
+#include "ExportProfiler.h"
+#include "ExportArchive.h"
+#include "File.h"
+#include "XXHash.h"
+#include "Thread.h"
+
+#include <deque>
+#include <condition_variable>
+
+struct ExportWriteJob
+{
+	string Path;
+	uint64_t PathHash;
+
+	std::unique_ptr<uint8_t[]> Header;
+	uint32_t HeaderSize;
+
+	// Either the buffer or the stream holds the contents
+	std::unique_ptr<uint8_t[]> Buffer;
+	std::unique_ptr<IO::MemoryStream> Stream;
+	uint64_t Size;
+
+	std::function<void()> OnWritten;
+};
+
+static std::mutex WriterMutex;
+static std::condition_variable WriterQueueReady;
+static std::condition_variable WriterQueueRoom;
+
+static std::deque<ExportWriteJob> WriterQueue;
+static Dictionary<uint64_t, bool> WriterQueuedPaths;
+static uint64_t WriterQueuedBytes = 0;
+static uint64_t WriterQueueLimit = 0;
+static bool WriterStopping = false;
+
+static std::vector<std::unique_ptr<Threading::Thread>> WriterThreads;
+static std::atomic<bool> WriterRunning = false;
+
+static ExportWriterStats WriterStats{};
+
+static void WriteJob(ExportWriteJob& Job)
+{
+	uint64_t Start = ExportProfiler::GetTicks();
+	bool Written = false;
+
+	try
+	{
+		{
+			auto Stream = IO::File::Create(Job.Path);
+
+			// The header lands in the stream buffer, the contents go to disk in one write
+			if (Job.HeaderSize > 0)
+				Stream->Write(Job.Header.get(), 0, Job.HeaderSize);
+
+			Stream->Write((Job.Stream) ? Job.Stream->GetBuffer() : Job.Buffer.get(), 0, Job.Size);
+		}
+
+		Written = true;
+
+		if (Job.OnWritten)
+			Job.OnWritten();
+	}
+	catch (...)
+	{
+		g_Logger.Warning("Failed to write %s\n", Job.Path.ToCString());
+
+		// A partial file would be skipped as already exported by every later run
+		if (!Written)
+		{
+			try
+			{
+				IO::File::Delete(Job.Path);
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	uint64_t Ticks = ExportProfiler::GetTicks() - Start;
+
+	std::lock_guard<std::mutex> Lock(WriterMutex);
+
+	if (Written)
+	{
+		WriterStats.FilesWritten++;
+		WriterStats.BytesWritten += Job.HeaderSize + Job.Size;
+	}
+	else
+	{
+		WriterStats.FilesFailed++;
+	}
+
+	WriterStats.WriteTicks += Ticks;
+}
+
+static void WriterThreadMain()
+{
+	while (true)
+	{
+		ExportWriteJob Job;
+
+		{
+			std::unique_lock<std::mutex> Lock(WriterMutex);
+
+			WriterQueueReady.wait(Lock, [] { return !WriterQueue.empty() || WriterStopping; });
+
+			if (WriterQueue.empty())
+				return;
+
+			Job = std::move(WriterQueue.front());
+			WriterQueue.pop_front();
+		}
+
+		WriteJob(Job);
+
+		{
+			std::lock_guard<std::mutex> Lock(WriterMutex);
+
+			WriterQueuedBytes -= Job.HeaderSize + Job.Size;
+			WriterQueuedPaths.Remove(Job.PathHash);
+		}
+
+		WriterQueueRoom.notify_all();
+	}
+}
+
+static void QueueJob(ExportWriteJob&& Job)
+{
+	// Packed exports go into the archive from memory, only scratch files outside the asset directories reach the disk
+	if (ExportArchive* Archive = ExportArchive::GetActive())
+	{
+		if (Archive->AddBuffer(Job.Path, Job.Header.get(), Job.HeaderSize, (Job.Stream) ? Job.Stream->GetBuffer() : Job.Buffer.get(), Job.Size))
+		{
+			if (Job.OnWritten)
+				Job.OnWritten();
+
+			return;
+		}
+	}
+
+	if (!WriterRunning)
+	{
+		WriteJob(Job);
+		return;
+	}
+
+	Job.PathHash = Hashing::XXHash::HashString(Job.Path.ToLower());
+
+	uint64_t JobBytes = Job.HeaderSize + Job.Size;
+
+	{
+		std::unique_lock<std::mutex> Lock(WriterMutex);
+
+		// Assets that share a file may both queue it before either is written, the first one wins
+		if (!WriterQueuedPaths.Add(Job.PathHash, true))
+			return;
+
+		// A file larger than the whole queue waits for it to drain
+		auto HasRoom = [JobBytes] { return WriterQueuedBytes == 0 || WriterQueuedBytes + JobBytes <= WriterQueueLimit; };
+
+		if (!HasRoom())
+		{
+			uint64_t Start = ExportProfiler::GetTicks();
+
+			WriterQueueRoom.wait(Lock, HasRoom);
+
+			WriterStats.Stalls++;
+			WriterStats.StallTicks += ExportProfiler::GetTicks() - Start;
+		}
+
+		WriterQueuedBytes += JobBytes;
+		WriterQueue.emplace_back(std::move(Job));
+
+		WriterStats.PeakQueuedFiles = max(WriterStats.PeakQueuedFiles, (uint64_t)WriterQueue.size());
+		WriterStats.PeakQueuedBytes = max(WriterStats.PeakQueuedBytes, WriterQueuedBytes);
+	}
+
+	WriterQueueReady.notify_one();
+}
+
+void ExportWriter::Start(uint32_t ThreadCount, uint64_t QueueLimit)
+{
+	WriterStats = {};
+
+	if (ThreadCount == 0 || WriterRunning)
+		return;
+
+	WriterQueueLimit = max(QueueLimit, 1ull);
+	WriterStopping = false;
+
+	for (uint32_t i = 0; i < ThreadCount; i++)
+	{
+		WriterThreads.emplace_back(std::make_unique<Threading::Thread>(WriterThreadMain));
+		WriterThreads.back()->Start();
+	}
+
+	WriterRunning = true;
+}
+
+void ExportWriter::Stop()
+{
+	if (!WriterRunning)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(WriterMutex);
+		WriterStopping = true;
+	}
+
+	WriterQueueReady.notify_all();
+
+	// Threads drain the queue before they leave
+	for (auto& Thread : WriterThreads)
+		Thread->Join();
+
+	WriterThreads.clear();
+	WriterRunning = false;
+
+	g_Logger.Info("Export writer: %llu files, %.2f MB in %.3fs of writes, %llu failed, peak queue %llu files / %.2f MB, workers stalled %llu times for %.3fs\n",
+		WriterStats.FilesWritten, (double)WriterStats.BytesWritten / (1024.0 * 1024.0), (double)WriterStats.WriteTicks / 1000000000.0, WriterStats.FilesFailed,
+		WriterStats.PeakQueuedFiles, (double)WriterStats.PeakQueuedBytes / (1024.0 * 1024.0),
+		WriterStats.Stalls, (double)WriterStats.StallTicks / 1000000000.0);
+}
+
+bool ExportWriter::IsRunning()
+{
+	return WriterRunning;
+}
+
+void ExportWriter::WriteFile(const string& Path, std::unique_ptr<uint8_t[]> Buffer, uint64_t Size, const uint8_t* Header, uint32_t HeaderSize, std::function<void()> OnWritten)
+{
+	ExportWriteJob Job{};
+
+	Job.Path = Path;
+	Job.Buffer = std::move(Buffer);
+	Job.Size = Size;
+	Job.OnWritten = std::move(OnWritten);
+
+	if (Header != nullptr && HeaderSize > 0)
+	{
+		Job.Header = std::make_unique<uint8_t[]>(HeaderSize);
+		Job.HeaderSize = HeaderSize;
+
+		std::memcpy(Job.Header.get(), Header, HeaderSize);
+	}
+
+	QueueJob(std::move(Job));
+}
+
+void ExportWriter::WriteFile(const string& Path, std::unique_ptr<IO::MemoryStream> Stream, std::function<void()> OnWritten)
+{
+	ExportWriteJob Job{};
+
+	Job.Path = Path;
+	Job.Size = Stream->GetLength();
+	Job.Stream = std::move(Stream);
+	Job.OnWritten = std::move(OnWritten);
+
+	QueueJob(std::move(Job));
+}
+
+ExportWriterStats ExportWriter::GetStats()
+{
+	std::lock_guard<std::mutex> Lock(WriterMutex);
+	return WriterStats;
+}
+
+uint32_t ExportWriter::GetConfiguredThreadCount()
+{
+	return (uint32_t)ExportManager::Config.Get<System::SettingType::Integer>("ExportWriterThreads");
+}
+
+uint64_t ExportWriter::GetConfiguredQueueLimit()
+{
+	return (uint64_t)ExportManager::Config.Get<System::SettingType::Integer>("ExportWriterQueueSize") * 1024 * 1024;
+}
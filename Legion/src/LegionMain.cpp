@@ -368,52 +368,15 @@ void LegionMain::SearchForAssets()
 	if (this->LoadedAssets == nullptr)
 		return;
 
-	string SearchText = this->SearchBox->Text().ToLower();
+	string SearchText = this->SearchBox->Text();
 
-	if (string::IsNullOrEmpty(SearchText))
+	if (string::IsNullOrWhiteSpace(SearchText))
 	{
 		this->ResetDisplayIndices();
 		return;
 	}
 
-	bool isBlackList = SearchText.StartsWith("!");
-	if (isBlackList)
-		SearchText = SearchText.Substring(1);
-
-	List<string> SearchMap = SearchText.Split(",");
-
-	for (auto& Search : SearchMap)
-		Search = Search.Trim();
-
-	List<uint32_t> SearchResults;
-	uint32_t CurrentIndex = 0;
-
-	for (auto& Asset : *LoadedAssets)
-	{
-		string AssetNameLowercase = Asset.Name.ToLower();
-		bool IsMatch = isBlackList;
-
-		for (auto& Search : SearchMap)
-		{
-			bool Result = AssetNameLowercase.Contains(Search);
-
-			if (!isBlackList && Result)
-			{
-				IsMatch = true;
-				break;
-			}
-			else if (isBlackList && Result)
-			{
-				IsMatch = false;
-				break;
-			}
-		}
-
-		if (IsMatch)
-			SearchResults.Add(CurrentIndex);
-
-		CurrentIndex++;
-	}
+	List<uint32_t> SearchResults = this->SearchIndex.Search(SearchText);
 
 	this->AssetsListView->SetVirtualListSize(0);
 
@@ -576,7 +539,8 @@ void LegionMain::RefreshView()
 		};
 
 		this->LoadedAssets = this->RpakFileSystem->BuildAssetList(bAssets);
-		this->LoadedAssets->Sort([](const ApexAsset& lhs, const ApexAsset& rhs) { return lhs.Name.Compare(rhs.Name) < 0; });
+		this->LoadedAssets->SortByName();
+		this->SearchIndex.Build(this->LoadedAssets.get());
 
 		this->ResetDisplayIndices();
 	}
@@ -585,7 +549,8 @@ void LegionMain::RefreshView()
 		this->AssetsListView->SetVirtualListSize(0);
 
 		this->LoadedAssets = this->MilesFileSystem->BuildAssetList();
-		this->LoadedAssets->Sort([](const ApexAsset& lhs, const ApexAsset& rhs) { return lhs.Name.Compare(rhs.Name) < 0; });
+		this->LoadedAssets->SortByName();
+		this->SearchIndex.Build(this->LoadedAssets.get());
 
 		this->ResetDisplayIndices();
 	}
@@ -629,7 +594,7 @@ void LegionMain::OnDumpAssetListClick(Forms::Control* Sender)
 		ExportManager::Config.GetBool("LoadEffects")
 	};
 
-	std::unique_ptr<List<ApexAsset>> AssetList;
+	std::unique_ptr<ApexAssetList> AssetList;
 
 	for (uint32_t i = 0; i < OpenFileD.Count(); i++)
 	{
@@ -767,12 +732,12 @@ void LegionMain::OnListRightClick(const std::unique_ptr<MouseEventArgs>& EventAr
 		uint32_t& DisplayIndex = ThisPtr->DisplayIndices[SelectedIndices[i]];
 		ApexAsset& Asset = (*ThisPtr->LoadedAssets.get())[DisplayIndex];
 
-		g_Logger.Info(Asset.Name + "\n");
+		g_Logger.Info("%s\n", Asset.Name);
+
+		endString += Asset.Name;
 
 		if (i != SelectedIndices.Count() - 1)
-			endString += Asset.Name + "\n";
-		else
-			endString += Asset.Name;
+			endString += "\n";
 	}
 
 	clip::set_text(endString.ToCString());
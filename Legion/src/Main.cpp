@@ -9,6 +9,9 @@
 #include "KoreTheme.h"
 #include "bsplib.h"
 #include "CommandLine.h"
+#include "ExportProfiler.h"
+#include "ExportBenchmark.h"
+#include "PakDiff.h"
 
 #pragma comment(linker,"/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 
@@ -88,6 +91,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 			auto Rpak = std::make_unique<RpakLib>();
 			auto ExportAssets = List<ExportAsset>();
 
+			// time every stage of the export, including mounting
+			if (bExportFile && cmdline.HasParam(L"--profile"))
+				ExportProfiler::Enable();
+
 			Rpak->LoadRpak(filePath);
 			Rpak->PatchAssets();
 
@@ -97,6 +104,31 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 			ExportManager::Config.SetBool("OverwriteExistingFiles", cmdline.HasParam(L"--overwrite"));
 			ExportManager::Config.SetBool("UseTxtrGuids", cmdline.HasParam(L"--usetxtrguids"));
 			ExportManager::Config.SetBool("SkinExport", cmdline.HasParam(L"--skinexport"));
+			ExportManager::Config.SetBool("ExportImageMips", cmdline.HasParam(L"--imagemips"));
+
+			// cap the memory held by export workers at once, in megabytes
+			if (cmdline.HasParam(L"--membudget"))
+				ExportManager::Config.Set<System::SettingType::Integer>("ExportMemoryBudget", (uint32_t)wcstoul(cmdline.GetParamValue(L"--membudget"), nullptr, 10));
+
+			// pack exported files into zip archives, optionally split into shards of the given megabytes
+			ExportManager::Config.SetBool("ExportArchive", cmdline.HasParam(L"--archive"));
+			ExportManager::Config.SetBool("ExportArchiveStoreTextures", !cmdline.HasParam(L"--archivecompressdds"));
+
+			if (cmdline.HasParam(L"--archiveshard"))
+				ExportManager::Config.Set<System::SettingType::Integer>("ExportArchiveShardSize", (uint32_t)wcstoul(cmdline.GetParamValue(L"--archiveshard"), nullptr, 10));
+
+			// write identical texture payloads once and hardlink every other name to that copy
+			ExportManager::Config.SetBool("DeduplicateImages", cmdline.HasParam(L"--dedupimages"));
+
+			// threads that write finished files while the workers decode the next assets, and how much may wait for them
+			if (cmdline.HasParam(L"--writerthreads"))
+				ExportManager::Config.Set<System::SettingType::Integer>("ExportWriterThreads", (uint32_t)wcstoul(cmdline.GetParamValue(L"--writerthreads"), nullptr, 10));
+
+			if (cmdline.HasParam(L"--writerqueue"))
+				ExportManager::Config.Set<System::SettingType::Integer>("ExportWriterQueueSize", (uint32_t)wcstoul(cmdline.GetParamValue(L"--writerqueue"), nullptr, 10));
+
+			// export in list order instead of starting with the assets expected to take the longest
+			ExportManager::Config.SetBool("ExportLongestFirst", !cmdline.HasParam(L"--listorder"));
 
 			// asset rpak formats flags
 			if (cmdline.HasParam(L"--mdlfmt"))
@@ -255,7 +287,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 					ExportManager::Config.Set<System::SettingType::Integer>("MatCPUFormat", (uint32_t)matcpuFmt);
 			}
 
-			std::unique_ptr<List<ApexAsset>> AssetList;
+			std::unique_ptr<ApexAssetList> AssetList;
 
 			// load rpak flags
 			bool bLoadModels = cmdline.HasParam(L"--loadmodels");
@@ -271,9 +303,11 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
 			bool bNoFlagsSpecified = !bLoadModels && !bLoadAnims && !BLoadAnimSeqs && !bLoadImages && !bLoadMaterials && !bLoadUIImages && !bLoadDataTables && !bLoadShaderSets && !bLoadSettingsSets && !bLoadRSONs;
 
+			std::array<bool, 11> bAssets;
+
 			if (bNoFlagsSpecified)
 			{
-				std::array<bool, 11> bAssets = {
+				bAssets = {
 					ExportManager::Config.GetBool("LoadModels"),
 					ExportManager::Config.GetBool("LoadAnimations"),
 					ExportManager::Config.GetBool("LoadAnimationSeqs"),
@@ -286,12 +320,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 					ExportManager::Config.GetBool("LoadRSONs"),
 					ExportManager::Config.GetBool("LoadEffects")
 				};
-
-				AssetList = Rpak->BuildAssetList(bAssets);
 			}
 			else
 			{
-				std::array<bool, 11> bAssets = {
+				bAssets = {
 					bLoadModels,
 					bLoadAnims,
 					BLoadAnimSeqs,
@@ -304,13 +336,23 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 					bLoadRSONs,
 					false // not ready yet.
 				};
-
-				AssetList = Rpak->BuildAssetList(bAssets);
 			}
 
+			AssetList = Rpak->BuildAssetList(bAssets);
+
 			if (bExportFile)
 			{
-				if (filePath.EndsWith(".rpak")) {
+				if (filePath.EndsWith(".rpak") && cmdline.HasParam(L"--benchmark")) {
+
+					// the first mount above warms the file cache, every benchmark run mounts again
+					uint32_t Runs = max(wcstoul(cmdline.GetParamValue(L"--benchmark", (LPWSTR)L"5"), nullptr, 10), 1ul);
+
+					AssetList.reset();
+					Rpak.reset();
+
+					ExportBenchmark::Run(filePath, bAssets, Runs);
+				}
+				else if (filePath.EndsWith(".rpak")) {
 					for (auto& Asset : *AssetList.get())
 					{
 						ExportAsset EAsset;
@@ -342,6 +384,16 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 					g_Logger.Info("You loaded a file extension that isn't supported, the --export flag only supports .rpak and .mbnk file extensions");
 
 				}
+
+				if (ExportProfiler::IsEnabled())
+				{
+					string ReportPath = IO::Path::Combine(ExportManager::ExportPath, "export_profile.json");
+
+					IO::Directory::CreateDirectory(ExportManager::ExportPath);
+
+					if (ExportProfiler::WriteReport(ReportPath))
+						g_Logger.Info("Exported profile: %s\n", ReportPath.ToCString());
+				}
 			}
 			else if (bExportList)
 			{
@@ -366,6 +418,18 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 			ShowGUI = false;
 		}
 	}
+	else if (cmdline.HasParam(L"--diff"))
+	{
+		// the old and new build folders both follow the flag
+		int DiffIndex = cmdline.FindParam((LPWSTR)L"--diff");
+
+		if (DiffIndex + 2 < cmdline.argc)
+			PakDiff::Run(wstring(cmdline.argv[DiffIndex + 1]).ToString(), wstring(cmdline.argv[DiffIndex + 2]).ToString());
+		else
+			g_Logger.Info("The --diff flag needs the folder of the old build and the folder of the new build\n");
+
+		ShowGUI = false;
+	}
 	else {
 		if (cmdline.ArgC() >= 1) {
 			wstring firstParam = cmdline.GetParamAtIdx(0);
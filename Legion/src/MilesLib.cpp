@@ -193,13 +193,42 @@ struct BinkASIStream
 
 struct BinkASIReader
 {
-	IO::BinaryReader* Stream;
+	const MilesStreamBank* Bank;
 	uint64_t DataRead;
 	uint64_t HeaderSize;
+	uint64_t HeaderOffset;
 	uint64_t DataStreamOffset;
 	uint64_t DataStreamSize;
+	uint64_t DataStreamRead;
+
+	// Read ahead window over the bank, owned by the extracting thread
+	uint8_t* Window;
+	uint64_t WindowCapacity;
+	uint64_t WindowOffset;
+	uint64_t WindowSize;
 };
 
+// Scratch memory reused by every extraction on the same thread
+struct MilesExtractBuffers
+{
+	std::vector<uint8_t> Window;
+	std::vector<uint8_t> DecoderState;
+	std::vector<char> StreamData;
+	std::vector<float> Decoded;
+	std::vector<float> DecodedInterleaved;
+	std::vector<uint16_t> DecodedShort;
+	std::vector<uint16_t> DecodedShortCopy;
+	std::vector<uint8_t> Output;
+};
+
+constexpr uint64_t MilesReadWindowSize = 0x100000;
+constexpr uint64_t MilesWriteBufferSize = 0x400000;
+
+static thread_local MilesExtractBuffers ExtractBuffers;
+
+// Number of names hashed per batch when mounting a bank
+constexpr uint32_t MilesHashBatchSize = 0x2000;
+
 const String&
 LanguageName(MilesLanguageID lang) {
 	static const String LanguageNames[(int16_t)MilesLanguageID::COUNT + 1] = {
@@ -225,6 +254,67 @@ LanguageName(MilesLanguageID lang) {
 	return LanguageNames[(int32_t)MilesLanguageID::UNKNOWN];
 }
 
+uint64_t MilesStreamBank::Read(uint64_t Offset, uint8_t* Buffer, uint64_t Count) const
+{
+	std::lock_guard<std::mutex> Lock(*this->StreamLock);
+	return this->Stream->Read(Buffer, 0, Count, Offset);
+}
+
+// Reads a block of the bank through the reader's window, Hint is how much of the bank we expect to read from here
+static uint64_t MilesReadWindow(BinkASIReader* Reader, uint64_t Offset, char* Buffer, uint64_t Length, uint64_t Hint)
+{
+	uint64_t TotalRead = 0;
+
+	while (TotalRead < Length)
+	{
+		uint64_t Position = Offset + TotalRead;
+		uint64_t Remaining = Length - TotalRead;
+
+		if (Position < Reader->WindowOffset || Position >= Reader->WindowOffset + Reader->WindowSize)
+		{
+			// Reads larger than the window go straight to the caller
+			if (Remaining >= Reader->WindowCapacity)
+			{
+				TotalRead += Reader->Bank->Read(Position, (uint8_t*)Buffer + TotalRead, Remaining);
+				break;
+			}
+
+			Reader->WindowOffset = Position;
+			Reader->WindowSize = Reader->Bank->Read(Position, Reader->Window, min(Reader->WindowCapacity, max(Remaining, Hint)));
+
+			if (Reader->WindowSize == 0)
+				break;
+		}
+
+		uint64_t Available = min(Reader->WindowOffset + Reader->WindowSize - Position, Remaining);
+
+		std::memcpy(Buffer + TotalRead, Reader->Window + (Position - Reader->WindowOffset), Available);
+		TotalRead += Available;
+	}
+
+	return TotalRead;
+}
+
+// Copies a block of the bank to the output stream in window sized chunks
+static void MilesCopyBankRange(BinkASIReader* Reader, uint64_t Offset, uint64_t Size, IO::Stream* Output)
+{
+	while (Size > 0)
+	{
+		uint64_t Read = Reader->Bank->Read(Offset, Reader->Window, min(Size, Reader->WindowCapacity));
+
+		if (Read == 0)
+			break;
+
+		Output->Write(Reader->Window, 0, Read);
+
+		Offset += Read;
+		Size -= Read;
+	}
+
+	// The window no longer holds what it says it does
+	Reader->WindowSize = 0;
+}
+
 static uint32_t MilesReadFileStream(char* Buffer, uint64_t Length, void* UserData)
 {
 	auto Reader = (BinkASIReader*)UserData;
@@ -234,19 +324,17 @@ static uint32_t MilesReadFileStream(char* Buffer, uint64_t Length, void* UserDat
 	{
 		auto Diff = Reader->HeaderSize - Reader->DataRead;
 		auto MinDiff = min(Length, Diff);
-		Reader->Stream->Read(Buffer, 0, MinDiff);
+		MilesReadWindow(Reader, Reader->HeaderOffset + Reader->DataRead, Buffer, MinDiff, Diff);
 		Reader->DataRead += MinDiff;
 		TotalRead += MinDiff;
-
-		if (Reader->DataRead >= Reader->HeaderSize)
-			Reader->Stream->GetBaseStream()->SetPosition(Reader->DataStreamOffset);
 	}
 
 	uint64_t LengthToRead = Length - TotalRead;
 	LengthToRead = min(Reader->DataStreamSize, LengthToRead);
 
-	Reader->Stream->Read(Buffer, TotalRead, LengthToRead);
+	MilesReadWindow(Reader, Reader->DataStreamOffset + Reader->DataStreamRead, Buffer + TotalRead, LengthToRead, Reader->DataStreamSize);
 	TotalRead += LengthToRead;
+	Reader->DataStreamRead += LengthToRead;
 	Reader->DataStreamSize -= LengthToRead;
 
 	return (uint32_t)TotalRead;
@@ -269,6 +357,26 @@ MilesLib::~MilesLib()
 {
 }
 
+// Reads a block of source entries in one go, skipping ones that aren't in the selected language
+template<typename T>
+static void ReadSourceEntries(IO::Stream* Stream, uint64_t Offset, uint32_t Count, bool FilterLanguage, MilesLanguageID SelectedLanguage, List<MilesAudioAsset>& Sources, List<uint32_t>& NameOffsets)
+{
+	if (Count == 0)
+		return;
+
+	List<T> Entries(Count, true);
+	Stream->Read((uint8_t*)&Entries[0], 0, sizeof(T) * Count, Offset);
+
+	for (auto& Entry : Entries)
+	{
+		if (FilterLanguage && Entry.EntryLocal != MilesLanguageID::None && Entry.EntryLocal != SelectedLanguage)
+			continue;
+
+		Sources.Add(MilesAudioAsset{ nullptr, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal });
+		NameOffsets.EmplaceBack(Entry.NameOffset);
+	}
+}
+
 void MilesLib::MountBank(const string& Path)
 {
 	auto BasePath = IO::Path::GetDirectoryName(Path);
@@ -280,112 +388,54 @@ void MilesLib::MountBank(const string& Path)
 
 	this->MbnkVersion = BankHeader.Version;
 
-	ReaderStream->SetPosition(BankHeader.SourceEntryOffset);
-
 	auto SelectedLanguage = (MilesLanguageID)ExportManager::Config.Get<System::SettingType::Integer>("AudioLanguage");
 
+	List<MilesAudioAsset> Sources;
+	List<uint32_t> NameOffsets;
+	uint64_t NameTableOffset = 0;
+
 	if (BankHeader.Version == 0xB)
 	{
 		// R2TT - only english audio exists
-		ReaderStream->SetPosition(*(uint64_t*)(uintptr_t(&BankHeader) + 0x48));
-		const auto NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
+		NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
 		const auto SourcesCount = *(uint32_t*)(uintptr_t(&BankHeader) + 0xA0);
-		List<MilesTitanfallSourceEntry> Sources(SourcesCount, true);
-		ReaderStream->Read((uint8_t*)&Sources[0], 0, sizeof(MilesTitanfallSourceEntry) * SourcesCount);
 
-		for (auto& Entry : Sources)
-		{
-			ReaderStream->SetPosition(NameTableOffset + Entry.NameOffset);
-
-			auto Name = Reader.ReadCString();
-
-			MilesAudioAsset Asset{ Name, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal };
-			Assets.Add(Hashing::XXHash::HashString(Name), Asset);
-		}
+		ReadSourceEntries<MilesTitanfallSourceEntry>(ReaderStream, *(uint64_t*)(uintptr_t(&BankHeader) + 0x48), SourcesCount, false, SelectedLanguage, Sources, NameOffsets);
 	}
 	else if (BankHeader.Version > 0xB && BankHeader.Version <= 0xD)
 	{
 		// TF|2
-		ReaderStream->SetPosition(*(uint64_t*)(uintptr_t(&BankHeader) + 0x48)); // SourcesOffset
-		const auto NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
+		NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
 		const auto LanguageSourcesCount = *(uint32_t*)(uintptr_t(&BankHeader) + 0x9C);
 		auto SourcesCount = *(uint32_t*)(uintptr_t(&BankHeader) + 0xA0);
 
 		SourcesCount += (LanguageSourcesCount * (uint32_t)SelectedLanguage);
 
-		List<MilesTitanfallSourceEntry> Sources(SourcesCount, true);
-		ReaderStream->Read((uint8_t*)&Sources[0], 0, sizeof(MilesTitanfallSourceEntry) * SourcesCount);
-
-		for (auto& Entry : Sources)
-		{
-			ReaderStream->SetPosition(NameTableOffset + Entry.NameOffset);
-
-			auto Name = Reader.ReadCString();
-
-			if (Entry.EntryLocal == MilesLanguageID::None || Entry.EntryLocal == SelectedLanguage)
-			{
-				MilesAudioAsset Asset{ Name, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal };
-				Assets.Add(Hashing::XXHash::HashString(Name), Asset);
-			}
-		}
+		ReadSourceEntries<MilesTitanfallSourceEntry>(ReaderStream, *(uint64_t*)(uintptr_t(&BankHeader) + 0x48), SourcesCount, true, SelectedLanguage, Sources, NameOffsets);
 	}
 	else
 	{
 		if (BankHeader.Version >= 40) {
 			// S11.1
+			NameTableOffset = BankHeader.NameTableOffset;
 			auto SoundCount = BankHeader.SourcesCount - BankHeader.DialogueCount;
-			{ 
-				// Gather non-voiced audio files
-				List<MilesApexSourceEntry> SoundSources(SoundCount, true);
-				ReaderStream->SetPosition(BankHeader.SourceEntryOffset);
-				ReaderStream->Read((uint8_t*)&SoundSources[0], 0, sizeof(MilesApexSourceEntry) * SoundCount);
-				for (auto& Entry : SoundSources)
-				{
-					ReaderStream->SetPosition(BankHeader.NameTableOffset + Entry.NameOffset);
-					auto Name = Reader.ReadCString();
-					MilesAudioAsset Asset{ Name, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal };
-					Assets.Add(Hashing::XXHash::HashString(Name), Asset);
-				}
-			}
 
-			{
-				// Gather voiced audio files in the selected language
-				List<MilesApexSourceEntry> DialogueSources(BankHeader.DialogueCount, true);
-				ReaderStream->SetPosition(BankHeader.SourceEntryOffset + sizeof(MilesApexSourceEntry) * (SoundCount + (int32_t)SelectedLanguage * BankHeader.DialogueCount));
-				ReaderStream->Read((uint8_t*)&DialogueSources[0], 0, sizeof(MilesApexSourceEntry) * BankHeader.DialogueCount);
-				for (auto& Entry : DialogueSources)
-				{
-					ReaderStream->SetPosition(BankHeader.NameTableOffset + Entry.NameOffset);
-					auto Name = Reader.ReadCString();
-					MilesAudioAsset Asset{ Name, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal };
-					Assets.Add(Hashing::XXHash::HashString(Name), Asset);
-				}
-			}
+			// Gather non-voiced audio files
+			ReadSourceEntries<MilesApexSourceEntry>(ReaderStream, BankHeader.SourceEntryOffset, SoundCount, false, SelectedLanguage, Sources, NameOffsets);
+
+			// Gather voiced audio files in the selected language
+			auto DialogueOffset = BankHeader.SourceEntryOffset + sizeof(MilesApexSourceEntry) * (SoundCount + (int32_t)SelectedLanguage * BankHeader.DialogueCount);
+			ReadSourceEntries<MilesApexSourceEntry>(ReaderStream, DialogueOffset, BankHeader.DialogueCount, false, SelectedLanguage, Sources, NameOffsets);
 		}
 		else if (BankHeader.Version >= 28 && BankHeader.Version <= 32) {
 			// S2 -> S3
-			ReaderStream->SetPosition(*(uint64_t*)(uintptr_t(&BankHeader) + 0x48));
-			const auto NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
+			NameTableOffset = *(uint64_t*)(uintptr_t(&BankHeader) + 0x70);
 			const auto LanguageSourcesCount = *(uint32_t*)(uintptr_t(&BankHeader) + 0x94);
 			auto SourcesCount = *(uint32_t*)(uintptr_t(&BankHeader) + 0x98);
 
 			SourcesCount += (LanguageSourcesCount * (uint32_t)SelectedLanguage);
 
-			List<MilesApexS3SourceEntry> Sources(SourcesCount, true);
-			ReaderStream->Read((uint8_t*)&Sources[0], 0, sizeof(MilesApexS3SourceEntry) * SourcesCount);
-
-			for (auto& Entry : Sources)
-			{
-				ReaderStream->SetPosition(NameTableOffset + Entry.NameOffset);
-
-				auto Name = Reader.ReadCString();
-
-				if (Entry.EntryLocal == MilesLanguageID::None || Entry.EntryLocal == SelectedLanguage)
-				{
-					MilesAudioAsset Asset{ Name, Entry.SampleRate, Entry.ChannelCount, Entry.StreamHeaderOffset, Entry.StreamHeaderSize, Entry.StreamDataOffset, Entry.StreamDataSize, Entry.PatchIndex, (uint32_t)Entry.EntryLocal };
-					Assets.Add(Hashing::XXHash::HashString(Name), Asset);
-				}
-			}
+			ReadSourceEntries<MilesApexS3SourceEntry>(ReaderStream, *(uint64_t*)(uintptr_t(&BankHeader) + 0x48), SourcesCount, true, SelectedLanguage, Sources, NameOffsets);
 		}
 		else {
 			g_Logger.Warning("Unknown MBNK Version: %i\n", BankHeader.Version);
@@ -393,22 +443,122 @@ void MilesLib::MountBank(const string& Path)
 		}
 	}
 
-	auto Language = LanguageName(SelectedLanguage);
+	// Load the referenced part of the name table as a single block, names stay in it for the life of the lib
+	uint32_t NameTableSize = 0;
+	const char* NameTable = this->LoadNameTable(ReaderStream, NameTableOffset, NameOffsets, NameTableSize);
+
+	// Resolve and hash the names, the hashes don't depend on each other so large banks are split across threads
+	const uint32_t SourcesCount = Sources.Count();
+	std::vector<uint64_t> Hashes(SourcesCount);
+	std::atomic<uint32_t> NextSource = 0;
 
-	struct MStrFile {
-		MilesLanguageID languageID;
-		int32_t patch;
-		string filename;
+	auto HashSources = [&Sources, &NameOffsets, &Hashes, &NextSource, NameTable, NameTableSize, SourcesCount]
+	{
+		while (true)
+		{
+			uint32_t Start = NextSource.fetch_add(MilesHashBatchSize);
+
+			if (Start >= SourcesCount)
+				break;
+
+			uint32_t End = min(Start + MilesHashBatchSize, SourcesCount);
+
+			for (uint32_t i = Start; i < End; i++)
+			{
+				const char* Name = (NameOffsets[i] < NameTableSize) ? NameTable + NameOffsets[i] : "";
+
+				Sources[i].Name = Name;
+				Hashes[i] = Hashing::XXHash::ComputeHash((uint8_t*)Name, 0, std::strlen(Name));
+			}
+		}
 	};
 
+	if (SourcesCount > MilesHashBatchSize)
+		Threading::ParallelTask([&HashSources] { HashSources(); });
+	else
+		HashSources();
+
+	for (uint32_t i = 0; i < SourcesCount; i++)
+		Assets.Add(Hashes[i], Sources[i]);
+
+	this->MountStreamBanks(BasePath, SelectedLanguage);
+}
+
+const char* MilesLib::LoadNameTable(IO::Stream* Stream, uint64_t NameTableOffset, const List<uint32_t>& NameOffsets, uint32_t& NameTableSize)
+{
+	uint32_t MaxNameOffset = 0;
+
+	for (auto& NameOffset : NameOffsets)
+		MaxNameOffset = max(MaxNameOffset, NameOffset);
+
+	uint64_t FileLength = Stream->GetLength();
+	uint64_t Available = (NameTableOffset < FileLength) ? (FileLength - NameTableOffset) : 0;
+
+	// We don't know the length of the last name, so read a little past it and grow until we find its terminator
+	uint64_t Size = min((uint64_t)MaxNameOffset + 0x200, Available);
+	std::unique_ptr<char[]> Table;
+
+	while (true)
+	{
+		Table = std::make_unique<char[]>(Size + 1);
+		Size = Stream->Read((uint8_t*)Table.get(), 0, Size, NameTableOffset);
+		Table[Size] = '\0';
+
+		if (Size >= Available || MaxNameOffset >= Size || std::memchr(Table.get() + MaxNameOffset, 0, Size - MaxNameOffset) != nullptr)
+			break;
+
+		Size = min(Size * 2, Available);
+	}
+
+	NameTableSize = (uint32_t)Size;
+	this->NameTables.emplace_back(std::move(Table));
+
+	return this->NameTables.back().get();
+}
+
+void MilesLib::MountStreamBanks(const string& BasePath, MilesLanguageID SelectedLanguage)
+{
+	// Banks in the same folder share their stream files, only scan them once
+	if (this->StreamBankDirectories.Contains(BasePath))
+		return;
+
+	this->StreamBankDirectories.EmplaceBack(BasePath);
+
+	// Localized banks are named after their language, skip other languages without opening them
+	List<string> SkippedLanguages;
+
+	for (int16_t i = 0; i < (int16_t)MilesLanguageID::UNKNOWN; i++)
+	{
+		if ((MilesLanguageID)i != SelectedLanguage)
+			SkippedLanguages.EmplaceBack(string("_") + LanguageName((MilesLanguageID)i).ToLower());
+	}
+
 	auto Paths = IO::Directory::GetFiles(BasePath, "*.mstr");
 
 	for (auto& Path : Paths)
 	{
+		auto FileName = IO::Path::GetFileNameWithoutExtension(Path).ToLower();
+		bool IsSkipped = false;
+
+		for (auto& Language : SkippedLanguages)
+		{
+			if (FileName.Contains(Language))
+			{
+				IsSkipped = true;
+				break;
+			}
+		}
+
+		if (IsSkipped)
+			continue;
+
+		std::shared_ptr<IO::FileStream> Stream;
 		MilesStreamBankHeader StreamHeader;
 		try {
-			auto StreamReader = IO::BinaryReader(IO::File::OpenRead(Path));
-			StreamHeader = StreamReader.Read<MilesStreamBankHeader>();
+			Stream = IO::File::OpenRead(Path);
+
+			if (Stream->Read((uint8_t*)&StreamHeader, 0, sizeof(MilesStreamBankHeader)) != sizeof(MilesStreamBankHeader))
+				continue;
 		}
 		catch (...) { continue; }
 
@@ -422,21 +572,25 @@ void MilesLib::MountBank(const string& Path)
 
 		uint32_t KeyIndex = ((uint32_t)StreamHeader.LocalizeIndex << 16) + StreamHeader.PatchIndex;
 
-		MilesStreamBank NewBank{ Path, StreamHeader.StreamDataOffset };
+		// Keep the handle open, every sound in the bank is extracted through it
+		MilesStreamBank NewBank;
+		NewBank.Path = Path;
+		NewBank.StreamDataOffset = StreamHeader.StreamDataOffset;
+		NewBank.Stream = Stream;
+		NewBank.StreamLock = std::make_shared<std::mutex>();
+
 		StreamBanks.Add(KeyIndex, NewBank);
 	}
 }
 
 bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath)
 {
-	uint32_t KeyIndex = ((uint32_t)Asset.LocalizeIndex << 16) + Asset.PatchIndex;
+	uint32_t KeyIndex = GetStreamBankKey(Asset);
 
 	if (!StreamBanks.ContainsKey(KeyIndex))
 		return false;
 	
 	const auto& Bank = StreamBanks[KeyIndex];
-	auto Reader = IO::BinaryReader(IO::File::OpenRead(Bank.Path));
-	auto ReaderStream = Reader.GetBaseStream();
 
 	static uintptr_t binkawin = 0;
 	if (!binkawin) {
@@ -529,35 +683,32 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 	uint16_t channels;
 	uint32_t sample_rate, samples_count;
 	uint32_t adw4[4];
+	auto& Buffers = ExtractBuffers;
+
+	if (Buffers.Window.size() < MilesReadWindowSize)
+		Buffers.Window.resize(MilesReadWindowSize);
+
+	BinkASIReader UserData{ &Bank, 0, Asset.PreloadSize, Asset.PreloadOffset, Asset.StreamOffset + Bank.StreamDataOffset, 0, 0, Buffers.Window.data(), Buffers.Window.size(), 0, 0 };
+
 	uint8_t header[24];
-	ReaderStream->SetPosition(Asset.PreloadOffset);
-	ReaderStream->Read(header, 0, sizeof(header));
+	MilesReadWindow(&UserData, Asset.PreloadOffset, (char*)header, sizeof(header), Asset.PreloadSize);
 	metadata(header, sizeof(header), &channels, &sample_rate, &samples_count, adw4);
 
-	ReaderStream->SetPosition(Asset.PreloadOffset);
-
 	if ((AudioExportFormat_t)ExportManager::Config.Get<System::SettingType::Integer>("AudioFormat") == AudioExportFormat_t::BinkA)
 	{
-		char* preloadBuf = new char[Asset.PreloadSize];
-		ReaderStream->Read((uint8_t*)preloadBuf, 0, Asset.PreloadSize);
-
-		ReaderStream->SetPosition(Asset.StreamOffset + Bank.StreamDataOffset);
-
 		uint32_t StreamDataSize = *(uint32_t*)(header + 16) - Asset.PreloadSize;
 
-		char* streamDataBuf = new char[StreamDataSize];
-		ReaderStream->Read((uint8_t*)streamDataBuf, 0, StreamDataSize);
+		auto BinkWriter = IO::File::Create(IO::Path::ChangeExtension(FilePath, "binka"));
 
-		std::ofstream out_file(IO::Path::ChangeExtension(FilePath, "binka").ToCString(), std::ios::out | std::ios::binary);
-		out_file.write(preloadBuf, Asset.PreloadSize);
-		out_file.write(streamDataBuf, StreamDataSize);
-		out_file.close();
+		MilesCopyBankRange(&UserData, Asset.PreloadOffset, Asset.PreloadSize, BinkWriter.get());
+		MilesCopyBankRange(&UserData, UserData.DataStreamOffset, StreamDataSize, BinkWriter.get());
 		return true;
 	}
 
 
-	auto allocd = std::vector<uint8_t>(adw4[0], 0);
-	BinkASIReader UserData{ &Reader, 0, Asset.PreloadSize, Asset.StreamOffset + Bank.StreamDataOffset, 0 };
+	auto& allocd = Buffers.DecoderState;
+	allocd.assign(adw4[0], 0);
+
 	if (version_tf2) {
 		// Let's hope someone won't use some old ass lib which doesn't expect the right header
 		const auto open_stream = *(open_stream_tf2_f_t*)(binka + 16);
@@ -593,21 +744,44 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 		// I think that's the pure max?
 		decoded_size = channels * adw4[2];
 	}
-	auto decoded = std::vector<float>(version_retail ? 0 : decoded_size);
-	auto decoded_desh = std::vector<float>(version_retail ? 0 : decoded_size);
-	auto decoded_short = std::vector<uint16_t>(version_retail ? decoded_size : 0);
+	auto& decoded = Buffers.Decoded;
+	auto& decoded_desh = Buffers.DecodedInterleaved;
+	auto& decoded_short = Buffers.DecodedShort;
+	auto& decoded_short_copy = Buffers.DecodedShortCopy;
+
+	decoded.assign(version_retail ? 0 : decoded_size, 0.f);
+	decoded_desh.assign(version_retail ? 0 : decoded_size, 0.f);
+	decoded_short.assign(version_retail ? decoded_size : 0, 0);
 
 	size_t ret = 0;
 	// TODO: potentially break on hitting the required sample count?
-	auto Writer = IO::File::OpenWrite(FilePath);
+	auto Writer = IO::File::Create(FilePath);
 
 	WAVEHEADER hdr;
 
 	uint64_t DataSize = 0;
 
-	Writer->Write((uint8_t*)&hdr, 0, sizeof(WAVEHEADER));
+	// Samples are collected into large blocks before they hit the disk, the header is rewritten at the end
+	auto& Output = Buffers.Output;
+	Output.reserve(MilesWriteBufferSize);
+	Output.assign((uint8_t*)&hdr, (uint8_t*)&hdr + sizeof(WAVEHEADER));
 
-	std::vector<char> stream_data(8);
+	auto WriteOutput = [&Output, &Writer](const uint8_t* Data, uint64_t Size)
+	{
+		if (Output.size() + Size > MilesWriteBufferSize)
+		{
+			Writer->Write(Output.data(), 0, Output.size());
+			Output.clear();
+		}
+
+		if (Size >= MilesWriteBufferSize)
+			Writer->Write((uint8_t*)Data, 0, Size);
+		else
+			Output.insert(Output.end(), Data, Data + Size);
+	};
+
+	auto& stream_data = Buffers.StreamData;
+	stream_data.resize(8);
 
 	do {
 		if (version_retail) {
@@ -671,7 +845,7 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 				// WAV expects all channels at once meanwhile MSS gives us 2 channels per big sample thingie?
 				// Or it just decodes everything in a big chunk?
 				size_t pos = 0;
-				auto decoded_short_copy = decoded_short;
+				decoded_short_copy.assign(decoded_short.begin(), decoded_short.end());
 				auto samples = ret / channels; // E - Effiecency 
 				for (size_t i = 0; i < samples; i++) {
 					//for (size_t chan = 0; chan < (channels / 2); chan++) { // remove for stereo
@@ -692,11 +866,11 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 		if (ret > 0) {
 			if (version_retail) {
 				DataSize += ret * 2;
-				Writer->Write((uint8_t*)decoded_short.data(), 0, ret * 2);
+				WriteOutput((uint8_t*)decoded_short.data(), ret * 2);
 			}
 			else {
 				DataSize += decoded_desh.size() * 4;
-				Writer->Write((uint8_t*)decoded_desh.data(), 0, decoded_desh.size() * 4);
+				WriteOutput((uint8_t*)decoded_desh.data(), decoded_desh.size() * 4);
 			}
 		}
 	} while ((ret == 64) || (version_retail && ret));
@@ -719,6 +893,11 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 
 	hdr.fmt.avgBytesPerSecond = hdr.fmt.blockAlign * sample_rate;
 
+	if (Output.size() > 0)
+		Writer->Write(Output.data(), 0, Output.size());
+
+	Output.clear();
+
 	Writer->Seek(0, IO::SeekOrigin::Begin);
 
 	Writer->Write((uint8_t*)&hdr, 0, sizeof(WAVEHEADER));
@@ -726,15 +905,51 @@ bool MilesLib::ExtractAsset(const MilesAudioAsset& Asset, const string& FilePath
 	return true;
 }
 
-std::unique_ptr<List<ApexAsset>> MilesLib::BuildAssetList()
+void MilesLib::SortByStreamOffset(List<ExportAsset>& ExportAssets)
+{
+	struct StreamOrder
+	{
+		uint32_t BankKey;
+		uint64_t StreamOffset;
+		ExportAsset Asset;
+	};
+
+	std::vector<StreamOrder> Order;
+	Order.reserve(ExportAssets.Count());
+
+	for (auto& Asset : ExportAssets)
+	{
+		auto& AudioAsset = this->Assets[Asset.AssetHash];
+		Order.push_back({ GetStreamBankKey(AudioAsset), AudioAsset.StreamOffset, Asset });
+	}
+
+	// Group by bank, then by where the data lives, so the banks are read front to back
+	std::stable_sort(Order.begin(), Order.end(), [](const StreamOrder& lhs, const StreamOrder& rhs)
+	{
+		if (lhs.BankKey != rhs.BankKey)
+			return lhs.BankKey < rhs.BankKey;
+
+		return lhs.StreamOffset < rhs.StreamOffset;
+	});
+
+	for (uint32_t i = 0; i < ExportAssets.Count(); i++)
+		ExportAssets[i] = Order[i].Asset;
+}
+
+uint32_t MilesLib::GetStreamBankKey(const MilesAudioAsset& Asset)
+{
+	return ((uint32_t)Asset.LocalizeIndex << 16) + Asset.PatchIndex;
+}
+
+std::unique_ptr<ApexAssetList> MilesLib::BuildAssetList()
 {
-	auto Result = std::make_unique<List<ApexAsset>>();
+	auto Result = std::make_unique<ApexAssetList>();
 
 	for (auto& AssetKvp : Assets)
 	{
 		auto& Asset = AssetKvp.Value();
 
-		ApexAsset NewAsset;
+		ApexAssetInfo NewAsset;
 		NewAsset.Hash = AssetKvp.first;
 		NewAsset.Name = AssetKvp.second.Name;
 		NewAsset.Type = ApexAssetType::Sound;
@@ -742,7 +957,7 @@ std::unique_ptr<List<ApexAsset>> MilesLib::BuildAssetList()
 		NewAsset.Info = string::Format("Language: %s, Sample Rate: %d, Channels: %d", Language.ToCString(), AssetKvp.second.SampleRate, AssetKvp.second.ChannelCount);
 		NewAsset.Version = this->MbnkVersion;
 
-		Result->EmplaceBack(std::move(NewAsset));
+		Result->AddAsset(NewAsset);
 	}
 
 	return std::move(Result);
@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "PakDiff.h"
+#include "ExportManager.h"
+#include "ExportProfiler.h"
+#include "RpakLib.h"
+#include "File.h"
+#include "Path.h"
+#include "Directory.h"
+#include "StreamWriter.h"
+
+#include <map>
+#include <vector>
+
+enum class PakDiffChange : uint32_t
+{
+	Added,
+	Removed,
+	Changed,
+
+	Count
+};
+
+static const char* PakDiffChangeNames[] = { "added", "removed", "changed" };
+
+struct PakDiffAsset
+{
+	uint32_t AssetType;
+	uint32_t AssetVersion;
+	uint64_t Hash;
+};
+
+static bool MountBuild(const string& Path, Dictionary<uint64_t, PakDiffAsset>& Result)
+{
+	if (!IO::Directory::Exists(Path))
+	{
+		g_Logger.Info("Diff failed to open %s\n", Path.ToCString());
+		return false;
+	}
+
+	// Base files sort before their patches, so assets resolve the same way every run
+	List<string> Files = IO::Directory::GetFiles(Path, "*.rpak");
+	std::sort(Files.begin(), Files.end(), [](const string& lhs, const string& rhs) { return lhs.Compare(rhs) < 0; });
+
+	uint64_t Start = ExportProfiler::GetTicks();
+
+	auto Rpak = std::make_unique<RpakLib>();
+	Rpak->LoadRpaks(Files);
+	Rpak->PatchAssets();
+
+	uint64_t Mounted = ExportProfiler::GetTicks();
+
+	Dictionary<uint64_t, uint64_t> Hashes;
+	Rpak->HashAssetContents(Hashes);
+
+	for (auto& AssetKvp : Rpak->Assets)
+	{
+		RpakLoadAsset& Asset = AssetKvp.Value();
+		Result.Add(AssetKvp.first, { Asset.AssetType, Asset.AssetVersion, Hashes[AssetKvp.first] });
+	}
+
+	g_Logger.Info("Diff mounted %s: %u rpaks, %u assets, mount %.3f ms, hash %.3f ms\n", Path.ToCString(), Files.Count(), Result.Count(),
+		(double)(Mounted - Start) / 1000000.0, (double)(ExportProfiler::GetTicks() - Mounted) / 1000000.0);
+
+	return true;
+}
+
+bool PakDiff::Run(const string& OldPath, const string& NewPath)
+{
+	Dictionary<uint64_t, PakDiffAsset> OldAssets;
+	Dictionary<uint64_t, PakDiffAsset> NewAssets;
+
+	if (!MountBuild(OldPath, OldAssets) || !MountBuild(NewPath, NewAssets))
+		return false;
+
+	// Guids of each change grouped by asset type, sorted so reports of two builds can be compared as text
+	std::map<uint32_t, std::vector<uint64_t>> Changes[(uint32_t)PakDiffChange::Count];
+
+	for (auto& AssetKvp : NewAssets)
+	{
+		PakDiffAsset& Asset = AssetKvp.Value();
+
+		if (!OldAssets.ContainsKey(AssetKvp.first))
+		{
+			Changes[(uint32_t)PakDiffChange::Added][Asset.AssetType].push_back(AssetKvp.first);
+			continue;
+		}
+
+		PakDiffAsset& OldAsset = OldAssets[AssetKvp.first];
+
+		if (OldAsset.AssetType != Asset.AssetType || OldAsset.AssetVersion != Asset.AssetVersion || OldAsset.Hash != Asset.Hash)
+			Changes[(uint32_t)PakDiffChange::Changed][Asset.AssetType].push_back(AssetKvp.first);
+	}
+
+	for (auto& AssetKvp : OldAssets)
+	{
+		if (!NewAssets.ContainsKey(AssetKvp.first))
+			Changes[(uint32_t)PakDiffChange::Removed][AssetKvp.Value().AssetType].push_back(AssetKvp.first);
+	}
+
+	string ReportPath = IO::Path::Combine(ExportManager::ExportPath, "pak_diff.json");
+
+	try
+	{
+		IO::Directory::CreateDirectory(ExportManager::ExportPath);
+		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(ReportPath));
+
+		Writer.WriteLine("{");
+		Writer.WriteLineFmt("\t\"old\": \"%s\",", OldPath.Replace("\\", "\\\\").ToCString());
+		Writer.WriteLineFmt("\t\"new\": \"%s\",", NewPath.Replace("\\", "\\\\").ToCString());
+		Writer.WriteLineFmt("\t\"old_assets\": %u,", OldAssets.Count());
+		Writer.WriteLineFmt("\t\"new_assets\": %u,", NewAssets.Count());
+
+		for (uint32_t c = 0; c < (uint32_t)PakDiffChange::Count; c++)
+		{
+			uint64_t Total = 0;
+
+			for (auto& Type : Changes[c])
+				Total += Type.second.size();
+
+			g_Logger.Info("Diff %s: %llu assets\n", PakDiffChangeNames[c], Total);
+
+			Writer.WriteLineFmt("\t\"%s\": {", PakDiffChangeNames[c]);
+
+			uint32_t TypeIndex = 0;
+
+			for (auto& Type : Changes[c])
+			{
+				std::sort(Type.second.begin(), Type.second.end());
+
+				Writer.WriteFmt("\t\t\"%s\": [", Utils::GetAssetTypeName(Type.first).ToCString());
+
+				for (size_t i = 0; i < Type.second.size(); i++)
+					Writer.WriteFmt("%s\"0x%llx\"", (i > 0) ? ", " : "", Type.second[i]);
+
+				Writer.WriteLine((++TypeIndex < Changes[c].size()) ? "]," : "]");
+			}
+
+			Writer.WriteLine((c + 1 < (uint32_t)PakDiffChange::Count) ? "\t}," : "\t}");
+		}
+
+		Writer.WriteLine("}");
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	g_Logger.Info("Exported diff: %s\n", ReportPath.ToCString());
+
+	return true;
+}
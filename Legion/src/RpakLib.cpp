@@ -9,6 +9,8 @@
 #include "Texture.h"
 #include "Model.h"
 #include "BinaryReader.h"
+#include "XXHash.h"
+#include "ThreadBudget.h"
 
 // Asset export formats
 #include "CoDXAssetExport.h"
@@ -25,11 +27,33 @@
 #include "rtech.h"
 #include "RpakImageTiles.h"
 
+bool StarpakEntryTable::TryGetSize(uint64_t Offset, uint64_t& Size) const
+{
+	auto It = std::lower_bound(this->Entries.begin(), this->Entries.end(), Offset, [](const StarpakStreamEntry& lhs, uint64_t rhs) { return lhs.Offset < rhs; });
+
+	if (It == this->Entries.end() || It->Offset != Offset)
+		return false;
+
+	Size = It->Size;
+	return true;
+}
+
 RpakFile::RpakFile()
 	: SegmentData(nullptr), StartSegmentIndex(0), SegmentDataSize(0), PatchData(nullptr), PatchDataSize(0), Version(RpakGameVersion::Apex), EmbeddedStarpakOffset(0), EmbeddedStarpakSize(0)
 {
 }
 
+bool RpakFile::TryGetStarpakEntrySize(uint64_t StarpakOffset, uint64_t& Size, bool Optimal) const
+{
+	const auto& Tables = Optimal ? this->OptimalStarpakTables : this->StarpakTables;
+	uint64_t StarpakIndex = StarpakOffset & 0xFF;
+
+	if (StarpakIndex >= Tables.size() || Tables[StarpakIndex] == nullptr)
+		return false;
+
+	return Tables[StarpakIndex]->TryGetSize(StarpakOffset & 0xFFFFFFFFFFFFFF00, Size);
+}
+
 RpakLib::RpakLib()
 	: LoadedFileIndex(0), ImageExtension(".dds"), ImageSaveType(Assets::SaveFileType::Dds)
 {
@@ -64,85 +88,146 @@ void RpakLib::LoadRpak(const string& Path, bool Dump)
 
 void RpakLib::PatchAssets()
 {
-	// This is a dictionary of failed stream assets
-	Dictionary<uint64_t, RpakLoadAsset> PatchedStreamAssets;
+	// Group the files that contain each asset, keeping them in load order
+	std::vector<RpakAssetFileEntry>& FileIndex = this->AssetFileIndex;
 
-	// We must load this way...
-	for (uint32_t i = 0; i < this->LoadedFileIndex; i++)
+	std::sort(FileIndex.begin(), FileIndex.end(), [](const RpakAssetFileEntry& lhs, const RpakAssetFileEntry& rhs)
 	{
-		RpakFile& LoadedFile = this->LoadedFiles[i];
+		return (lhs.NameHash != rhs.NameHash) ? (lhs.NameHash < rhs.NameHash) : (lhs.Order < rhs.Order);
+	});
 
-		for (auto& Kvp : LoadedFile.AssetHashmap)
+	struct AssetCandidates
+	{
+		uint32_t First;
+		uint32_t Count;
+
+		// The file that provides the headers, and the file that provides the streamed data, -1 if unresolved
+		uint32_t HeaderFile;
+		uint32_t StreamFile;
+		// Mount order of the winning entry, assets are added in the order their entries were read from the files
+		uint32_t Order;
+	};
+
+	std::vector<AssetCandidates> Candidates;
+
+	for (uint32_t i = 0; i < (uint32_t)FileIndex.size();)
+	{
+		uint32_t First = i;
+
+		while (i < (uint32_t)FileIndex.size() && FileIndex[i].NameHash == FileIndex[First].NameHash)
+			i++;
+
+		if (!this->Assets.ContainsKey(FileIndex[First].NameHash))
+			Candidates.push_back({ First, i - First, (uint32_t)-1, (uint32_t)-1, 0 });
+	}
+
+	auto BuildLoadAsset = [this](uint64_t NameHash, uint32_t FileIndex)
+	{
+		// Runs on many threads at once, the asset tables are only read through const lookups
+		const RpakFile& LoadedFile = this->LoadedFiles[FileIndex];
+		const RpakApexAssetEntry& Entry = LoadedFile.AssetHashmap[NameHash];
+
+		return RpakLoadAsset(
+			Entry.NameHash,
+			FileIndex,
+			Entry.Magic,
+			Entry.SubHeaderDataBlockIndex,
+			Entry.SubHeaderDataBlockOffset,
+			Entry.SubHeaderSize,
+			Entry.RawDataBlockIndex,
+			Entry.RawDataBlockOffset,
+			Entry.StarpakOffset,
+			Entry.OptimalStarpakOffset,
+			LoadedFile.Version,
+			Entry.Version,
+			&this->LoadedFiles[FileIndex]
+		);
+	};
+
+	// Every asset resolves independently, validate the headers in parallel
+	Threading::ThreadBudget::Run((uint32_t)Candidates.size(), [&](uint32_t i)
+	{
+		AssetCandidates& Group = Candidates[i];
+		uint32_t PatchCandidate = (uint32_t)-1;
+
+		for (uint32_t c = Group.First; c < Group.First + Group.Count; c++)
 		{
-			if (!this->Assets.ContainsKey(Kvp.first))
+			RpakLoadAsset Asset = BuildLoadAsset(FileIndex[c].NameHash, FileIndex[c].FileIndex);
+
+			// All assets must follow this patch sequence
+			if (!this->ValidateAssetPatchStatus(Asset))
+				continue;
+
+			// If we have a model or texture, it must also pass the stream test
+			bool IsStreamed = (Asset.AssetType == (uint32_t)AssetType_t::Model
+				|| Asset.AssetType == (uint32_t)AssetType_t::Texture
+				|| Asset.AssetType == (uint32_t)AssetType_t::UIIA);
+
+			if (!IsStreamed || this->ValidateAssetStreamStatus(Asset))
 			{
-				RpakLoadAsset Asset = RpakLoadAsset(
-					Kvp.second.NameHash,
-					i,
-					Kvp.second.Magic,
-					Kvp.second.SubHeaderDataBlockIndex,
-					Kvp.second.SubHeaderDataBlockOffset,
-					Kvp.second.SubHeaderSize,
-					Kvp.second.RawDataBlockIndex,
-					Kvp.second.RawDataBlockOffset,
-					Kvp.second.StarpakOffset,
-					Kvp.second.OptimalStarpakOffset,
-					LoadedFile.Version,
-					Kvp.second.Version,
-					&this->LoadedFiles[i]
-				);
-
-				// All assets must follow this patch sequence
-				if (this->ValidateAssetPatchStatus(Asset))
-				{
-					// If we have a model or texture, it must also pass the stream test
-					if (Asset.AssetType == (uint32_t)AssetType_t::Model
-						|| Asset.AssetType == (uint32_t)AssetType_t::Texture
-						|| Asset.AssetType == (uint32_t)AssetType_t::UIIA)
-					{
-						if (this->ValidateAssetStreamStatus(Asset))
-						{
-							this->Assets.Add(Kvp.first, Asset);
-						}
-						else if (!PatchedStreamAssets.ContainsKey(Kvp.first))
-						{
-							PatchedStreamAssets.Add(Kvp.first, Asset);
-						}
-					}
-					else
-					{
-						this->Assets.Add(Kvp.first, Asset);
-					}
-				}
+				Group.HeaderFile = Group.StreamFile = FileIndex[c].FileIndex;
+				Group.Order = FileIndex[c].Order;
+				return;
 			}
+
+			if (PatchCandidate == (uint32_t)-1)
+				PatchCandidate = c;
 		}
-	}
 
-	// We will attempt to brute force patch assets...
-	for (auto& Kvp : PatchedStreamAssets)
-	{
-		for (uint32_t i = 0; i < this->LoadedFileIndex; i++)
+		if (PatchCandidate == (uint32_t)-1)
+			return;
+
+		// The headers are fine but the streamed data is missing, borrow it from another file with the asset
+		RpakLoadAsset Asset = BuildLoadAsset(FileIndex[PatchCandidate].NameHash, FileIndex[PatchCandidate].FileIndex);
+
+		for (uint32_t c = Group.First; c < Group.First + Group.Count; c++)
 		{
-			if (i == Kvp.second.FileIndex)
+			if (c == PatchCandidate)
 				continue;
 
-			RpakFile& File = this->LoadedFiles[i];
+			const RpakFile& LoadedFile = this->LoadedFiles[FileIndex[c].FileIndex];
+			const RpakApexAssetEntry& Entry = LoadedFile.AssetHashmap[FileIndex[c].NameHash];
 
-			if (File.AssetHashmap.ContainsKey(Kvp.first))
+			Asset.RpakFileIndex = FileIndex[c].FileIndex;
+			Asset.StarpakOffset = Entry.StarpakOffset;
+			Asset.OptimalStarpakOffset = Entry.OptimalStarpakOffset;
+
+			if (this->ValidateAssetStreamStatus(Asset))
 			{
-				RpakApexAssetEntry& Asset = File.AssetHashmap[Kvp.first];
+				Group.HeaderFile = FileIndex[PatchCandidate].FileIndex;
+				Group.StreamFile = FileIndex[c].FileIndex;
+				// Patched assets were added after every other asset
+				Group.Order = FileIndex[PatchCandidate].Order + (uint32_t)FileIndex.size();
+				return;
+			}
+		}
+	});
 
-				Kvp.second.RpakFileIndex = i;
-				Kvp.second.StarpakOffset = Asset.StarpakOffset;
-				Kvp.second.OptimalStarpakOffset = Asset.OptimalStarpakOffset;
+	std::vector<const AssetCandidates*> Resolved;
 
-				if (this->ValidateAssetStreamStatus(Kvp.second))
-				{
-					this->Assets.Add(Kvp.first, Kvp.second);
-					break;
-				}
-			}
+	for (auto& Group : Candidates)
+	{
+		if (Group.HeaderFile != (uint32_t)-1)
+			Resolved.push_back(&Group);
+	}
+
+	std::sort(Resolved.begin(), Resolved.end(), [](const AssetCandidates* lhs, const AssetCandidates* rhs) { return lhs->Order < rhs->Order; });
+
+	for (auto& Group : Resolved)
+	{
+		uint64_t NameHash = FileIndex[Group->First].NameHash;
+		RpakLoadAsset Asset = BuildLoadAsset(NameHash, Group->HeaderFile);
+
+		if (Group->StreamFile != Group->HeaderFile)
+		{
+			RpakApexAssetEntry& Entry = this->LoadedFiles[Group->StreamFile].AssetHashmap[NameHash];
+
+			Asset.RpakFileIndex = Group->StreamFile;
+			Asset.StarpakOffset = Entry.StarpakOffset;
+			Asset.OptimalStarpakOffset = Entry.OptimalStarpakOffset;
 		}
+
+		this->Assets.Add(NameHash, Asset);
 	}
 
 	// Clean up the old cache of assets
@@ -150,18 +235,27 @@ void RpakLib::PatchAssets()
 	{
 		this->LoadedFiles[i].AssetHashmap.Clear();
 	}
+
+	FileIndex.clear();
+	FileIndex.shrink_to_fit();
+
+	// Patched assets may have replaced anything parsed before
+	this->ShaderVarCache.Clear();
+	this->ShaderResBindingCache.Clear();
+	this->SettingsLayoutCache.Clear();
+	this->SkeletonCache.Clear();
 }
 
 //std::unique_ptr<List<ApexAsset>> RpakLib::BuildAssetList(bool Models, bool Anims, bool Images, bool Materials, bool UIImages, bool DataTables)
-std::unique_ptr<List<ApexAsset>> RpakLib::BuildAssetList(const std::array<bool, 11> &arrAssets)
+std::unique_ptr<ApexAssetList> RpakLib::BuildAssetList(const std::array<bool, 11> &arrAssets)
 {
-	auto Result = std::make_unique<List<ApexAsset>>();
+	auto Result = std::make_unique<ApexAssetList>();
 
 	for (auto& AssetKvp : Assets)
 	{
 		RpakLoadAsset& Asset = AssetKvp.Value();
 
-		ApexAsset NewAsset;
+		ApexAssetInfo NewAsset;
 		NewAsset.Hash = AssetKvp.first;
 		NewAsset.FileCreatedTime = this->LoadedFiles[Asset.RpakFileIndex].CreatedTime;
 
@@ -251,7 +345,7 @@ std::unique_ptr<List<ApexAsset>> RpakLib::BuildAssetList(const std::array<bool,
 
 		NewAsset.Version = Asset.AssetVersion;
 
-		Result->EmplaceBack(std::move(NewAsset));
+		Result->AddAsset(NewAsset);
 	}
 
 	return std::move(Result);
@@ -337,6 +431,332 @@ void RpakLib::InitializeImageExporter(ImageExportFormat_t Format)
 	m_bImageExporterInitialized = true;
 }
 
+// Memory assumed for assets that export other assets without a size in their header
+constexpr uint64_t ExportMemoryMaterialEstimate = 64ull * 1024 * 1024;
+constexpr uint64_t ExportMemoryAnimationEstimate = 16ull * 1024 * 1024;
+
+// Rough export rates in nanoseconds, compare against the profiler report when tuning them
+constexpr uint64_t ExportCostBase = 200000;
+constexpr uint64_t ExportCostCopyByte = 1;
+constexpr uint64_t ExportCostEncodePixel = 25;
+constexpr uint64_t ExportCostDecodeBlockPixel = 4;
+constexpr uint64_t ExportCostDecodeBC7Pixel = 30;
+constexpr uint64_t ExportCostModelByte = 8;
+constexpr uint64_t ExportCostSequence = 2000000;
+constexpr uint64_t ExportCostSequenceByte = 4;
+constexpr uint64_t ExportCostWrapByte = 2;
+constexpr uint64_t ExportCostMaterial = 50000000;
+constexpr uint64_t ExportCostImageAtlas = 20000000;
+
+RpakExportEstimate RpakLib::EstimateExport(const RpakLoadAsset& Asset)
+{
+	try
+	{
+		auto RpakStream = this->GetFileStream(Asset);
+		IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
+
+		RpakStream->SetPosition(this->GetFileOffset(Asset, Asset.SubHeaderIndex, Asset.SubHeaderOffset));
+
+		switch (Asset.AssetType)
+		{
+		case (uint32_t)AssetType_t::Texture:
+		{
+			uint64_t Width = 0, Height = 0, DataSize = 0, ArraySize = 1;
+			uint16_t Format = 0;
+
+			if (Asset.AssetVersion >= 9)
+			{
+				TextureHeaderV9 TxtrHdr = Reader.Read<TextureHeaderV9>();
+				Width = TxtrHdr.width;
+				Height = TxtrHdr.height;
+				DataSize = TxtrHdr.dataSize;
+				ArraySize = max(TxtrHdr.arraySize, (uint8_t)1);
+				Format = TxtrHdr.imageFormat;
+			}
+			else
+			{
+				TextureHeaderV8 TxtrHdr = Reader.Read<TextureHeaderV8>();
+				Width = TxtrHdr.width;
+				Height = TxtrHdr.height;
+				DataSize = TxtrHdr.dataSize;
+				ArraySize = max(TxtrHdr.arraySize, (uint8_t)1);
+				Format = TxtrHdr.imageFormat;
+			}
+
+			// Raw dds output copies the payload, anything else decodes the top mip to rgba and encodes it
+			if (ImageSaveType == Assets::SaveFileType::Dds)
+				return { DataSize, ExportCostBase + (DataSize * ExportCostCopyByte) };
+
+			uint64_t Pixels = Width * Height * ArraySize;
+
+			DXGI_FORMAT DxgiFormat = (Format < TxtrFormatToDXGI.size()) ? TxtrFormatToDXGI[Format] : DXGI_FORMAT_UNKNOWN;
+			uint64_t DecodeCost = 0;
+
+			if (DxgiFormat >= DXGI_FORMAT_BC6H_TYPELESS && DxgiFormat <= DXGI_FORMAT_BC7_UNORM_SRGB)
+				DecodeCost = ExportCostDecodeBC7Pixel;
+			else if (DxgiFormat >= DXGI_FORMAT_BC1_TYPELESS && DxgiFormat <= DXGI_FORMAT_BC5_SNORM)
+				DecodeCost = ExportCostDecodeBlockPixel;
+
+			return { DataSize + (Pixels * 4), ExportCostBase + (DataSize * ExportCostCopyByte) + (Pixels * (ExportCostEncodePixel + DecodeCost)) };
+		}
+		case (uint32_t)AssetType_t::UIIA:
+		{
+			UIIAHeader TexHeader = Reader.Read<UIIAHeader>();
+			uint64_t Pixels = (uint64_t)TexHeader.Width * TexHeader.Height;
+
+			// The reconstructed image, plus a converted copy when saving
+			return { Pixels * 4 * 2, ExportCostBase + (Pixels * ExportCostEncodePixel) };
+		}
+		case (uint32_t)AssetType_t::Model:
+		{
+			ModelHeader MdlHdr;
+			MdlHdr.ReadFromAssetStream(&RpakStream, Asset.SubHeaderSize, Asset.AssetVersion);
+
+			// The vertex data is decompressed and unpacked, then every sequence is exported with the model
+			uint64_t StreamingSize = (uint64_t)max(MdlHdr.alignedStreamingSize, 0);
+			RpakExportEstimate Estimate = { StreamingSize * 4, ExportCostBase + (StreamingSize * ExportCostModelByte) };
+
+			if (MdlHdr.animSeqCount > 0)
+			{
+				Estimate.Memory += ExportMemoryAnimationEstimate;
+				Estimate.Ticks += this->EstimateSequencesCost(Asset, MdlHdr.animSeqs, MdlHdr.animSeqCount);
+			}
+
+			return Estimate;
+		}
+		case (uint32_t)AssetType_t::AnimationRig:
+		{
+			AnimRigHeader RigHeader{};
+			RigHeader.ReadFromAssetStream(&RpakStream, Asset.AssetVersion);
+
+			return { ExportMemoryAnimationEstimate, ExportCostBase + this->EstimateSequencesCost(Asset, RigHeader.animSeqs, (uint32_t)max(RigHeader.animSeqCount, 0)) };
+		}
+		case (uint32_t)AssetType_t::Animation:
+		{
+			// Sequences are only exported on their own as raw data, any other format skips them without reading anything
+			if ((AnimExportFormat_t)ExportManager::Config.Get<System::SettingType::Integer>("AnimFormat") != AnimExportFormat_t::RAnim)
+				return { 0, 0 };
+
+			uint64_t DataSize = this->GetSequenceDataSize(Asset);
+
+			return { ExportMemoryAnimationEstimate + (DataSize * 4), ExportCostBase + (DataSize * ExportCostCopyByte) };
+		}
+		case (uint32_t)AssetType_t::Wrap:
+		{
+			WrapHeader Hdr = Reader.Read<WrapHeader>();
+
+			return { 0, ExportCostBase + ((uint64_t)max(Hdr.dcmpSize, 0) * ExportCostWrapByte) };
+		}
+		case (uint32_t)AssetType_t::Material:
+			return { ExportMemoryMaterialEstimate, ExportCostMaterial };
+		case (uint32_t)AssetType_t::UIImageAtlas:
+			return { ExportMemoryMaterialEstimate, ExportCostImageAtlas };
+		}
+	}
+	catch (...)
+	{
+	}
+
+	return { 0, ExportCostBase };
+}
+
+uint64_t RpakLib::EstimateSequencesCost(const RpakLoadAsset& Asset, const RPakPtr& Sequences, uint32_t Count)
+{
+	auto RpakStream = this->GetFileStream(Asset);
+	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
+
+	RpakStream->SetPosition(this->GetFileOffset(Asset, Sequences.Index, Sequences.Offset));
+
+	uint64_t Cost = 0;
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		uint64_t AnimHash = Reader.Read<uint64_t>();
+
+		if (!Assets.ContainsKey(AnimHash))
+			continue;
+
+		Cost += ExportCostSequence + (this->GetSequenceDataSize(Assets[AnimHash]) * ExportCostSequenceByte);
+	}
+
+	return Cost;
+}
+
+uint64_t RpakLib::GetSequenceDataSize(const RpakLoadAsset& Asset)
+{
+	// Only the newest header knows the size of the data stored outside of the sequence
+	if (Asset.SubHeaderSize != sizeof(ASeqHeaderV10))
+		return 0;
+
+	auto RpakStream = this->GetFileStream(Asset);
+	IO::BinaryReader Reader = IO::BinaryReader(RpakStream.get(), true);
+
+	RpakStream->SetPosition(this->GetFileOffset(Asset, Asset.SubHeaderIndex, Asset.SubHeaderOffset));
+
+	return Reader.Read<ASeqHeaderV10>().externalDataSize;
+}
+
+void RpakLib::HashAssetContents(Dictionary<uint64_t, uint64_t>& Hashes)
+{
+	std::vector<const RpakLoadAsset*> HashAssets;
+	HashAssets.reserve(this->Assets.Count());
+
+	for (auto& AssetKvp : this->Assets)
+		HashAssets.push_back(&AssetKvp.Value());
+
+	// The raw data of an asset has no size, it runs until the next subheader or raw data in the same page
+	std::vector<std::vector<uint64_t>> Boundaries(this->LoadedFileIndex);
+
+	for (auto& Asset : HashAssets)
+	{
+		Boundaries[Asset->FileIndex].push_back(((uint64_t)Asset->SubHeaderIndex << 32) | Asset->SubHeaderOffset);
+
+		if (Asset->RawDataIndex != -1)
+			Boundaries[Asset->FileIndex].push_back(((uint64_t)Asset->RawDataIndex << 32) | Asset->RawDataOffset);
+	}
+
+	for (auto& FileBoundaries : Boundaries)
+		std::sort(FileBoundaries.begin(), FileBoundaries.end());
+
+	// Pointers change whenever anything before their target moves, so the locations the pak lists are left out of the hash
+	std::vector<std::vector<uint64_t>> PointerOffsets(this->LoadedFileIndex);
+
+	for (uint32_t f = 0; f < this->LoadedFileIndex; f++)
+	{
+		RpakFile& File = this->LoadedFiles[f];
+
+		for (auto& Descriptor : File.PointerDescriptors)
+		{
+			if (Descriptor.PageIdx < File.StartSegmentIndex || Descriptor.PageIdx >= File.StartSegmentIndex + File.SegmentBlocks.Count())
+				continue;
+
+			PointerOffsets[f].push_back(File.SegmentBlocks[Descriptor.PageIdx - File.StartSegmentIndex].Offset + Descriptor.PageOffset);
+		}
+
+		std::sort(PointerOffsets[f].begin(), PointerOffsets[f].end());
+	}
+
+	std::vector<uint64_t> Results(HashAssets.size());
+
+	Threading::ThreadBudget::Run((uint32_t)HashAssets.size(), [&](uint32_t i)
+	{
+		const RpakLoadAsset& Asset = *HashAssets[i];
+		RpakFile& File = *Asset.PakFile;
+		const std::vector<uint64_t>& FileBoundaries = Boundaries[Asset.FileIndex];
+		const std::vector<uint64_t>& FilePointers = PointerOffsets[Asset.FileIndex];
+
+		std::vector<uint8_t> Buffer;
+		uint64_t Hash = 0;
+
+		// Pages below the start of a patch live in the base file and can't be read from here
+		auto HashRange = [&](uint32_t SegmentIndex, uint32_t SegmentOffset, uint64_t Size)
+		{
+			if (SegmentIndex < File.StartSegmentIndex || SegmentIndex >= File.StartSegmentIndex + File.SegmentBlocks.Count())
+			{
+				Hash = Hashing::XXHash::HashValue<uint64_t>(-1, Hashing::XXHashVersion::XX64, Hash);
+				return;
+			}
+
+			const RpakSegmentBlock& Block = File.SegmentBlocks[SegmentIndex - File.StartSegmentIndex];
+
+			if (SegmentOffset > Block.Size || Block.Offset + Block.Size > File.SegmentDataSize)
+				return;
+
+			Size = min(Size, Block.Size - SegmentOffset);
+
+			uint64_t Start = Block.Offset + SegmentOffset;
+			Buffer.assign(File.SegmentData.get() + Start, File.SegmentData.get() + Start + Size);
+
+			for (auto Pointer = std::lower_bound(FilePointers.begin(), FilePointers.end(), Start); Pointer != FilePointers.end() && *Pointer < Start + Size; Pointer++)
+				std::memset(Buffer.data() + (*Pointer - Start), 0, min(sizeof(RPakPtr), Start + Size - *Pointer));
+
+			Hash = Hashing::XXHash::ComputeHash(Buffer.data(), 0, Buffer.size(), Hashing::XXHashVersion::XX64, Hash);
+		};
+
+		HashRange(Asset.SubHeaderIndex, Asset.SubHeaderOffset, Asset.SubHeaderSize);
+
+		if (Asset.RawDataIndex != -1)
+		{
+			uint64_t Start = ((uint64_t)Asset.RawDataIndex << 32) | Asset.RawDataOffset;
+			auto Next = std::upper_bound(FileBoundaries.begin(), FileBoundaries.end(), Start);
+
+			uint64_t Size = (uint64_t)-1;
+
+			if (Next != FileBoundaries.end() && (uint32_t)(*Next >> 32) == Asset.RawDataIndex)
+				Size = (uint32_t)*Next - Asset.RawDataOffset;
+
+			HashRange(Asset.RawDataIndex, Asset.RawDataOffset, Size);
+		}
+
+		// Streamed data is too large to read, its size stands in for it
+		RpakFile& StreamFile = this->LoadedFiles[Asset.RpakFileIndex];
+		uint64_t StreamSizes[2]{};
+
+		if (Asset.StarpakOffset != -1 && Asset.StarpakOffset != 0)
+			StreamFile.TryGetStarpakEntrySize(Asset.StarpakOffset, StreamSizes[0], false);
+		if (Asset.OptimalStarpakOffset != -1 && Asset.OptimalStarpakOffset != 0)
+			StreamFile.TryGetStarpakEntrySize(Asset.OptimalStarpakOffset, StreamSizes[1], true);
+
+		Results[i] = Hashing::XXHash::ComputeHash((uint8_t*)StreamSizes, 0, sizeof(StreamSizes), Hashing::XXHashVersion::XX64, Hash);
+	});
+
+	for (size_t i = 0; i < HashAssets.size(); i++)
+		Hashes.Add(HashAssets[i]->NameHash, Results[i]);
+}
+
+string RpakLib::GetStoreTempPath(const string& BlobPath)
+{
+	return string::Format("%s.%u.tmp", BlobPath.ToCString(), this->ContentStoreTempIndex++);
+}
+
+bool RpakLib::LinkStoredBlob(const string& BlobPath, const string& DestPath)
+{
+	{
+		std::lock_guard<std::mutex> Lock(this->ContentStoreMutex);
+
+		// Blobs only appear in the store once they are complete
+		if (!IO::File::Exists(BlobPath))
+			return false;
+	}
+
+	// Never write through an existing link into the stored copy
+	if (IO::File::Exists(DestPath))
+		IO::File::Delete(DestPath);
+
+	// Volumes without hardlinks get a plain copy
+	if (!CreateHardLinkA(DestPath.ToCString(), BlobPath.ToCString(), nullptr))
+		IO::File::Copy(BlobPath, DestPath, true);
+
+	return true;
+}
+
+void RpakLib::StoreBlob(const string& TempPath, const string& BlobPath, const string& DestPath)
+{
+	if (!IO::File::Exists(TempPath))
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(this->ContentStoreMutex);
+
+		// Another thread stored the same blob first, its copy is identical
+		if (IO::File::Exists(BlobPath))
+			IO::File::Delete(TempPath);
+		else
+			IO::File::Move(TempPath, BlobPath, true);
+	}
+
+	this->LinkStoredBlob(BlobPath, DestPath);
+}
+
+void RpakLib::LogMemoCacheStats()
+{
+	g_Logger.Info("Parsed asset caches (hits/misses): shader vars %llu/%llu, shader bindings %llu/%llu, settings layouts %llu/%llu, skeletons %llu/%llu\n",
+		this->ShaderVarCache.GetHits(), this->ShaderVarCache.GetMisses(),
+		this->ShaderResBindingCache.GetHits(), this->ShaderResBindingCache.GetMisses(),
+		this->SettingsLayoutCache.GetHits(), this->SettingsLayoutCache.GetMisses(),
+		this->SkeletonCache.GetHits(), this->SkeletonCache.GetMisses());
+}
+
 std::unique_ptr<IO::MemoryStream> RpakLib::GetFileStream(const RpakLoadAsset& Asset)
 {
 	RpakFile& File = this->LoadedFiles[Asset.FileIndex];
@@ -685,16 +1105,17 @@ bool RpakLib::ValidateAssetStreamStatus(const RpakLoadAsset& Asset)
 	uint64_t ActualOptStarpakOffset = Asset.OptimalStarpakOffset & 0xFFFFFFFFFFFFFF00;
 	uint64_t StarpakPatchIndex = Asset.StarpakOffset & 0xFF;
 	uint64_t OptStarpakIndex = Asset.OptimalStarpakOffset & 0xFF;
+	uint64_t EntrySize = 0;
 
 	if (Asset.OptimalStarpakOffset != -1 && Asset.OptimalStarpakOffset != 0)
 	{
-		if (!this->LoadedFiles[Asset.RpakFileIndex].OptimalStarpakMap.ContainsKey(Asset.OptimalStarpakOffset))
+		if (!this->LoadedFiles[Asset.RpakFileIndex].TryGetStarpakEntrySize(Asset.OptimalStarpakOffset, EntrySize, true))
 			return false;
 	}
 
 	if (Asset.StarpakOffset != -1 && Asset.StarpakOffset != 0)
 	{
-		if (!this->LoadedFiles[Asset.RpakFileIndex].StarpakMap.ContainsKey(Asset.StarpakOffset))
+		if (!this->LoadedFiles[Asset.RpakFileIndex].TryGetStarpakEntrySize(Asset.StarpakOffset, EntrySize, false))
 			return false;
 	}
 
@@ -703,7 +1124,11 @@ bool RpakLib::ValidateAssetStreamStatus(const RpakLoadAsset& Asset)
 
 bool RpakLib::MountRpak(const string& Path, bool Dump)
 {
+	ExportProfileScope Profile(ExportStage::Mount);
+
 	IO::BinaryReader Reader = IO::BinaryReader(IO::File::OpenRead(Path));
+	Profile.AddBytes(Reader.GetBaseStream()->GetLength());
+
 	RpakBaseHeader BaseHeader = Reader.Read<RpakBaseHeader>();
 
 	if (BaseHeader.Magic != 0x6B615052)
@@ -788,12 +1213,15 @@ bool RpakLib::ParseApexRpak(const string& RpakPath, std::unique_ptr<IO::MemorySt
 	// Faster loading here by reading to the buffers directly
 	ParseStream->Read((uint8_t*)&VirtualSegments[0], 0, sizeof(RpakVirtualSegment) * Header.VirtualSegmentCount);
 	ParseStream->Read((uint8_t*)&MemPages[0], 0, sizeof(RpakVirtualSegmentBlock) * Header.MemPageCount);
-	ParseStream->Seek(Header.DescriptorCount * sizeof(RpakDescriptor), IO::SeekOrigin::Current);
+	ParseStream->Read((uint8_t*)&Descriptors[0], 0, sizeof(RpakDescriptor) * Header.DescriptorCount);
 	ParseStream->Read((uint8_t*)&AssetEntries[0], 0, sizeof(RpakApexAssetEntry) * Header.AssetEntryCount);
 
 	ParseStream->Seek(sizeof(RpakDescriptor) * Header.GuidDescriptorCount, IO::SeekOrigin::Current);
 	ParseStream->Seek(sizeof(RpakFileRelation) * Header.RelationsCount, IO::SeekOrigin::Current);
 
+	// Kept so content hashes can skip the pointers, they change whenever anything before their target moves
+	File->PointerDescriptors = Descriptors;
+
 	// do we have patch info
 	if (Header.PatchIndex)
 	{
@@ -825,7 +1253,8 @@ bool RpakLib::ParseApexRpak(const string& RpakPath, std::unique_ptr<IO::MemorySt
 
 	for (auto& Asset : AssetEntries)
 	{
-		File->AssetHashmap.Add(Asset.NameHash, Asset);
+		if (File->AssetHashmap.Add(Asset.NameHash, Asset))
+			this->AssetFileIndex.push_back({ Asset.NameHash, this->LoadedFileIndex - 1, (uint32_t)this->AssetFileIndex.size() });
 	}
 
 	File->StartSegmentIndex = PatchHeader.PatchSegmentIndex;
@@ -912,9 +1341,10 @@ bool RpakLib::ParseTitanfallRpak(const string& RpakPath, std::unique_ptr<IO::Mem
 	{
 		MemPages.EmplaceBack(Reader.Read<RpakVirtualSegmentBlock>());
 	}
+	File->PointerDescriptors.Clear();
 	for (uint32_t i = 0; i < Header.DescriptorCount; i++)
 	{
-		RpakDescriptor Descriptor = Reader.Read<RpakDescriptor>();
+		File->PointerDescriptors.EmplaceBack(Reader.Read<RpakDescriptor>());
 	}
 	for (uint32_t i = 0; i < Header.AssetEntryCount; i++)
 	{
@@ -955,7 +1385,8 @@ bool RpakLib::ParseTitanfallRpak(const string& RpakPath, std::unique_ptr<IO::Mem
 		std::memcpy(&NewAsset, &Asset, 40);
 		std::memcpy(((uint8_t*)&NewAsset) + 48, ((uint8_t*)&Asset) + 40, 32);
 
-		File->AssetHashmap.Add(Asset.NameHash, NewAsset);
+		if (File->AssetHashmap.Add(Asset.NameHash, NewAsset))
+			this->AssetFileIndex.push_back({ Asset.NameHash, this->LoadedFileIndex - 1, (uint32_t)this->AssetFileIndex.size() });
 	}
 	File->StartSegmentIndex = PatchHeader.PatchSegmentIndex;
 	File->SegmentData = std::make_unique<uint8_t[]>(BufferRemaining);
@@ -1027,9 +1458,10 @@ bool RpakLib::ParseR2TTRpak(const string& RpakPath, std::unique_ptr<IO::MemorySt
 	{
 		MemPages.EmplaceBack(Reader.Read<RpakVirtualSegmentBlock>());
 	}
+	File->PointerDescriptors.Clear();
 	for (uint32_t i = 0; i < Header.DescriptorCount; i++)
 	{
-		RpakDescriptor Descriptor = Reader.Read<RpakDescriptor>();
+		File->PointerDescriptors.EmplaceBack(Reader.Read<RpakDescriptor>());
 	}
 	for (uint32_t i = 0; i < Header.AssetEntryCount; i++)
 	{
@@ -1060,7 +1492,8 @@ bool RpakLib::ParseR2TTRpak(const string& RpakPath, std::unique_ptr<IO::MemorySt
 		std::memcpy(&NewAsset, &Asset, 40);
 		std::memcpy(((uint8_t*)&NewAsset) + 48, ((uint8_t*)&Asset) + 40, 32);
 
-		File->AssetHashmap.Add(Asset.NameHash, NewAsset);
+		if (File->AssetHashmap.Add(Asset.NameHash, NewAsset))
+			this->AssetFileIndex.push_back({ Asset.NameHash, this->LoadedFileIndex - 1, (uint32_t)this->AssetFileIndex.size() });
 	}
 	File->StartSegmentIndex = 0;
 	File->SegmentData = std::make_unique<uint8_t[]>(BufferRemaining);
@@ -1088,6 +1521,21 @@ bool RpakLib::ParseR2TTRpak(const string& RpakPath, std::unique_ptr<IO::MemorySt
 void RpakLib::MountStarpak(const string& Path, uint32_t FileIndex, uint32_t StarpakIndex, bool Optimal)
 {
 	RpakFile& File = this->LoadedFiles[FileIndex];
+	auto& Tables = Optimal ? File.OptimalStarpakTables : File.StarpakTables;
+
+	// Keep the tables lined up with the references, even when the starpak is missing
+	if (Tables.size() <= StarpakIndex)
+		Tables.resize(StarpakIndex + 1);
+
+	// Most starpaks are referenced by many rpaks, only read their table once
+	uint64_t PathHash = Hashing::XXHash::HashString(Path.ToLower());
+	std::shared_ptr<const StarpakEntryTable> Table;
+
+	if (this->StarpakTableCache.TryGetValue(PathHash, Table))
+	{
+		Tables[StarpakIndex] = Table;
+		return;
+	}
 
 	if (!IO::File::Exists(Path))
 	{
@@ -1095,28 +1543,32 @@ void RpakLib::MountStarpak(const string& Path, uint32_t FileIndex, uint32_t Star
 		return;
 	}
 
-	IO::BinaryReader Reader = IO::BinaryReader(IO::File::OpenRead(Path));
-	IO::Stream* StarpakStream = Reader.GetBaseStream();
-
-	StarpakStream->SetPosition(StarpakStream->GetLength() - sizeof(uint64_t));
+	auto StarpakStream = IO::File::OpenRead(Path);
+	uint64_t StarpakLength = StarpakStream->GetLength();
+	uint64_t EntryCount = 0;
 
-	uint64_t EntryCount = Reader.Read<uint64_t>();
+	if (StarpakLength < sizeof(uint64_t))
+		return;
 
-	StarpakStream->SetPosition(StarpakStream->GetLength() - sizeof(uint64_t) - (sizeof(StarpakStreamEntry) * EntryCount));
+	StarpakStream->Read((uint8_t*)&EntryCount, 0, sizeof(uint64_t), StarpakLength - sizeof(uint64_t));
 
-	for (uint32_t i = 0; i < EntryCount; i++)
+	if (EntryCount > (StarpakLength - sizeof(uint64_t)) / sizeof(StarpakStreamEntry))
 	{
-		StarpakStreamEntry Entry = Reader.Read<StarpakStreamEntry>();
-
-		if (Optimal)
-		{
-			File.OptimalStarpakMap.Add(Entry.Offset + StarpakIndex, Entry.Size);
-		}
-		else
-		{
-			File.StarpakMap.Add(Entry.Offset + StarpakIndex, Entry.Size);
-		}
+		g_Logger.Warning("Invalid streaming file %s\n", Path.ToCString());
+		return;
 	}
+
+	// The whole footer is read in one go, then sorted so lookups can binary search it
+	uint64_t TableSize = EntryCount * sizeof(StarpakStreamEntry);
+	auto NewTable = std::make_shared<StarpakEntryTable>();
+
+	NewTable->Entries.resize(EntryCount);
+	StarpakStream->Read((uint8_t*)NewTable->Entries.data(), 0, TableSize, StarpakLength - sizeof(uint64_t) - TableSize);
+
+	std::stable_sort(NewTable->Entries.begin(), NewTable->Entries.end(), [](const StarpakStreamEntry& lhs, const StarpakStreamEntry& rhs) { return lhs.Offset < rhs.Offset; });
+
+	this->StarpakTableCache.Add(PathHash, NewTable);
+	Tables[StarpakIndex] = NewTable;
 }
 
 bool RpakLib::MountApexRpak(const string& Path, bool Dump)
@@ -1145,6 +1597,7 @@ bool RpakLib::MountApexRpak(const string& Path, bool Dump)
 
 		Reader.Read(CompressedBuffer.get() + sizeof(RpakApexHeader), 0, Header.CompressedSize - sizeof(RpakApexHeader));
 
+		ExportProfileScope Profile(ExportStage::Decompress, Header.CompressedSize);
 		rpak_decomp_state state;
 
 		uint64_t dSize = RTech::DecompressPakfileInit(&state, CompressedBuffer.get(), Header.CompressedSize, 0, sizeof(RpakApexHeader));
@@ -1,10 +1,18 @@
 #include "pch.h"
 #include "Utils.h"
+#include "ExportArchive.h"
 
 // Check whether the specified file path should be written
 // Uses the OverwriteExistingFiles config value to determine whether existing files should be overwritten
 bool Utils::ShouldWriteFile(string Path)
 {
+	// Packed files leave their staging directory once the asset is done, the archive keeps the first copy of each
+	if (ExportArchive* Archive = ExportArchive::GetActive())
+	{
+		if (Archive->Contains(Path))
+			return false;
+	}
+
 	if (IO::File::Exists(Path))
 		return ExportManager::Config.Get<System::SettingType::Boolean>("OverwriteExistingFiles");
 
@@ -40,4 +48,21 @@ string Utils::Vector3ToHexColor(Math::Vector3 vec)
     stream << std::hex << (uint16_t)vec.X << (uint16_t)vec.Y << (uint16_t)vec.Z;
 
     return stream.str().c_str();
-}
\ No newline at end of file
+}
+
+string Utils::GetAssetTypeName(uint32_t AssetType)
+{
+    if (AssetType == 0)
+        return "none";
+
+    // Asset types are four character codes stored little endian
+    char Name[5]{};
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        char Value = (char)((AssetType >> (i * 8)) & 0xFF);
+        Name[i] = (std::isalnum((uint8_t)Value) || Value == '_') ? Value : '?';
+    }
+
+    return string(Name);
+}
@@ -64,7 +64,7 @@ void ExportApexBsp(const std::unique_ptr<RpakLib>& RpakFileSystem, std::unique_p
 	auto vertUnlitLumpData = ReadLump<dvertUnlit>(helper, LUMP_VERTEX_UNLIT);
 	auto vertUnlitTSLumpData = ReadLump<dvertUnlitTS>(helper, LUMP_VERTEX_UNLIT_TS);
 
-	std::unique_ptr<List<ApexAsset>> assetList;
+	std::unique_ptr<ApexAssetList> assetList;
 	Dictionary<string, RpakLoadAsset> loadedMaterials;
 
 	// make sure that RpakFileSystem actually exists (i.e. an rpak is loaded)
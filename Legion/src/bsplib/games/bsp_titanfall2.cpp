@@ -76,7 +76,7 @@ void ExportTitanfall2Bsp(const std::unique_ptr<RpakLib>& RpakFileSystem, std::un
 		}
 	}
 
-	std::unique_ptr<List<ApexAsset>> RpakMaterials;
+	std::unique_ptr<ApexAssetList> RpakMaterials;
 	Dictionary<string, RpakLoadAsset> RpakMaterialLookup;
 
 	// make sure that RpakFileSystem actually exists (i.e. an rpak is loaded)
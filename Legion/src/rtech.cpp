@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "rtech.h"
+#include "ExportProfiler.h"
 #include "basetypes.h"
 #include "../../cppnet/cppkore_incl/OODLE/oodle2.h"
 
@@ -2689,6 +2690,8 @@ void RTech::UnswizzleBlock(uint32_t x, uint32_t y, uint32_t a3, uint32_t power,
 
 std::unique_ptr<IO::MemoryStream> RTech::DecompressStreamedBuffer(const uint8_t* Data, uint64_t& DataSize, uint8_t Format, bool OodleReturnDataOnError, uint64_t OodleOutBufOffset)
 {
+	ExportProfileScope Profile(ExportStage::Decompress, DataSize);
+
 	switch ((CompressionType)Format)
 	{
 	case CompressionType::PAKFILE:
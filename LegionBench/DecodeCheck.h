@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include "StringBase.h"
+
+// Decodes generated BCn images with the CPU decoder and with DirectXTex, then compares the pixels and the speed of both
+//
+// The blocks are random bytes rather than encoded images, so every mode and endpoint combination of a format gets decoded.
+// Pixels may differ by one step where DirectXTex interpolates endpoints in floating point.
+class DecodeCheck
+{
+public:
+	// Runs the check for every format the CPU decoder supports and writes decode_check.json to the given folder
+	static bool Run(const string& OutputPath, uint32_t Size, uint32_t Runs, uint32_t Seed);
+
+private:
+	// Don't initialize this class
+	DecodeCheck() = delete;
+	~DecodeCheck() = delete;
+};
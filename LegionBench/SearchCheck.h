@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include "StringBase.h"
+
+// Runs search queries through AssetSearchIndex and through the linear filter the asset list used before it, then compares the rows
+//
+// Plain terms are checked against the old filter as it was. Prefix and re: terms didn't exist there, so they are checked
+// against a linear scan that matches them the way the query syntax documents, with regex patterns kept in the case they were typed.
+class SearchCheck
+{
+public:
+	// Searches a generated list of the given number of assets and writes search_check.json to the given folder
+	static bool Run(const string& OutputPath, uint32_t AssetCount, uint32_t Seed);
+
+private:
+	// Don't initialize this class
+	SearchCheck() = delete;
+	~SearchCheck() = delete;
+};
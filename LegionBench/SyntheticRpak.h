@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "StringBase.h"
+#include "ListBase.h"
+#include "RpakLib.h"
+
+// Builds an Apex (v8) rpak and its starpak from generated assets
+//
+// Every asset lives in one header page and one cpu page, and every pointer written into them gets a descriptor.
+// The content is drawn from a seeded generator, so the same seed always produces the same files.
+class SyntheticRpak
+{
+public:
+	SyntheticRpak(uint32_t Seed);
+
+	// Adds a v8 texture with a full mip chain, the highest mip goes to the starpak when Streamed is set
+	uint64_t AddTexture(const string& Name, uint16_t Width, uint16_t Height, uint16_t ImageFormat, bool Streamed);
+	// Adds a v11 sequence with one static blend, BoneCount must match the models that use it
+	uint64_t AddSequence(const string& Name, uint32_t BoneCount, uint32_t FrameCount);
+	// Adds a v16 model whose vertex data is streamed, the sequences are exported alongside it
+	uint64_t AddModel(const string& Name, uint32_t BoneCount, uint32_t MeshCount, uint32_t VerticesPerMesh, const List<uint64_t>& Sequences);
+
+	// Writes the rpak, oodle compressed when Compress is set, and the starpak beside it when any asset streams data
+	bool Save(const string& RpakPath, bool Compress = false);
+
+	// The number of assets added so far
+	uint32_t AssetCount() const;
+
+private:
+	enum PageIndex : uint32_t
+	{
+		HeaderPage,
+		CpuPage,
+
+		PageCount
+	};
+
+	std::mt19937 Random;
+	std::vector<uint8_t> Pages[PageCount];
+	std::vector<uint8_t> Starpak;
+	std::vector<StarpakStreamEntry> StarpakEntries;
+
+	List<RpakDescriptor> Descriptors;
+	List<RpakApexAssetEntry> Entries;
+
+	// Reserves zeroed space in a page and returns its offset
+	uint32_t Allocate(PageIndex Page, uint64_t Size, uint32_t Alignment);
+	// Copies data into a page that was already allocated
+	void Store(PageIndex Page, uint32_t Offset, const void* Data, uint64_t Size);
+	// Builds a pointer to a page offset, and records the location it is written to
+	RPakPtr Pointer(PageIndex Page, uint32_t Offset, PageIndex PtrPage, uint32_t PtrOffset);
+	// Writes a string to the cpu page
+	uint32_t AddString(const string& Value);
+	// Appends a streamed entry to the starpak and returns its offset
+	uint64_t AddStreamed(const uint8_t* Data, uint64_t Size);
+	// Fills a buffer with generated bytes
+	void Fill(uint8_t* Data, uint64_t Size);
+	// Records the asset entry for a finished sub header
+	void AddEntry(uint64_t Guid, AssetType_t Type, uint32_t Version, uint32_t HeaderOffset, uint32_t HeaderSize, uint32_t RawOffset, uint64_t StarpakOffset);
+};
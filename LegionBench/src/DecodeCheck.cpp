@@ -0,0 +1,214 @@
+#include "pch.h"
+#include "DecodeCheck.h"
+#include "ExportProfiler.h"
+#include "TextureCPUDecoder.h"
+#include "File.h"
+#include "Path.h"
+#include "Directory.h"
+#include "StreamWriter.h"
+
+#include <random>
+#include <vector>
+
+struct DecodeCheckFormat
+{
+	DXGI_FORMAT Format;
+	const char* Name;
+};
+
+static const DecodeCheckFormat DecodeCheckFormats[] =
+{
+	{ DXGI_FORMAT_BC1_UNORM, "BC1" },
+	{ DXGI_FORMAT_BC2_UNORM, "BC2" },
+	{ DXGI_FORMAT_BC3_UNORM, "BC3" },
+	{ DXGI_FORMAT_BC4_UNORM, "BC4" },
+	{ DXGI_FORMAT_BC5_UNORM, "BC5" },
+	{ DXGI_FORMAT_BC6H_UF16, "BC6H" },
+	{ DXGI_FORMAT_BC7_UNORM, "BC7" },
+};
+
+struct DecodeCheckResult
+{
+	const char* Name;
+	bool Supported;
+
+	uint64_t CpuTicks;
+	uint64_t DirectXTicks;
+
+	uint64_t Mismatches;
+	uint64_t OutOfTolerance;
+	uint32_t MaxDifference;
+};
+
+// Rounding differences between the decoders, in steps of an 8 bit channel
+constexpr uint32_t DecodeCheckTolerance = 1;
+
+static double DecodeCheckMegapixels(uint64_t Pixels, uint64_t Ticks)
+{
+	if (Ticks == 0)
+		return 0.0;
+
+	return ((double)Pixels / 1000000.0) / ((double)Ticks / 1000000000.0);
+}
+
+// Compares two RGBA8 images of the same size and counts the pixels where any channel differs
+static void DecodeCheckCompare(const DirectX::Image* Lhs, const DirectX::Image* Rhs, DecodeCheckResult& Result)
+{
+	for (size_t y = 0; y < Lhs->height; y++)
+	{
+		const uint8_t* LhsRow = Lhs->pixels + (y * Lhs->rowPitch);
+		const uint8_t* RhsRow = Rhs->pixels + (y * Rhs->rowPitch);
+
+		for (size_t x = 0; x < Lhs->width; x++)
+		{
+			uint32_t Difference = 0;
+
+			for (size_t c = 0; c < 4; c++)
+				Difference = max(Difference, (uint32_t)std::abs((int)LhsRow[(x * 4) + c] - (int)RhsRow[(x * 4) + c]));
+
+			if (Difference > 0)
+				Result.Mismatches++;
+			if (Difference > DecodeCheckTolerance)
+				Result.OutOfTolerance++;
+
+			Result.MaxDifference = max(Result.MaxDifference, Difference);
+		}
+	}
+}
+
+bool DecodeCheck::Run(const string& OutputPath, uint32_t Size, uint32_t Runs, uint32_t Seed)
+{
+	// Whole blocks only, the decoders agree on padding but it isn't what is being measured
+	Size = min(max(Size & ~3u, 4u), 16384u);
+	Runs = max(Runs, 1u);
+
+	std::mt19937 Random(Seed);
+	std::vector<DecodeCheckResult> Results;
+
+	uint64_t Pixels = (uint64_t)Size * Size;
+	bool Passed = true;
+
+	for (auto& Format : DecodeCheckFormats)
+	{
+		DecodeCheckResult Result{};
+		Result.Name = Format.Name;
+		Result.Supported = Assets::TextureCPUDecoder::IsSupported(Format.Format, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+		if (!Result.Supported)
+		{
+			g_Logger.Info("Decode check %s: not supported by the cpu decoder, skipped\n", Format.Name);
+			Results.push_back(Result);
+			continue;
+		}
+
+		size_t RowPitch = 0;
+		size_t SlicePitch = 0;
+
+		DirectX::ComputePitch(Format.Format, Size, Size, RowPitch, SlicePitch);
+
+		std::vector<uint8_t> Blocks(SlicePitch);
+
+		for (auto& Value : Blocks)
+			Value = (uint8_t)Random();
+
+		DirectX::Image Source{};
+		Source.width = Size;
+		Source.height = Size;
+		Source.format = Format.Format;
+		Source.rowPitch = RowPitch;
+		Source.slicePitch = SlicePitch;
+		Source.pixels = Blocks.data();
+
+		DirectX::TexMetadata Metadata{};
+		Metadata.width = Size;
+		Metadata.height = Size;
+		Metadata.depth = 1;
+		Metadata.arraySize = 1;
+		Metadata.mipLevels = 1;
+		Metadata.format = Format.Format;
+		Metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+		DirectX::ScratchImage CpuImage;
+		DirectX::ScratchImage DirectXImage;
+
+		Result.CpuTicks = UINT64_MAX;
+		Result.DirectXTicks = UINT64_MAX;
+
+		// The best run of each decoder is kept, both allocate their output every run
+		for (uint32_t i = 0; i < Runs; i++)
+		{
+			uint64_t Start = ExportProfiler::GetTicks();
+			HRESULT CpuResult = Assets::TextureCPUDecoder::Decompress(&Source, 1, Metadata, DXGI_FORMAT_R8G8B8A8_UNORM, CpuImage);
+			uint64_t CpuDone = ExportProfiler::GetTicks();
+			HRESULT DirectXResult = DirectX::Decompress(Source, DXGI_FORMAT_R8G8B8A8_UNORM, DirectXImage);
+			uint64_t DirectXDone = ExportProfiler::GetTicks();
+
+			if (FAILED(CpuResult) || FAILED(DirectXResult))
+			{
+				g_Logger.Info("Decode check %s: decoding failed (cpu 0x%08x, directxtex 0x%08x)\n", Format.Name, CpuResult, DirectXResult);
+				return false;
+			}
+
+			Result.CpuTicks = min(Result.CpuTicks, CpuDone - Start);
+			Result.DirectXTicks = min(Result.DirectXTicks, DirectXDone - CpuDone);
+		}
+
+		DecodeCheckCompare(CpuImage.GetImage(0, 0, 0), DirectXImage.GetImage(0, 0, 0), Result);
+
+		if (Result.OutOfTolerance > 0)
+			Passed = false;
+
+		g_Logger.Info("Decode check %s: cpu %.1f MP/s, directxtex %.1f MP/s, %llu of %llu pixels differ (%llu beyond tolerance, max %u)\n", Format.Name,
+			DecodeCheckMegapixels(Pixels, Result.CpuTicks),
+			DecodeCheckMegapixels(Pixels, Result.DirectXTicks),
+			Result.Mismatches, Pixels, Result.OutOfTolerance, Result.MaxDifference);
+
+		Results.push_back(Result);
+	}
+
+	string ReportPath = IO::Path::Combine(OutputPath, "decode_check.json");
+
+	try
+	{
+		IO::Directory::CreateDirectory(OutputPath);
+		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(ReportPath));
+
+		Writer.WriteLine("{");
+		Writer.WriteLineFmt("\t\"width\": %u,", Size);
+		Writer.WriteLineFmt("\t\"height\": %u,", Size);
+		Writer.WriteLineFmt("\t\"runs\": %u,", Runs);
+		Writer.WriteLineFmt("\t\"seed\": %u,", Seed);
+		Writer.WriteLineFmt("\t\"tolerance\": %u,", DecodeCheckTolerance);
+		Writer.WriteLineFmt("\t\"passed\": %s,", Passed ? "true" : "false");
+		Writer.WriteLine("\t\"formats\": [");
+
+		for (size_t i = 0; i < Results.size(); i++)
+		{
+			auto& Result = Results[i];
+			const char* Separator = (i + 1 < Results.size()) ? "," : "";
+
+			if (!Result.Supported)
+			{
+				Writer.WriteLineFmt("\t\t{ \"format\": \"%s\", \"supported\": false }%s", Result.Name, Separator);
+				continue;
+			}
+
+			Writer.WriteLineFmt("\t\t{ \"format\": \"%s\", \"supported\": true, \"cpu_mp_per_s\": %.2f, \"directxtex_mp_per_s\": %.2f, \"mismatched_pixels\": %llu, \"out_of_tolerance_pixels\": %llu, \"max_difference\": %u }%s",
+				Result.Name,
+				DecodeCheckMegapixels(Pixels, Result.CpuTicks),
+				DecodeCheckMegapixels(Pixels, Result.DirectXTicks),
+				Result.Mismatches, Result.OutOfTolerance, Result.MaxDifference, Separator);
+		}
+
+		Writer.WriteLine("\t]");
+		Writer.WriteLine("}");
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	g_Logger.Info("Decode check %s: %s\n", Passed ? "passed" : "failed", ReportPath.ToCString());
+
+	return Passed;
+}
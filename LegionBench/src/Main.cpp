@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "Directory.h"
+#include "Environment.h"
+#include "CommandLine.h"
+#include "ExportManager.h"
+#include "ExportBenchmark.h"
+#include "SyntheticRpak.h"
+#include "DecodeCheck.h"
+#include "SearchCheck.h"
+
+// Texture formats the generator picks from, as indices into TxtrFormatToDXGI (BC1, BC2, BC3, BC4, BC5, BC6H, BC7)
+static const uint16_t SyntheticImageFormats[] = { 0, 2, 4, 6, 8, 10, 12 };
+
+static uint32_t GetCountParam(const CommandLine& cmdline, const wchar_t* Name, const wchar_t* Default)
+{
+	return wcstoul(cmdline.GetParamValue(Name, (LPWSTR)Default), nullptr, 10);
+}
+
+int main()
+{
+	ExportManager::InitializeExporter();
+
+	int argc;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+	CommandLine cmdline(argc, argv);
+
+	SetConsoleTitleA("Legion+ | Benchmark");
+
+	if (!cmdline.HasParam(L"--nologfile"))
+		g_Logger.InitializeLogFile();
+
+	string OutputPath = IO::Path::Combine(System::Environment::GetApplicationPath(), "bench");
+
+	if (cmdline.HasParam(L"--out"))
+		OutputPath = wstring(cmdline.GetParamValue(L"--out")).ToString();
+
+	uint32_t Runs = max(GetCountParam(cmdline, L"--runs", L"5"), 1u);
+	uint32_t TextureCount = GetCountParam(cmdline, L"--textures", L"64");
+	uint32_t ModelCount = GetCountParam(cmdline, L"--models", L"16");
+	uint32_t SequenceCount = GetCountParam(cmdline, L"--sequences", L"8");
+	uint32_t BoneCount = min(max(GetCountParam(cmdline, L"--bones", L"64"), 1u), 128u);
+	uint32_t Seed = GetCountParam(cmdline, L"--seed", L"1");
+
+	IO::Directory::CreateDirectory(OutputPath);
+
+	// compares the cpu texture decoder against DirectXTex instead of exporting a pak
+	if (cmdline.HasParam(L"--decodecheck"))
+	{
+		uint32_t DecodeSize = GetCountParam(cmdline, L"--decodecheck", L"2048");
+
+		return DecodeCheck::Run(OutputPath, (DecodeSize > 0) ? DecodeSize : 2048, Runs, Seed) ? 0 : 1;
+	}
+
+	// compares the asset search index against the linear filter it replaced
+	if (cmdline.HasParam(L"--searchcheck"))
+	{
+		uint32_t SearchCount = GetCountParam(cmdline, L"--searchcheck", L"100000");
+
+		return SearchCheck::Run(OutputPath, (SearchCount > 0) ? SearchCount : 100000, Seed) ? 0 : 1;
+	}
+
+	// exports land next to the generated pak, in formats that every asset type here supports
+	ExportManager::ExportPath = IO::Path::Combine(OutputPath, "exported_files");
+	ExportManager::Config.Set<System::SettingType::Integer>("ModelFormat", (uint32_t)ModelExportFormat_t::Cast);
+	ExportManager::Config.Set<System::SettingType::Integer>("AnimFormat", (uint32_t)AnimExportFormat_t::Cast);
+	ExportManager::Config.Set<System::SettingType::Integer>("ImageFormat", (uint32_t)ImageExportFormat_t::Dds);
+
+	SyntheticRpak Pak(Seed);
+	std::mt19937 Random(Seed);
+
+	for (uint32_t i = 0; i < TextureCount; i++)
+	{
+		uint16_t Format = SyntheticImageFormats[Random() % _countof(SyntheticImageFormats)];
+		uint16_t Width = (uint16_t)(64 << (Random() % 6));
+		uint16_t Height = (uint16_t)(64 << (Random() % 6));
+
+		Pak.AddTexture(string::Format("texture/bench/synthetic_%04u.rpak", i), Width, Height, Format, (i % 2) == 0);
+	}
+
+	List<uint64_t> Sequences;
+
+	for (uint32_t i = 0; i < SequenceCount; i++)
+		Sequences.EmplaceBack(Pak.AddSequence(string::Format("animseq/bench/synthetic_%04u.rseq", i), BoneCount, 30 + (Random() % 90)));
+
+	for (uint32_t i = 0; i < ModelCount; i++)
+		Pak.AddModel(string::Format("mdl/bench/synthetic_%04u.rmdl", i), BoneCount, 1 + (Random() % 8), 256 + (Random() % 16384), Sequences);
+
+	string RpakPath = IO::Path::Combine(OutputPath, "bench_synthetic.rpak");
+
+	// Oodle is the only pak compression that can be written here, so the RTech pakfile decoder isn't measured
+	if (!Pak.Save(RpakPath, cmdline.HasParam(L"--compress")))
+	{
+		g_Logger.Info("Failed to generate %s\n", RpakPath.ToCString());
+		return 1;
+	}
+
+	g_Logger.Info("Generated %d assets into %s\n", Pak.AssetCount(), RpakPath.ToCString());
+
+	// models export their sequences with them, so only models and textures are listed
+	std::array<bool, 11> Assets{};
+	Assets[0] = true;
+	Assets[3] = true;
+
+	return ExportBenchmark::Run(RpakPath, Assets, Runs) ? 0 : 1;
+}
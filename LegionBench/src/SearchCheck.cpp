@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "SearchCheck.h"
+#include "AssetSearchIndex.h"
+#include "ExportProfiler.h"
+#include "File.h"
+#include "Path.h"
+#include "Directory.h"
+#include "StreamWriter.h"
+
+#include <random>
+#include <regex>
+#include <vector>
+
+// Queries in the order they are run, consecutive ones that extend a term go through the index's refinement
+static const char* SearchCheckQueries[] =
+{
+	// Plain terms, the old filter lowercased the whole query
+	"r97",
+	"R97",
+	"Flatline_V1",
+	"fl",
+	"wingman, KRABER",
+	"  havoc  ",
+	"zzz_missing",
+	"!mdl/",
+	"!lod0, texture/",
+	"w",
+	"wr",
+	"wra",
+	"wrai",
+	"wraith",
+	"wraith_v",
+	"wraith_v1",
+
+	// Prefix wildcards
+	"^mdl/weapons",
+	"^MDL/Humans",
+	"^texture/, ^ui/",
+	"^",
+	"!^settings/",
+
+	// Regex terms, escapes must keep their case
+	"re:r97_v\\d+",
+	"re:_V\\D",
+	"re:\\W",
+	"re:\\blod",
+	"re:^MDL/.*_lod[0-2]\\.rmdl$",
+	"re:(wraith|lifeline)_v[0-9]",
+	"re:kraber$",
+	"re:[abc",
+	"!re:lod0",
+	"havoc, re:^ui/",
+};
+
+static const char* SearchCheckFolders[] = { "mdl/Weapons/", "mdl/Humans/Pilots/", "texture/Models/", "animseq/Weapons/", "ui/Menu/", "Settings/Weapons/" };
+static const ApexAssetType SearchCheckTypes[] = { ApexAssetType::Model, ApexAssetType::Model, ApexAssetType::Image, ApexAssetType::AnimationSeq, ApexAssetType::UIImage, ApexAssetType::Settings };
+static const char* SearchCheckExtensions[] = { ".rmdl", ".rmdl", ".rpak", ".rseq", ".rpak", ".rpak" };
+static const char* SearchCheckWords[] = { "R97", "Flatline", "Wingman", "Kraber", "Havoc", "Wraith", "Lifeline", "Bloodhound" };
+
+struct SearchCheckTerm
+{
+	AssetSearchTerm::TermKind Kind;
+	string Text;
+	std::unique_ptr<std::regex> Pattern;
+};
+
+struct SearchCheckResult
+{
+	const char* Query;
+	uint32_t IndexRows;
+	uint32_t LinearRows;
+	bool Matched;
+
+	uint64_t IndexTicks;
+	uint64_t LinearTicks;
+};
+
+static double SearchCheckMilliseconds(uint64_t Ticks)
+{
+	return (double)Ticks / 1000000.0;
+}
+
+// Escapes a query for a json string
+static string SearchCheckEscape(const char* Value)
+{
+	string Result = "";
+
+	for (const char* c = Value; *c != 0; c++)
+	{
+		if (*c == '\\' || *c == '"')
+			Result.Append("\\");
+
+		Result.Append(*c);
+	}
+
+	return Result;
+}
+
+// Parses a term the way the search box documents it, only plain terms existed before the index
+static SearchCheckTerm SearchCheckParse(const string& Search)
+{
+	SearchCheckTerm Result;
+	string Term = Search.ToLower();
+
+	Result.Kind = AssetSearchTerm::TermKind::Substring;
+	Result.Text = Term;
+
+	if (Term.StartsWith("re:"))
+	{
+		try
+		{
+			Result.Pattern = std::make_unique<std::regex>(Search.Substring(3).ToCString(), std::regex::ECMAScript | std::regex::icase);
+			Result.Kind = AssetSearchTerm::TermKind::Regex;
+		}
+		catch (const std::regex_error&)
+		{
+			Result.Text = Term.Substring(3);
+		}
+	}
+	else if (Term.StartsWith("^") && Term.Length() > 1)
+	{
+		Result.Kind = AssetSearchTerm::TermKind::Prefix;
+		Result.Text = Term.Substring(1);
+	}
+
+	return Result;
+}
+
+// The filter LegionMain::SearchForAssets ran over every row before the index was built
+static List<uint32_t> SearchCheckLinear(const ApexAssetList& Assets, const string& Text)
+{
+	string SearchText = Text;
+
+	bool isBlackList = SearchText.StartsWith("!");
+	if (isBlackList)
+		SearchText = SearchText.Substring(1);
+
+	List<string> SearchMap = SearchText.Split(",");
+	std::vector<SearchCheckTerm> Terms;
+
+	for (auto& Search : SearchMap)
+		Terms.push_back(SearchCheckParse(Search.Trim()));
+
+	List<uint32_t> SearchResults;
+	uint32_t CurrentIndex = 0;
+
+	for (auto& Asset : Assets)
+	{
+		bool IsMatch = isBlackList;
+
+		for (auto& Search : Terms)
+		{
+			bool Result = false;
+
+			switch (Search.Kind)
+			{
+			case AssetSearchTerm::TermKind::Prefix:
+				Result = std::strncmp(Asset.NameLower, Search.Text.ToCString(), Search.Text.Length()) == 0;
+				break;
+			case AssetSearchTerm::TermKind::Regex:
+				Result = std::regex_search(Asset.NameLower, *Search.Pattern);
+				break;
+			default:
+				Result = std::strstr(Asset.NameLower, Search.Text.ToCString()) != nullptr;
+				break;
+			}
+
+			if (!isBlackList && Result)
+			{
+				IsMatch = true;
+				break;
+			}
+			else if (isBlackList && Result)
+			{
+				IsMatch = false;
+				break;
+			}
+		}
+
+		if (IsMatch)
+			SearchResults.Add(CurrentIndex);
+
+		CurrentIndex++;
+	}
+
+	return SearchResults;
+}
+
+bool SearchCheck::Run(const string& OutputPath, uint32_t AssetCount, uint32_t Seed)
+{
+	std::mt19937 Random(Seed);
+	ApexAssetList Assets;
+
+	for (uint32_t i = 0; i < AssetCount; i++)
+	{
+		uint32_t Folder = Random() % _countof(SearchCheckFolders);
+
+		ApexAssetInfo Info;
+		Info.Hash = ((uint64_t)Random() << 32) | Random();
+		Info.Name = string::Format("%s%s_v%u_LOD%u%s", SearchCheckFolders[Folder], SearchCheckWords[Random() % _countof(SearchCheckWords)], Random() % 24, Random() % 4, SearchCheckExtensions[Folder]);
+		Info.Type = SearchCheckTypes[Folder];
+		Info.Status = ApexAssetStatus::Loaded;
+		Info.Version = 8 + (Random() % 8);
+
+		Assets.AddAsset(Info);
+	}
+
+	Assets.SortByName();
+
+	AssetSearchIndex Index;
+
+	uint64_t BuildStart = ExportProfiler::GetTicks();
+	Index.Build(&Assets);
+	uint64_t BuildTicks = ExportProfiler::GetTicks() - BuildStart;
+
+	g_Logger.Info("Search check: indexed %u assets in %.3f ms\n", AssetCount, SearchCheckMilliseconds(BuildTicks));
+
+	std::vector<SearchCheckResult> Results;
+	bool Passed = true;
+
+	for (auto& Query : SearchCheckQueries)
+	{
+		SearchCheckResult Result{};
+		Result.Query = Query;
+
+		uint64_t Start = ExportProfiler::GetTicks();
+		List<uint32_t> IndexRows = Index.Search(Query);
+		uint64_t Searched = ExportProfiler::GetTicks();
+		List<uint32_t> LinearRows = SearchCheckLinear(Assets, Query);
+		uint64_t Scanned = ExportProfiler::GetTicks();
+
+		Result.IndexRows = IndexRows.Count();
+		Result.LinearRows = LinearRows.Count();
+		Result.IndexTicks = Searched - Start;
+		Result.LinearTicks = Scanned - Searched;
+		Result.Matched = (IndexRows.Count() == LinearRows.Count()) && std::equal(IndexRows.begin(), IndexRows.end(), LinearRows.begin());
+
+		if (!Result.Matched)
+			Passed = false;
+
+		g_Logger.Info("Search check \"%s\": index %u rows in %.3f ms, linear %u rows in %.3f ms%s\n", Query,
+			Result.IndexRows, SearchCheckMilliseconds(Result.IndexTicks),
+			Result.LinearRows, SearchCheckMilliseconds(Result.LinearTicks),
+			Result.Matched ? "" : ", rows differ");
+
+		Results.push_back(Result);
+	}
+
+	string ReportPath = IO::Path::Combine(OutputPath, "search_check.json");
+
+	try
+	{
+		IO::Directory::CreateDirectory(OutputPath);
+		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(ReportPath));
+
+		Writer.WriteLine("{");
+		Writer.WriteLineFmt("\t\"assets\": %u,", AssetCount);
+		Writer.WriteLineFmt("\t\"seed\": %u,", Seed);
+		Writer.WriteLineFmt("\t\"build_ms\": %.3f,", SearchCheckMilliseconds(BuildTicks));
+		Writer.WriteLineFmt("\t\"passed\": %s,", Passed ? "true" : "false");
+		Writer.WriteLine("\t\"queries\": [");
+
+		for (size_t i = 0; i < Results.size(); i++)
+		{
+			auto& Result = Results[i];
+
+			Writer.WriteLineFmt("\t\t{ \"query\": \"%s\", \"matched\": %s, \"index_rows\": %u, \"linear_rows\": %u, \"index_ms\": %.3f, \"linear_ms\": %.3f }%s",
+				SearchCheckEscape(Result.Query).ToCString(), Result.Matched ? "true" : "false",
+				Result.IndexRows, Result.LinearRows,
+				SearchCheckMilliseconds(Result.IndexTicks), SearchCheckMilliseconds(Result.LinearTicks),
+				(i + 1 < Results.size()) ? "," : "");
+		}
+
+		Writer.WriteLine("\t]");
+		Writer.WriteLine("}");
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	g_Logger.Info("Search check %s: %s\n", Passed ? "passed" : "failed", ReportPath.ToCString());
+
+	return Passed;
+}
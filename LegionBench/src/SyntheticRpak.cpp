@@ -0,0 +1,597 @@
+#include "pch.h"
+#include "SyntheticRpak.h"
+#include "File.h"
+#include "Path.h"
+#include "XXHash.h"
+#include "Half.h"
+#include "BinaryWriter.h"
+#include "MemoryStream.h"
+#include <DDS.h>
+#include <rtech.h>
+#include <animtypes.h>
+
+#include "../../cppnet/cppkore_incl/OODLE/oodle2.h"
+
+// Vertex layout for mesh flags 0x5001, a full position, one packed weight, the packed normal and one uv
+struct SyntheticVertex
+{
+	Math::Vector3 Position;
+	RMdlPackedVertexWeights Weights;
+	RMdlPackedVertexTBN Normal;
+	Math::Vector2 UV;
+};
+
+static_assert(sizeof(SyntheticVertex) == 0x20, "Invalid SyntheticVertex size, expected 0x20");
+
+// Static rotation of an animation track, 21 bits per component biased by 0x100000
+struct SyntheticQuat64
+{
+	uint64_t X : 21;
+	uint64_t Y : 21;
+	uint64_t Z : 21;
+	uint64_t WNeg : 1;
+};
+
+static uint64_t AlignValue(uint64_t Value, uint64_t Alignment)
+{
+	return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
+SyntheticRpak::SyntheticRpak(uint32_t Seed)
+	: Random(Seed)
+{
+}
+
+uint64_t SyntheticRpak::AddTexture(const string& Name, uint16_t Width, uint16_t Height, uint16_t ImageFormat, bool Streamed)
+{
+	uint64_t Guid = Hashing::XXHash::HashString(Name);
+
+	Assets::DDSFormat Format;
+	Format.Format = TxtrFormatToDXGI[ImageFormat];
+
+	uint32_t MipCount = Assets::DDS::CountMipLevels(Width, Height);
+	uint32_t StreamedMipCount = (Streamed && MipCount > 1) ? 1 : 0;
+
+	// Permanent mips are stored smallest first, each one 16 byte aligned, so the highest of them ends the data
+	uint64_t PermanentSize = 0;
+
+	for (uint32_t Mip = StreamedMipCount; Mip < MipCount; Mip++)
+		PermanentSize += AlignValue(Assets::DDS::CalculateMipSize(Width, Height, Mip, Format), 16);
+
+	uint32_t RawOffset = this->Allocate(CpuPage, PermanentSize, 16);
+	this->Fill(this->Pages[CpuPage].data() + RawOffset, PermanentSize);
+
+	uint64_t StarpakOffset = (uint64_t)-1;
+	uint64_t StreamedSize = 0;
+
+	if (StreamedMipCount > 0)
+	{
+		StreamedSize = Assets::DDS::CalculateMipSize(Width, Height, 0, Format);
+
+		std::vector<uint8_t> Mip(StreamedSize);
+		this->Fill(Mip.data(), StreamedSize);
+
+		StarpakOffset = this->AddStreamed(Mip.data(), StreamedSize);
+	}
+
+	uint32_t HeaderOffset = this->Allocate(HeaderPage, sizeof(TextureHeaderV8), 8);
+
+	TextureHeaderV8 Header{};
+	Header.guid = Guid;
+	Header.name = this->Pointer(CpuPage, this->AddString(Name), HeaderPage, HeaderOffset + offsetof(TextureHeaderV8, name));
+	Header.width = Width;
+	Header.height = Height;
+	Header.depth = 1;
+	Header.imageFormat = ImageFormat;
+	Header.dataSize = (uint32_t)(PermanentSize + StreamedSize);
+	Header.arraySize = 1;
+	Header.permanentMipCount = (uint8_t)(MipCount - StreamedMipCount);
+	Header.streamedMipCount = (uint8_t)StreamedMipCount;
+
+	this->Store(HeaderPage, HeaderOffset, &Header, sizeof(Header));
+	this->AddEntry(Guid, AssetType_t::Texture, 8, HeaderOffset, sizeof(TextureHeaderV8), RawOffset, StarpakOffset);
+
+	return Guid;
+}
+
+uint64_t SyntheticRpak::AddSequence(const string& Name, uint32_t BoneCount, uint32_t FrameCount)
+{
+	uint64_t Guid = Hashing::XXHash::HashString(Name);
+	string AnimName = IO::Path::GetFileNameWithoutExtension(Name);
+
+	// Every bone has a static position and rotation, the exporter decodes them once per frame
+	uint32_t FlagsSize = ((4 * BoneCount + 7) / 8 + 1) & ~1u;
+	uint32_t TrackSize = sizeof(mstudio_rle_anim_t) + (sizeof(uint16_t) * 3) + sizeof(SyntheticQuat64);
+
+	// Laid out like a compiled sequence, the descriptor, its blend table, the names, the blend and its data
+	uint32_t BlendTableOffset = sizeof(mstudioseqdesc_t_v16);
+	uint32_t LabelOffset = BlendTableOffset + sizeof(uint16_t);
+	uint32_t ActivityOffset = LabelOffset + AnimName.Length() + 1;
+	uint32_t AnimDescOffset = (uint32_t)AlignValue(ActivityOffset + 1, 4);
+	uint32_t AnimNameOffset = AnimDescOffset + sizeof(mstudioanimdescv54_t_v16);
+	uint32_t AnimDataOffset = (uint32_t)AlignValue(AnimNameOffset + AnimName.Length() + 1, 4);
+
+	std::vector<uint8_t> Data(AnimDataOffset + FlagsSize + (TrackSize * BoneCount));
+
+	mstudioseqdesc_t_v16 SeqDesc{};
+	SeqDesc.szlabelindex = (short)LabelOffset;
+	SeqDesc.szactivitynameindex = (short)ActivityOffset;
+	SeqDesc.numblends = 1;
+	SeqDesc.animindexindex = (short)BlendTableOffset;
+	SeqDesc.fadeintime = 0.2f;
+	SeqDesc.fadeouttime = 0.2f;
+
+	std::memcpy(Data.data(), &SeqDesc, sizeof(SeqDesc));
+	*(uint16_t*)(Data.data() + BlendTableOffset) = (uint16_t)AnimDescOffset;
+	std::memcpy(Data.data() + LabelOffset, AnimName.ToCString(), AnimName.Length());
+
+	mstudioanimdescv54_t_v16 AnimDesc{};
+	AnimDesc.fps = 30.f;
+	AnimDesc.flags = 0x20000;
+	AnimDesc.numframes = (short)FrameCount;
+	AnimDesc.sznameindex = (short)(AnimNameOffset - AnimDescOffset);
+	AnimDesc.animindex = (int)(AnimDataOffset - AnimDescOffset);
+
+	std::memcpy(Data.data() + AnimDescOffset, &AnimDesc, sizeof(AnimDesc));
+	std::memcpy(Data.data() + AnimNameOffset, AnimName.ToCString(), AnimName.Length());
+
+	std::uniform_real_distribution<float> Translation(-8.f, 8.f);
+	std::uniform_real_distribution<float> Rotation(-0.3f, 0.3f);
+
+	uint8_t* BoneFlags = Data.data() + AnimDataOffset;
+	uint8_t* Track = BoneFlags + FlagsSize;
+
+	for (uint32_t i = 0; i < BoneCount; i++)
+	{
+		BoneFlags[i / 2] |= (STUDIO_ANIM_BONEPOS | STUDIO_ANIM_BONEROT) << (4 * (i % 2));
+
+		mstudio_rle_anim_t Anim{};
+		Anim.size = TrackSize;
+
+		uint16_t Position[3]{ Math::Half::ToHalf(Translation(this->Random)), Math::Half::ToHalf(Translation(this->Random)), Math::Half::ToHalf(Translation(this->Random)) };
+
+		SyntheticQuat64 Quat{};
+		Quat.X = (uint64_t)((int)(Rotation(this->Random) * 1048576.5f) + 0x100000);
+		Quat.Y = (uint64_t)((int)(Rotation(this->Random) * 1048576.5f) + 0x100000);
+		Quat.Z = (uint64_t)((int)(Rotation(this->Random) * 1048576.5f) + 0x100000);
+
+		std::memcpy(Track, &Anim, sizeof(Anim));
+		std::memcpy(Track + sizeof(Anim), Position, sizeof(Position));
+		std::memcpy(Track + sizeof(Anim) + sizeof(Position), &Quat, sizeof(Quat));
+
+		Track += TrackSize;
+	}
+
+	uint32_t SeqOffset = this->Allocate(CpuPage, Data.size(), 16);
+	this->Store(CpuPage, SeqOffset, Data.data(), Data.size());
+
+	uint32_t HeaderOffset = this->Allocate(HeaderPage, sizeof(ASeqHeaderV10), 8);
+
+	ASeqHeaderV10 Header{};
+	Header.pAnimation = this->Pointer(CpuPage, SeqOffset, HeaderPage, HeaderOffset + offsetof(ASeqHeaderV10, pAnimation));
+	Header.pName = this->Pointer(CpuPage, this->AddString(Name), HeaderPage, HeaderOffset + offsetof(ASeqHeaderV10, pName));
+
+	this->Store(HeaderPage, HeaderOffset, &Header, sizeof(Header));
+	this->AddEntry(Guid, AssetType_t::Animation, 11, HeaderOffset, sizeof(ASeqHeaderV10), (uint32_t)-1, (uint64_t)-1);
+
+	return Guid;
+}
+
+uint64_t SyntheticRpak::AddModel(const string& Name, uint32_t BoneCount, uint32_t MeshCount, uint32_t VerticesPerMesh, const List<uint64_t>& Sequences)
+{
+	uint64_t Guid = Hashing::XXHash::HashString(Name);
+	string ModelName = IO::Path::GetFileNameWithoutExtension(Name);
+
+	// Offsets inside the studio data are 16 bit, and vertices are indexed with 16 bit indices
+	BoneCount = min(max(BoneCount, 1u), 128u);
+	MeshCount = min(max(MeshCount, 1u), 16u);
+
+	uint32_t GridSize = min(max((uint32_t)std::sqrt((double)VerticesPerMesh), 2u), 255u);
+	uint32_t VertexCount = GridSize * GridSize;
+	uint32_t IndexCount = (GridSize - 1) * (GridSize - 1) * 6;
+
+	// The vertex group holds every mesh of the single lod, each followed by its vertices and indices
+	std::vector<uint8_t> Vg(sizeof(VGHeader_t_v16) + (sizeof(VGMesh_t_v16) * MeshCount));
+
+	VGHeader_t_v16 VgHeader{};
+	VgHeader.nummeshes = MeshCount;
+	VgHeader.meshindex = sizeof(VGHeader_t_v16) - offsetof(VGHeader_t_v16, meshindex);
+
+	std::memcpy(Vg.data(), &VgHeader, sizeof(VgHeader));
+
+	std::uniform_real_distribution<float> Placement(-64.f, 64.f);
+
+	for (uint32_t s = 0; s < MeshCount; s++)
+	{
+		uint64_t MeshPosition = sizeof(VGHeader_t_v16) + (sizeof(VGMesh_t_v16) * s);
+		uint64_t VertexPosition = AlignValue(Vg.size(), 16);
+		uint64_t IndexPosition = VertexPosition + (sizeof(SyntheticVertex) * VertexCount);
+
+		Vg.resize(IndexPosition + (sizeof(uint16_t) * IndexCount), 0);
+
+		VGMesh_t_v16 Mesh{};
+		Mesh.flags = 0x5001;
+		Mesh.vertexCount = VertexCount;
+		Mesh.vertexSize = sizeof(SyntheticVertex);
+		Mesh.indexOffset = (int)(IndexPosition - (MeshPosition + offsetof(VGMesh_t_v16, indexOffset)));
+		Mesh.indexPacked.Count = IndexCount;
+		Mesh.vertexOffset = (int)(VertexPosition - (MeshPosition + offsetof(VGMesh_t_v16, vertexOffset)));
+		Mesh.vertexBufferSize = sizeof(SyntheticVertex) * VertexCount;
+
+		std::memcpy(Vg.data() + MeshPosition, &Mesh, sizeof(Mesh));
+
+		// A regular grid bent into a wave, bands of it follow one bone each
+		Math::Vector3 Origin(Placement(this->Random), Placement(this->Random), Placement(this->Random));
+		SyntheticVertex* Vertices = (SyntheticVertex*)(Vg.data() + VertexPosition);
+
+		for (uint32_t y = 0; y < GridSize; y++)
+		{
+			for (uint32_t x = 0; x < GridSize; x++)
+			{
+				SyntheticVertex& Vertex = Vertices[(y * GridSize) + x];
+				uint8_t Bone = (uint8_t)((x * BoneCount) / GridSize);
+
+				Vertex.Position = Math::Vector3(Origin.X + x, Origin.Y + y, Origin.Z + std::sin(x * 0.25f) * 4.f);
+				Vertex.Weights.BlendWeights[0] = 0x7FFF;
+				Vertex.Weights.BlendIds[0] = Bone;
+				Vertex.Weights.BlendIds[1] = Bone;
+				Vertex.Normal._Value = (2u << 29) | (256u << 19) | (256u << 10);
+				Vertex.UV = Math::Vector2((float)x / (GridSize - 1), (float)y / (GridSize - 1));
+			}
+		}
+
+		uint16_t* Indices = (uint16_t*)(Vg.data() + IndexPosition);
+
+		for (uint32_t y = 0; y < GridSize - 1; y++)
+		{
+			for (uint32_t x = 0; x < GridSize - 1; x++)
+			{
+				uint16_t Corner = (uint16_t)((y * GridSize) + x);
+
+				*Indices++ = Corner;
+				*Indices++ = (uint16_t)(Corner + GridSize);
+				*Indices++ = (uint16_t)(Corner + 1);
+				*Indices++ = (uint16_t)(Corner + 1);
+				*Indices++ = (uint16_t)(Corner + GridSize);
+				*Indices++ = (uint16_t)(Corner + GridSize + 1);
+			}
+		}
+	}
+
+	std::vector<uint8_t> Compressed(OodleLZ_GetCompressedBufferSizeNeeded(OodleLZ_Compressor_Kraken, Vg.size()));
+	int64_t CompressedSize = OodleLZ_Compress(OodleLZ_Compressor_Kraken, Vg.data(), Vg.size(), Compressed.data(), OodleLZ_CompressionLevel_Fast);
+
+	// The exporter reads the compressed data into a buffer of the decompressed size
+	if (CompressedSize <= 0 || (uint64_t)CompressedSize > Vg.size())
+	{
+		g_Logger.Warning("Failed to compress the vertex data of %s\n", Name.ToCString());
+		return 0;
+	}
+
+	uint64_t StarpakOffset = this->AddStreamed(Compressed.data(), CompressedSize);
+
+	// The studio data, every index in it is relative to the header or to the structure that holds it
+	List<string> BoneNames;
+	uint32_t BoneNamesSize = 0;
+
+	for (uint32_t i = 0; i < BoneCount; i++)
+	{
+		BoneNames.EmplaceBack(string::Format("bone_%03u", i));
+		BoneNamesSize += BoneNames[i].Length() + 1;
+	}
+
+	uint32_t StudioSize = sizeof(studiohdr_t_v16);
+
+	auto Reserve = [&StudioSize](uint64_t Size, uint64_t Alignment) -> uint32_t
+	{
+		uint32_t Result = (uint32_t)AlignValue(StudioSize, Alignment);
+		StudioSize = Result + (uint32_t)Size;
+
+		return Result;
+	};
+
+	uint32_t BoneIndex = Reserve(sizeof(mstudiobone_t_v16) * BoneCount, 4);
+	uint32_t BoneNameIndex = Reserve(BoneNamesSize, 1);
+	uint32_t BoneDataIndex = Reserve(sizeof(mstudiobonedata_t_v16) * BoneCount, 16);
+	uint32_t TextureIndex = Reserve(sizeof(uint64_t), 8);
+	uint32_t BodyPartIndex = Reserve(sizeof(mstudiobodyparts_t_v16), 4);
+	uint32_t MeshIndex = Reserve(sizeof(mstudiomesh_t_v16) * MeshCount, 4);
+	uint32_t LodDataIndex = Reserve(sizeof(vgloddata_t_v16), 4);
+
+	std::vector<uint8_t> Studio(StudioSize);
+
+	studiohdr_t_v16 StudioHeader{};
+	std::memcpy(StudioHeader.name, ModelName.ToCString(), min((uint32_t)ModelName.Length(), (uint32_t)sizeof(StudioHeader.name) - 1));
+	StudioHeader.checksum = (int)this->Random();
+	StudioHeader.hull_min = Math::Vector3(-64.f, -64.f, -64.f);
+	StudioHeader.hull_max = Math::Vector3(64.f, 64.f, 64.f);
+	StudioHeader.view_bbmin = StudioHeader.hull_min;
+	StudioHeader.view_bbmax = StudioHeader.hull_max;
+	StudioHeader.numbones = (short)BoneCount;
+	StudioHeader.boneindex = (uint16)BoneIndex;
+	StudioHeader.bonedataindex = (uint16)BoneDataIndex;
+	StudioHeader.numtextures = 1;
+	StudioHeader.textureindex = (uint16)TextureIndex;
+	StudioHeader.numbodyparts = 1;
+	StudioHeader.bodypartindex = (uint16)BodyPartIndex;
+	StudioHeader.vgloddataindex = (uint16)(LodDataIndex - offsetof(studiohdr_t_v16, vgloddataindex));
+	StudioHeader.numvgloddata = 1;
+
+	std::memcpy(Studio.data(), &StudioHeader, sizeof(StudioHeader));
+
+	std::uniform_real_distribution<float> BoneOffset(-10.f, 10.f);
+	uint32_t NameOffset = BoneNameIndex;
+
+	for (uint32_t i = 0; i < BoneCount; i++)
+	{
+		uint32_t BonePosition = BoneIndex + (sizeof(mstudiobone_t_v16) * i);
+
+		mstudiobone_t_v16 Bone{};
+		Bone.sznameindex = (short)(NameOffset - BonePosition);
+
+		std::memcpy(Studio.data() + BonePosition, &Bone, sizeof(Bone));
+		std::memcpy(Studio.data() + NameOffset, BoneNames[i].ToCString(), BoneNames[i].Length());
+
+		NameOffset += BoneNames[i].Length() + 1;
+
+		mstudiobonedata_t_v16 BoneData{};
+		BoneData.parent = (i == 0) ? -1 : (short)(this->Random() % i);
+		BoneData.pos = Math::Vector3(BoneOffset(this->Random), BoneOffset(this->Random), BoneOffset(this->Random));
+		BoneData.quat = Math::Quaternion(0.f, 0.f, 0.f, 1.f);
+		BoneData.qAlignment = Math::Quaternion(0.f, 0.f, 0.f, 1.f);
+		BoneData.scale = Math::Vector3(1.f, 1.f, 1.f);
+
+		std::memcpy(Studio.data() + BoneDataIndex + (sizeof(mstudiobonedata_t_v16) * i), &BoneData, sizeof(BoneData));
+	}
+
+	// The material isn't part of the pak, the exporter names it after its guid
+	*(uint64_t*)(Studio.data() + TextureIndex) = Hashing::XXHash::HashString(Name + "_material");
+
+	mstudiobodyparts_t_v16 BodyPart{};
+	BodyPart.nummodels = 1;
+	BodyPart.meshindex = (int)(MeshIndex - BodyPartIndex);
+
+	std::memcpy(Studio.data() + BodyPartIndex, &BodyPart, sizeof(BodyPart));
+
+	for (uint32_t s = 0; s < MeshCount; s++)
+	{
+		mstudiomesh_t_v16 Mesh{};
+		Mesh.meshid = (short)s;
+
+		std::memcpy(Studio.data() + MeshIndex + (sizeof(mstudiomesh_t_v16) * s), &Mesh, sizeof(Mesh));
+	}
+
+	vgloddata_t_v16 LodData{};
+	LodData.vgsizecompressed = (int)CompressedSize;
+	LodData.vgsizedecompressed = (int)Vg.size();
+	LodData.numMeshes = (byte)MeshCount;
+	LodData.numlods = 1;
+
+	std::memcpy(Studio.data() + LodDataIndex, &LodData, sizeof(LodData));
+
+	uint32_t StudioOffset = this->Allocate(CpuPage, Studio.size(), 16);
+	this->Store(CpuPage, StudioOffset, Studio.data(), Studio.size());
+
+	ModelCPU CpuData{};
+	CpuData.modelLength = (int)Studio.size();
+
+	uint32_t RawOffset = this->Allocate(CpuPage, sizeof(ModelCPU), 8);
+	this->Store(CpuPage, RawOffset, &CpuData, sizeof(CpuData));
+
+	uint32_t HeaderOffset = this->Allocate(HeaderPage, sizeof(ModelHeaderV16), 8);
+
+	ModelHeaderV16 Header{};
+	Header.studioData = this->Pointer(CpuPage, StudioOffset, HeaderPage, HeaderOffset + offsetof(ModelHeaderV16, studioData));
+	Header.name = this->Pointer(CpuPage, this->AddString(Name), HeaderPage, HeaderOffset + offsetof(ModelHeaderV16, name));
+	Header.alignedStreamingSize = (int)AlignValue(CompressedSize, 0x1000);
+	Header.bbox_min = StudioHeader.hull_min;
+	Header.bbox_max = StudioHeader.hull_max;
+
+	if (Sequences.Count() > 0)
+	{
+		uint32_t SequencesOffset = this->Allocate(CpuPage, sizeof(uint64_t) * Sequences.Count(), 8);
+
+		this->Store(CpuPage, SequencesOffset, Sequences.begin(), sizeof(uint64_t) * Sequences.Count());
+
+		Header.animSeqs = this->Pointer(CpuPage, SequencesOffset, HeaderPage, HeaderOffset + offsetof(ModelHeaderV16, animSeqs));
+		Header.animSeqCount = (short)Sequences.Count();
+	}
+
+	this->Store(HeaderPage, HeaderOffset, &Header, sizeof(Header));
+	this->AddEntry(Guid, AssetType_t::Model, 16, HeaderOffset, sizeof(ModelHeaderV16), RawOffset, StarpakOffset);
+
+	return Guid;
+}
+
+bool SyntheticRpak::Save(const string& RpakPath, bool Compress)
+{
+	if (this->Entries.Count() == 0)
+		return false;
+
+	// The loader keeps only the file name of a reference and opens it beside the rpak
+	string StarpakName = IO::Path::GetFileNameWithoutExtension(RpakPath) + ".starpak";
+	string StarpakReference = string("paks\\Win64\\") + StarpakName;
+	bool HasStarpak = !this->Starpak.empty();
+
+	RpakApexHeader Header{};
+	Header.Magic = 0x6B615052;
+	Header.Version = (uint16_t)RpakGameVersion::Apex;
+	Header.CompressionType = RpakCompressionType::None;
+	Header.Hash = ((uint64_t)this->Random() << 32) | this->Random();
+	Header.StarpakReferenceSize = HasStarpak ? (uint16_t)(StarpakReference.Length() + 1) : 0;
+	Header.VirtualSegmentCount = PageCount;
+	Header.MemPageCount = PageCount;
+	Header.DescriptorCount = this->Descriptors.Count();
+	Header.AssetEntryCount = this->Entries.Count();
+
+	// Everything after the header, which is what gets compressed
+	IO::MemoryStream Body;
+
+	{
+		IO::BinaryWriter Writer = IO::BinaryWriter(&Body, true);
+
+		if (HasStarpak)
+			Writer.WriteCString(StarpakReference);
+
+		// One segment per page, the header page holds sub headers and the cpu page everything they point to
+		for (uint32_t i = 0; i < PageCount; i++)
+			Writer.Write<RpakVirtualSegment>({ i, (i == HeaderPage) ? 8u : 16u, this->Pages[i].size() });
+
+		for (uint32_t i = 0; i < PageCount; i++)
+			Writer.Write<RpakVirtualSegmentBlock>({ i, (i == HeaderPage) ? 8u : 16u, (uint32_t)this->Pages[i].size() });
+
+		Writer.Write(&this->Descriptors[0], 0, sizeof(RpakDescriptor) * this->Descriptors.Count());
+		Writer.Write(&this->Entries[0], 0, sizeof(RpakApexAssetEntry) * this->Entries.Count());
+
+		for (auto& Page : this->Pages)
+			Writer.Write(Page.data(), 0, Page.size());
+	}
+
+	uint8_t* Data = Body.GetBuffer();
+	uint64_t DataSize = Body.GetLength();
+
+	Header.CompressedSize = sizeof(RpakApexHeader) + DataSize;
+	Header.DecompressedSize = sizeof(RpakApexHeader) + DataSize;
+
+	std::vector<uint8_t> Compressed;
+
+	if (Compress)
+	{
+		Compressed.resize(OodleLZ_GetCompressedBufferSizeNeeded(OodleLZ_Compressor_Kraken, DataSize));
+		int64_t CompressedSize = OodleLZ_Compress(OodleLZ_Compressor_Kraken, Data, DataSize, Compressed.data(), OodleLZ_CompressionLevel_Fast);
+
+		if (CompressedSize <= 0)
+		{
+			g_Logger.Info("Failed to compress %s\n", RpakPath.ToCString());
+			return false;
+		}
+
+		// The loader decodes the decompressed size into a buffer that already holds the header
+		Header.CompressionType = RpakCompressionType::Oodle;
+		Header.CompressedSize = sizeof(RpakApexHeader) + CompressedSize;
+		Header.DecompressedSize = DataSize;
+
+		Data = Compressed.data();
+		DataSize = (uint64_t)CompressedSize;
+	}
+
+	try
+	{
+		IO::BinaryWriter Writer = IO::BinaryWriter(IO::File::Create(RpakPath));
+
+		Writer.Write<RpakApexHeader>(Header);
+		Writer.Write(Data, 0, DataSize);
+	}
+	catch (...)
+	{
+		g_Logger.Info("Failed to write %s\n", RpakPath.ToCString());
+		return false;
+	}
+
+	if (!HasStarpak)
+		return true;
+
+	string StarpakPath = IO::Path::Combine(IO::Path::GetDirectoryName(RpakPath), StarpakName);
+
+	try
+	{
+		IO::BinaryWriter Writer = IO::BinaryWriter(IO::File::Create(StarpakPath));
+
+		// The entry table and its count close the file
+		Writer.Write(this->Starpak.data(), 0, this->Starpak.size());
+		Writer.Write(this->StarpakEntries.data(), 0, sizeof(StarpakStreamEntry) * this->StarpakEntries.size());
+		Writer.Write<uint64_t>(this->StarpakEntries.size());
+	}
+	catch (...)
+	{
+		g_Logger.Info("Failed to write %s\n", StarpakPath.ToCString());
+		return false;
+	}
+
+	return true;
+}
+
+uint32_t SyntheticRpak::AssetCount() const
+{
+	return this->Entries.Count();
+}
+
+uint32_t SyntheticRpak::Allocate(PageIndex Page, uint64_t Size, uint32_t Alignment)
+{
+	std::vector<uint8_t>& Data = this->Pages[Page];
+	uint64_t Offset = AlignValue(Data.size(), Alignment);
+
+	Data.resize(Offset + Size, 0);
+
+	return (uint32_t)Offset;
+}
+
+void SyntheticRpak::Store(PageIndex Page, uint32_t Offset, const void* Data, uint64_t Size)
+{
+	std::memcpy(this->Pages[Page].data() + Offset, Data, Size);
+}
+
+RPakPtr SyntheticRpak::Pointer(PageIndex Page, uint32_t Offset, PageIndex PtrPage, uint32_t PtrOffset)
+{
+	this->Descriptors.EmplaceBack(RpakDescriptor{ PtrPage, PtrOffset });
+
+	RPakPtr Result{};
+	Result.Index = Page;
+	Result.Offset = Offset;
+
+	return Result;
+}
+
+uint32_t SyntheticRpak::AddString(const string& Value)
+{
+	uint32_t Offset = this->Allocate(CpuPage, Value.Length() + 1, 1);
+	this->Store(CpuPage, Offset, Value.ToCString(), Value.Length());
+
+	return Offset;
+}
+
+uint64_t SyntheticRpak::AddStreamed(const uint8_t* Data, uint64_t Size)
+{
+	// The first page holds the file header, so no entry ever starts at zero
+	if (this->Starpak.empty())
+	{
+		this->Starpak.resize(0x1000, 0);
+
+		*(uint32_t*)&this->Starpak[0] = 0x6B505253; // SRPk
+		*(uint32_t*)&this->Starpak[4] = 1;
+	}
+
+	// Entries are page aligned, which leaves the low byte of the offset for the starpak index
+	uint64_t Offset = this->Starpak.size();
+
+	this->Starpak.insert(this->Starpak.end(), Data, Data + Size);
+	this->Starpak.resize(AlignValue(this->Starpak.size(), 0x1000), 0);
+
+	this->StarpakEntries.push_back({ Offset, Size });
+
+	return Offset;
+}
+
+void SyntheticRpak::Fill(uint8_t* Data, uint64_t Size)
+{
+	for (uint64_t i = 0; i < Size; i++)
+		Data[i] = (uint8_t)this->Random();
+}
+
+void SyntheticRpak::AddEntry(uint64_t Guid, AssetType_t Type, uint32_t Version, uint32_t HeaderOffset, uint32_t HeaderSize, uint32_t RawOffset, uint64_t StarpakOffset)
+{
+	RpakApexAssetEntry Entry{};
+	Entry.NameHash = Guid;
+	Entry.SubHeaderDataBlockIndex = HeaderPage;
+	Entry.SubHeaderDataBlockOffset = HeaderOffset;
+	Entry.RawDataBlockIndex = (RawOffset != (uint32_t)-1) ? (uint32_t)CpuPage : (uint32_t)-1;
+	Entry.RawDataBlockOffset = (RawOffset != (uint32_t)-1) ? RawOffset : 0;
+	Entry.StarpakOffset = StarpakOffset;
+	Entry.OptimalStarpakOffset = (uint64_t)-1;
+	Entry.PageEnd = PageCount;
+	Entry.SubHeaderSize = HeaderSize;
+	Entry.Version = Version;
+	Entry.Magic = (uint32_t)Type;
+
+	this->Entries.EmplaceBack(Entry);
+}
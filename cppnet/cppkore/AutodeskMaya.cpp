@@ -4,7 +4,7 @@
 #include "File.h"
 #include "Path.h"
 #include "CRC32.h"
-#include "StreamWriter.h"
+#include "BufferedTextWriter.h"
 #include "DictionaryBase.h"
 
 namespace Assets::Exporters
@@ -16,7 +16,7 @@ namespace Assets::Exporters
 
 	bool AutodeskMaya::ExportModel(const Model& Model, const string& Path)
 	{
-		auto Writer = IO::StreamWriter(IO::File::Create(Path));
+		auto Writer = IO::BufferedTextWriter(IO::File::Create(Path));
 		auto FileName = IO::Path::GetFileNameWithoutExtension(Path);
 		auto Hash = Hashing::CRC32::HashString(FileName);
 
@@ -70,7 +70,7 @@ namespace Assets::Exporters
 				for (auto& Vertex : Submesh.Vertices)
 				{
 					auto& Layer = Vertex.UVLayers(i - 1);
-					Writer.WriteFmt(" %f %f", Layer.U, (1 - Layer.V));
+					Writer << ' ' << Layer.U << ' ' << (1 - Layer.V);
 				}
 
 				Writer.Write(";\n");
@@ -90,14 +90,9 @@ namespace Assets::Exporters
 				auto& Vertex2 = Submesh.Vertices[Face[1]].Color();
 				auto& Vertex3 = Submesh.Vertices[Face[0]].Color();
 
-				Writer.WriteFmt(
-					" %f %f %f %f"
-					" %f %f %f %f"
-					" %f %f %f %f",
-					Vertex1[0] / 255.f, Vertex1[1] / 255.f, Vertex1[2] / 255.f, Vertex1[3] / 255.f,
-					Vertex2[0] / 255.f, Vertex2[1] / 255.f, Vertex2[2] / 255.f, Vertex2[3] / 255.f,
-					Vertex3[0] / 255.f, Vertex3[1] / 255.f, Vertex3[2] / 255.f, Vertex3[3] / 255.f
-				);
+				Writer << ' ' << (Vertex1[0] / 255.f) << ' ' << (Vertex1[1] / 255.f) << ' ' << (Vertex1[2] / 255.f) << ' ' << (Vertex1[3] / 255.f);
+				Writer << ' ' << (Vertex2[0] / 255.f) << ' ' << (Vertex2[1] / 255.f) << ' ' << (Vertex2[2] / 255.f) << ' ' << (Vertex2[3] / 255.f);
+				Writer << ' ' << (Vertex3[0] / 255.f) << ' ' << (Vertex3[1] / 255.f) << ' ' << (Vertex3[2] / 255.f) << ' ' << (Vertex3[3] / 255.f);
 			}
 
 			Writer.WriteLineFmt(
@@ -114,7 +109,7 @@ namespace Assets::Exporters
 			for (auto& Vertex : Submesh.Vertices)
 			{
 				auto& Position = Vertex.Position();
-				Writer.WriteFmt(" %f %f %f", Position.X, Position.Y, Position.Z);
+				Writer << ' ' << Position.X << ' ' << Position.Y << ' ' << Position.Z;
 			}
 
 			Writer.WriteFmt(
@@ -126,7 +121,7 @@ namespace Assets::Exporters
 			);
 
 			for (auto& Face : Submesh.Faces)
-				Writer.WriteFmt(" %d %d 0 %d %d 0 %d %d 0", Face[2], Face[1], Face[1], Face[0], Face[0], Face[2]);
+				Writer << ' ' << Face[2] << ' ' << Face[1] << " 0 " << Face[1] << ' ' << Face[0] << " 0 " << Face[0] << ' ' << Face[2] << " 0";
 
 			Writer.WriteFmt(
 				";\n"
@@ -142,14 +137,9 @@ namespace Assets::Exporters
 				auto& Vertex2 = Submesh.Vertices[Face[1]].Normal();
 				auto& Vertex3 = Submesh.Vertices[Face[0]].Normal();
 
-				Writer.WriteFmt(
-					" %f %f %f"
-					" %f %f %f"
-					" %f %f %f",
-					Vertex1.X, Vertex1.Y, Vertex1.Z,
-					Vertex2.X, Vertex2.Y, Vertex2.Z,
-					Vertex3.X, Vertex3.Y, Vertex3.Z
-				);
+				Writer << ' ' << Vertex1.X << ' ' << Vertex1.Y << ' ' << Vertex1.Z;
+				Writer << ' ' << Vertex2.X << ' ' << Vertex2.Y << ' ' << Vertex2.Z;
+				Writer << ' ' << Vertex3.X << ' ' << Vertex3.Y << ' ' << Vertex3.Z;
 			}
 
 			Writer.WriteLine(";");
@@ -163,12 +153,12 @@ namespace Assets::Exporters
 
 			for (auto& Face : Submesh.Faces)
 			{
-				Writer.WriteFmt(" f 3 %d %d %d", FaceIndex, (FaceIndex + 1), (FaceIndex + 2));
+				Writer << " f 3 " << FaceIndex << ' ' << (FaceIndex + 1) << ' ' << (FaceIndex + 2);
 
 				for (uint8_t i = 0; i < Submesh.Vertices.UVLayerCount(); i++)
-					Writer.WriteFmt(" mu %d 3 %d %d %d", i, Face[2], Face[1], Face[0]);
+					Writer << " mu " << (uint32_t)i << " 3 " << Face[2] << ' ' << Face[1] << ' ' << Face[0];
 
-				Writer.WriteFmt(" mc 0 3 %d %d %d", FaceIndex, (FaceIndex + 1), (FaceIndex + 2));
+				Writer << " mc 0 3 " << FaceIndex << ' ' << (FaceIndex + 1) << ' ' << (FaceIndex + 2);
 
 				FaceIndex += 3;
 			}
@@ -379,7 +369,7 @@ namespace Assets::Exporters
 			}
 		}
 
-		auto Binder = IO::StreamWriter(IO::File::Create(IO::Path::Combine(IO::Path::GetDirectoryName(Path), FileName + "_BIND.mel")));
+		auto Binder = IO::BufferedTextWriter(IO::File::Create(IO::Path::Combine(IO::Path::GetDirectoryName(Path), FileName + "_BIND.mel")));
 
 		Binder.WriteLine(
 			"/*\n* Autodesk Maya Bind Script\n*/\n"
@@ -438,12 +428,12 @@ namespace Assets::Exporters
 					auto Vertex = Submesh.Vertices[i];
 
 					if (i != 0)
-						Binder.Write(";");
+						Binder.Write(';');
 
 					for (uint32_t b = 0; b < BoneNames.Count(); b++)
 					{
 						if (b != 0)
-							Binder.Write(",");
+							Binder.Write(',');
 
 						float WeightValue = 0.0f;
 
@@ -457,9 +447,9 @@ namespace Assets::Exporters
 						}
 
 						if (WeightValue == 0.0f || WeightValue == 1.0f)
-							Binder.WriteFmt("%d", (uint32_t)WeightValue);
+							Binder.Write((uint32_t)WeightValue);
 						else
-							Binder.WriteFmt("%f", WeightValue);
+							Binder.Write(WeightValue);
 					}
 				}
 
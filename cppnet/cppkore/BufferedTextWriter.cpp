@@ -0,0 +1,311 @@
+#include "stdafx.h"
+#include "BufferedTextWriter.h"
+
+#include <charconv>
+
+namespace IO
+{
+	BufferedTextWriter::BufferedTextWriter(std::unique_ptr<Stream> Stream, bool TranslateNewLines, uint32_t BufferSize)
+	{
+		this->BaseStream = std::move(Stream);
+		this->_LeaveOpen = false;
+		this->_TranslateNewLines = TranslateNewLines;
+		this->_BufferSize = (BufferSize < MaxNumberLength) ? MaxNumberLength : BufferSize;
+		this->_BufferPosition = 0;
+		this->_Buffer = std::make_unique<char[]>(this->_BufferSize);
+	}
+
+	BufferedTextWriter::BufferedTextWriter(Stream* Stream, bool LeaveOpen, bool TranslateNewLines, uint32_t BufferSize)
+	{
+		this->BaseStream.reset(Stream);
+		this->_LeaveOpen = LeaveOpen;
+		this->_TranslateNewLines = TranslateNewLines;
+		this->_BufferSize = (BufferSize < MaxNumberLength) ? MaxNumberLength : BufferSize;
+		this->_BufferPosition = 0;
+		this->_Buffer = std::make_unique<char[]>(this->_BufferSize);
+	}
+
+	BufferedTextWriter::~BufferedTextWriter()
+	{
+		// Errors can't leave a destructor, callers that care should close the writer themselves
+		try
+		{
+			this->Close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void BufferedTextWriter::Close()
+	{
+		if (this->BaseStream && this->_BufferPosition > 0)
+			this->Flush();
+
+		// Forcefully reset the stream
+		if (this->_LeaveOpen)
+			this->BaseStream.release();
+		else
+			this->BaseStream.reset();
+	}
+
+	void BufferedTextWriter::Flush()
+	{
+		if (!this->BaseStream)
+			IOError::StreamBaseStream();
+
+		if (this->_BufferPosition > 0)
+		{
+			this->BaseStream->Write((uint8_t*)this->_Buffer.get(), 0, this->_BufferPosition);
+			this->_BufferPosition = 0;
+		}
+
+		this->BaseStream->Flush();
+	}
+
+	void BufferedTextWriter::Write(const char Value)
+	{
+		if (Value == '\n' && this->_TranslateNewLines)
+		{
+			this->WriteRaw("\r\n", 2);
+			return;
+		}
+
+		*this->Reserve(1) = Value;
+		this->_BufferPosition++;
+	}
+
+	void BufferedTextWriter::Write(const char* Buffer, uint32_t Index, uint32_t Count)
+	{
+		if (!this->_TranslateNewLines)
+		{
+			this->WriteRaw(Buffer + Index, Count);
+			return;
+		}
+
+		const char* Start = Buffer + Index;
+		const char* End = Start + Count;
+
+		while (Start < End)
+		{
+			auto NewLine = (const char*)std::memchr(Start, '\n', End - Start);
+
+			if (NewLine == nullptr)
+			{
+				this->WriteRaw(Start, (uint32_t)(End - Start));
+				break;
+			}
+
+			this->WriteRaw(Start, (uint32_t)(NewLine - Start));
+			this->WriteRaw("\r\n", 2);
+
+			Start = NewLine + 1;
+		}
+	}
+
+	void BufferedTextWriter::Write(const char* Value)
+	{
+		this->Write(Value, 0, (uint32_t)strlen(Value));
+	}
+
+	void BufferedTextWriter::Write(const string& Value)
+	{
+		this->Write((const char*)Value, 0, Value.Length());
+	}
+
+	void BufferedTextWriter::Write(const std::string& Value)
+	{
+		this->Write(Value.c_str(), 0, (uint32_t)Value.size());
+	}
+
+	void BufferedTextWriter::Write(int32_t Value)
+	{
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::Write(uint32_t Value)
+	{
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::Write(long Value)
+	{
+		this->Write((int64_t)Value);
+	}
+
+	void BufferedTextWriter::Write(unsigned long Value)
+	{
+		this->Write((uint64_t)Value);
+	}
+
+	void BufferedTextWriter::Write(int64_t Value)
+	{
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::Write(uint64_t Value)
+	{
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::Write(bool Value)
+	{
+		if (Value)
+			this->WriteRaw("true", 4);
+		else
+			this->WriteRaw("false", 5);
+	}
+
+	void BufferedTextWriter::Write(float Value)
+	{
+		// Fixed notation of the largest float fits in the reserved space, no format call needed
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value, std::chars_format::fixed);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::Write(double Value)
+	{
+		auto Buffer = this->Reserve(MaxNumberLength);
+		auto Result = std::to_chars(Buffer, Buffer + MaxNumberLength, Value, std::chars_format::fixed);
+
+		this->_BufferPosition += (uint32_t)(Result.ptr - Buffer);
+	}
+
+	void BufferedTextWriter::WriteLine()
+	{
+		this->WriteRaw("\r\n", 2);
+	}
+
+	void BufferedTextWriter::WriteLine(const char* Value)
+	{
+		if (Value != nullptr)
+			this->Write(Value);
+
+		this->WriteLine();
+	}
+
+	void BufferedTextWriter::WriteLine(const string& Value)
+	{
+		this->Write(Value);
+		this->WriteLine();
+	}
+
+	void BufferedTextWriter::WriteFmt(const char* Format, ...)
+	{
+		va_list vArgs;
+		va_start(vArgs, Format);
+
+		this->WriteFmtInternal(Format, vArgs);
+
+		va_end(vArgs);
+	}
+
+	void BufferedTextWriter::WriteLineFmt(const char* Format, ...)
+	{
+		if (Format != nullptr)
+		{
+			va_list vArgs;
+			va_start(vArgs, Format);
+
+			this->WriteFmtInternal(Format, vArgs);
+
+			va_end(vArgs);
+		}
+
+		this->WriteLine();
+	}
+
+	Stream* BufferedTextWriter::GetBaseStream() const
+	{
+		return this->BaseStream.get();
+	}
+
+	char* BufferedTextWriter::Reserve(uint32_t Count)
+	{
+		if (this->_BufferPosition + Count > this->_BufferSize)
+		{
+			if (!this->BaseStream)
+				IOError::StreamBaseStream();
+
+			this->BaseStream->Write((uint8_t*)this->_Buffer.get(), 0, this->_BufferPosition);
+			this->_BufferPosition = 0;
+		}
+
+		return this->_Buffer.get() + this->_BufferPosition;
+	}
+
+	void BufferedTextWriter::WriteRaw(const char* Buffer, uint32_t Count)
+	{
+		// Large blocks skip the buffer rather than being copied through it
+		if (Count >= this->_BufferSize)
+		{
+			if (!this->BaseStream)
+				IOError::StreamBaseStream();
+
+			if (this->_BufferPosition > 0)
+			{
+				this->BaseStream->Write((uint8_t*)this->_Buffer.get(), 0, this->_BufferPosition);
+				this->_BufferPosition = 0;
+			}
+
+			this->BaseStream->Write((uint8_t*)Buffer, 0, Count);
+			return;
+		}
+
+		std::memcpy(this->Reserve(Count), Buffer, Count);
+		this->_BufferPosition += Count;
+	}
+
+	void BufferedTextWriter::WriteFmtInternal(const char* Format, va_list Args)
+	{
+		va_list ArgsCopy;
+		va_copy(ArgsCopy, Args);
+
+		// Format straight into the buffer when the result fits the space left
+		auto Available = this->_BufferSize - this->_BufferPosition;
+
+		if (Available < MaxNumberLength)
+		{
+			this->Reserve(this->_BufferSize);
+			Available = this->_BufferSize;
+		}
+
+		auto ResultFmt = vsnprintf(this->_Buffer.get() + this->_BufferPosition, Available, Format, Args);
+
+		if (ResultFmt < 0)
+		{
+			va_end(ArgsCopy);
+			return;
+		}
+
+		auto Formatted = this->_Buffer.get() + this->_BufferPosition;
+
+		if ((uint32_t)ResultFmt < Available && (!this->_TranslateNewLines || std::memchr(Formatted, '\n', ResultFmt) == nullptr))
+		{
+			va_end(ArgsCopy);
+			this->_BufferPosition += (uint32_t)ResultFmt;
+			return;
+		}
+
+		auto HeapFmt = std::make_unique<char[]>(ResultFmt + 1);
+
+		vsnprintf(HeapFmt.get(), ResultFmt + 1, Format, ArgsCopy);
+		va_end(ArgsCopy);
+
+		this->Write((const char*)HeapFmt.get(), 0, (uint32_t)ResultFmt);
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <cstdarg>
+#include <string>
+#include "Stream.h"
+#include "IOError.h"
+#include "StringBase.h"
+
+namespace IO
+{
+	// BufferedTextWriter formats text into a large buffer and writes it to the stream in blocks,
+	// numbers are formatted without printf and floats use the shortest text that reads back the same value
+	class BufferedTextWriter
+	{
+	public:
+		BufferedTextWriter(std::unique_ptr<Stream> Stream, bool TranslateNewLines = false, uint32_t BufferSize = DefaultBufferSize);
+		BufferedTextWriter(Stream* Stream, bool LeaveOpen, bool TranslateNewLines = false, uint32_t BufferSize = DefaultBufferSize);
+		~BufferedTextWriter();
+
+		// Writes the buffer and closes the stream
+		void Close();
+		// Writes the buffer to the stream
+		void Flush();
+
+		// Writes a character to the file
+		void Write(const char Value);
+		// Writes a character array to the file
+		void Write(const char* Buffer, uint32_t Index, uint32_t Count);
+		// Writes a null-terminated string to the file
+		void Write(const char* Value);
+		// Writes a string to the file
+		void Write(const string& Value);
+		// Writes a string to the file
+		void Write(const std::string& Value);
+
+		// Writes an integer to the file
+		void Write(int32_t Value);
+		// Writes an integer to the file
+		void Write(uint32_t Value);
+		// Writes an integer to the file
+		void Write(long Value);
+		// Writes an integer to the file
+		void Write(unsigned long Value);
+		// Writes an integer to the file
+		void Write(int64_t Value);
+		// Writes an integer to the file
+		void Write(uint64_t Value);
+		// Writes a boolean to the file as true or false
+		void Write(bool Value);
+		// Writes a float to the file in fixed notation
+		void Write(float Value);
+		// Writes a double to the file in fixed notation
+		void Write(double Value);
+
+		// Ends the current line
+		void WriteLine();
+		// Writes a null-terminated string to the file and ends the line
+		void WriteLine(const char* Value);
+		// Writes a string to the file and ends the line
+		void WriteLine(const string& Value);
+
+		// Writes a formatted string to the file
+		void WriteFmt(const char* Format, ...);
+		// Writes a formatted string to the file and ends the line
+		void WriteLineFmt(const char* Format, ...);
+
+		// Writes any supported value, for porting stream style writers
+		template<typename T>
+		BufferedTextWriter& operator<<(const T& Value)
+		{
+			this->Write(Value);
+			return *this;
+		}
+
+		// Get the underlying stream
+		Stream* GetBaseStream() const;
+
+	private:
+		std::unique_ptr<Stream> BaseStream;
+		bool _LeaveOpen;
+		bool _TranslateNewLines;
+
+		std::unique_ptr<char[]> _Buffer;
+		uint32_t _BufferSize;
+		uint32_t _BufferPosition;
+
+		// Makes room for the count of characters in the buffer
+		char* Reserve(uint32_t Count);
+		// Copies characters into the buffer without translating new lines
+		void WriteRaw(const char* Buffer, uint32_t Count);
+		// Writes a formatted string to the file
+		void WriteFmtInternal(const char* Format, va_list Args);
+
+		// Formatted values are written straight into the buffer
+		static uint32_t constexpr MaxNumberLength = 384;
+		static uint32_t constexpr DefaultBufferSize = 0x100000;
+	};
+}
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "DDS.h"
+#include "File.h"
 
 #include "..\cppkore_incl\DirectXTex\DirectXTex.h"
 
@@ -45,10 +46,11 @@ namespace Assets
 		WriteDDSHeader(Stream.get(), Width, Height, Format);
 	}
 
-	void DDS::WriteDDSHeader(IO::Stream* Stream, uint32_t Width, uint32_t Height, const DDSFormat& Format)
+	// The largest possible header, magic + DDS_HEADER + DDS_HEADER_DXT10
+	constexpr size_t DDSMaxHeaderSize = 0x94;
+
+	static DirectX::TexMetadata BuildDDSMetadata(uint32_t Width, uint32_t Height, const DDSFormat& Format)
 	{
-		// Temporary buffer
-		char Buffer[0x100]{};
 		DirectX::TexMetadata MetaData{};
 
 		MetaData.width = Width;
@@ -60,31 +62,73 @@ namespace Assets
 		MetaData.dimension = DirectX::TEX_DIMENSION::TEX_DIMENSION_TEXTURE2D;
 		MetaData.format = Format.Format;
 
+		return MetaData;
+	}
+
+	static DirectX::DDS_FLAGS BuildDDSFlags(const DDSFormat& Format)
+	{
+		return (Format.Flags == DDSFormatFlags::ForceDX10) ? DirectX::DDS_FLAGS::DDS_FLAGS_FORCE_DX10_EXT : DirectX::DDS_FLAGS::DDS_FLAGS_NONE;
+	}
+
+	void DDS::WriteDDSHeader(IO::Stream* Stream, uint32_t Width, uint32_t Height, const DDSFormat& Format)
+	{
+		// Temporary buffer
+		char Buffer[0x100]{};
+
 		size_t ResultSize = 0;
-		DirectX::EncodeDDSHeader(MetaData, DirectX::DDS_FLAGS::DDS_FLAGS_NONE, Buffer, sizeof(Buffer), ResultSize);
+		DirectX::EncodeDDSHeader(BuildDDSMetadata(Width, Height, Format), BuildDDSFlags(Format), Buffer, sizeof(Buffer), ResultSize);
 
 		Stream->Write((uint8_t*)Buffer, 0, (uint64_t)ResultSize);
 	}
 
 	void DDS::WriteDDSHeader(uint8_t* Buffer, uint32_t Width, uint32_t Height, const DDSFormat& Format, uint32_t& ResultSize)
 	{
-		DirectX::TexMetadata MetaData{};
-
-		MetaData.width = Width;
-		MetaData.height = Height;
-		MetaData.depth = 1;
-		MetaData.arraySize = (Format.CubeMap) ? 6 : 1;
-		MetaData.mipLevels = Format.MipLevels;
-		MetaData.miscFlags = (Format.CubeMap) ? DirectX::TEX_MISC_FLAG::TEX_MISC_TEXTURECUBE : 0;
-		MetaData.dimension = DirectX::TEX_DIMENSION::TEX_DIMENSION_TEXTURE2D;
-		MetaData.format = Format.Format;
-
 		size_t Result = 0;
-		DirectX::EncodeDDSHeader(MetaData, DirectX::DDS_FLAGS::DDS_FLAGS_NONE, Buffer, sizeof(Buffer), Result);
+		DirectX::EncodeDDSHeader(BuildDDSMetadata(Width, Height, Format), BuildDDSFlags(Format), Buffer, DDSMaxHeaderSize, Result);
 
 		ResultSize = (uint32_t)Result;
 	}
 
+	bool DDS::WriteDDSFile(const string& Path, uint32_t Width, uint32_t Height, const DDSFormat& Format, const uint8_t* Payload, uint64_t PayloadSize)
+	{
+		if (Payload == nullptr || PayloadSize < CalculatePayloadSize(Width, Height, Format))
+			return false;
+
+		uint8_t Header[DDSMaxHeaderSize]{};
+		size_t HeaderSize = 0;
+
+		if (FAILED(DirectX::EncodeDDSHeader(BuildDDSMetadata(Width, Height, Format), BuildDDSFlags(Format), Header, sizeof(Header), HeaderSize)))
+			return false;
+
+		auto Stream = IO::File::Create(Path);
+
+		// The header lands in the stream buffer, the payload is large enough to go straight to disk
+		Stream->Write(Header, 0, (uint64_t)HeaderSize);
+		Stream->Write(const_cast<uint8_t*>(Payload), 0, CalculatePayloadSize(Width, Height, Format));
+
+		return true;
+	}
+
+	const uint64_t DDS::CalculateMipSize(uint32_t Width, uint32_t Height, uint32_t MipLevel, const DDSFormat& Format)
+	{
+		size_t RowPitch = 0, SlicePitch = 0;
+
+		if (FAILED(DirectX::ComputePitch(Format.Format, max(1u, Width >> MipLevel), max(1u, Height >> MipLevel), RowPitch, SlicePitch)))
+			return 0;
+
+		return (uint64_t)SlicePitch;
+	}
+
+	const uint64_t DDS::CalculatePayloadSize(uint32_t Width, uint32_t Height, const DDSFormat& Format)
+	{
+		uint64_t Result = 0;
+
+		for (uint32_t i = 0; i < Format.MipLevels; i++)
+			Result += CalculateMipSize(Width, Height, i, Format);
+
+		return (Format.CubeMap) ? Result * 6 : Result;
+	}
+
 	const uint32_t DDS::CalculateBlockSize(uint32_t Width, uint32_t Height, const DDSFormat& Format)
 	{
 		return (uint32_t)(DirectX::BitsPerPixel(Format.Format) * Width * Height) / 8;
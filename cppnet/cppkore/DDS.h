@@ -4,13 +4,16 @@
 #include <memory>
 #include <dxgiformat.h>
 #include "Stream.h"
+#include "StringBase.h"
 
 namespace Assets
 {
 	// Flags used to extend the DDS texture format.
 	enum class DDSFormatFlags
 	{
-		None = 0
+		None = 0,
+		// Always writes the DX10 extended header, even for legacy compatible formats
+		ForceDX10 = 1,
 	};
 
 	// Contains information about the DDS texture format.
@@ -47,6 +50,13 @@ namespace Assets
 		// Serializes a DDS header to the buffer.
 		static void WriteDDSHeader(uint8_t* Buffer, uint32_t Width, uint32_t Height, const DDSFormat& Format, uint32_t& ResultSize);
 
+		// Writes a complete DDS file from raw payload data, the payload must already be in the final layout of the format, mips stored largest first.
+		static bool WriteDDSFile(const string& Path, uint32_t Width, uint32_t Height, const DDSFormat& Format, const uint8_t* Payload, uint64_t PayloadSize);
+
+		// Calculate the size of a single mip level for the given format.
+		static const uint64_t CalculateMipSize(uint32_t Width, uint32_t Height, uint32_t MipLevel, const DDSFormat& Format);
+		// Calculate the size of the payload for the given format, including every mip level and face.
+		static const uint64_t CalculatePayloadSize(uint32_t Width, uint32_t Height, const DDSFormat& Format);
 		// Calculate a block size for the given format.
 		static const uint32_t CalculateBlockSize(uint32_t Width, uint32_t Height, const DDSFormat& Format);
 		// Calculate the maximum level of mips.
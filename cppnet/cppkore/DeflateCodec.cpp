@@ -62,6 +62,57 @@ namespace Compression
 		return Result;
 	}
 
+	uint64_t DeflateCodec::CompressFinal(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint8_t* Output, uint64_t OutputOffset, uint64_t OutputLength)
+	{
+		z_stream DeflateStream{};
+
+		if (deflateInit2(&DeflateStream, MZ_DEFAULT_LEVEL, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9, MZ_DEFAULT_STRATEGY) != MZ_OK)
+			return 0;
+
+		DeflateStream.next_in = (const uint8_t*)(Input + InputOffset);
+		DeflateStream.next_out = (uint8_t*)(Output + OutputOffset);
+
+		// The stream counts in 32 bits, so larger buffers are handed over in chunks
+		uint64_t InputLeft = InputLength;
+		uint64_t OutputLeft = OutputLength;
+
+		while (true)
+		{
+			if (DeflateStream.avail_in == 0 && InputLeft > 0)
+			{
+				DeflateStream.avail_in = (uint32_t)min(InputLeft, (uint64_t)UINT32_MAX);
+				InputLeft -= DeflateStream.avail_in;
+			}
+
+			if (DeflateStream.avail_out == 0)
+			{
+				// The output is full before the stream ended, it doesn't fit
+				if (OutputLeft == 0)
+					break;
+
+				DeflateStream.avail_out = (uint32_t)min(OutputLeft, (uint64_t)UINT32_MAX);
+				OutputLeft -= DeflateStream.avail_out;
+			}
+
+			// Readers expect the final block, a sync flush leaves the stream open
+			auto Result = deflate(&DeflateStream, (InputLeft == 0) ? MZ_FINISH : MZ_NO_FLUSH);
+
+			if (Result == MZ_STREAM_END)
+			{
+				deflateEnd(&DeflateStream);
+
+				return (uint64_t)(DeflateStream.next_out - (Output + OutputOffset));
+			}
+
+			if (Result != MZ_OK)
+				break;
+		}
+
+		deflateEnd(&DeflateStream);
+
+		return 0;
+	}
+
 	uint64_t DeflateCodec::Decompress(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint8_t* Output, uint64_t OutputOffset, uint64_t OutputLength)
 	{
 		z_stream DeflateStream{};
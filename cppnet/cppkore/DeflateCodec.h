@@ -14,6 +14,8 @@ namespace Compression
 		static uint64_t Compress(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint8_t* Output, uint64_t OutputOffset, uint64_t OutputLength);
 		// Compress the input buffer using the Deflate codec
 		static std::unique_ptr<uint8_t[]> Compress(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint64_t& OutputLength);
+		// Compress the input buffer into a finished Deflate stream, returns 0 when it doesn't fit the output
+		static uint64_t CompressFinal(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint8_t* Output, uint64_t OutputOffset, uint64_t OutputLength);
 
 		// Decompress the input buffer using the Deflate codec
 		static uint64_t Decompress(uint8_t* Input, uint64_t InputOffset, uint64_t InputLength, uint8_t* Output, uint64_t OutputOffset, uint64_t OutputLength);
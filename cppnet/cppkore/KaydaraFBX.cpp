@@ -118,7 +118,7 @@ namespace Assets::Exporters
 		AddObjectConnection(ConnectionsNode, DeformerId, GeometryId);
 	}
 
-	void InitializeMeshSubDeformer(KaydaraFBXNode& ObjectsNode, Bone& Bone, uint64_t SubmeshIndex, uint64_t BoneIndex, uint64_t DeformerId)
+	void InitializeMeshSubDeformer(KaydaraFBXNode& ObjectsNode, Math::Matrix& GlobalMatrix, Math::Matrix& InverseGlobalMatrix, uint64_t SubmeshIndex, uint64_t BoneIndex, uint64_t DeformerId)
 	{
 		auto& SubDeformer = ObjectsNode.Children.Emplace("Deformer");
 
@@ -128,11 +128,6 @@ namespace Assets::Exporters
 
 		SubDeformer.Children.Emplace("Version").AddPropertyInteger32(100);
 
-		auto GlobalMatrix = Math::Matrix::CreateFromQuaternion(Bone.GlobalRotation());
-		GlobalMatrix.SetPosition(Bone.GlobalPosition());
-
-		auto InverseGlobalMatrix = GlobalMatrix.Inverse();
-
 		SubDeformer.Children.Emplace("Indexes").Properties.EmplaceBack('i', nullptr, 0);
 		SubDeformer.Children.Emplace("Weights").Properties.EmplaceBack('d', nullptr, 0);
 
@@ -341,6 +336,25 @@ namespace Assets::Exporters
 			}
 		}
 
+		// Every submesh a bone weights shares its bind matrices, build them once
+		List<Math::Matrix> BindMatrices(Model.Bones.Count(), true);
+		List<Math::Matrix> InverseBindMatrices(Model.Bones.Count(), true);
+
+		{
+			List<Math::Quaternion> BindRotations;
+
+			for (auto& Bone : Model.Bones)
+				BindRotations.EmplaceBack(Bone.GlobalRotation());
+
+			Math::Matrix::CreateFromQuaternionBatch(BindRotations.begin(), BindMatrices.begin(), BindRotations.Count());
+
+			for (uint32_t i = 0; i < Model.Bones.Count(); i++)
+			{
+				BindMatrices[i].SetPosition(Model.Bones[i].GlobalPosition());
+				InverseBindMatrices[i] = BindMatrices[i].Inverse();
+			}
+		}
+
 		for (auto& Mesh : Model.Meshes)
 		{
 			auto& MeshModelNode = ObjectsNode.Children.Emplace("Model");
@@ -529,7 +543,7 @@ namespace Assets::Exporters
 					if (!SubDeformers.ContainsKey(BoneId))
 					{
 						// Make new subdeformer, connect to root, and add it
-						InitializeMeshSubDeformer(ObjectsNode, Model.Bones[BoneId], SubmeshIndex, BoneId, DeformerId);
+						InitializeMeshSubDeformer(ObjectsNode, BindMatrices[BoneId], InverseBindMatrices[BoneId], SubmeshIndex, BoneId, DeformerId);
 
 						// Add a connection
 						AddObjectConnection(ConnectionsNode, DeformerId, RootDeformer);
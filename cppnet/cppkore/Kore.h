@@ -82,6 +82,7 @@
 #include "BinaryWriter.h"
 #include "StreamReader.h"
 #include "StreamWriter.h"
+#include "BufferedTextWriter.h"
 #endif
 
 #if KORE_ENABLE_NET
@@ -93,6 +94,7 @@
 #include "Task.h"
 #include "Thread.h"
 #include "ParallelTask.h"
+#include "ThreadBudget.h"
 #include "ThreadStart.h"
 #endif
 
@@ -107,6 +109,7 @@
 #include "Vector3.h"
 #include "Quaternion.h"
 #include "Matrix.h"
+#include "TransformBatch.h"
 #include "Half.h"
 #endif
 
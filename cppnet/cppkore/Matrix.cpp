@@ -312,6 +312,56 @@ namespace Math
 		return Result;
 	}
 
+	void Matrix::CreateFromQuaternionBatch(const Quaternion* Rotations, Matrix* Result, uint32_t Count)
+	{
+		const __m128 One = _mm_set1_ps(1.0f);
+		const __m128 Two = _mm_set1_ps(2.0f);
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 LastRow = _mm_setr_ps(0, 0, 0, 1);
+		uint32_t i = 0;
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			// Four rotations become one register per component
+			__m128 X = _mm_loadu_ps(&Rotations[i].X);
+			__m128 Y = _mm_loadu_ps(&Rotations[i + 1].X);
+			__m128 Z = _mm_loadu_ps(&Rotations[i + 2].X);
+			__m128 W = _mm_loadu_ps(&Rotations[i + 3].X);
+
+			_MM_TRANSPOSE4_PS(X, Y, Z, W);
+
+			__m128 XX = _mm_mul_ps(X, X);
+			__m128 XY = _mm_mul_ps(X, Y);
+			__m128 XZ = _mm_mul_ps(X, Z);
+			__m128 XW = _mm_mul_ps(X, W);
+			__m128 YY = _mm_mul_ps(Y, Y);
+			__m128 YZ = _mm_mul_ps(Y, Z);
+			__m128 YW = _mm_mul_ps(Y, W);
+			__m128 ZZ = _mm_mul_ps(Z, Z);
+			__m128 ZW = _mm_mul_ps(Z, W);
+
+			// Rows of the matrices, one matrix in each lane
+			__m128 Row0[4] = { _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(YY, ZZ))), _mm_mul_ps(Two, _mm_add_ps(XY, ZW)), _mm_mul_ps(Two, _mm_sub_ps(XZ, YW)), Zero };
+			__m128 Row1[4] = { _mm_mul_ps(Two, _mm_sub_ps(XY, ZW)), _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(XX, ZZ))), _mm_mul_ps(Two, _mm_add_ps(YZ, XW)), Zero };
+			__m128 Row2[4] = { _mm_mul_ps(Two, _mm_add_ps(XZ, YW)), _mm_mul_ps(Two, _mm_sub_ps(YZ, XW)), _mm_sub_ps(One, _mm_mul_ps(Two, _mm_add_ps(XX, YY))), Zero };
+
+			_MM_TRANSPOSE4_PS(Row0[0], Row0[1], Row0[2], Row0[3]);
+			_MM_TRANSPOSE4_PS(Row1[0], Row1[1], Row1[2], Row1[3]);
+			_MM_TRANSPOSE4_PS(Row2[0], Row2[1], Row2[2], Row2[3]);
+
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				_mm_storeu_ps(Result[i + j]._Data, Row0[j]);
+				_mm_storeu_ps(Result[i + j]._Data + 4, Row1[j]);
+				_mm_storeu_ps(Result[i + j]._Data + 8, Row2[j]);
+				_mm_storeu_ps(Result[i + j]._Data + 12, LastRow);
+			}
+		}
+
+		for (; i < Count; i++)
+			Result[i] = CreateFromQuaternion(Rotations[i]);
+	}
+
 	Vector3 Matrix::TransformVector(const Vector3& Vector, const Matrix& Value)
 	{
 		Vector3 Result;
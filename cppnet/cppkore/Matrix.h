@@ -57,6 +57,8 @@ namespace Math
 
 		// Create a rotation matrix from a quaternion rotation
 		static Matrix CreateFromQuaternion(const Quaternion& Rotation);
+		// Create rotation matrices from quaternion rotations, four at a time
+		static void CreateFromQuaternionBatch(const Quaternion* Rotations, Matrix* Result, uint32_t Count);
 		// Transform a vector3 by the given matrix
 		static Vector3 TransformVector(const Vector3& Vector, const Matrix& Value);
 		// Creates a matrix look at
@@ -203,6 +203,14 @@ namespace IO
 		this->Write(Buffer, Offset, Count);
 	}
 
+	uint8_t* MemoryStream::GetBuffer() const
+	{
+		if (!this->_Buffer)
+			throw std::exception("Stream not open");
+
+		return this->_Buffer + this->_Origin;
+	}
+
 	void MemoryStream::EnsureCapacity(uint64_t Size)
 	{
 		if (Size < this->_BufferSize)
@@ -36,6 +36,9 @@ namespace IO
 		virtual void Write(uint8_t* Buffer, uint64_t Offset, uint64_t Count);
 		virtual void Write(uint8_t* Buffer, uint64_t Offset, uint64_t Count, uint64_t Position);
 
+		// Gets the data of the stream, positions from the beginning are relative to this
+		uint8_t* GetBuffer() const;
+
 	private:
 		// Memory flags cached
 		bool _CanWrite;
@@ -46,65 +46,33 @@ namespace Assets
 
 	void Model::GenerateLocalTransforms(bool Position, bool Rotation)
 	{
-		for (auto& Bone : Bones)
-		{
-			if (Bone.Parent() != -1)
-			{
-				if (Position)
-				{
-					auto ParentMatrix = Matrix::CreateFromQuaternion(~Bones[Bone.Parent()].GlobalRotation());
+		auto Transforms = this->CreateTransformBatch();
 
-					// Inverse parent matrix * parent position difference
-					Bone.SetLocalPosition(Matrix::TransformVector(Bone.GlobalPosition() - Bones[Bone.Parent()].GlobalPosition(), ParentMatrix));
-				}
+		// Inverse parent rotation * parent position difference, and inverse parent rotation * rotation
+		Transforms.GlobalToLocal(Position, Rotation);
 
-				// Inverse parent rotation * rotation
-				if (Rotation)
-					Bone.SetLocalRotation(~Bones[Bone.Parent()].GlobalRotation() * Bone.GlobalRotation());
-			}
-			else
-			{
-				// The global transform is the same as the local
-				if (Position)
-					Bone.SetLocalPosition(Bone.GlobalPosition());
-				if (Rotation)
-					Bone.SetLocalRotation(Bone.GlobalRotation());
-			}
+		for (uint32_t i = 0; i < Bones.Count(); i++)
+		{
+			if (Position)
+				Bones[i].SetLocalPosition(Transforms.LocalPosition(i));
+			if (Rotation)
+				Bones[i].SetLocalRotation(Transforms.LocalRotation(i));
 		}
 	}
 
 	void Model::GenerateGlobalTransforms(bool Position, bool Rotation)
 	{
-		for (auto& Bone : Bones)
+		auto Transforms = this->CreateTransformBatch();
+
+		// Parent rotation * local position added to the parent position, and parent rotation * local rotation
+		Transforms.LocalToGlobal(Position, Rotation);
+
+		for (uint32_t i = 0; i < Bones.Count(); i++)
 		{
-			if (Bone.Parent() != -1)
-			{
-				if (Position)
-				{
-					auto& ParentRotation = Bones[Bone.Parent()].GlobalRotation();
-					auto& ParentPosition = Bones[Bone.Parent()].GlobalPosition();
-					auto& LocalPosition = Bone.LocalPosition();
-
-					auto PositionQuaternion = Quaternion(LocalPosition.X, LocalPosition.Y, LocalPosition.Z, 0);
-
-					// Parent rotation * local position transform, then * inverse parent rotation
-					auto Result = (ParentRotation * PositionQuaternion) * ~ParentRotation;
-					// Add to the parent's global position
-					Bone.SetGlobalPosition({ ParentPosition.X + Result.X, ParentPosition.Y + Result.Y, ParentPosition.Z + Result.Z });
-				}
-
-				// Parent rotation * local rotation transform
-				if (Rotation)
-					Bone.SetGlobalRotation(Bones[Bone.Parent()].GlobalRotation() * Bone.LocalRotation());
-			}
-			else
-			{
-				// The local transform is the same as the global
-				if (Position)
-					Bone.SetGlobalPosition(Bone.LocalPosition());
-				if (Rotation)
-					Bone.SetGlobalRotation(Bone.LocalRotation());
-			}
+			if (Position)
+				Bones[i].SetGlobalPosition(Transforms.GlobalPosition(i));
+			if (Rotation)
+				Bones[i].SetGlobalRotation(Transforms.GlobalRotation(i));
 		}
 	}
 
@@ -143,4 +111,22 @@ namespace Assets
 				Vertex.SetPosition(Vertex.Position() * Factor);
 		}
 	}
+
+	Math::TransformBatch Model::CreateTransformBatch() const
+	{
+		List<int32_t> Parents(Bones.Count(), true);
+
+		for (uint32_t i = 0; i < Bones.Count(); i++)
+			Parents[i] = Bones[i].Parent();
+
+		Math::TransformBatch Result(Parents.begin(), Parents.Count());
+
+		for (uint32_t i = 0; i < Bones.Count(); i++)
+		{
+			Result.SetLocal(i, Bones[i].LocalPosition(), Bones[i].LocalRotation());
+			Result.SetGlobal(i, Bones[i].GlobalPosition(), Bones[i].GlobalRotation());
+		}
+
+		return Result;
+	}
 }
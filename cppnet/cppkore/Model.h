@@ -10,6 +10,9 @@
 #include "Mesh.h"
 #include "Material.h"
 
+// Batched bone transforms
+#include "TransformBatch.h"
+
 // Hash algorithm for materials
 #include "XXHash.h"
 
@@ -99,5 +102,9 @@ namespace Assets
 
 		// Scales the model with the given factor.
 		void Scale(float Factor);
+
+	private:
+		// Loads the bone hierarchy and transforms into a batch.
+		Math::TransformBatch CreateTransformBatch() const;
 	};
 }
\ No newline at end of file
@@ -244,4 +244,86 @@ namespace Math
 	{
 		return Quaternion();
 	}
+
+	// The same products as operator*, for four rotations in each register
+	static __forceinline void MultiplyLanes(__m128 LX, __m128 LY, __m128 LZ, __m128 LW, __m128 RX, __m128 RY, __m128 RZ, __m128 RW, __m128& X, __m128& Y, __m128& Z, __m128& W)
+	{
+		X = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(LW, RX), _mm_mul_ps(LX, RW)), _mm_mul_ps(LY, RZ)), _mm_mul_ps(LZ, RY));
+		Y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(LW, RY), _mm_mul_ps(LX, RZ)), _mm_mul_ps(LY, RW)), _mm_mul_ps(LZ, RX));
+		Z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(LW, RZ), _mm_mul_ps(LX, RY)), _mm_mul_ps(LY, RX)), _mm_mul_ps(LZ, RW));
+		W = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(LW, RW), _mm_mul_ps(LX, RX)), _mm_mul_ps(LY, RY)), _mm_mul_ps(LZ, RZ));
+	}
+
+	void Quaternion::MultiplyBatch(const float* const Lhs[4], const float* const Rhs[4], float* const Result[4], uint32_t Count, bool ConjugateLhs)
+	{
+		// Conjugating flips the sign of the vector part
+		const __m128 Sign = _mm_set1_ps(ConjugateLhs ? -1.0f : 1.0f);
+		uint32_t i = 0;
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			__m128 X, Y, Z, W;
+
+			MultiplyLanes(
+				_mm_mul_ps(_mm_loadu_ps(Lhs[0] + i), Sign), _mm_mul_ps(_mm_loadu_ps(Lhs[1] + i), Sign), _mm_mul_ps(_mm_loadu_ps(Lhs[2] + i), Sign), _mm_loadu_ps(Lhs[3] + i),
+				_mm_loadu_ps(Rhs[0] + i), _mm_loadu_ps(Rhs[1] + i), _mm_loadu_ps(Rhs[2] + i), _mm_loadu_ps(Rhs[3] + i),
+				X, Y, Z, W);
+
+			_mm_storeu_ps(Result[0] + i, X);
+			_mm_storeu_ps(Result[1] + i, Y);
+			_mm_storeu_ps(Result[2] + i, Z);
+			_mm_storeu_ps(Result[3] + i, W);
+		}
+
+		for (; i < Count; i++)
+		{
+			Quaternion Left(Lhs[0][i], Lhs[1][i], Lhs[2][i], Lhs[3][i]);
+			auto Product = ((ConjugateLhs) ? ~Left : Left) * Quaternion(Rhs[0][i], Rhs[1][i], Rhs[2][i], Rhs[3][i]);
+
+			Result[0][i] = Product.X;
+			Result[1][i] = Product.Y;
+			Result[2][i] = Product.Z;
+			Result[3][i] = Product.W;
+		}
+	}
+
+	void Quaternion::RotateBatch(const float* const Rotation[4], const float* const Vector[3], float* const Result[3], uint32_t Count, bool ConjugateRotation)
+	{
+		const __m128 Sign = _mm_set1_ps(ConjugateRotation ? -1.0f : 1.0f);
+		const __m128 Negate = _mm_set1_ps(-1.0f);
+		const __m128 Zero = _mm_setzero_ps();
+		uint32_t i = 0;
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			__m128 QX = _mm_mul_ps(_mm_loadu_ps(Rotation[0] + i), Sign);
+			__m128 QY = _mm_mul_ps(_mm_loadu_ps(Rotation[1] + i), Sign);
+			__m128 QZ = _mm_mul_ps(_mm_loadu_ps(Rotation[2] + i), Sign);
+			__m128 QW = _mm_loadu_ps(Rotation[3] + i);
+
+			// Rotation * vector, then * conjugate rotation
+			__m128 TX, TY, TZ, TW, X, Y, Z, W;
+
+			MultiplyLanes(QX, QY, QZ, QW, _mm_loadu_ps(Vector[0] + i), _mm_loadu_ps(Vector[1] + i), _mm_loadu_ps(Vector[2] + i), Zero, TX, TY, TZ, TW);
+			MultiplyLanes(TX, TY, TZ, TW, _mm_mul_ps(QX, Negate), _mm_mul_ps(QY, Negate), _mm_mul_ps(QZ, Negate), QW, X, Y, Z, W);
+
+			_mm_storeu_ps(Result[0] + i, X);
+			_mm_storeu_ps(Result[1] + i, Y);
+			_mm_storeu_ps(Result[2] + i, Z);
+		}
+
+		for (; i < Count; i++)
+		{
+			Quaternion Q(Rotation[0][i], Rotation[1][i], Rotation[2][i], Rotation[3][i]);
+
+			if (ConjugateRotation)
+				Q = ~Q;
+
+			auto Rotated = (Q * Quaternion(Vector[0][i], Vector[1][i], Vector[2][i], 0)) * ~Q;
+
+			Result[0][i] = Rotated.X;
+			Result[1][i] = Rotated.Y;
+			Result[2][i] = Rotated.Z;
+		}
+	}
 }
\ No newline at end of file
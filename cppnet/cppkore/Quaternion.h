@@ -65,6 +65,11 @@ namespace Math
 
 		// Get an identity quaternion
 		static Quaternion Identity();
+
+		// Multiplies rotations stored as component arrays (X, Y, Z, W) four at a time, the result may alias either input
+		static void MultiplyBatch(const float* const Lhs[4], const float* const Rhs[4], float* const Result[4], uint32_t Count, bool ConjugateLhs = false);
+		// Rotates vectors stored as component arrays (X, Y, Z) four at a time, the result may alias the vectors
+		static void RotateBatch(const float* const Rotation[4], const float* const Vector[3], float* const Result[3], uint32_t Count, bool ConjugateRotation = false);
 	};
 
 	static_assert(sizeof(Quaternion) == 0x10, "Invalid Math::Quaternion size, expected 0x10");
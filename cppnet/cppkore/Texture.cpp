@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Texture.h"
 #include "DDS.h"
+#include "TextureCPUDecoder.h"
 #include "MathHelper.h"
 #include <wincodec.h>
 
@@ -134,7 +135,13 @@ namespace Assets
 		if (DirectX::IsCompressed(InternalScratchImage->GetMetadata().format))
 		{
 			auto TemporaryImage = std::make_unique<DirectX::ScratchImage>();
-			auto Result = DirectX::Decompress(InternalScratchImage->GetImages(), InternalScratchImage->GetImageCount(), InternalScratchImage->GetMetadata(), DecompressFmt, *TemporaryImage);
+			HRESULT Result = 0;
+
+			// The CPU decoder handles the common 8 bit targets, everything else goes through DirectXTex
+			if (TextureCPUDecoder::IsSupported(InternalScratchImage->GetMetadata().format, DecompressFmt))
+				Result = TextureCPUDecoder::Decompress(InternalScratchImage->GetImages(), InternalScratchImage->GetImageCount(), InternalScratchImage->GetMetadata(), DecompressFmt, *TemporaryImage);
+			else
+				Result = DirectX::Decompress(InternalScratchImage->GetImages(), InternalScratchImage->GetImageCount(), InternalScratchImage->GetMetadata(), DecompressFmt, *TemporaryImage);
 
 			if (SUCCEEDED(Result))
 			{
@@ -581,6 +588,16 @@ namespace Assets
 				break;
 			case SaveFileType::Png:
 				Wc = DirectX::GetWICCodec(DirectX::WICCodecs::WIC_CODEC_PNG);
+				PropertyWriter = [](IPropertyBag2 * props)
+				{
+					PROPBAG2 options{};
+					VARIANT varValues{};
+					options.pstrName = (LPOLESTR)L"FilterOption";
+					varValues.vt = VT_UI1;
+					varValues.bVal = WICPngFilterOption::WICPngFilterUp;
+
+					(void)props->Write(1, &options, &varValues);
+				};
 				break;
 			case SaveFileType::Tiff:
 				Wc = DirectX::GetWICCodec(DirectX::WICCodecs::WIC_CODEC_TIFF);
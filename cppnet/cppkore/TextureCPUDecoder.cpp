@@ -0,0 +1,628 @@
+#include "stdafx.h"
+#include "TextureCPUDecoder.h"
+#include "ThreadBudget.h"
+
+#include <vector>
+
+#include "..\cppkore_incl\DirectXTex\DirectXTex.h"
+
+#if _WIN64
+#if _DEBUG
+#pragma comment(lib, "..\\cppkore_libs\\DirectXTex\\DirectXTex_x64d.lib")
+#else
+#pragma comment(lib, "..\\cppkore_libs\\DirectXTex\\DirectXTex_x64r.lib")
+#endif
+#else
+#error DirectXTex doesn't support non x64 builds yet
+#endif
+
+namespace Assets
+{
+	// Decodes a single 4x4 block to RGBA8 pixels
+	typedef void(*BlockDecoder)(const uint8_t* Block, uint32_t* Pixels);
+
+	// Subset of each pixel for the 2 subset BC7 partitions, one bit per pixel
+	constexpr const uint16_t BC7Partitions2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+
+	// Subset of each pixel for the 3 subset BC7 partitions
+	constexpr const uint8_t BC7Partitions3[64][16] =
+	{
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+		{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+		{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+		{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+		{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+	};
+
+	// Anchor pixel of the second subset for the 2 subset partitions
+	constexpr const uint8_t BC7Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+	};
+
+	// Anchor pixel of the second subset for the 3 subset partitions
+	constexpr const uint8_t BC7Anchors3A[64] =
+	{
+		3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+		3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+		8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+		3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+	};
+
+	// Anchor pixel of the third subset for the 3 subset partitions
+	constexpr const uint8_t BC7Anchors3B[64] =
+	{
+		15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+		15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+		15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+		15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+	};
+
+	// Interpolation weights, indexed by the index bit count
+	constexpr const uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+	constexpr const uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	constexpr const uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7ModeInfo
+	{
+		uint8_t Subsets;
+		uint8_t PartitionBits;
+		uint8_t RotationBits;
+		uint8_t IndexSelectionBits;
+		uint8_t ColorBits;
+		uint8_t AlphaBits;
+		uint8_t EndpointPBits;
+		uint8_t SharedPBits;
+		uint8_t IndexBits;
+		uint8_t IndexBits2;
+	};
+
+	constexpr const BC7ModeInfo BC7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	// Reads the block bits from the lowest bit up
+	struct BC7BitReader
+	{
+		uint64_t Low;
+		uint64_t High;
+		uint32_t Position;
+
+		uint32_t Read(uint32_t Count)
+		{
+			uint64_t Value;
+
+			if (Position >= 64)
+				Value = High >> (Position - 64);
+			else if (Position == 0)
+				Value = Low;
+			else
+				Value = (Low >> Position) | (High << (64 - Position));
+
+			Position += Count;
+
+			return (uint32_t)(Value & ((1ull << Count) - 1));
+		}
+	};
+
+	static const uint8_t* BC7WeightsForBits(uint32_t Bits)
+	{
+		return (Bits == 2) ? BC7Weights2 : (Bits == 3) ? BC7Weights3 : BC7Weights4;
+	}
+
+	// Builds the palette between two RGBA endpoints, two entries per iteration with a 16 bit lane per channel
+	static void BC7Interpolate(const uint8_t* Endpoint0, const uint8_t* Endpoint1, uint32_t Bits, uint32_t* Palette)
+	{
+		const uint8_t* Weights = BC7WeightsForBits(Bits);
+
+		__m128i Low = _mm_cvtepu8_epi16(_mm_set1_epi32(*(const int32_t*)Endpoint0));
+		__m128i High = _mm_cvtepu8_epi16(_mm_set1_epi32(*(const int32_t*)Endpoint1));
+		__m128i Round = _mm_set1_epi16(32);
+		__m128i Total = _mm_set1_epi16(64);
+
+		for (uint32_t i = 0; i < (1u << Bits); i += 2)
+		{
+			__m128i Weight1 = _mm_setr_epi16(Weights[i], Weights[i], Weights[i], Weights[i], Weights[i + 1], Weights[i + 1], Weights[i + 1], Weights[i + 1]);
+			__m128i Weight0 = _mm_sub_epi16(Total, Weight1);
+
+			__m128i Result = _mm_add_epi16(_mm_mullo_epi16(Low, Weight0), _mm_mullo_epi16(High, Weight1));
+			Result = _mm_srli_epi16(_mm_add_epi16(Result, Round), 6);
+
+			_mm_storel_epi64((__m128i*)(Palette + i), _mm_packus_epi16(Result, Result));
+		}
+	}
+
+	static void DecodeBC7Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		uint32_t Mode = 0;
+
+		while (Mode < 8 && (Block[0] & (1 << Mode)) == 0)
+			Mode++;
+
+		// Reserved mode, decodes to transparent black
+		if (Mode == 8)
+		{
+			std::memset(Pixels, 0, sizeof(uint32_t) * 16);
+			return;
+		}
+
+		const BC7ModeInfo& Info = BC7Modes[Mode];
+
+		BC7BitReader Bits{};
+		std::memcpy(&Bits.Low, Block, sizeof(uint64_t));
+		std::memcpy(&Bits.High, Block + 8, sizeof(uint64_t));
+		Bits.Position = Mode + 1;
+
+		uint32_t Partition = Bits.Read(Info.PartitionBits);
+		uint32_t Rotation = Bits.Read(Info.RotationBits);
+		uint32_t IndexSelection = Bits.Read(Info.IndexSelectionBits);
+
+		// Subset, endpoint, channel
+		alignas(4) uint8_t Endpoints[3][2][4]{};
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			for (uint32_t s = 0; s < Info.Subsets; s++)
+			{
+				Endpoints[s][0][c] = (uint8_t)Bits.Read(Info.ColorBits);
+				Endpoints[s][1][c] = (uint8_t)Bits.Read(Info.ColorBits);
+			}
+		}
+
+		for (uint32_t s = 0; s < Info.Subsets && Info.AlphaBits > 0; s++)
+		{
+			Endpoints[s][0][3] = (uint8_t)Bits.Read(Info.AlphaBits);
+			Endpoints[s][1][3] = (uint8_t)Bits.Read(Info.AlphaBits);
+		}
+
+		uint32_t ColorBits = Info.ColorBits;
+		uint32_t AlphaBits = Info.AlphaBits;
+		uint32_t Channels = (Info.AlphaBits > 0) ? 4 : 3;
+
+		if (Info.EndpointPBits || Info.SharedPBits)
+		{
+			for (uint32_t s = 0; s < Info.Subsets; s++)
+			{
+				uint32_t PBit0 = Bits.Read(1);
+				uint32_t PBit1 = (Info.SharedPBits) ? PBit0 : Bits.Read(1);
+
+				for (uint32_t c = 0; c < Channels; c++)
+				{
+					Endpoints[s][0][c] = (uint8_t)((Endpoints[s][0][c] << 1) | PBit0);
+					Endpoints[s][1][c] = (uint8_t)((Endpoints[s][1][c] << 1) | PBit1);
+				}
+			}
+
+			ColorBits++;
+			AlphaBits += (AlphaBits > 0) ? 1 : 0;
+		}
+
+		// Expand to 8 bits by replicating the high bits
+		for (uint32_t s = 0; s < Info.Subsets; s++)
+		{
+			for (uint32_t e = 0; e < 2; e++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					uint32_t Value = (uint32_t)Endpoints[s][e][c] << (8 - ColorBits);
+					Endpoints[s][e][c] = (uint8_t)(Value | (Value >> ColorBits));
+				}
+
+				if (AlphaBits > 0)
+				{
+					uint32_t Value = (uint32_t)Endpoints[s][e][3] << (8 - AlphaBits);
+					Endpoints[s][e][3] = (uint8_t)(Value | (Value >> AlphaBits));
+				}
+				else
+				{
+					Endpoints[s][e][3] = 0xFF;
+				}
+			}
+		}
+
+		uint8_t Subsets[16]{};
+		uint32_t Anchor1 = 0xFF, Anchor2 = 0xFF;
+
+		if (Info.Subsets == 2)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+				Subsets[i] = (uint8_t)((BC7Partitions2[Partition] >> i) & 1);
+
+			Anchor1 = BC7Anchors2[Partition];
+		}
+		else if (Info.Subsets == 3)
+		{
+			std::memcpy(Subsets, BC7Partitions3[Partition], sizeof(Subsets));
+
+			Anchor1 = BC7Anchors3A[Partition];
+			Anchor2 = BC7Anchors3B[Partition];
+		}
+
+		// Anchor pixels drop the top bit of their index
+		uint8_t Indices[16];
+		uint8_t Indices2[16]{};
+
+		for (uint32_t i = 0; i < 16; i++)
+			Indices[i] = (uint8_t)Bits.Read((i == 0 || i == Anchor1 || i == Anchor2) ? Info.IndexBits - 1 : Info.IndexBits);
+
+		for (uint32_t i = 0; i < 16 && Info.IndexBits2 > 0; i++)
+			Indices2[i] = (uint8_t)Bits.Read((i == 0) ? Info.IndexBits2 - 1 : Info.IndexBits2);
+
+		if (Info.IndexBits2 > 0)
+		{
+			// Color and alpha use separate index sets, the selection bit swaps which one each uses
+			uint32_t ColorIndexBits = (IndexSelection) ? Info.IndexBits2 : Info.IndexBits;
+			uint32_t AlphaIndexBits = (IndexSelection) ? Info.IndexBits : Info.IndexBits2;
+			const uint8_t* ColorIndices = (IndexSelection) ? Indices2 : Indices;
+			const uint8_t* AlphaIndices = (IndexSelection) ? Indices : Indices2;
+
+			alignas(16) uint32_t ColorPalette[16];
+			alignas(16) uint32_t AlphaPalette[16];
+
+			BC7Interpolate(Endpoints[0][0], Endpoints[0][1], ColorIndexBits, ColorPalette);
+			BC7Interpolate(Endpoints[0][0], Endpoints[0][1], AlphaIndexBits, AlphaPalette);
+
+			for (uint32_t i = 0; i < 16; i++)
+				Pixels[i] = (ColorPalette[ColorIndices[i]] & 0x00FFFFFF) | (AlphaPalette[AlphaIndices[i]] & 0xFF000000);
+		}
+		else
+		{
+			alignas(16) uint32_t Palettes[3][16];
+
+			for (uint32_t s = 0; s < Info.Subsets; s++)
+				BC7Interpolate(Endpoints[s][0], Endpoints[s][1], Info.IndexBits, Palettes[s]);
+
+			for (uint32_t i = 0; i < 16; i++)
+				Pixels[i] = Palettes[Subsets[i]][Indices[i]];
+		}
+
+		// Rotation swaps alpha with one of the color channels
+		if (Rotation > 0)
+		{
+			uint32_t Shift = (Rotation - 1) * 8;
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t Alpha = Pixels[i] >> 24;
+				uint32_t Channel = (Pixels[i] >> Shift) & 0xFF;
+
+				Pixels[i] = (Pixels[i] & ~(0xFFu << Shift) & 0x00FFFFFF) | (Alpha << Shift) | (Channel << 24);
+			}
+		}
+	}
+
+	static inline uint32_t PackRGBA(uint32_t R, uint32_t G, uint32_t B, uint32_t A)
+	{
+		return R | (G << 8) | (B << 16) | (A << 24);
+	}
+
+	// Decodes the color half of a BC1-BC3 block, endpoints are interpolated from their 5:6:5 values with rounding to match DirectXTex
+	static void DecodeBC1Colors(const uint8_t* Block, uint32_t* Pixels, bool AllowTransparent)
+	{
+		uint32_t Color0 = Block[0] | (Block[1] << 8);
+		uint32_t Color1 = Block[2] | (Block[3] << 8);
+
+		uint32_t R0 = (Color0 >> 11) & 0x1F, G0 = (Color0 >> 5) & 0x3F, B0 = Color0 & 0x1F;
+		uint32_t R1 = (Color1 >> 11) & 0x1F, G1 = (Color1 >> 5) & 0x3F, B1 = Color1 & 0x1F;
+
+		uint32_t Palette[4];
+
+		Palette[0] = PackRGBA((R0 << 3) | (R0 >> 2), (G0 << 2) | (G0 >> 4), (B0 << 3) | (B0 >> 2), 0xFF);
+		Palette[1] = PackRGBA((R1 << 3) | (R1 >> 2), (G1 << 2) | (G1 >> 4), (B1 << 3) | (B1 >> 2), 0xFF);
+
+		if (Color0 > Color1 || !AllowTransparent)
+		{
+			Palette[2] = PackRGBA(((2 * R0 + R1) * 255 + 46) / 93, ((2 * G0 + G1) * 255 + 94) / 189, ((2 * B0 + B1) * 255 + 46) / 93, 0xFF);
+			Palette[3] = PackRGBA(((R0 + 2 * R1) * 255 + 46) / 93, ((G0 + 2 * G1) * 255 + 94) / 189, ((B0 + 2 * B1) * 255 + 46) / 93, 0xFF);
+		}
+		else
+		{
+			Palette[2] = PackRGBA(((R0 + R1) * 255 + 31) / 62, ((G0 + G1) * 255 + 63) / 126, ((B0 + B1) * 255 + 31) / 62, 0xFF);
+			Palette[3] = 0;
+		}
+
+		uint32_t Indices = Block[4] | (Block[5] << 8) | (Block[6] << 16) | ((uint32_t)Block[7] << 24);
+
+		for (uint32_t i = 0; i < 16; i++)
+			Pixels[i] = Palette[(Indices >> (i * 2)) & 3];
+	}
+
+	// Decodes a BC4 style channel block, values are interpolated with rounding to match DirectXTex
+	static void DecodeBC4Channel(const uint8_t* Block, uint8_t* Values)
+	{
+		uint32_t Value0 = Block[0];
+		uint32_t Value1 = Block[1];
+
+		uint8_t Palette[8];
+
+		Palette[0] = (uint8_t)Value0;
+		Palette[1] = (uint8_t)Value1;
+
+		if (Value0 > Value1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+				Palette[i + 1] = (uint8_t)(((Value0 * (7 - i) + Value1 * i) * 2 + 7) / 14);
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+				Palette[i + 1] = (uint8_t)(((Value0 * (5 - i) + Value1 * i) * 2 + 5) / 10);
+
+			Palette[6] = 0;
+			Palette[7] = 0xFF;
+		}
+
+		uint64_t Indices = 0;
+		std::memcpy(&Indices, Block + 2, 6);
+
+		for (uint32_t i = 0; i < 16; i++)
+			Values[i] = Palette[(Indices >> (i * 3)) & 7];
+	}
+
+	static void DecodeBC1Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		DecodeBC1Colors(Block, Pixels, true);
+	}
+
+	static void DecodeBC2Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		DecodeBC1Colors(Block + 8, Pixels, false);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t Alpha = (Block[i / 2] >> ((i & 1) * 4)) & 0xF;
+			Pixels[i] = (Pixels[i] & 0x00FFFFFF) | ((Alpha * 17) << 24);
+		}
+	}
+
+	static void DecodeBC3Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		uint8_t Alpha[16];
+
+		DecodeBC1Colors(Block + 8, Pixels, false);
+		DecodeBC4Channel(Block, Alpha);
+
+		for (uint32_t i = 0; i < 16; i++)
+			Pixels[i] = (Pixels[i] & 0x00FFFFFF) | ((uint32_t)Alpha[i] << 24);
+	}
+
+	static void DecodeBC4Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		uint8_t Red[16];
+
+		DecodeBC4Channel(Block, Red);
+
+		for (uint32_t i = 0; i < 16; i++)
+			Pixels[i] = PackRGBA(Red[i], 0, 0, 0xFF);
+	}
+
+	static void DecodeBC5Block(const uint8_t* Block, uint32_t* Pixels)
+	{
+		uint8_t Red[16];
+		uint8_t Green[16];
+
+		DecodeBC4Channel(Block, Red);
+		DecodeBC4Channel(Block + 8, Green);
+
+		for (uint32_t i = 0; i < 16; i++)
+			Pixels[i] = PackRGBA(Red[i], Green[i], 0, 0xFF);
+	}
+
+	static BlockDecoder GetBlockDecoder(DXGI_FORMAT Format)
+	{
+		switch (Format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return DecodeBC1Block;
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			return DecodeBC2Block;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return DecodeBC3Block;
+		case DXGI_FORMAT_BC4_UNORM:
+			return DecodeBC4Block;
+		case DXGI_FORMAT_BC5_UNORM:
+			return DecodeBC5Block;
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return DecodeBC7Block;
+		default:
+			return nullptr;
+		}
+	}
+
+	// Swaps the red and blue channels of four RGBA8 pixels
+	static inline __m128i SwapRedBlue(__m128i Pixels)
+	{
+		__m128i GreenAlpha = _mm_and_si128(Pixels, _mm_set1_epi32((int32_t)0xFF00FF00));
+		__m128i RedBlue = _mm_and_si128(Pixels, _mm_set1_epi32(0x00FF00FF));
+
+		return _mm_or_si128(GreenAlpha, _mm_or_si128(_mm_slli_epi32(RedBlue, 16), _mm_srli_epi32(RedBlue, 16)));
+	}
+
+	// Decodes a range of block rows from one image
+	static void DecodeBlockRows(const DirectX::Image& Source, const DirectX::Image& Target, BlockDecoder Decoder, size_t BlockSize, bool SwapChannels, size_t FirstRow, size_t RowCount)
+	{
+		size_t BlocksWide = (Source.width + 3) / 4;
+		alignas(16) uint32_t Pixels[16];
+
+		for (size_t Row = FirstRow; Row < FirstRow + RowCount; Row++)
+		{
+			const uint8_t* Block = Source.pixels + Row * Source.rowPitch;
+			size_t Lines = min((size_t)4, Source.height - Row * 4);
+
+			for (size_t x = 0; x < BlocksWide; x++, Block += BlockSize)
+			{
+				Decoder(Block, Pixels);
+
+				size_t Columns = min((size_t)4, Source.width - x * 4);
+
+				for (size_t y = 0; y < Lines; y++)
+				{
+					uint8_t* Destination = Target.pixels + (Row * 4 + y) * Target.rowPitch + x * 16;
+					__m128i Line = _mm_load_si128((const __m128i*)(Pixels + y * 4));
+
+					if (SwapChannels)
+						Line = SwapRedBlue(Line);
+
+					if (Columns == 4)
+					{
+						_mm_storeu_si128((__m128i*)Destination, Line);
+					}
+					else
+					{
+						alignas(16) uint32_t Partial[4];
+						_mm_store_si128((__m128i*)Partial, Line);
+						std::memcpy(Destination, Partial, Columns * sizeof(uint32_t));
+					}
+				}
+			}
+		}
+	}
+
+	// Block rows handed out per task, and the smallest image worth splitting up
+	constexpr size_t DecodeRowsPerTask = 16;
+	constexpr size_t DecodeParallelPixels = 512 * 512;
+
+	bool TextureCPUDecoder::IsSupported(DXGI_FORMAT Format, DXGI_FORMAT TargetFormat)
+	{
+		if (GetBlockDecoder(Format) == nullptr)
+			return false;
+
+		switch (TargetFormat)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			// Color space conversions are left to DirectXTex
+			return DirectX::IsSRGB(Format) == DirectX::IsSRGB(TargetFormat);
+		default:
+			return false;
+		}
+	}
+
+	HRESULT TextureCPUDecoder::Decompress(const DirectX::Image* cImages, size_t nimages, const DirectX::TexMetadata& metadata, DXGI_FORMAT format, DirectX::ScratchImage& images)
+	{
+		if (cImages == nullptr || !IsSupported(metadata.format, format))
+			return E_INVALIDARG;
+
+		DirectX::TexMetadata Metadata = metadata;
+		Metadata.format = format;
+
+		HRESULT Result = images.Initialize(Metadata);
+
+		if (FAILED(Result))
+			return Result;
+
+		if (images.GetImageCount() != nimages)
+		{
+			images.Release();
+			return E_FAIL;
+		}
+
+		BlockDecoder Decoder = GetBlockDecoder(metadata.format);
+		size_t BlockSize = DirectX::BitsPerPixel(metadata.format) * 2;
+		bool SwapChannels = (format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+
+		const DirectX::Image* Targets = images.GetImages();
+
+		// Split every image into runs of block rows
+		struct DecodeTask
+		{
+			size_t Image;
+			size_t FirstRow;
+			size_t RowCount;
+		};
+
+		std::vector<DecodeTask> Tasks;
+		size_t TotalPixels = 0;
+
+		for (size_t i = 0; i < nimages; i++)
+		{
+			if (cImages[i].format != metadata.format || Targets[i].width != cImages[i].width || Targets[i].height != cImages[i].height)
+			{
+				images.Release();
+				return E_FAIL;
+			}
+
+			size_t BlockRows = (cImages[i].height + 3) / 4;
+
+			for (size_t Row = 0; Row < BlockRows; Row += DecodeRowsPerTask)
+				Tasks.push_back({ i, Row, min(DecodeRowsPerTask, BlockRows - Row) });
+
+			TotalPixels += cImages[i].width * cImages[i].height;
+		}
+
+		// Small images aren't worth waking helpers for
+		Threading::ThreadBudget::Run((uint32_t)Tasks.size(), [&Tasks, cImages, Targets, Decoder, BlockSize, SwapChannels](uint32_t Index)
+		{
+			const DecodeTask& Task = Tasks[Index];
+			DecodeBlockRows(cImages[Task.Image], Targets[Task.Image], Decoder, BlockSize, SwapChannels, Task.FirstRow, Task.RowCount);
+		}, (TotalPixels >= DecodeParallelPixels) ? (uint32_t)-1 : 0);
+
+		return S_OK;
+	}
+
+	bool TextureCPUDecoder::DecompressBlock(DXGI_FORMAT Format, const uint8_t* Block, uint8_t* Pixels, size_t RowPitch)
+	{
+		BlockDecoder Decoder = GetBlockDecoder(Format);
+
+		if (Decoder == nullptr)
+			return false;
+
+		alignas(16) uint32_t Decoded[16];
+		Decoder(Block, Decoded);
+
+		for (uint32_t y = 0; y < 4; y++)
+			_mm_storeu_si128((__m128i*)(Pixels + y * RowPitch), _mm_load_si128((const __m128i*)(Decoded + y * 4)));
+
+		return true;
+	}
+}
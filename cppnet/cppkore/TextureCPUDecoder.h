@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "..\cppkore_incl\DirectXTex\DirectXTex.h"
+
+namespace Assets
+{
+	// Represents a CPU based BCn decoder for texture assets, rows of blocks are decoded in parallel
+	class TextureCPUDecoder
+	{
+	public:
+		// Whether or not the decoder can decompress the format to the target format
+		static bool IsSupported(DXGI_FORMAT Format, DXGI_FORMAT TargetFormat);
+		// Decompresses the input images to the resulting scratch image, API matches DirectXTex
+		static HRESULT Decompress(const DirectX::Image* cImages, size_t nimages, const DirectX::TexMetadata& metadata, DXGI_FORMAT format, DirectX::ScratchImage& images);
+		// Decompresses a single 4x4 block to RGBA8 pixels in place, returns false if the format isn't supported
+		static bool DecompressBlock(DXGI_FORMAT Format, const uint8_t* Block, uint8_t* Pixels, size_t RowPitch);
+
+	private:
+		// Don't initialize this class
+		TextureCPUDecoder() = delete;
+		~TextureCPUDecoder() = delete;
+	};
+}
@@ -0,0 +1,106 @@
+#include "stdafx.h"
+#include "ThreadBudget.h"
+#include "Thread.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Threading
+{
+	std::atomic<int32_t> ThreadBudget::Available = (int32_t)max(std::thread::hardware_concurrency(), 1u);
+	std::atomic<ThreadBudgetCapture> ThreadBudget::Capture = nullptr;
+
+	void ThreadBudget::Run(uint32_t Count, const std::function<void(uint32_t)>& Task, uint32_t MaxHelpers)
+	{
+		std::atomic<uint32_t> NextTask = 0;
+		std::exception_ptr TaskError = nullptr;
+		std::mutex TaskErrorMutex;
+
+		std::function<void(void)> Worker = [&NextTask, &TaskError, &TaskErrorMutex, &Task, Count]
+		{
+			while (true)
+			{
+				uint32_t Index = NextTask++;
+
+				if (Index >= Count)
+					break;
+
+				try
+				{
+					Task(Index);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> Lock(TaskErrorMutex);
+
+					if (TaskError == nullptr)
+						TaskError = std::current_exception();
+				}
+			}
+		};
+
+		uint32_t Borrowed = (Count > 1) ? TryTake(min(Count - 1, MaxHelpers)) : 0;
+
+		// Helpers work on behalf of the calling thread, give them its state before they start
+		ThreadBudgetCapture CaptureContext = Capture.load();
+		std::unique_ptr<ThreadBudgetContext> Context = (Borrowed > 0 && CaptureContext != nullptr) ? CaptureContext() : nullptr;
+
+		std::function<void(void)> HelperWorker = [&Worker, &Context]
+		{
+			if (Context != nullptr)
+				Context->Attach();
+
+			Worker();
+
+			if (Context != nullptr)
+				Context->Detach();
+		};
+
+		{
+			// Threads own their handles, keep them in place while they run
+			std::vector<std::unique_ptr<Thread>> Helpers;
+
+			for (uint32_t i = 0; i < Borrowed; i++)
+			{
+				Helpers.emplace_back(std::make_unique<Thread>(HelperWorker));
+				Helpers.back()->Start();
+			}
+
+			Worker();
+
+			for (auto& Helper : Helpers)
+				Helper->Join();
+		}
+
+		Return(Borrowed);
+
+		if (TaskError != nullptr)
+			std::rethrow_exception(TaskError);
+	}
+
+	uint32_t ThreadBudget::TryTake(uint32_t Wanted)
+	{
+		int32_t Current = Available.load();
+
+		while (Wanted > 0 && Current > 0)
+		{
+			int32_t Take = (int32_t)min((uint32_t)Current, Wanted);
+
+			if (Available.compare_exchange_weak(Current, Current - Take))
+				return (uint32_t)Take;
+		}
+
+		return 0;
+	}
+
+	void ThreadBudget::Return(uint32_t Count)
+	{
+		Available += (int32_t)Count;
+	}
+
+	void ThreadBudget::SetCapture(ThreadBudgetCapture Capture)
+	{
+		ThreadBudget::Capture = Capture;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace Threading
+{
+	// Per thread state of a thread that runs a loop, carried over to the threads it borrows
+	class ThreadBudgetContext
+	{
+	public:
+		virtual ~ThreadBudgetContext() = default;
+
+		// Called on a borrowed thread before it runs any task
+		virtual void Attach() = 0;
+		// Called on a borrowed thread after its last task
+		virtual void Detach() = 0;
+	};
+
+	// Captures the state of the calling thread, may return nullptr when there is nothing to carry over
+	typedef std::unique_ptr<ThreadBudgetContext>(*ThreadBudgetCapture)();
+
+	// Threads shared by every nested parallel loop in the process, one per core
+	//
+	// Loops always work on the calling thread and only borrow the threads that are free right now, long running
+	// workers take a thread for as long as they run. Loops started from many workers at once never run more threads
+	// than there are cores.
+	class ThreadBudget
+	{
+	public:
+		// Runs tasks 0 to Count - 1 on the calling thread and up to MaxHelpers borrowed threads, rethrows the first exception of a task
+		static void Run(uint32_t Count, const std::function<void(uint32_t)>& Task, uint32_t MaxHelpers = (uint32_t)-1);
+
+		// Takes up to Wanted threads without waiting, returns the number taken
+		static uint32_t TryTake(uint32_t Wanted);
+		// Returns threads taken before
+		static void Return(uint32_t Count);
+
+		// Sets the function that captures the calling thread's state for the threads a loop borrows
+		static void SetCapture(ThreadBudgetCapture Capture);
+
+	private:
+		static std::atomic<int32_t> Available;
+		static std::atomic<ThreadBudgetCapture> Capture;
+
+		// Don't initialize this class
+		ThreadBudget() = delete;
+		~ThreadBudget() = delete;
+	};
+}
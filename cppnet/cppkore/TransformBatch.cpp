@@ -0,0 +1,290 @@
+#include "stdafx.h"
+#include "TransformBatch.h"
+
+namespace Math
+{
+	TransformBatch::TransformBatch(const int32_t* Parents, uint32_t Count)
+		: _Count(Count)
+	{
+		this->_Slots = std::make_unique<uint32_t[]>(Count);
+		this->_Bones = std::make_unique<uint32_t[]>(Count);
+		this->_ParentSlots = std::make_unique<int32_t[]>(Count);
+
+		// -1 is unknown, -2 is on the chain being resolved
+		auto Depths = std::make_unique<int32_t[]>(Count);
+		int32_t MaxDepth = 0;
+
+		for (uint32_t i = 0; i < Count; i++)
+			Depths[i] = -1;
+
+		List<uint32_t> Chain;
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			if (Depths[i] >= 0)
+				continue;
+
+			uint32_t Bone = i;
+			int32_t Depth = -1;
+
+			Chain.Clear();
+
+			while (true)
+			{
+				Depths[Bone] = -2;
+				Chain.EmplaceBack(Bone);
+
+				int32_t Parent = Parents[Bone];
+
+				// Missing parents and cycles end the chain at a root
+				if (Parent < 0 || (uint32_t)Parent >= Count || Depths[Parent] == -2)
+					break;
+
+				if (Depths[Parent] >= 0)
+				{
+					Depth = Depths[Parent];
+					break;
+				}
+
+				Bone = (uint32_t)Parent;
+			}
+
+			// The chain runs from the child up to the bone it stopped at
+			for (uint32_t j = Chain.Count(); j-- > 0;)
+				Depths[Chain[j]] = ++Depth;
+
+			MaxDepth = max(MaxDepth, Depth);
+		}
+
+		// Slots are handed out by depth, bones of the same depth keep their order
+		this->_Depths = List<uint32_t>(MaxDepth + 2, true);
+
+		for (uint32_t i = 0; i < Count; i++)
+			this->_Depths[Depths[i] + 1]++;
+
+		for (int32_t d = 0; d <= MaxDepth; d++)
+			this->_Depths[d + 1] += this->_Depths[d];
+
+		{
+			List<uint32_t> Next(this->_Depths);
+
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				uint32_t Slot = Next[Depths[i]]++;
+
+				this->_Slots[i] = Slot;
+				this->_Bones[Slot] = i;
+			}
+		}
+
+		for (uint32_t Slot = 0; Slot < Count; Slot++)
+		{
+			uint32_t Bone = this->_Bones[Slot];
+			this->_ParentSlots[Slot] = (Depths[Bone] == 0) ? -1 : (int32_t)this->_Slots[Parents[Bone]];
+		}
+
+		// Position and rotation arrays for local, global and gathered parent transforms
+		this->_Data = std::make_unique<float[]>((uint64_t)Count * 21);
+
+		float* Data = this->_Data.get();
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			this->_LocalPosition[c] = Data + (c * Count);
+			this->_GlobalPosition[c] = Data + ((c + 3) * Count);
+			this->_ParentPosition[c] = Data + ((c + 6) * Count);
+		}
+
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			this->_LocalRotation[c] = Data + ((c + 9) * Count);
+			this->_GlobalRotation[c] = Data + ((c + 13) * Count);
+			this->_ParentRotation[c] = Data + ((c + 17) * Count);
+		}
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			this->_LocalRotation[3][i] = 1.0f;
+			this->_GlobalRotation[3][i] = 1.0f;
+		}
+	}
+
+	void TransformBatch::SetLocal(uint32_t Index, const Vector3& Position, const Quaternion& Rotation)
+	{
+		uint32_t Slot = this->_Slots[Index];
+
+		this->_LocalPosition[0][Slot] = Position.X;
+		this->_LocalPosition[1][Slot] = Position.Y;
+		this->_LocalPosition[2][Slot] = Position.Z;
+
+		this->_LocalRotation[0][Slot] = Rotation.X;
+		this->_LocalRotation[1][Slot] = Rotation.Y;
+		this->_LocalRotation[2][Slot] = Rotation.Z;
+		this->_LocalRotation[3][Slot] = Rotation.W;
+	}
+
+	void TransformBatch::SetGlobal(uint32_t Index, const Vector3& Position, const Quaternion& Rotation)
+	{
+		uint32_t Slot = this->_Slots[Index];
+
+		this->_GlobalPosition[0][Slot] = Position.X;
+		this->_GlobalPosition[1][Slot] = Position.Y;
+		this->_GlobalPosition[2][Slot] = Position.Z;
+
+		this->_GlobalRotation[0][Slot] = Rotation.X;
+		this->_GlobalRotation[1][Slot] = Rotation.Y;
+		this->_GlobalRotation[2][Slot] = Rotation.Z;
+		this->_GlobalRotation[3][Slot] = Rotation.W;
+	}
+
+	Vector3 TransformBatch::LocalPosition(uint32_t Index) const
+	{
+		uint32_t Slot = this->_Slots[Index];
+		return Vector3(this->_LocalPosition[0][Slot], this->_LocalPosition[1][Slot], this->_LocalPosition[2][Slot]);
+	}
+
+	Quaternion TransformBatch::LocalRotation(uint32_t Index) const
+	{
+		uint32_t Slot = this->_Slots[Index];
+		return Quaternion(this->_LocalRotation[0][Slot], this->_LocalRotation[1][Slot], this->_LocalRotation[2][Slot], this->_LocalRotation[3][Slot]);
+	}
+
+	Vector3 TransformBatch::GlobalPosition(uint32_t Index) const
+	{
+		uint32_t Slot = this->_Slots[Index];
+		return Vector3(this->_GlobalPosition[0][Slot], this->_GlobalPosition[1][Slot], this->_GlobalPosition[2][Slot]);
+	}
+
+	Quaternion TransformBatch::GlobalRotation(uint32_t Index) const
+	{
+		uint32_t Slot = this->_Slots[Index];
+		return Quaternion(this->_GlobalRotation[0][Slot], this->_GlobalRotation[1][Slot], this->_GlobalRotation[2][Slot], this->_GlobalRotation[3][Slot]);
+	}
+
+	void TransformBatch::LocalToGlobal(bool Position, bool Rotation)
+	{
+		if (this->_Count == 0)
+			return;
+
+		// The global transform of a root is the same as the local
+		for (uint32_t Slot = 0; Slot < this->_Depths[1]; Slot++)
+		{
+			if (Position)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+					this->_GlobalPosition[c][Slot] = this->_LocalPosition[c][Slot];
+			}
+
+			if (Rotation)
+			{
+				for (uint32_t c = 0; c < 4; c++)
+					this->_GlobalRotation[c][Slot] = this->_LocalRotation[c][Slot];
+			}
+		}
+
+		for (uint32_t d = 1; d + 1 < this->_Depths.Count(); d++)
+		{
+			uint32_t Start = this->_Depths[d];
+			uint32_t Count = this->_Depths[d + 1] - Start;
+
+			this->GatherParents(Start, Count);
+
+			if (Position)
+			{
+				const float* Local[3] = { this->_LocalPosition[0] + Start, this->_LocalPosition[1] + Start, this->_LocalPosition[2] + Start };
+				float* Global[3] = { this->_GlobalPosition[0] + Start, this->_GlobalPosition[1] + Start, this->_GlobalPosition[2] + Start };
+
+				// Parent rotation * local position, added to the parent position
+				Quaternion::RotateBatch(this->_ParentRotation, Local, Global, Count);
+
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					for (uint32_t i = 0; i < Count; i++)
+						Global[c][i] += this->_ParentPosition[c][i];
+				}
+			}
+
+			if (Rotation)
+			{
+				const float* Local[4] = { this->_LocalRotation[0] + Start, this->_LocalRotation[1] + Start, this->_LocalRotation[2] + Start, this->_LocalRotation[3] + Start };
+				float* Global[4] = { this->_GlobalRotation[0] + Start, this->_GlobalRotation[1] + Start, this->_GlobalRotation[2] + Start, this->_GlobalRotation[3] + Start };
+
+				// Parent rotation * local rotation
+				Quaternion::MultiplyBatch(this->_ParentRotation, Local, Global, Count);
+			}
+		}
+	}
+
+	void TransformBatch::GlobalToLocal(bool Position, bool Rotation)
+	{
+		if (this->_Count == 0)
+			return;
+
+		// The local transform of a root is the same as the global
+		for (uint32_t Slot = 0; Slot < this->_Depths[1]; Slot++)
+		{
+			if (Position)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+					this->_LocalPosition[c][Slot] = this->_GlobalPosition[c][Slot];
+			}
+
+			if (Rotation)
+			{
+				for (uint32_t c = 0; c < 4; c++)
+					this->_LocalRotation[c][Slot] = this->_GlobalRotation[c][Slot];
+			}
+		}
+
+		for (uint32_t d = 1; d + 1 < this->_Depths.Count(); d++)
+		{
+			uint32_t Start = this->_Depths[d];
+			uint32_t Count = this->_Depths[d + 1] - Start;
+
+			this->GatherParents(Start, Count);
+
+			if (Position)
+			{
+				float* Local[3] = { this->_LocalPosition[0] + Start, this->_LocalPosition[1] + Start, this->_LocalPosition[2] + Start };
+
+				// The parent position is replaced by the difference to it
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					for (uint32_t i = 0; i < Count; i++)
+						this->_ParentPosition[c][i] = this->_GlobalPosition[c][Start + i] - this->_ParentPosition[c][i];
+				}
+
+				// Inverse parent rotation * position difference
+				Quaternion::RotateBatch(this->_ParentRotation, this->_ParentPosition, Local, Count, true);
+			}
+
+			if (Rotation)
+			{
+				const float* Global[4] = { this->_GlobalRotation[0] + Start, this->_GlobalRotation[1] + Start, this->_GlobalRotation[2] + Start, this->_GlobalRotation[3] + Start };
+				float* Local[4] = { this->_LocalRotation[0] + Start, this->_LocalRotation[1] + Start, this->_LocalRotation[2] + Start, this->_LocalRotation[3] + Start };
+
+				// Inverse parent rotation * rotation
+				Quaternion::MultiplyBatch(this->_ParentRotation, Global, Local, Count, true);
+			}
+		}
+	}
+
+	uint32_t TransformBatch::Count() const
+	{
+		return this->_Count;
+	}
+
+	void TransformBatch::GatherParents(uint32_t Start, uint32_t Count)
+	{
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			int32_t Parent = this->_ParentSlots[Start + i];
+
+			for (uint32_t c = 0; c < 3; c++)
+				this->_ParentPosition[c][i] = this->_GlobalPosition[c][Parent];
+
+			for (uint32_t c = 0; c < 4; c++)
+				this->_ParentRotation[c][i] = this->_GlobalRotation[c][Parent];
+		}
+	}
+}
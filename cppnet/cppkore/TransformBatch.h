@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include "ListBase.h"
+#include "Vector3.h"
+#include "Quaternion.h"
+
+namespace Math
+{
+	// Bone transforms stored as one array per component, sorted by depth in the hierarchy
+	//
+	// The bones of a depth only read the depth before it, so every depth is transformed with the
+	// batch kernels, four bones at a time. Parents may be listed in any order.
+	class TransformBatch
+	{
+	public:
+		// Builds the hierarchy from parent indices, -1 or an invalid parent marks a root
+		TransformBatch(const int32_t* Parents, uint32_t Count);
+		~TransformBatch() = default;
+
+		// The component arrays point into the storage, which a move keeps in place
+		TransformBatch(TransformBatch&&) = default;
+
+		// Sets the local transform of a bone
+		void SetLocal(uint32_t Index, const Vector3& Position, const Quaternion& Rotation);
+		// Sets the global transform of a bone
+		void SetGlobal(uint32_t Index, const Vector3& Position, const Quaternion& Rotation);
+
+		// Gets the local position of a bone
+		Vector3 LocalPosition(uint32_t Index) const;
+		// Gets the local rotation of a bone
+		Quaternion LocalRotation(uint32_t Index) const;
+		// Gets the global position of a bone
+		Vector3 GlobalPosition(uint32_t Index) const;
+		// Gets the global rotation of a bone
+		Quaternion GlobalRotation(uint32_t Index) const;
+
+		// Computes the global transforms from the local ones
+		void LocalToGlobal(bool Position, bool Rotation);
+		// Computes the local transforms from the global ones
+		void GlobalToLocal(bool Position, bool Rotation);
+
+		// Gets the count of bones
+		uint32_t Count() const;
+
+	private:
+		uint32_t _Count;
+
+		// The slot of each bone, and the bone in each slot
+		std::unique_ptr<uint32_t[]> _Slots;
+		std::unique_ptr<uint32_t[]> _Bones;
+		// The parent slot of each slot, -1 for roots
+		std::unique_ptr<int32_t[]> _ParentSlots;
+		// The first slot of each depth, followed by the count
+		List<uint32_t> _Depths;
+
+		// Storage for every component array
+		std::unique_ptr<float[]> _Data;
+
+		float* _LocalPosition[3];
+		float* _LocalRotation[4];
+		float* _GlobalPosition[3];
+		float* _GlobalRotation[4];
+
+		// Parent transforms gathered for the depth being transformed
+		float* _ParentPosition[3];
+		float* _ParentRotation[4];
+
+		// Gathers the global transforms of the parents of a depth
+		void GatherParents(uint32_t Start, uint32_t Count);
+	};
+}
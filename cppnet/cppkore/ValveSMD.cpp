@@ -4,23 +4,25 @@
 #include "File.h"
 #include "Path.h"
 #include "MathHelper.h"
-#include "StreamWriter.h"
+#include "BufferedTextWriter.h"
 #include <vector>
 
 namespace Assets::Exporters
 {
-	void ProcessVertex(IO::StreamWriter& Writer, const Vertex& Vertex)
+	void ProcessVertex(IO::BufferedTextWriter& Writer, const Vertex& Vertex)
 	{
 		const Vector3 Normal = Vertex.Normal().GetNormalized();
 		const Vector3& Position = Vertex.Position();
 		const Vector2& UVLayer = Vertex.UVLayers(0);
 
-		Writer.WriteFmt("\t0 %f %f %f %f %f %f %f %f %d ", Position.X, Position.Y, Position.Z, Normal.X, Normal.Y, Normal.Z, UVLayer.U, (1 - UVLayer.V), Vertex.WeightCount());
+		Writer << "\t0 " << Position.X << ' ' << Position.Y << ' ' << Position.Z;
+		Writer << ' ' << Normal.X << ' ' << Normal.Y << ' ' << Normal.Z;
+		Writer << ' ' << UVLayer.U << ' ' << (1 - UVLayer.V) << ' ' << (uint32_t)Vertex.WeightCount() << ' ';
 
 		for (uint8_t i = 0; i < Vertex.WeightCount(); i++)
-			Writer.WriteFmt("%d %f ", Vertex.Weights(i).Bone, Vertex.Weights(i).Value);
+			Writer << Vertex.Weights(i).Bone << ' ' << Vertex.Weights(i).Value << ' ';
 
-		Writer.Write("\n");
+		Writer.Write('\n');
 	}
 
 	void GetBoneAnimation(int frame, List <Assets::Curve>& Curves, Vector3& Pos, Vector3& Rot)
@@ -64,7 +66,7 @@ namespace Assets::Exporters
 
 	bool ValveSMD::ExportAnimation(const Animation& Animation, const string& Path)
 	{
-		IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(Path));
+		IO::BufferedTextWriter Writer = IO::BufferedTextWriter(IO::File::Create(Path));
 
 		Writer.WriteLine(
 			"version 1\n"
@@ -114,7 +116,9 @@ namespace Assets::Exporters
 				if (Pos == Vector3(0, 0, 0) && Rot == Vector3(0, 0, 0))
 					continue;
 
-				Writer.WriteLineFmt("\t%d %f %f %f %f %f %f", j, Pos.X, Pos.Y, Pos.Z, MathHelper::DegreesToRadians(Rot.X), MathHelper::DegreesToRadians(Rot.Y), MathHelper::DegreesToRadians(Rot.Z));
+				Writer << '\t' << j << ' ' << Pos.X << ' ' << Pos.Y << ' ' << Pos.Z;
+				Writer << ' ' << MathHelper::DegreesToRadians(Rot.X) << ' ' << MathHelper::DegreesToRadians(Rot.Y) << ' ' << MathHelper::DegreesToRadians(Rot.Z);
+				Writer.WriteLine();
 			}
 		}
 
@@ -125,7 +129,7 @@ namespace Assets::Exporters
 		return false;
 	}
 
-	void WriteSubMesh(IO::StreamWriter& Writer, const Model& Model, const List<int>& MeshIds, const string& Path)
+	void WriteSubMesh(IO::BufferedTextWriter& Writer, const Model& Model, const List<int>& MeshIds, const string& Path)
 	{
 		Writer.WriteLine(
 			"version 1\n"
@@ -152,7 +156,9 @@ namespace Assets::Exporters
 		{
 			Vector3 Euler = Bone.LocalRotation().ToEulerAngles();
 
-			Writer.WriteLineFmt("  %d %f %f %f %f %f %f", BoneIndex, Bone.LocalPosition().X, Bone.LocalPosition().Y, Bone.LocalPosition().Z, MathHelper::DegreesToRadians(Euler.X), MathHelper::DegreesToRadians(Euler.Y), MathHelper::DegreesToRadians(Euler.Z));
+			Writer << "  " << BoneIndex << ' ' << Bone.LocalPosition().X << ' ' << Bone.LocalPosition().Y << ' ' << Bone.LocalPosition().Z;
+			Writer << ' ' << MathHelper::DegreesToRadians(Euler.X) << ' ' << MathHelper::DegreesToRadians(Euler.Y) << ' ' << MathHelper::DegreesToRadians(Euler.Z);
+			Writer.WriteLine();
 			BoneIndex++;
 		}
 
@@ -164,12 +170,11 @@ namespace Assets::Exporters
 		{
 			Assets::Mesh& Submesh = Model.Meshes[SubmeshId];
 
+			const string MaterialName = (Submesh.MaterialIndices[0] > -1) ? IO::Path::GetFileNameWithoutExtension(Model.Materials[Submesh.MaterialIndices[0]].Name) : string("default_material");
+
 			for (auto& Face : Submesh.Faces)
 			{
-				if (Submesh.MaterialIndices[0] > -1)
-					Writer.WriteLine(IO::Path::GetFileNameWithoutExtension(Model.Materials[Submesh.MaterialIndices[0]].Name));
-				else
-					Writer.WriteLine("default_material");
+				Writer.WriteLine(MaterialName);
 
 				ProcessVertex(Writer, Submesh.Vertices[Face[2]]);
 				ProcessVertex(Writer, Submesh.Vertices[Face[1]]);
@@ -197,13 +202,13 @@ namespace Assets::Exporters
 				{
 					NewPath = BodyPath + (string::Format("_%d", i).ToCString()) + ModelExtension().ToCString();
 
-					IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(NewPath));
+					IO::BufferedTextWriter Writer = IO::BufferedTextWriter(IO::File::Create(NewPath));
 					WriteSubMesh(Writer, Model, Bodypart.Models[i].MeshIndexes, NewPath);
 				}
 			}
 			else
 			{
-				IO::StreamWriter Writer = IO::StreamWriter(IO::File::Create(NewPath));
+				IO::BufferedTextWriter Writer = IO::BufferedTextWriter(IO::File::Create(NewPath));
 				WriteSubMesh(Writer, Model, Bodypart.Models[0].MeshIndexes, NewPath);
 			}
 		}
@@ -4,6 +4,7 @@
 #include "File.h"
 #include "Path.h"
 #include "StreamWriter.h"
+#include "BufferedTextWriter.h"
 
 namespace Assets::Exporters
 {
@@ -14,7 +15,7 @@ namespace Assets::Exporters
 
 	bool WavefrontOBJ::ExportModel(const Model& Model, const string& Path)
 	{
-		auto Writer = IO::StreamWriter(IO::File::Create(Path));
+		auto Writer = IO::BufferedTextWriter(IO::File::Create(Path));
 		auto MaterialPath = IO::Path::ChangeExtension(Path, ".mtl");
 
 		Writer.WriteLineFmt("\nmtllib %s\n", (char*)IO::Path::GetFileName(MaterialPath));
@@ -27,14 +28,10 @@ namespace Assets::Exporters
 				auto& FaceVert2 = Submesh.Vertices[Face[1]].Position();
 				auto& FaceVert3 = Submesh.Vertices[Face[2]].Position();
 
-				Writer.WriteLineFmt(
-					"v %f %f %f\n"
-					"v %f %f %f\n"
-					"v %f %f %f",
-					FaceVert1.X, FaceVert1.Y, FaceVert1.Z,
-					FaceVert2.X, FaceVert2.Y, FaceVert2.Z,
-					FaceVert3.X, FaceVert3.Y, FaceVert3.Z
-				);
+				Writer << "v " << FaceVert1.X << ' ' << FaceVert1.Y << ' ' << FaceVert1.Z << '\n';
+				Writer << "v " << FaceVert2.X << ' ' << FaceVert2.Y << ' ' << FaceVert2.Z << '\n';
+				Writer << "v " << FaceVert3.X << ' ' << FaceVert3.Y << ' ' << FaceVert3.Z;
+				Writer.WriteLine();
 			}
 		}
 
@@ -46,14 +43,10 @@ namespace Assets::Exporters
 				auto& FaceVert2 = Submesh.Vertices[Face[1]].UVLayers(0);
 				auto& FaceVert3 = Submesh.Vertices[Face[2]].UVLayers(0);
 
-				Writer.WriteLineFmt(
-					"vt %f %f\n"
-					"vt %f %f\n"
-					"vt %f %f",
-					FaceVert1.U, (1 - FaceVert1.V),
-					FaceVert2.U, (1 - FaceVert2.V),
-					FaceVert3.U, (1 - FaceVert3.V)
-				);
+				Writer << "vt " << FaceVert1.U << ' ' << (1 - FaceVert1.V) << '\n';
+				Writer << "vt " << FaceVert2.U << ' ' << (1 - FaceVert2.V) << '\n';
+				Writer << "vt " << FaceVert3.U << ' ' << (1 - FaceVert3.V);
+				Writer.WriteLine();
 			}
 		}
 
@@ -65,14 +58,10 @@ namespace Assets::Exporters
 				auto& FaceVert2 = Submesh.Vertices[Face[1]].Normal();
 				auto& FaceVert3 = Submesh.Vertices[Face[2]].Normal();
 
-				Writer.WriteLineFmt(
-					"vn %f %f %f\n"
-					"vn %f %f %f\n"
-					"vn %f %f %f",
-					FaceVert1.X, FaceVert1.Y, FaceVert1.Z,
-					FaceVert2.X, FaceVert2.Y, FaceVert2.Z,
-					FaceVert3.X, FaceVert3.Y, FaceVert3.Z
-				);
+				Writer << "vn " << FaceVert1.X << ' ' << FaceVert1.Y << ' ' << FaceVert1.Z << '\n';
+				Writer << "vn " << FaceVert2.X << ' ' << FaceVert2.Y << ' ' << FaceVert2.Z << '\n';
+				Writer << "vn " << FaceVert3.X << ' ' << FaceVert3.Y << ' ' << FaceVert3.Z;
+				Writer.WriteLine();
 			}
 		}
 
@@ -101,12 +90,10 @@ namespace Assets::Exporters
 
 			for (auto& Face : Submesh.Faces)
 			{
-				Writer.WriteLineFmt(
-					"f %d/%d/%d %d/%d/%d %d/%d/%d",
-					(VertexIndex + 2), (VertexIndex + 2), (VertexIndex + 2),
-					(VertexIndex + 1), (VertexIndex + 1), (VertexIndex + 1),
-					VertexIndex, VertexIndex, VertexIndex
-				);
+				Writer << "f " << (VertexIndex + 2) << '/' << (VertexIndex + 2) << '/' << (VertexIndex + 2);
+				Writer << ' ' << (VertexIndex + 1) << '/' << (VertexIndex + 1) << '/' << (VertexIndex + 1);
+				Writer << ' ' << VertexIndex << '/' << VertexIndex << '/' << VertexIndex;
+				Writer.WriteLine();
 
 				VertexIndex += 3;
 			}
@@ -3,7 +3,7 @@
 
 #include "File.h"
 #include "Path.h"
-#include "StreamWriter.h"
+#include "BufferedTextWriter.h"
 
 namespace Assets::Exporters
 {
@@ -14,7 +14,7 @@ namespace Assets::Exporters
 
 	bool XNALaraAscii::ExportModel(const Model& Model, const string& Path)
 	{
-		auto Writer = IO::StreamWriter(IO::File::Create(Path));
+		auto Writer = IO::BufferedTextWriter(IO::File::Create(Path));
 
 		Writer.WriteLineFmt("%d", Model.Bones.Count());
 
@@ -58,17 +58,16 @@ namespace Assets::Exporters
 				auto& Normal = Vertex.Normal();
 				auto& Color = Vertex.Color();
 
-				Writer.WriteLineFmt(
-					"%f %f %f\n"
-					"%f %f %f\n"
-					"%d %d %d %d",
-					Position.X, Position.Y, Position.Z,
-					Normal.X, Normal.Y, Normal.Z,
-					Color[0], Color[1], Color[2], Color[3]
-				);
+				Writer << Position.X << ' ' << Position.Y << ' ' << Position.Z << '\n';
+				Writer << Normal.X << ' ' << Normal.Y << ' ' << Normal.Z << '\n';
+				Writer << (uint32_t)Color[0] << ' ' << (uint32_t)Color[1] << ' ' << (uint32_t)Color[2] << ' ' << (uint32_t)Color[3];
+				Writer.WriteLine();
 
 				for (uint8_t i = 0; i < Vertex.UVLayerCount(); i++)
-					Writer.WriteLineFmt("%f %f", Vertex.UVLayers(i).U, Vertex.UVLayers(i).V);
+				{
+					Writer << Vertex.UVLayers(i).U << ' ' << Vertex.UVLayers(i).V;
+					Writer.WriteLine();
+				}
 
 				uint32_t Bones[] = { 0, 0, 0, 0 };
 				float Values[] = { 0.f, 0.f, 0.f, 0.f };
@@ -81,18 +80,18 @@ namespace Assets::Exporters
 					Values[i] = Weight.Value;
 				}
 
-				Writer.WriteLineFmt(
-					"%d %d %d %d\n"
-					"%f %f %f %f",
-					Bones[0], Bones[1], Bones[2], Bones[3],
-					Values[0], Values[1], Values[2], Values[3]
-				);
+				Writer << Bones[0] << ' ' << Bones[1] << ' ' << Bones[2] << ' ' << Bones[3] << '\n';
+				Writer << Values[0] << ' ' << Values[1] << ' ' << Values[2] << ' ' << Values[3];
+				Writer.WriteLine();
 			}
 
 			Writer.WriteLineFmt("%d", Submesh.Faces.Count());
 
 			for (auto& Face : Submesh.Faces)
-				Writer.WriteLineFmt("%d %d %d", Face[0], Face[1], Face[2]);
+			{
+				Writer << Face[0] << ' ' << Face[1] << ' ' << Face[2];
+				Writer.WriteLine();
+			}
 
 			SubmeshIndex++;
 		}
@@ -6,7 +6,9 @@
 #include "BinaryWriter.h"
 #include "ZipArchive.h"
 #include "ZLibCodec.h"
+#include "DeflateCodec.h"
 #include "DeflateStream.h"
+#include "CRC32.h"
 
 namespace Compression
 {
@@ -26,6 +28,7 @@ namespace Compression
 		this->_LeaveOpen = LeaveOpen;
 		this->_ExistingFiles = 0;
 		this->_CentralDirLength = 0;
+		this->_WriteOffset = 0;
 
 		this->ReadFileInfo();
 	}
@@ -41,6 +44,7 @@ namespace Compression
 		this->_LeaveOpen = LeaveOpen;
 		this->_ExistingFiles = 0;
 		this->_CentralDirLength = 0;
+		this->_WriteOffset = 0;
 
 		this->ReadFileInfo();
 	}
@@ -82,7 +86,6 @@ namespace Compression
 
 			Entry.Method = (ZipCompressionMethod)Method;
 			Entry.FileNameInZip = string((const char*)&Buffer[i + 46], (size_t)FileNameSize);
-			Entry.FileOffset = GetFileOffset(HeaderOffset);
 			Entry.FileSize = FileSize;
 			Entry.CompressedSize = CompressedSize;
 			Entry.HeaderOffset = HeaderOffset;
@@ -94,7 +97,9 @@ namespace Compression
 				Entry.Comment = string((const char*)&Buffer[i + 46 + FileNameSize + ExtraSize], (size_t)CommentSize);
 
 			if (ExtraSize > 0)
-				this->ReadExtraInfo(i + 46 + FileNameSize, Entry);
+				this->ReadExtraInfo(i + 46 + FileNameSize, ExtraSize, Entry);
+
+			Entry.FileOffset = GetFileOffset(Entry.HeaderOffset);
 
 			Result.EmplaceBack(std::move(Entry));
 
@@ -111,27 +116,62 @@ namespace Compression
 	}
 
 	ZipEntry ZipArchive::AddStream(ZipCompressionMethod Method, const string& FileNameInZip, IO::Stream* Stream, const string& Comment)
+	{
+		auto FileSize = Stream->GetLength() - Stream->GetPosition();
+		auto Buffer = std::make_unique<uint8_t[]>(FileSize);
+
+		for (uint64_t Offset = 0; Offset < FileSize;)
+		{
+			auto Result = Stream->Read(Buffer.get(), Offset, FileSize - Offset);
+
+			if (Result == 0)
+				break;
+
+			Offset += Result;
+		}
+
+		auto Crc32 = Hashing::CRC32::ComputeHash(Buffer.get(), 0, FileSize);
+
+		if (Method == ZipCompressionMethod::Deflate)
+		{
+			auto Compressed = std::make_unique<uint8_t[]>(FileSize);
+			auto CompressedSize = DeflateCodec::CompressFinal(Buffer.get(), 0, FileSize, Compressed.get(), 0, FileSize);
+
+			// Data that doesn't shrink is stored instead
+			if (CompressedSize > 0)
+				return AddCompressed(Method, FileNameInZip, Compressed.get(), CompressedSize, FileSize, Crc32, Comment);
+		}
+
+		return AddCompressed(ZipCompressionMethod::Store, FileNameInZip, Buffer.get(), FileSize, FileSize, Crc32, Comment);
+	}
+
+	ZipEntry ZipArchive::AddCompressed(ZipCompressionMethod Method, const string& FileNameInZip, const uint8_t* Buffer, uint64_t CompressedSize, uint64_t FileSize, uint32_t Crc32, const string& Comment)
 	{
 		auto Entry = ZipEntry();
 
 		Entry.Method = Method;
-		Entry.EncodeUTF8 = false;
+		Entry.EncodeUTF8 = true;
 		Entry.FileNameInZip = NormalizeFileName(FileNameInZip);
 		Entry.Comment = Comment;
-		Entry.Crc32 = 0;
-		Entry.HeaderOffset = this->BaseStream->GetPosition();
+		Entry.Crc32 = Crc32;
+		Entry.FileSize = FileSize;
+		Entry.CompressedSize = CompressedSize;
+		Entry.HeaderOffset = this->_WriteOffset;
+
+		// Reading entries moves the stream, new entries always follow the last one
+		if (this->BaseStream->GetPosition() != this->_WriteOffset)
+			this->BaseStream->SetPosition(this->_WriteOffset);
 
 		// Write local header
 		this->WriteLocalHeader(Entry);
 		Entry.FileOffset = this->BaseStream->GetPosition();
 
-		// TODO: Write file to zip (store)
-
+		this->BaseStream->Write((uint8_t*)Buffer, 0, CompressedSize);
+		this->_WriteOffset = this->BaseStream->GetPosition();
 
-		this->UpdateCrcAndSizes(Entry);
-		// TODO: Add to files array...
+		this->_Files.EmplaceBack(Entry);
 
-		return std::move(Entry);
+		return Entry;
 	}
 
 	void ZipArchive::ExtractFile(ZipEntry& Entry, const string& FileName)
@@ -202,8 +242,25 @@ namespace Compression
 
 	void ZipArchive::Close()
 	{
-		// TODO: Finalize writing
-		// https://github.com/jaime-olivares/zipstorer/blob/master/src/ZipStorer.cs#L330
+		// A new archive gets its end record even without entries, so it opens as an empty zip
+		bool EmptyArchive = this->BaseStream && this->BaseStream->GetLength() == 0 && this->BaseStream->CanWrite();
+
+		if (this->BaseStream && (this->_Files.Count() > 0 || EmptyArchive))
+		{
+			this->BaseStream->SetPosition(this->_WriteOffset);
+
+			// Entries that were already in the archive keep their records
+			if (this->_CentralDir != nullptr)
+				this->BaseStream->Write(this->_CentralDir.get(), 0, this->_CentralDirLength);
+
+			for (auto& Entry : this->_Files)
+				this->WriteCentralDirRecord(Entry);
+
+			this->WriteEndRecord(this->BaseStream->GetPosition() - this->_WriteOffset, this->_WriteOffset);
+			this->BaseStream->Flush();
+
+			this->_Files.Clear();
+		}
 
 		// Forcefully reset the stream
 		if (this->_LeaveOpen)
@@ -217,6 +274,9 @@ namespace Compression
 
 	void ZipArchive::ReadFileInfo()
 	{
+		// New entries are appended to data that isn't an archive
+		this->_WriteOffset = this->BaseStream->GetLength();
+
 		// This is the minimum size of a zip archive
 		if (this->BaseStream->GetLength() < 22)
 			return;
@@ -246,7 +306,7 @@ namespace Compression
 
 					auto CommentPosition = this->BaseStream->GetPosition();
 
-					if (CentralDirOffset == 0xffffffff)	// We have a Zip64 file
+					if (Entries == 0xffff || CentralSize == 0xffffffff || CentralDirOffset == 0xffffffff)	// We have a Zip64 file
 					{
 						this->BaseStream->SetPosition(DirPosition - 20);
 
@@ -282,6 +342,8 @@ namespace Compression
 					this->_CentralDirLength = CentralSize;
 					this->_CentralDir = Reader.Read(CentralSize, Temp);
 
+					// New entries replace the central directory, it's written again on close
+					this->_WriteOffset = CentralDirOffset;
 					this->BaseStream->SetPosition(CentralDirOffset);
 					return;
 				}
@@ -294,7 +356,7 @@ namespace Compression
 		}
 	}
 
-	uint32_t ZipArchive::GetFileOffset(uint32_t HeaderOffset)
+	uint64_t ZipArchive::GetFileOffset(uint64_t HeaderOffset)
 	{
 		uint8_t Buffer[2]{};
 
@@ -307,37 +369,41 @@ namespace Compression
 
 		uint16_t ExtraSize = *(uint16_t*)&Buffer[0];
 
-		return (uint32_t)(30 + FileNameSize + ExtraSize + HeaderOffset);
+		return (30 + FileNameSize + ExtraSize + HeaderOffset);
 	}
 
-	void ZipArchive::ReadExtraInfo(uint64_t i, ZipEntry& Entry)
+	void ZipArchive::ReadExtraInfo(uint64_t i, uint16_t ExtraSize, ZipEntry& Entry)
 	{
-		if (this->_CentralDirLength < 4)
-			return;
-
 		uint64_t Pos = i;
-		uint32_t Tag, Size;
+		uint64_t End = std::min<uint64_t>(i + ExtraSize, this->_CentralDirLength);
 
 		uint8_t* Buffer = this->_CentralDir.get();
 
-		while (Pos < this->_CentralDirLength - 4)
+		while (Pos + 4 <= End)
 		{
 			uint32_t ExtraId = *(uint16_t*)(&Buffer[Pos]);
 			uint32_t Length = *(uint16_t*)(&Buffer[Pos + 2]);
 
 			if (ExtraId == 0x1)	// Zip64 information
 			{
-				Tag = *(uint16_t*)(&Buffer[Pos + 8]);
-				Size = *(uint16_t*)(&Buffer[Pos + 10]);
+				// Only the fields that overflowed the record are present, in this order
+				uint64_t Field = Pos + 4;
+				uint64_t FieldEnd = std::min<uint64_t>(Field + Length, End);
 
-				if (Tag == 1 && Size >= 24)
+				if (Entry.FileSize == 0xFFFFFFFF && Field + 8 <= FieldEnd)
+				{
+					Entry.FileSize = *(uint64_t*)(&Buffer[Field]);
+					Field += 8;
+				}
+				if (Entry.CompressedSize == 0xFFFFFFFF && Field + 8 <= FieldEnd)
+				{
+					Entry.CompressedSize = *(uint64_t*)(&Buffer[Field]);
+					Field += 8;
+				}
+				if (Entry.HeaderOffset == 0xFFFFFFFF && Field + 8 <= FieldEnd)
 				{
-					if (Entry.FileSize == 0xFFFFFFFF)
-						Entry.FileSize = *(uint64_t*)(&Buffer[Pos + 12]);
-					if (Entry.CompressedSize == 0xFFFFFFFF)
-						Entry.CompressedSize = *(uint64_t*)(&Buffer[Pos + 20]);
-					if (Entry.HeaderOffset == 0xFFFFFFFF)
-						Entry.HeaderOffset = *(uint64_t*)(&Buffer[Pos + 28]);
+					Entry.HeaderOffset = *(uint64_t*)(&Buffer[Field]);
+					Field += 8;
 				}
 			}
 
@@ -363,79 +429,162 @@ namespace Compression
 		return Name;
 	}
 
-	void ZipArchive::UpdateCrcAndSizes(ZipEntry& Entry)
+	// Entries carry no time, this is the earliest date the format can hold
+	constexpr uint32_t ZipDosTime = 0x00210000;
+
+	void ZipArchive::WriteLocalHeader(ZipEntry& Entry)
 	{
-		auto LastPos = this->BaseStream->GetPosition();
+		auto Pos = this->BaseStream->GetPosition();
 
 		auto Writer = IO::BinaryWriter(this->BaseStream.get(), true);
 
-		this->BaseStream->SetPosition(Entry.HeaderOffset + 8);
-		Writer.Write<uint16_t>((uint16_t)Entry.Method);
+		uint8_t ExtraInfo[28]{};
+		auto ExtraSize = this->CreateExtraInfo(Entry, false, ExtraInfo);
 
-		this->BaseStream->SetPosition(Entry.HeaderOffset + 14);
+		Writer.Write<uint32_t>(0x04034b50);
+		Writer.Write<uint16_t>((uint16_t)((ExtraSize > 0) ? 45 : 20));	// Version needed, 4.5 for Zip64
+		Writer.Write<uint16_t>((uint16_t)0x0800);		// Encode in UTF8
+		Writer.Write<uint16_t>((uint16_t)Entry.Method);
+		Writer.Write<uint32_t>(ZipDosTime);
 		Writer.Write<uint32_t>(Entry.Crc32);
-		Writer.Write<uint32_t>(Get32BitSize(Entry.CompressedSize));
-		Writer.Write<uint32_t>(Get32BitSize(Entry.FileSize));
 
-		this->BaseStream->SetPosition(LastPos);
+		// Both sizes move to the Zip64 info when either overflows
+		if (ExtraSize > 0)
+		{
+			Writer.Write<uint32_t>(0xFFFFFFFF);
+			Writer.Write<uint32_t>(0xFFFFFFFF);
+		}
+		else
+		{
+			Writer.Write<uint32_t>((uint32_t)Entry.CompressedSize);
+			Writer.Write<uint32_t>((uint32_t)Entry.FileSize);
+		}
+
+		Writer.Write<uint16_t>((uint16_t)Entry.FileNameInZip.Length());
+		Writer.Write<uint16_t>(ExtraSize);
+
+		this->BaseStream->Write((uint8_t*)&Entry.FileNameInZip[0], 0, Entry.FileNameInZip.Length());
+		this->BaseStream->Write(ExtraInfo, 0, ExtraSize);
+
+		Entry.HeaderSize = (uint32_t)(this->BaseStream->GetPosition() - Pos);
 	}
 
-	void ZipArchive::WriteLocalHeader(ZipEntry& Entry)
+	void ZipArchive::WriteCentralDirRecord(const ZipEntry& Entry)
 	{
-		auto Pos = this->BaseStream->GetPosition();
-
 		auto Writer = IO::BinaryWriter(this->BaseStream.get(), true);
 
-		constexpr uint8_t NoExtraData[] = { 80, 75, 3, 4, 20, 0 };
-		constexpr uint8_t NoCrcSize[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-
-		this->BaseStream->Write((uint8_t*)&NoExtraData[0], 0, sizeof(NoExtraData));
+		uint8_t ExtraInfo[28]{};
+		auto ExtraSize = this->CreateExtraInfo(Entry, true, ExtraInfo);
 
+		Writer.Write<uint32_t>(0x02014b50);
+		Writer.Write<uint16_t>((uint16_t)45);			// Version made by
+		Writer.Write<uint16_t>((uint16_t)((ExtraSize > 0) ? 45 : 20));	// Version needed, 4.5 for Zip64
 		Writer.Write<uint16_t>((uint16_t)0x0800);		// Encode in UTF8
 		Writer.Write<uint16_t>((uint16_t)Entry.Method);
-		Writer.Write<uint32_t>(0x0);					// DosTime
-
-		this->BaseStream->Write((uint8_t*)&NoCrcSize[0], 0, sizeof(NoCrcSize));
-
+		Writer.Write<uint32_t>(ZipDosTime);
+		Writer.Write<uint32_t>(Entry.Crc32);
+		Writer.Write<uint32_t>(Get32BitSize(Entry.CompressedSize));
+		Writer.Write<uint32_t>(Get32BitSize(Entry.FileSize));
 		Writer.Write<uint16_t>((uint16_t)Entry.FileNameInZip.Length());
-		Writer.Write<uint16_t>((uint16_t)72);			// ExtraInfo
+		Writer.Write<uint16_t>(ExtraSize);
+		Writer.Write<uint16_t>((uint16_t)Entry.Comment.Length());
+		Writer.Write<uint16_t>((uint16_t)0);			// Disk
+		Writer.Write<uint16_t>((uint16_t)0);			// Internal attributes
+		Writer.Write<uint32_t>(0x0);					// External attributes
+		Writer.Write<uint32_t>(Get32BitSize(Entry.HeaderOffset));
 
 		this->BaseStream->Write((uint8_t*)&Entry.FileNameInZip[0], 0, Entry.FileNameInZip.Length());
-		
-		this->CreateExtraInfo(Entry, this->BaseStream.get());
+		this->BaseStream->Write(ExtraInfo, 0, ExtraSize);
 
-		Entry.HeaderSize = (uint32_t)(this->BaseStream->GetPosition() - Pos);
+		if (Entry.Comment.Length() > 0)
+			this->BaseStream->Write((uint8_t*)&Entry.Comment[0], 0, Entry.Comment.Length());
 	}
 
-	void ZipArchive::CreateExtraInfo(ZipEntry& Entry, IO::Stream* Output)
+	void ZipArchive::WriteEndRecord(uint64_t CentralSize, uint64_t CentralOffset)
 	{
-		uint8_t Buffer[72]{};
+		auto Writer = IO::BinaryWriter(this->BaseStream.get(), true);
 
-		//
-		// Zip64 Extended Info
-		//
+		uint64_t Entries = this->_ExistingFiles + this->_Files.Count();
+
+		if (Entries >= 0xFFFF || CentralSize >= 0xFFFFFFFF || CentralOffset >= 0xFFFFFFFF)
+		{
+			auto RecordOffset = this->BaseStream->GetPosition();
+
+			//
+			// Zip64 end of central directory record
+			//
+
+			Writer.Write<uint32_t>(0x06064b50);
+			Writer.Write<uint64_t>(44);					// Size of the remaining record
+			Writer.Write<uint16_t>((uint16_t)45);			// Version made by
+			Writer.Write<uint16_t>((uint16_t)45);			// Version needed
+			Writer.Write<uint32_t>(0x0);					// Disk
+			Writer.Write<uint32_t>(0x0);					// Disk with the central directory
+			Writer.Write<uint64_t>(Entries);				// Entries on this disk
+			Writer.Write<uint64_t>(Entries);
+			Writer.Write<uint64_t>(CentralSize);
+			Writer.Write<uint64_t>(CentralOffset);
+
+			//
+			// Zip64 end of central directory locator
+			//
+
+			Writer.Write<uint32_t>(0x07064b50);
+			Writer.Write<uint32_t>(0x0);					// Disk with the record
+			Writer.Write<uint64_t>(RecordOffset);
+			Writer.Write<uint32_t>(0x1);					// Total disks
+		}
 
-		*(uint16_t*)(&Buffer[0]) = 0x1;		// ZIP64 Tag
-		*(uint16_t*)(&Buffer[2]) = 32;		// Length
-		*(uint16_t*)(&Buffer[8]) = 1;		// One tag
-		*(uint16_t*)(&Buffer[10]) = 24;		// One Size
-		*(uint64_t*)(&Buffer[12]) = Entry.FileSize;
-		*(uint64_t*)(&Buffer[20]) = Entry.CompressedSize;
-		*(uint64_t*)(&Buffer[28]) = Entry.HeaderOffset;
+		Writer.Write<uint32_t>(0x06054b50);
+		Writer.Write<uint16_t>((uint16_t)0);			// Disk
+		Writer.Write<uint16_t>((uint16_t)0);			// Disk with the central directory
+		Writer.Write<uint16_t>((uint16_t)std::min<uint64_t>(Entries, 0xFFFF));
+		Writer.Write<uint16_t>((uint16_t)std::min<uint64_t>(Entries, 0xFFFF));
+		Writer.Write<uint32_t>(Get32BitSize(CentralSize));
+		Writer.Write<uint32_t>(Get32BitSize(CentralOffset));
+		Writer.Write<uint16_t>((uint16_t)0);			// Comment
+	}
 
+	uint16_t ZipArchive::CreateExtraInfo(const ZipEntry& Entry, bool CentralDir, uint8_t* Buffer)
+	{
 		//
-		// NTFS FileTime
+		// Zip64 Extended Info, only holds the fields that overflow
 		//
 
-		*(uint16_t*)(&Buffer[36]) = 0xA;		// NTFS Tag
-		*(uint16_t*)(&Buffer[38]) = 32;			// Length
-		*(uint16_t*)(&Buffer[44]) = 1;			// One tag
-		*(uint16_t*)(&Buffer[46]) = 24;			// One Size
-		*(uint64_t*)(&Buffer[48]) = 0x0;
-		*(uint64_t*)(&Buffer[56]) = 0x0;
-		*(uint64_t*)(&Buffer[64]) = 0x0;
+		uint16_t Size = 4;
+
+		if (CentralDir)
+		{
+			if (Entry.FileSize >= 0xFFFFFFFF)
+			{
+				*(uint64_t*)(&Buffer[Size]) = Entry.FileSize;
+				Size += 8;
+			}
+			if (Entry.CompressedSize >= 0xFFFFFFFF)
+			{
+				*(uint64_t*)(&Buffer[Size]) = Entry.CompressedSize;
+				Size += 8;
+			}
+			if (Entry.HeaderOffset >= 0xFFFFFFFF)
+			{
+				*(uint64_t*)(&Buffer[Size]) = Entry.HeaderOffset;
+				Size += 8;
+			}
+		}
+		else if (Entry.FileSize >= 0xFFFFFFFF || Entry.CompressedSize >= 0xFFFFFFFF)
+		{
+			*(uint64_t*)(&Buffer[4]) = Entry.FileSize;
+			*(uint64_t*)(&Buffer[12]) = Entry.CompressedSize;
+			Size += 16;
+		}
+
+		if (Size == 4)
+			return 0;
+
+		*(uint16_t*)(&Buffer[0]) = 0x1;				// ZIP64 Tag
+		*(uint16_t*)(&Buffer[2]) = Size - 4;		// Length
 
-		Output->Write(Buffer, 0, sizeof(Buffer));
+		return Size;
 	}
 
 	uint32_t ZipArchive::Get32BitSize(uint64_t Size)
@@ -29,6 +29,8 @@ namespace Compression
 		ZipEntry AddFile(ZipCompressionMethod Method, const string& Path, const string& FileNameInZip, const string& Comment = "");
 		// Add a stream into the ZipArchive.
 		ZipEntry AddStream(ZipCompressionMethod Method, const string& FileNameInZip, IO::Stream* Stream, const string& Comment = "");
+		// Add an entry that was already compressed with the method, the size and crc are of the original data.
+		ZipEntry AddCompressed(ZipCompressionMethod Method, const string& FileNameInZip, const uint8_t* Buffer, uint64_t CompressedSize, uint64_t FileSize, uint32_t Crc32, const string& Comment = "");
 
 		// Extract the entry to the provided file path.
 		void ExtractFile(ZipEntry& Entry, const string& FileName);
@@ -39,7 +41,7 @@ namespace Compression
 
 		// Get the underlying stream
 		IO::Stream* GetBaseStream() const;
-		// Close the ZipArchive and underlying stream
+		// Write the central directory of added entries, then close the ZipArchive and underlying stream
 		void Close();
 
 	private:
@@ -47,22 +49,28 @@ namespace Compression
 		std::unique_ptr<uint8_t[]> _CentralDir;
 		uint64_t _CentralDirLength;
 		uint64_t _ExistingFiles;
+		uint64_t _WriteOffset;
 		bool _LeaveOpen;
 
+		// Entries added since the archive was opened
+		List<ZipEntry> _Files;
+
 		// Internal helper routine to parse the end of central directory record.
 		void ReadFileInfo();
 		// Internal helper routine to calculate file offset.
-		uint32_t GetFileOffset(uint32_t HeaderOffset);
+		uint64_t GetFileOffset(uint64_t HeaderOffset);
 		// Internal helper routine to read extra info.
-		void ReadExtraInfo(uint64_t i, ZipEntry& Entry);
+		void ReadExtraInfo(uint64_t i, uint16_t ExtraSize, ZipEntry& Entry);
 		// Internal helper routine to clean a file name
 		string NormalizeFileName(const string& FileName);
-		// Internal routine to calculate crc and sizes
-		void UpdateCrcAndSizes(ZipEntry& Entry);
 		// Internal routine to write the file header
 		void WriteLocalHeader(ZipEntry& Entry);
-		// Internal routine to create extra info
-		void CreateExtraInfo(ZipEntry& Entry, IO::Stream* Output);
+		// Internal routine to write the central directory record of an entry
+		void WriteCentralDirRecord(const ZipEntry& Entry);
+		// Internal routine to write the end of central directory records
+		void WriteEndRecord(uint64_t CentralSize, uint64_t CentralOffset);
+		// Internal routine to create extra info, returns the size
+		uint16_t CreateExtraInfo(const ZipEntry& Entry, bool CentralDir, uint8_t* Buffer);
 		// Internal routine to get maximum 32bit size
 		uint32_t Get32BitSize(uint64_t Size);
 	};